@@ -21,7 +21,10 @@
 #include "../tile/net_xsk/fdgen_tile_net_xsk.h"
 #include "../tile/net_xsk/fdgen_tile_net_xsk_rx.h"
 #include "../tile/net_xsk/fdgen_tile_net_xsk_poll.h"
+#include "../tile/net_packet/fdgen_tile_net_packet.h"
+#include "../tile/net_packet/fdgen_tile_net_packet_rx.h"
 #include "../cfg/fdgen_cfg_net_xdp.h"
+#include "../cfg/fdgen_cfg_net_packet.h"
 #include <firedancer/tango/cnc/fd_cnc.h>
 #include <firedancer/tango/mcache/fd_mcache.h>
 #include <firedancer/tango/dcache/fd_dcache.h>
@@ -46,6 +49,74 @@ rx_tile_main( int     argc,
   return fdgen_tile_net_xsk_rx_run( cfg );
 }
 
+static int
+packet_rx_tile_main( int     argc,
+                     char ** argv ) {
+  fdgen_tile_net_packet_rx_cfg_t * cfg = fd_type_pun( argv[0] );
+  return fdgen_tile_net_packet_rx_run( cfg );
+}
+
+/* rxdrop_packet runs the drop benchmark with an AF_PACKET TPACKET_V3
+   ring instead of AF_XDP.  Does not return. */
+
+static void
+rxdrop_packet( fd_rng_t *       rng,
+               fd_cnc_t *       rx_cnc,
+               fd_frag_meta_t * mcache,
+               uchar *          dcache,
+               ulong            mtu,
+               uint             if_idx,
+               ulong            block_cnt,
+               int              fanout_mode ) {
+
+  fdgen_packet_params_t params = {
+    .block_sz    = 1UL<<20,
+    .block_cnt   = block_cnt,
+    .frame_sz    = mtu,
+    .retire_ms   = 1U,
+    .fanout_mode = fanout_mode,
+    .fanout_id   = (ushort)getpid()
+  };
+  static fdgen_packet_ring_t ring[1];
+  FD_TEST( fdgen_packet_ring_init( ring, if_idx, &params ) );
+
+  static fdgen_tile_net_packet_rx_cfg_t rx_cfg[1];
+  rx_cfg[0] = (fdgen_tile_net_packet_rx_cfg_t) {
+    .orig        = 1UL,
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+    .seq0        = fd_mcache_seq0( mcache ),
+    .mtu         = mtu,
+
+    .rng    = rng,
+    .cnc    = rx_cnc,
+    .mcache = mcache,
+    .dcache = dcache,
+    .base   = dcache,
+
+    .ring = ring
+  };
+
+  char * rx_tile_argv[1] = { fd_type_pun( rx_cfg ) };
+  fd_tile_exec_t * rx_tile = fd_tile_exec_new( 1UL, packet_rx_tile_main, 1, rx_tile_argv );
+  FD_TEST( rx_tile );
+
+  fdgen_tile_net_packet_rx_diag_t volatile const * rx_diag = fd_cnc_app_laddr_const( rx_cnc );
+
+  ulong const * seq      = (ulong const *)fd_mcache_seq_laddr_const( mcache );
+  ulong         last_seq = fd_mcache_seq_query( seq );
+  ulong         dt       = 100e6;
+  for(;;) {
+    fd_log_sleep( dt );
+
+    ulong cur_seq = fd_mcache_seq_query( seq );
+    FD_LOG_NOTICE(( "rate: %10.0f/s", (float)(cur_seq-last_seq)/((float)dt/1e9) ));
+    last_seq = cur_seq;
+
+    FD_LOG_DEBUG(( "blk_cnt=%lu kern_drop_cnt=%lu filt_cnt=%lu",
+                   rx_diag->blk_cnt, rx_diag->kern_drop_cnt, rx_diag->filt_cnt ));
+  }
+}
+
 int
 main( int     argc,
       char ** argv ) {
@@ -68,6 +139,8 @@ main( int     argc,
   ulong        busy_poll_budget = fd_env_strip_cmdline_ulong( &argc, &argv, "--busy-poll-budget", NULL,   2048UL                   );
   ulong        busy_poll_usecs  = fd_env_strip_cmdline_ulong( &argc, &argv, "--busy-poll-usecs",  NULL,     50UL                   );
   char const * poll_mode_cstr   = fd_env_strip_cmdline_cstr ( &argc, &argv, "--poll-mode",        NULL, "wakeup"                   );
+  ulong        block_cnt        = fd_env_strip_cmdline_ulong( &argc, &argv, "--block-cnt",        NULL,     64UL                   );
+  char const * _fanout          = fd_env_strip_cmdline_cstr ( &argc, &argv, "--fanout",           NULL, "none"                     );
 
   int poll_mode = 0;
   if( 0==strcmp( poll_mode_cstr, "none" ) ) {
@@ -99,6 +172,9 @@ main( int     argc,
   int net_mode = fdgen_cstr_to_net_mode( _net_mode );
   if( FD_UNLIKELY( !net_mode ) ) FD_LOG_ERR(( "Invalid --net-mode" ));
 
+  int fanout_mode = fdgen_cstr_to_packet_fanout( _fanout );
+  if( FD_UNLIKELY( fanout_mode<0 ) ) FD_LOG_ERR(( "Invalid --fanout (%s)", _fanout ));
+
   fdgen_port_range_t src_ports[1];
   if( FD_UNLIKELY( !fdgen_cstr_to_port_range( src_ports, (char *)_src_ports ) ) ) {
     FD_LOG_ERR(( "Invalid --src-ports" ));
@@ -143,6 +219,11 @@ main( int     argc,
   uint if_idx = if_nametoindex( iface );
   FD_TEST( if_idx );
 
+  if( net_mode==FDGEN_NET_MODE_PACKET ) {
+    FD_LOG_NOTICE(( "Using AF_PACKET --block-cnt %lu --fanout %s", block_cnt, _fanout ));
+    rxdrop_packet( rng, rx_cnc, mcache, dcache, mtu, if_idx, block_cnt, fanout_mode );
+  }
+
   fdgen_xdp_port_redir_t _redir[1];
   fdgen_xdp_port_redir_t * redir = fdgen_xdp_full_redir_init(
      _redir, 1UL,
@@ -5,6 +5,7 @@ int
 fdgen_cstr_to_net_mode( char const * cstr ) {
   if( 0==strcmp( cstr, "xdp"    ) ) return FDGEN_NET_MODE_XDP;
   if( 0==strcmp( cstr, "socket" ) ) return FDGEN_NET_MODE_SOCKET;
+  if( 0==strcmp( cstr, "packet" ) ) return FDGEN_NET_MODE_PACKET;
   return 0;
 }
 
@@ -4,6 +4,7 @@
 
 #define FDGEN_NET_MODE_XDP    (1)
 #define FDGEN_NET_MODE_SOCKET (2)
+#define FDGEN_NET_MODE_PACKET (3)
 
 /* fdgen_port_range_t defines a port range (inclusive) */
 
@@ -0,0 +1,215 @@
+#include "fdgen_cfg_net_packet.h"
+#include <firedancer/util/fd_util.h>
+
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>           /* htons */
+#include <linux/if_ether.h>      /* ETH_P_IP */
+#include <linux/if_packet.h>     /* tpacket_req3, sockaddr_ll */
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+int
+fdgen_cstr_to_packet_fanout( char const * cstr ) {
+  if( 0==strcmp( cstr, "none" ) ) return FDGEN_PACKET_FANOUT_NONE;
+  if( 0==strcmp( cstr, "hash" ) ) return FDGEN_PACKET_FANOUT_HASH;
+  if( 0==strcmp( cstr, "cpu"  ) ) return FDGEN_PACKET_FANOUT_CPU;
+  if( 0==strcmp( cstr, "lb"   ) ) return FDGEN_PACKET_FANOUT_LB;
+  return -1;
+}
+
+fdgen_packet_ring_t *
+fdgen_packet_ring_init( fdgen_packet_ring_t *         ring,
+                        uint                          if_idx,
+                        fdgen_packet_params_t const * params ) {
+
+  ulong page_sz = (ulong)sysconf( _SC_PAGESIZE );
+  if( FD_UNLIKELY( !params->block_sz || !params->block_cnt || !params->frame_sz ||
+                   params->block_sz % page_sz ||
+                   params->frame_sz % TPACKET_ALIGNMENT ||
+                   params->block_sz % params->frame_sz ||
+                   params->block_sz > UINT_MAX || params->block_cnt > UINT_MAX ) ) {
+    FD_LOG_WARNING(( "invalid TPACKET_V3 ring geometry (block_sz %lu block_cnt %lu frame_sz %lu)",
+                     params->block_sz, params->block_cnt, params->frame_sz ));
+    return NULL;
+  }
+
+  int fanout_type;
+  switch( params->fanout_mode ) {
+  case FDGEN_PACKET_FANOUT_NONE: fanout_type = -1;                 break;
+  case FDGEN_PACKET_FANOUT_HASH: fanout_type = PACKET_FANOUT_HASH; break;
+  case FDGEN_PACKET_FANOUT_CPU:  fanout_type = PACKET_FANOUT_CPU;  break;
+  case FDGEN_PACKET_FANOUT_LB:   fanout_type = PACKET_FANOUT_LB;   break;
+  default:
+    FD_LOG_WARNING(( "invalid fanout_mode %d", params->fanout_mode ));
+    return NULL;
+  }
+
+  /* Create the socket without a protocol so that it receives nothing
+     until the ring is in place and it is bound below. */
+
+  int fd = socket( AF_PACKET, SOCK_RAW, 0 );
+  if( FD_UNLIKELY( fd<0 ) ) {
+    FD_LOG_WARNING(( "socket(AF_PACKET,SOCK_RAW) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    return NULL;
+  }
+
+  int version = TPACKET_V3;
+  if( FD_UNLIKELY( 0!=setsockopt( fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(int) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(PACKET_VERSION,TPACKET_V3) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+
+  struct tpacket_req3 req = {
+    .tp_block_size     = (uint)params->block_sz,
+    .tp_block_nr       = (uint)params->block_cnt,
+    .tp_frame_size     = (uint)params->frame_sz,
+    .tp_frame_nr       = (uint)( (params->block_sz / params->frame_sz) * params->block_cnt ),
+    .tp_retire_blk_tov   = params->retire_ms,
+    .tp_feature_req_word = TP_FT_REQ_FILL_RXHASH
+  };
+  if( FD_UNLIKELY( 0!=setsockopt( fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(struct tpacket_req3) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(PACKET_RX_RING) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+
+  ulong map_sz = params->block_sz * params->block_cnt;
+  void * mem = mmap( NULL, map_sz, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, 0 );
+  if( FD_UNLIKELY( mem==MAP_FAILED ) ) {
+    FD_LOG_WARNING(( "mmap(PACKET_RX_RING,%lu) failed (%i-%s)", map_sz, errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+
+  struct sockaddr_ll sll = {
+    .sll_family   = AF_PACKET,
+    .sll_protocol = htons( ETH_P_IP ),
+    .sll_ifindex  = (int)if_idx
+  };
+  if( FD_UNLIKELY( 0!=bind( fd, fd_type_pun_const( &sll ), sizeof(struct sockaddr_ll) ) ) ) {
+    FD_LOG_WARNING(( "bind(AF_PACKET,if_idx=%u) failed (%i-%s)", if_idx, errno, fd_io_strerror( errno ) ));
+    munmap( mem, map_sz );
+    close( fd );
+    return NULL;
+  }
+
+  if( fanout_type>=0 ) {
+    int fanout = (int)params->fanout_id | (fanout_type<<16);
+    if( FD_UNLIKELY( 0!=setsockopt( fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(int) ) ) ) {
+      FD_LOG_WARNING(( "setsockopt(PACKET_FANOUT,id=%u) failed (%i-%s)", params->fanout_id, errno, fd_io_strerror( errno ) ));
+      munmap( mem, map_sz );
+      close( fd );
+      return NULL;
+    }
+  }
+
+  ring->fd        = fd;
+  ring->rx_mem    = mem;
+  ring->map_sz    = map_sz;
+  ring->block_sz  = params->block_sz;
+  ring->block_cnt = params->block_cnt;
+  return ring;
+}
+
+void
+fdgen_packet_ring_fini( fdgen_packet_ring_t * ring ) {
+  if( ring->rx_mem ) munmap( ring->rx_mem, ring->map_sz );
+  if( ring->fd>=0  ) close( ring->fd );
+  ring->rx_mem = NULL;
+  ring->fd     = -1;
+}
+
+fdgen_packet_tx_ring_t *
+fdgen_packet_tx_ring_init( fdgen_packet_tx_ring_t * ring,
+                           uint                     if_idx,
+                           ulong                    frame_sz,
+                           ulong                    frame_cnt,
+                           int                      qdisc_bypass ) {
+
+  /* One frame per block keeps slots contiguous at stride frame_sz */
+
+  ulong page_sz = (ulong)sysconf( _SC_PAGESIZE );
+  if( FD_UNLIKELY( !fd_ulong_is_pow2( frame_sz ) || frame_sz<TPACKET_ALIGNMENT || frame_sz>page_sz ||
+                   frame_sz<=FDGEN_PACKET_TX_DATA_OFF || !frame_cnt || frame_cnt>UINT_MAX ) ) {
+    FD_LOG_WARNING(( "invalid TPACKET_V2 TX ring geometry (frame_sz %lu frame_cnt %lu)", frame_sz, frame_cnt ));
+    return NULL;
+  }
+  ulong frame_per_block = page_sz / frame_sz;
+  ulong block_cnt       = fd_ulong_align_up( frame_cnt, frame_per_block ) / frame_per_block;
+  frame_cnt             = block_cnt * frame_per_block;
+
+  int fd = socket( AF_PACKET, SOCK_RAW, 0 );
+  if( FD_UNLIKELY( fd<0 ) ) {
+    FD_LOG_WARNING(( "socket(AF_PACKET,SOCK_RAW) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    return NULL;
+  }
+
+  int version = TPACKET_V2;
+  int one     = 1;
+  if( FD_UNLIKELY( 0!=setsockopt( fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(int) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(PACKET_VERSION,TPACKET_V2) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+  if( FD_UNLIKELY( 0!=setsockopt( fd, SOL_PACKET, PACKET_LOSS, &one, sizeof(int) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(PACKET_LOSS) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+  if( qdisc_bypass &&
+      FD_UNLIKELY( 0!=setsockopt( fd, SOL_PACKET, PACKET_QDISC_BYPASS, &one, sizeof(int) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(PACKET_QDISC_BYPASS) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+
+  struct tpacket_req req = {
+    .tp_block_size = (uint)page_sz,
+    .tp_block_nr   = (uint)block_cnt,
+    .tp_frame_size = (uint)frame_sz,
+    .tp_frame_nr   = (uint)frame_cnt
+  };
+  if( FD_UNLIKELY( 0!=setsockopt( fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(struct tpacket_req) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(PACKET_TX_RING) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+
+  ulong map_sz = page_sz * block_cnt;
+  void * mem = mmap( NULL, map_sz, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, 0 );
+  if( FD_UNLIKELY( mem==MAP_FAILED ) ) {
+    FD_LOG_WARNING(( "mmap(PACKET_TX_RING,%lu) failed (%i-%s)", map_sz, errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return NULL;
+  }
+
+  /* Protocol 0: the socket transmits but never receives */
+  struct sockaddr_ll sll = {
+    .sll_family   = AF_PACKET,
+    .sll_protocol = 0,
+    .sll_ifindex  = (int)if_idx
+  };
+  if( FD_UNLIKELY( 0!=bind( fd, fd_type_pun_const( &sll ), sizeof(struct sockaddr_ll) ) ) ) {
+    FD_LOG_WARNING(( "bind(AF_PACKET,if_idx=%u) failed (%i-%s)", if_idx, errno, fd_io_strerror( errno ) ));
+    munmap( mem, map_sz );
+    close( fd );
+    return NULL;
+  }
+
+  ring->fd        = fd;
+  ring->tx_mem    = mem;
+  ring->map_sz    = map_sz;
+  ring->frame_sz  = frame_sz;
+  ring->frame_cnt = frame_cnt;
+  return ring;
+}
+
+void
+fdgen_packet_tx_ring_fini( fdgen_packet_tx_ring_t * ring ) {
+  if( ring->tx_mem ) munmap( ring->tx_mem, ring->map_sz );
+  if( ring->fd>=0  ) close( ring->fd );
+  ring->tx_mem = NULL;
+  ring->fd     = -1;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+/* fdgen_cfg_net_packet.h provides APIs for setting up AF_PACKET sockets
+   with memory-mapped rings: TPACKET_V3 block rings for receive and
+   TPACKET_V2 frame rings for transmit.  This is the fallback for hosts
+   where XDP cannot be attached (shared NICs, drivers without XDP
+   support) that still avoids one syscall per packet. */
+
+#include "fdgen_cfg_net.h"
+#include <linux/if_packet.h>  /* tpacket2_hdr */
+
+/* FDGEN_PACKET_FANOUT_{...} are the supported PACKET_FANOUT modes for
+   spreading traffic of one interface across multiple rings.
+
+   NONE does not join a fanout group.
+
+   HASH selects the ring by flow hash (PACKET_FANOUT_HASH), so all
+   packets of a flow land on the same ring.
+
+   CPU selects the ring by receiving CPU (PACKET_FANOUT_CPU).
+
+   LB selects rings round-robin (PACKET_FANOUT_LB). */
+
+#define FDGEN_PACKET_FANOUT_NONE (0)
+#define FDGEN_PACKET_FANOUT_HASH (1)
+#define FDGEN_PACKET_FANOUT_CPU  (2)
+#define FDGEN_PACKET_FANOUT_LB   (3)
+
+/* fdgen_packet_params_t configures a TPACKET_V3 ring. */
+
+struct fdgen_packet_params {
+  ulong  block_sz;     /* block size in bytes, multiple of the page size */
+  ulong  block_cnt;    /* number of blocks */
+  ulong  frame_sz;     /* max frame size in bytes (incl. TPACKET_V3 header), divides block_sz */
+  uint   retire_ms;    /* retire partially filled blocks after this many ms, 0 for kernel default */
+  int    fanout_mode;  /* FDGEN_PACKET_FANOUT_{...} */
+  ushort fanout_id;    /* fanout group id, shared by all rings of a group */
+};
+
+typedef struct fdgen_packet_params fdgen_packet_params_t;
+
+/* fdgen_packet_ring_t owns an AF_PACKET socket and its mapped RX block
+   ring. */
+
+struct fdgen_packet_ring {
+  int     fd;
+  uchar * rx_mem;     /* first block of the RX ring */
+  ulong   map_sz;     /* size of the mapping at rx_mem */
+  ulong   block_sz;
+  ulong   block_cnt;
+};
+
+typedef struct fdgen_packet_ring fdgen_packet_ring_t;
+
+/* FDGEN_PACKET_TX_DATA_OFF is the offset of frame data within a TX ring
+   slot (TPACKET_V2, no PACKET_TX_HAS_OFF). */
+
+#define FDGEN_PACKET_TX_DATA_OFF ( TPACKET_ALIGN( sizeof(struct tpacket2_hdr) ) )
+
+/* fdgen_packet_tx_ring_t owns an AF_PACKET socket and its mapped TX
+   frame ring. */
+
+struct fdgen_packet_tx_ring {
+  int     fd;
+  uchar * tx_mem;     /* first slot of the TX ring */
+  ulong   map_sz;     /* size of the mapping at tx_mem */
+  ulong   frame_sz;   /* slot size, frames carry up to frame_sz-FDGEN_PACKET_TX_DATA_OFF bytes */
+  ulong   frame_cnt;
+};
+
+typedef struct fdgen_packet_tx_ring fdgen_packet_tx_ring_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_cstr_to_packet_fanout converts "none", "hash", "cpu" or "lb" to
+   the corresponding FDGEN_PACKET_FANOUT_{...}.  Returns -1 on invalid
+   input. */
+
+int
+fdgen_cstr_to_packet_fanout( char const * cstr );
+
+/* fdgen_packet_ring_init creates an AF_PACKET socket receiving IPv4
+   frames on the interface with index if_idx, sets up and maps a
+   TPACKET_V3 RX ring according to params and joins the fanout group
+   given by params, if any.  The ring reports the flow hash of each
+   frame (TP_FT_REQ_FILL_RXHASH).  Requires CAP_NET_RAW.  Returns ring
+   on success.  On failure, releases all resources, logs warning, and
+   returns NULL. */
+
+fdgen_packet_ring_t *
+fdgen_packet_ring_init( fdgen_packet_ring_t *         ring,
+                        uint                          if_idx,
+                        fdgen_packet_params_t const * params );
+
+/* fdgen_packet_ring_fini unmaps the ring and closes the socket. */
+
+void
+fdgen_packet_ring_fini( fdgen_packet_ring_t * ring );
+
+/* fdgen_packet_tx_ring_init creates an AF_PACKET socket transmitting on
+   the interface with index if_idx and sets up and maps a TPACKET_V2 TX
+   ring of frame_cnt slots of frame_sz bytes (a power of two of at least
+   TPACKET_ALIGNMENT, at most the page size).  Frames are sent exactly
+   as written, starting at the Ethernet header.  Malformed frames are
+   discarded by the kernel instead of stalling the ring (PACKET_LOSS).
+   If qdisc_bypass, frames skip the interface's qdisc layer
+   (PACKET_QDISC_BYPASS), trading traffic control and taps for speed.
+   Requires CAP_NET_RAW.  Returns ring on success.  On failure, releases
+   all resources, logs warning, and returns NULL. */
+
+fdgen_packet_tx_ring_t *
+fdgen_packet_tx_ring_init( fdgen_packet_tx_ring_t * ring,
+                           uint                     if_idx,
+                           ulong                    frame_sz,
+                           ulong                    frame_cnt,
+                           int                      qdisc_bypass );
+
+/* fdgen_packet_tx_ring_fini unmaps the ring and closes the socket. */
+
+void
+fdgen_packet_tx_ring_fini( fdgen_packet_tx_ring_t * ring );
+
+FD_PROTOTYPES_END
@@ -5,10 +5,225 @@
 #include <assert.h>
 #include <errno.h>
 #include <sys/epoll.h>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <unistd.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+
+/* Mirror of struct epoll_params from linux/eventpoll.h (Linux 6.9+),
+   redeclared so that fdgen builds against older kernel headers. */
+
+struct fdgen_epoll_params {
+  uint   busy_poll_usecs;
+  ushort busy_poll_budget;
+  uchar  prefer_busy_poll;
+  uchar  _pad;
+};
+
+#define FDGEN_EPIOCSPARAMS _IOW( 0x8A, 0x01, struct fdgen_epoll_params )
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF (51)
+#endif
+
+/* STEER_TILE_MAX bounds the receive tiles handled by
+   fdgen_ports_socket_steer_cpu (two instructions each, plus two). */
+
+#define STEER_TILE_MAX (1024UL)
+
+int
+fdgen_cstr_to_socket_poll_mode( char const * cstr ) {
+  if( 0==strcmp( cstr, "none" ) ) return FDGEN_SOCKET_POLL_MODE_NONE;
+  if( 0==strcmp( cstr, "busy" ) ) return FDGEN_SOCKET_POLL_MODE_BUSY;
+  return -1;
+}
+
+int
+fdgen_socket_poll_valid( fdgen_socket_poll_t const * poll ) {
+
+  if( !poll || poll->mode==FDGEN_SOCKET_POLL_MODE_NONE ) return 1;
+
+  if( FD_UNLIKELY( poll->mode!=FDGEN_SOCKET_POLL_MODE_BUSY ) ) {
+    FD_LOG_WARNING(( "invalid poll mode %d", poll->mode ));
+    return 0;
+  }
+  if( FD_UNLIKELY( !poll->busy_poll_budget || poll->busy_poll_budget>FDGEN_SOCKET_BUSY_POLL_BUDGET_MAX ) ) {
+    FD_LOG_WARNING(( "busy_poll_budget %u out of range [1,%u] (NAPI_POLL_WEIGHT)",
+                     poll->busy_poll_budget, FDGEN_SOCKET_BUSY_POLL_BUDGET_MAX ));
+    return 0;
+  }
+  return 1;
+}
+
+int
+fdgen_socket_busy_poll( int                         sock_fd,
+                        fdgen_socket_poll_t const * poll ) {
+
+  if( !poll || poll->mode==FDGEN_SOCKET_POLL_MODE_NONE ) return 0;
+  if( FD_UNLIKELY( !fdgen_socket_poll_valid( poll ) ) ) return EINVAL;
+
+  int prefer_busy_poll = 1;
+  int busy_poll_usecs  = (int)poll->busy_poll_usecs;
+  int busy_poll_budget = (int)poll->busy_poll_budget;
+  if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer_busy_poll, sizeof(int) )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "setsockopt(SO_PREFER_BUSY_POLL) failed (%d-%s)", err, fd_io_strerror( err ) ));
+    return err;
+  }
+  if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_usecs, sizeof(int) )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "setsockopt(SO_BUSY_POLL,%u) failed (%d-%s)", poll->busy_poll_usecs, err, fd_io_strerror( err ) ));
+    return err;
+  }
+  if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &busy_poll_budget, sizeof(int) )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "setsockopt(SO_BUSY_POLL_BUDGET,%u) failed (%d-%s)", poll->busy_poll_budget, err, fd_io_strerror( err ) ));
+    return err;
+  }
+  return 0;
+}
+
+FD_FN_CONST ulong
+fdgen_socket_buf_sz( ulong burst,
+                     ulong mtu,
+                     ulong pkt_rate,
+                     long  drain_ns ) {
+
+  ulong pkt_cnt = 2UL*burst;
+  if( drain_ns>0L ) {
+    ulong drain_cnt = (ulong)( (double)pkt_rate * (double)drain_ns * 1e-9 );
+    pkt_cnt = fd_ulong_max( pkt_cnt, drain_cnt );
+  }
+
+  ulong truesize = mtu + FDGEN_SOCKET_SKB_OVERHEAD;
+  ulong sz;
+  if( FD_UNLIKELY( __builtin_umull_overflow( pkt_cnt, truesize, &sz ) ) ) sz = ULONG_MAX;
+  /* The kernel doubles the requested value and stores it in an int */
+  return fd_ulong_min( sz, (ulong)INT_MAX/2UL );
+}
+
+/* set_buf sets one socket buffer size, preferring the FORCE variant.
+   Logs the effective size if verbose. */
+
+static int
+set_buf( int          sock_fd,
+         int          opt_force,
+         int          opt,
+         char const * opt_name,
+         ulong        sz,
+         int          verbose ) {
+
+  if( !sz ) return 0;
+  int val = (int)fd_ulong_min( sz, (ulong)INT_MAX/2UL );
+
+  if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, opt_force, &val, sizeof(int) )<0 ) ) {
+    int err = errno;
+    if( FD_UNLIKELY( err!=EPERM ) ) {
+      FD_LOG_WARNING(( "setsockopt(%sFORCE,%d) failed (%d-%s)", opt_name, val, err, fd_io_strerror( err ) ));
+      return err;
+    }
+    if( verbose ) FD_LOG_WARNING(( "%sFORCE not permitted (missing CAP_NET_ADMIN), falling back to %s capped by sysctl", opt_name, opt_name ));
+    if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, opt, &val, sizeof(int) )<0 ) ) {
+      err = errno;
+      FD_LOG_WARNING(( "setsockopt(%s,%d) failed (%d-%s)", opt_name, val, err, fd_io_strerror( err ) ));
+      return err;
+    }
+  }
+
+  if( verbose ) {
+    int       eff     = 0;
+    socklen_t eff_len = sizeof(int);
+    if( FD_UNLIKELY( getsockopt( sock_fd, SOL_SOCKET, opt, &eff, &eff_len )<0 ) ) {
+      int err = errno;
+      FD_LOG_WARNING(( "getsockopt(%s) failed (%d-%s)", opt_name, err, fd_io_strerror( err ) ));
+      return err;
+    }
+    /* Kernel reports twice the usable size (includes bookkeeping) */
+    FD_LOG_NOTICE(( "%s requested %d bytes, effective %d bytes", opt_name, val, eff/2 ));
+    if( FD_UNLIKELY( eff/2 < val ) ) {
+      FD_LOG_WARNING(( "%s capped below requested size, expect kernel drops under load", opt_name ));
+    }
+  }
+  return 0;
+}
+
+int
+fdgen_socket_buf_apply( int                        sock_fd,
+                        fdgen_socket_buf_t const * buf,
+                        int                        verbose ) {
+  if( !buf ) return 0;
+  int err = set_buf( sock_fd, SO_RCVBUFFORCE, SO_RCVBUF, "SO_RCVBUF", buf->rcvbuf_sz, verbose );
+  if( FD_UNLIKELY( err ) ) return err;
+  return set_buf( sock_fd, SO_SNDBUFFORCE, SO_SNDBUF, "SO_SNDBUF", buf->sndbuf_sz, verbose );
+}
+
+int
+fdgen_socket_recv_addrs( int sock_fd ) {
+
+  int one = 1;
+  if( FD_UNLIKELY( setsockopt( sock_fd, IPPROTO_IP, IP_PKTINFO, &one, sizeof(int) )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "setsockopt(IP_PKTINFO) failed (%d-%s)", err, fd_io_strerror( err ) ));
+    return err;
+  }
+  if( FD_UNLIKELY( setsockopt( sock_fd, IPPROTO_IP, IP_RECVORIGDSTADDR, &one, sizeof(int) )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "setsockopt(IP_RECVORIGDSTADDR) failed (%d-%s)", err, fd_io_strerror( err ) ));
+    return err;
+  }
+  return 0;
+}
+
+int
+fdgen_socket_rxq_ovfl( int sock_fd ) {
+
+  int one = 1;
+  if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(int) )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "setsockopt(SO_RXQ_OVFL) failed (%d-%s)", err, fd_io_strerror( err ) ));
+    return err;
+  }
+  return 0;
+}
+
+int
+fdgen_socket_timestamping( int sock_fd ) {
+
+  int flags = SOF_TIMESTAMPING_RX_SOFTWARE |
+              SOF_TIMESTAMPING_SOFTWARE    |
+              SOF_TIMESTAMPING_RX_HARDWARE |
+              SOF_TIMESTAMPING_RAW_HARDWARE;
+  if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(int) )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "setsockopt(SO_TIMESTAMPING) failed (%d-%s)", err, fd_io_strerror( err ) ));
+    return err;
+  }
+  return 0;
+}
+
+int
+fdgen_socket_epoll_busy_poll( int                         epoll_fd,
+                              fdgen_socket_poll_t const * poll ) {
+
+  if( !poll || poll->mode==FDGEN_SOCKET_POLL_MODE_NONE ) return 0;
+  if( FD_UNLIKELY( !fdgen_socket_poll_valid( poll ) ) ) return EINVAL;
+
+  struct fdgen_epoll_params params = {
+    .busy_poll_usecs  = poll->busy_poll_usecs,
+    .busy_poll_budget = (ushort)poll->busy_poll_budget,
+    .prefer_busy_poll = 1
+  };
+  if( FD_UNLIKELY( ioctl( epoll_fd, FDGEN_EPIOCSPARAMS, &params )<0 ) ) {
+    int err = errno;
+    FD_LOG_WARNING(( "ioctl(EPIOCSPARAMS) failed (%d-%s)", err, fd_io_strerror( err ) ));
+    return err;
+  }
+  return 0;
+}
 
 FD_FN_CONST ulong
 fdgen_ports_socket_align( void ) {
@@ -57,6 +272,9 @@ fdgen_ports_socket_new( void * shmem,
   fdgen_ports_socket_t * ports = shmem;
   ports->sock_max = rx_cnt * port_cnt;
   ports->sock_cnt = 0UL;
+  ports->rx_cnt   = 0UL;
+  ports->skip_cnt = 0UL;
+  ports->port_lo  = 0;
 
   int * fds = fdgen_ports_socket_fds( ports );
   for( ulong j = 0UL; j < ports->sock_max; j++ ) {
@@ -96,19 +314,40 @@ fdgen_ports_socket_delete( void * mem ) {
   return mem;
 }
 
+/* create_socket creates a socket bound to listen_ip4:listen_port
+   (port in host order).  Returns the socket on success.  On failure,
+   logs warning, stores the errno in *_err, and returns -1. */
+
 static int
-create_socket( uint listen_ip4,
-               uint listen_port ) {
+create_socket( uint                        listen_ip4,
+               uint                        listen_port,
+               fdgen_socket_poll_t const * poll,
+               fdgen_socket_buf_t const *  buf,
+               int                         verbose,
+               int *                       _err ) {
 
   int sock_fd = socket( AF_INET, SOCK_DGRAM, 0 );
   if( FD_UNLIKELY( sock_fd < 0 ) ) {
-    FD_LOG_WARNING(( "socket(AF_INET, SOCK_DGRAM) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
+    *_err = errno;
+    FD_LOG_WARNING(( "socket(AF_INET, SOCK_DGRAM) failed (%d-%s)", *_err, fd_io_strerror( *_err ) ));
     return -1;
   }
 
   int reuse = 1;
   if( FD_UNLIKELY( setsockopt( sock_fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(int) ) < 0 ) ) {
-    FD_LOG_WARNING(( "setsockopt(SO_REUSEPORT) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
+    *_err = errno;
+    FD_LOG_WARNING(( "setsockopt(SO_REUSEPORT) failed (%d-%s)", *_err, fd_io_strerror( *_err ) ));
+    close( sock_fd );
+    return -1;
+  }
+
+  int err;
+  if( FD_UNLIKELY( (err = fdgen_socket_busy_poll   ( sock_fd, poll ))          ||
+                   (err = fdgen_socket_buf_apply   ( sock_fd, buf, verbose ))  ||
+                   (err = fdgen_socket_recv_addrs  ( sock_fd ))                ||
+                   (err = fdgen_socket_rxq_ovfl    ( sock_fd ))                ||
+                   (err = fdgen_socket_timestamping( sock_fd )) ) ) {
+    *_err = err;
     close( sock_fd );
     return -1;
   }
@@ -116,13 +355,14 @@ create_socket( uint listen_ip4,
   struct sockaddr_in saddr = {
     .sin_family      = AF_INET,
     .sin_addr.s_addr = listen_ip4,  /* already big endian */
-    .sin_port        = fd_ushort_bswap( listen_port )
+    .sin_port        = fd_ushort_bswap( (ushort)listen_port )
   };
 
   if( FD_UNLIKELY( bind( sock_fd, fd_type_pun( &saddr ), sizeof(struct sockaddr_in) ) < 0 ) ) {
+    *_err = errno;
     FD_LOG_WARNING(( "bind(" FD_IP4_ADDR_FMT ",%u) failed (%d-%s)",
                      FD_IP4_ADDR_FMT_ARGS( listen_ip4 ), listen_port,
-                     errno, fd_io_strerror( errno ) ));
+                     *_err, fd_io_strerror( *_err ) ));
     close( sock_fd );
     return -1;
   }
@@ -130,11 +370,100 @@ create_socket( uint listen_ip4,
   return sock_fd;
 }
 
+/* bulk_job_t is the state shared by the threads of
+   fdgen_ports_socket_init.  Ports are handed out via an atomic
+   counter. */
+
+struct bulk_job {
+  int *                       fds;
+  int *                       port_err;   /* NULL if not requested */
+  uint                        ip4;
+  ushort                      port_lo;
+  ulong                       port_cnt;
+  ulong                       rx_cnt;
+  fdgen_socket_poll_t const * poll;
+  fdgen_socket_buf_t const *  buf;
+  int                         err_mode;
+
+  ulong                       next;       /* next port index to create, atomic */
+  ulong                       skip_cnt;   /* atomic */
+  int                         abort;      /* set once init must fail */
+  int                         buf_logged; /* set while a socket logs its effective buffer sizes, atomic */
+};
+
+typedef struct bulk_job bulk_job_t;
+
+/* bulk_create_port creates the rx_cnt sockets of the port_idx-th port
+   in tile order.  On error, closes the port's sockets, leaves their
+   slots at -1, and either counts the port as skipped or flags the job
+   for abort depending on err_mode. */
+
+static void
+bulk_create_port( bulk_job_t * job,
+                  ulong        port_idx ) {
+
+  uint  port = (uint)job->port_lo + (uint)port_idx;
+  int * fds  = job->fds + port_idx*job->rx_cnt;
+  int   err  = 0;
+
+  for( ulong j=0UL; j<job->rx_cnt; j++ ) {
+    /* The first socket to be created logs the effective buffer sizes.
+       If it fails, the claim is released for the next one. */
+    int verbose = !FD_VOLATILE_CONST( job->buf_logged ) && !FD_ATOMIC_CAS( &job->buf_logged, 0, 1 );
+    int sock_fd = create_socket( job->ip4, port, job->poll, job->buf, verbose, &err );
+    if( FD_UNLIKELY( sock_fd<0 ) ) {
+      if( verbose ) FD_VOLATILE( job->buf_logged ) = 0;
+      for( ulong k=0UL; k<j; k++ ) {
+        close( fds[k] );
+        fds[k] = -1;
+      }
+      break;
+    }
+    fds[j] = sock_fd;
+  }
+
+  if( job->port_err ) job->port_err[ port_idx ] = err;
+  if( FD_LIKELY( !err ) ) return;
+
+  int skip;
+  switch( job->err_mode ) {
+  case FDGEN_PORTS_SOCKET_ERR_SKIP:    skip = err==EADDRINUSE || err==EACCES; break;
+  case FDGEN_PORTS_SOCKET_ERR_PARTIAL: skip = 1;                              break;
+  default:                             skip = 0;                              break;
+  }
+  if( skip ) {
+    FD_LOG_WARNING(( "skipping port %u (%d-%s)", port, err, fd_io_strerror( err ) ));
+    FD_ATOMIC_FETCH_AND_ADD( &job->skip_cnt, 1UL );
+  } else {
+    FD_LOG_WARNING(( "cannot create sockets for port %u (%d-%s)", port, err, fd_io_strerror( err ) ));
+    FD_VOLATILE( job->abort ) = 1;
+  }
+}
+
+static void *
+bulk_worker( void * _job ) {
+  bulk_job_t * job = _job;
+  for(;;) {
+    if( FD_UNLIKELY( FD_VOLATILE_CONST( job->abort ) ) ) break;
+    ulong port_idx = FD_ATOMIC_FETCH_AND_ADD( &job->next, 1UL );
+    if( port_idx>=job->port_cnt ) break;
+    bulk_create_port( job, port_idx );
+  }
+  return NULL;
+}
+
+/* BULK_THREAD_MAX bounds the threads used by fdgen_ports_socket_init */
+
+#define BULK_THREAD_MAX (64UL)
+
 fdgen_ports_socket_t *
-fdgen_ports_socket_init( fdgen_ports_socket_t * sockets,
-                         uint                   ip4,
-                         fdgen_port_range_t     port_range,
-                         ulong                  rx_cnt ) {
+fdgen_ports_socket_init( fdgen_ports_socket_t *      sockets,
+                         uint                        ip4,
+                         fdgen_port_range_t          port_range,
+                         ulong                       rx_cnt,
+                         fdgen_socket_poll_t const * poll,
+                         fdgen_socket_buf_t const *  buf,
+                         fdgen_socket_bulk_t const * bulk ) {
 
   ulong port_cnt = fdgen_port_cnt( &port_range );
   ulong sock_cnt;
@@ -152,22 +481,107 @@ fdgen_ports_socket_init( fdgen_ports_socket_t * sockets,
     return NULL;
   }
 
+  /* Ports left behind by an abort are never attempted */
+  if( bulk && bulk->port_err ) {
+    for( ulong j=0UL; j<port_cnt; j++ ) bulk->port_err[ j ] = ECANCELED;
+  }
+
+  ulong thread_cnt = bulk ? fd_ulong_max( bulk->thread_cnt, 1UL ) : 1UL;
+  thread_cnt       = fd_ulong_min( fd_ulong_min( thread_cnt, BULK_THREAD_MAX ), port_cnt );
+
+  sockets->rx_cnt   = rx_cnt;
+  sockets->skip_cnt = 0UL;
+  sockets->port_lo  = port_range.lo;
+
   int * fds = fdgen_ports_socket_fds( sockets );
-  for( uint port = port_range.lo; port < port_range.hi; port++ ) {
-    for( ulong j=0UL; j<rx_cnt; j++ ) {
-      int sock_fd = create_socket( ip4, port );
-      if( FD_UNLIKELY( sock_fd < 0 ) ) {
-        fdgen_ports_socket_fini( sockets );
-        return NULL;
-      }
-      fds[ sockets->sock_cnt++ ] = sock_fd;
-      assert( sockets->sock_cnt <= sockets->sock_max );
+  for( ulong j=0UL; j<sock_cnt; j++ ) fds[j] = -1;
+
+  bulk_job_t job = {
+    .fds      = fds,
+    .port_err = bulk ? bulk->port_err : NULL,
+    .ip4      = ip4,
+    .port_lo  = port_range.lo,
+    .port_cnt = port_cnt,
+    .rx_cnt   = rx_cnt,
+    .poll     = poll,
+    .buf      = buf,
+    .err_mode = bulk ? bulk->err_mode : FDGEN_PORTS_SOCKET_ERR_ABORT
+  };
+
+  /* The calling thread is worker 0.  If a thread cannot be spawned,
+     carry on with the ones that could. */
+
+  pthread_t thread[ BULK_THREAD_MAX ];
+  ulong     spawn_cnt = 0UL;
+  for( ulong j=1UL; j<thread_cnt; j++ ) {
+    int err = pthread_create( &thread[ spawn_cnt ], NULL, bulk_worker, &job );
+    if( FD_UNLIKELY( err ) ) {
+      FD_LOG_WARNING(( "pthread_create failed (%d-%s), continuing with %lu threads",
+                       err, fd_io_strerror( err ), spawn_cnt+1UL ));
+      break;
     }
+    spawn_cnt++;
+  }
+  bulk_worker( &job );
+  for( ulong j=0UL; j<spawn_cnt; j++ ) pthread_join( thread[ j ], NULL );
+
+  sockets->sock_cnt = sock_cnt;
+  sockets->skip_cnt = job.skip_cnt;
+
+  if( FD_UNLIKELY( job.abort || job.skip_cnt==port_cnt ) ) {
+    if( !job.abort ) FD_LOG_WARNING(( "all %lu ports skipped", port_cnt ));
+    fdgen_ports_socket_fini( sockets );
+    return NULL;
   }
 
+  if( job.skip_cnt ) {
+    FD_LOG_NOTICE(( "Bound %lu of %lu ports (%lu skipped)", port_cnt-job.skip_cnt, port_cnt, job.skip_cnt ));
+  }
   return sockets;
 }
 
+int
+fdgen_ports_socket_steer_cpu( fdgen_ports_socket_t const * sockets,
+                              ulong const *                tile_cpu ) {
+
+  ulong rx_cnt = sockets->rx_cnt;
+  if( FD_UNLIKELY( !rx_cnt || rx_cnt>STEER_TILE_MAX ) ) {
+    FD_LOG_WARNING(( "invalid rx_cnt %lu for CPU steering", rx_cnt ));
+    return EINVAL;
+  }
+
+  /* A = cpu; for each tile: if A==tile_cpu[j] return j; return ~0
+     The return value indexes the reuseport group in bind order.  Out of
+     range values make the kernel fall back to the flow hash. */
+
+  static FD_TL struct sock_filter insns[ 2UL*STEER_TILE_MAX+2UL ];
+  ulong insn_cnt = 0UL;
+  insns[ insn_cnt++ ] = (struct sock_filter)BPF_STMT( BPF_LD | BPF_W | BPF_ABS, (uint)( SKF_AD_OFF + SKF_AD_CPU ) );
+  for( ulong j=0UL; j<rx_cnt; j++ ) {
+    insns[ insn_cnt++ ] = (struct sock_filter)BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K, (uint)tile_cpu[ j ], 0, 1 );
+    insns[ insn_cnt++ ] = (struct sock_filter)BPF_STMT( BPF_RET | BPF_K, (uint)j );
+  }
+  insns[ insn_cnt++ ] = (struct sock_filter)BPF_STMT( BPF_RET | BPF_K, UINT_MAX );
+
+  struct sock_fprog prog = {
+    .len    = (ushort)insn_cnt,
+    .filter = insns
+  };
+
+  /* The program applies to the whole group, attach via its first socket */
+  int * fds = fdgen_ports_socket_fds( sockets );
+  for( ulong j=0UL; j<sockets->sock_cnt; j+=rx_cnt ) {
+    if( fds[j]<0 ) continue;  /* skipped port */
+    if( FD_UNLIKELY( setsockopt( fds[j], SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(struct sock_fprog) )<0 ) ) {
+      int err = errno;
+      FD_LOG_WARNING(( "setsockopt(SO_ATTACH_REUSEPORT_CBPF) failed (%d-%s)", err, fd_io_strerror( err ) ));
+      return err;
+    }
+  }
+
+  return 0;
+}
+
 void
 fdgen_ports_socket_fini( fdgen_ports_socket_t * sockets ) {
 
@@ -177,52 +591,89 @@ fdgen_ports_socket_fini( fdgen_ports_socket_t * sockets ) {
   for( ulong j=0UL; j<sock_cnt; j++ ) {
     if( fds[j] >= 0 ) {
       close( fds[j] );
+      fds[j] = -1;
     }
   }
   sockets->sock_cnt = 0UL;
 
 }
 
-int
-fdgen_ports_socket_epoll_join( fdgen_ports_socket_t const * sockets,
-                               int                          epoll_fd ) {
+/* epoll_ctl_strided adds (op EPOLL_CTL_ADD) or removes sockets
+   j0, j0+stride, ... to/from epoll_fd.  The socket index in the event
+   user data is (j-j0)/stride.  On failure to add, removes the sockets
+   added so far. */
+
+static int
+epoll_ctl_strided( fdgen_ports_socket_t const * sockets,
+                   int                          epoll_fd,
+                   int                          op,
+                   ulong                        j0,
+                   ulong                        stride ) {
 
   ulong sock_cnt = sockets->sock_cnt;
   int * fds      = fdgen_ports_socket_fds( sockets );
 
-  for( ulong j=0UL; j<sock_cnt; j++ ) {
+  /* Socket indices must fit the 16 bits of the event user data */
+  ulong idx_cnt = sock_cnt>j0 ? (sock_cnt-j0+stride-1UL)/stride : 0UL;
+  if( FD_UNLIKELY( idx_cnt>(ulong)USHORT_MAX+1UL ) ) {
+    FD_LOG_WARNING(( "%lu sockets exceed the epoll socket index range [0,%lu]", idx_cnt, (ulong)USHORT_MAX ));
+    return EINVAL;
+  }
+
+  for( ulong j=j0; j<sock_cnt; j+=stride ) {
+    if( fds[j]<0 ) continue;  /* skipped port */
+    ulong port = sockets->port_lo + j/sockets->rx_cnt;
+    ulong idx  = (j-j0)/stride;
     struct epoll_event ev = {
-      .events  = EPOLLIN,
-      .data.fd = fds[j]
+      .events   = EPOLLIN | EPOLLET,
+      .data.u64 = (ulong)(uint)fds[j] | (port<<32) | (idx<<48)
     };
-    if( FD_UNLIKELY( epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fds[j], &ev )<0 ) ) {
-      fdgen_ports_socket_epoll_leave( sockets, epoll_fd );
-      FD_LOG_WARNING(( "epoll_ctl(EPOLL_CTL_ADD) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
-      return errno;  /* FIXME does fd_log overwrite errno here? */
+    if( FD_UNLIKELY( epoll_ctl( epoll_fd, op, fds[j], &ev )<0 ) ) {
+      int err = errno;
+      FD_LOG_WARNING(( "epoll_ctl(%s) failed (%d-%s)", op==EPOLL_CTL_ADD ? "EPOLL_CTL_ADD" : "EPOLL_CTL_DEL",
+                       err, fd_io_strerror( err ) ));
+      if( op==EPOLL_CTL_ADD ) {
+        for( ulong k=j0; k<j; k+=stride ) {
+          if( fds[k]>=0 ) epoll_ctl( epoll_fd, EPOLL_CTL_DEL, fds[k], &ev );
+        }
+      }
+      return err;
     }
   }
 
   return 0;
 }
 
+int
+fdgen_ports_socket_epoll_join( fdgen_ports_socket_t const * sockets,
+                               int                          epoll_fd ) {
+  return epoll_ctl_strided( sockets, epoll_fd, EPOLL_CTL_ADD, 0UL, 1UL );
+}
+
 int
 fdgen_ports_socket_epoll_leave( fdgen_ports_socket_t const * sockets,
                                 int                          epoll_fd ) {
+  return epoll_ctl_strided( sockets, epoll_fd, EPOLL_CTL_DEL, 0UL, 1UL );
+}
 
-  ulong sock_cnt = sockets->sock_cnt;
-  int * fds      = fdgen_ports_socket_fds( sockets );
-
-  for( ulong j=0UL; j<sock_cnt; j++ ) {
-    struct epoll_event ev = {
-      .events  = EPOLLIN,
-      .data.fd = fds[j]
-    };
-
-    if( FD_UNLIKELY( epoll_ctl( epoll_fd, EPOLL_CTL_DEL, fds[j], &ev )<0 ) ) {
-      FD_LOG_WARNING(( "epoll_ctl(EPOLL_CTL_DEL) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
-      return errno;  /* FIXME does fd_log overwrite errno here? */
-    }
+int
+fdgen_ports_socket_epoll_join_tile( fdgen_ports_socket_t const * sockets,
+                                    ulong                        tile_idx,
+                                    int                          epoll_fd ) {
+  if( FD_UNLIKELY( tile_idx>=sockets->rx_cnt ) ) {
+    FD_LOG_WARNING(( "invalid tile_idx %lu (rx_cnt %lu)", tile_idx, sockets->rx_cnt ));
+    return EINVAL;
   }
+  return epoll_ctl_strided( sockets, epoll_fd, EPOLL_CTL_ADD, tile_idx, sockets->rx_cnt );
+}
 
-  return 0;
+int
+fdgen_ports_socket_epoll_leave_tile( fdgen_ports_socket_t const * sockets,
+                                     ulong                        tile_idx,
+                                     int                          epoll_fd ) {
+  if( FD_UNLIKELY( tile_idx>=sockets->rx_cnt ) ) {
+    FD_LOG_WARNING(( "invalid tile_idx %lu (rx_cnt %lu)", tile_idx, sockets->rx_cnt ));
+    return EINVAL;
+  }
+  return epoll_ctl_strided( sockets, epoll_fd, EPOLL_CTL_DEL, tile_idx, sockets->rx_cnt );
 }
@@ -5,17 +5,184 @@
 
 #include "fdgen_cfg_net.h"
 
+/* FDGEN_SOCKET_POLL_MODE_{...} are available poll modes for socket
+   mode, mirroring FDGEN_XSK_POLL_MODE_{...}.
+
+   NONE waits for interrupts and softirq processing.
+
+   BUSY sets SO_PREFER_BUSY_POLL, SO_BUSY_POLL and SO_BUSY_POLL_BUDGET
+   on every socket, so that recvmmsg(2) busy polls the device queue,
+   and sets the equivalent epoll parameters (EPIOCSPARAMS, Linux 6.9+)
+   on the RX tile's epoll fd.  Setting SO_PREFER_BUSY_POLL or
+   SO_BUSY_POLL_BUDGET, or raising SO_BUSY_POLL above the
+   net.core.busy_read sysctl, requires CAP_NET_ADMIN, so BUSY mode
+   generally needs CAP_NET_ADMIN. */
+
+#define FDGEN_SOCKET_POLL_MODE_NONE (0)
+#define FDGEN_SOCKET_POLL_MODE_BUSY (1)
+
+/* fdgen_socket_poll_t configures kernel busy polling for sockets. */
+
+struct fdgen_socket_poll {
+  int  mode;              /* FDGEN_SOCKET_POLL_MODE_{...} */
+  uint busy_poll_usecs;   /* SO_BUSY_POLL, time to busy poll per call */
+  uint busy_poll_budget;  /* SO_BUSY_POLL_BUDGET, packets per poll, in [1,FDGEN_SOCKET_BUSY_POLL_BUDGET_MAX] */
+};
+
+typedef struct fdgen_socket_poll fdgen_socket_poll_t;
+
+/* FDGEN_SOCKET_BUSY_POLL_BUDGET_MAX is the largest busy poll budget
+   accepted, the kernel's NAPI_POLL_WEIGHT.  Drivers warn about and cap
+   NAPI polls asking for more than their weight, so larger budgets do
+   not poll more packets. */
+
+#define FDGEN_SOCKET_BUSY_POLL_BUDGET_MAX (64U)
+
+/* FDGEN_SOCKET_SKB_OVERHEAD approximates the per-datagram memory the
+   kernel charges against a socket buffer beyond the payload (sk_buff
+   and skb_shared_info).  Socket buffer limits count this truesize, not
+   payload bytes. */
+
+#define FDGEN_SOCKET_SKB_OVERHEAD (640UL)
+
+/* fdgen_socket_buf_t configures socket buffer sizes in bytes.  Zero
+   keeps the system default. */
+
+struct fdgen_socket_buf {
+  ulong rcvbuf_sz;
+  ulong sndbuf_sz;
+};
+
+typedef struct fdgen_socket_buf fdgen_socket_buf_t;
+
+/* FDGEN_PORTS_SOCKET_ERR_{...} select how fdgen_ports_socket_init
+   handles ports whose sockets cannot be created.
+
+   ABORT fails the whole init on the first error.
+
+   SKIP skips ports that are unavailable (bind fails with EADDRINUSE or
+   EACCES, e.g. taken by another process or privileged) and fails on
+   any other error.
+
+   PARTIAL skips ports on any error and succeeds as long as at least
+   one port is usable. */
+
+#define FDGEN_PORTS_SOCKET_ERR_ABORT   (0)
+#define FDGEN_PORTS_SOCKET_ERR_SKIP    (1)
+#define FDGEN_PORTS_SOCKET_ERR_PARTIAL (2)
+
+/* fdgen_socket_bulk_t configures bulk socket creation. */
+
+struct fdgen_socket_bulk {
+  ulong thread_cnt;  /* threads creating sockets in parallel, 0 or 1 for the calling thread only */
+  int   err_mode;    /* FDGEN_PORTS_SOCKET_ERR_{...} */
+  int * port_err;    /* if non-NULL, receives per-port errno (0 on success, ECANCELED if not attempted), indexed by port in [0,port_cnt) */
+};
+
+typedef struct fdgen_socket_bulk fdgen_socket_bulk_t;
+
 /* fdgen_ports_socket_t owns an array of sockets. */
 
 struct fdgen_ports_socket {
-  ulong sock_max;
-  ulong sock_cnt;
+  ulong  sock_max;
+  ulong  sock_cnt;
+  ulong  rx_cnt;    /* sockets per port, set by init */
+  ulong  skip_cnt;  /* ports skipped by init, their sockets are -1 */
+  ushort port_lo;   /* port of the first socket, set by init */
 };
 
 typedef struct fdgen_ports_socket fdgen_ports_socket_t;
 
 FD_PROTOTYPES_BEGIN
 
+/* fdgen_cstr_to_socket_poll_mode converts "none" or "busy" to the
+   corresponding FDGEN_SOCKET_POLL_MODE_{...}.  Returns -1 on invalid
+   input. */
+
+int
+fdgen_cstr_to_socket_poll_mode( char const * cstr );
+
+/* fdgen_socket_poll_valid returns 1 if poll is NULL, of mode NONE, or
+   of mode BUSY with a budget in [1,FDGEN_SOCKET_BUSY_POLL_BUDGET_MAX],
+   0 otherwise (logs details). */
+
+int
+fdgen_socket_poll_valid( fdgen_socket_poll_t const * poll );
+
+/* fdgen_socket_busy_poll applies the busy poll socket options of poll
+   to sock_fd.  poll==NULL or mode NONE is a no-op.  Returns 0 on
+   success.  On failure (EINVAL if poll is not valid), logs warning and
+   returns errno-compatible error code. */
+
+int
+fdgen_socket_busy_poll( int                         sock_fd,
+                        fdgen_socket_poll_t const * poll );
+
+/* fdgen_socket_buf_sz returns a socket buffer size in bytes that holds
+   the datagrams arriving at pkt_rate (datagrams per second) during
+   drain_ns nanoseconds, the target worst case latency between two
+   drains of the socket.  At least two bursts of burst datagrams of up
+   to mtu bytes are always accommodated.  The result accounts for kernel
+   per-datagram overhead and is clamped to what setsockopt accepts. */
+
+FD_FN_CONST ulong
+fdgen_socket_buf_sz( ulong burst,
+                     ulong mtu,
+                     ulong pkt_rate,
+                     long  drain_ns );
+
+/* fdgen_socket_buf_apply sets the socket buffer sizes in buf on
+   sock_fd.  Uses SO_{RCV,SND}BUFFORCE, which bypass the
+   net.core.{r,w}mem_max limits but require CAP_NET_ADMIN.  Without the
+   capability, logs a warning and falls back to SO_{RCV,SND}BUF (the
+   kernel then silently caps the size).  If verbose, the effective sizes
+   are read back and logged.  Returns 0 on success.  On failure, logs
+   warning and returns errno-compatible error code. */
+
+int
+fdgen_socket_buf_apply( int                        sock_fd,
+                        fdgen_socket_buf_t const * buf,
+                        int                        verbose );
+
+/* fdgen_socket_recv_addrs enables IP_PKTINFO and IP_RECVORIGDSTADDR
+   on sock_fd, so that received datagrams carry their destination
+   address and port as ancillary data.  Returns 0 on success.  On
+   failure, logs warning and returns errno-compatible error code. */
+
+int
+fdgen_socket_recv_addrs( int sock_fd );
+
+/* fdgen_socket_rxq_ovfl enables SO_RXQ_OVFL on sock_fd, so that each
+   received datagram carries the socket's cumulative count of datagrams
+   dropped by the kernel as ancillary data.  Returns 0 on success.  On
+   failure, logs warning and returns errno-compatible error code. */
+
+int
+fdgen_socket_rxq_ovfl( int sock_fd );
+
+/* fdgen_socket_timestamping enables SO_TIMESTAMPING on sock_fd with
+   software RX timestamps and raw hardware RX timestamps, so that
+   received datagrams carry a SCM_TIMESTAMPING control message.
+   Hardware timestamps are only generated if the device has RX
+   timestamping enabled (SIOCSHWTSTAMP, e.g. via hwstamp_ctl), which is
+   left to the operator.  Returns 0 on success.  On failure, logs
+   warning and returns errno-compatible error code. */
+
+int
+fdgen_socket_timestamping( int sock_fd );
+
+/* fdgen_socket_epoll_busy_poll sets the busy poll parameters of poll
+   on epoll_fd, so that epoll_wait(2) busy polls the NAPI contexts of
+   the registered sockets.  poll==NULL or mode NONE is a no-op.  Returns
+   0 on success.  On failure, logs warning and returns errno-compatible
+   error code: EINVAL if poll is not valid (see fdgen_socket_poll_valid),
+   or the error of EPIOCSPARAMS, e.g. ENOTTY or EINVAL on kernels older
+   than 6.9. */
+
+int
+fdgen_socket_epoll_busy_poll( int                         epoll_fd,
+                              fdgen_socket_poll_t const * poll );
+
 /* fdgen_ports_socket_{align,footprint,new,join,leave,delete} are the
    usual Firedancer dynamic object construction API.
 
@@ -46,23 +213,79 @@ fdgen_ports_socket_delete( void * mem );
 
 /* fdgen_ports_socket_fds returns a pointer to the socket array of a
    ports object.  The array is indexed in [0,sock_max).  Only index in
-   [0,sock_cnt) are valid file descriptors. */
+   [0,sock_cnt) may hold valid file descriptors, ports skipped by init
+   hold -1.  Sockets are laid out port-major, i.e. the socket of receive
+   tile tile_idx for the port_idx-th port is at index
+   port_idx*rx_cnt + tile_idx, regardless of skipped ports. */
 
 FD_FN_CONST static inline int *
 fdgen_ports_socket_fds( fdgen_ports_socket_t const * ports ) {
   return fd_type_pun( (void *)( (ulong)ports + sizeof(fdgen_ports_socket_t) ) );
 }
 
+/* fdgen_ports_socket_shard_fd returns a bound socket that a sharded
+   transmit tile with index shard_idx may send from, such that each
+   shard uses a distinct UDP source port where possible (shards wrap
+   around if there are more shards than ports).  Skipped ports are
+   passed over.  Returns -1 if sockets holds no sockets. */
+
+static inline int
+fdgen_ports_socket_shard_fd( fdgen_ports_socket_t const * ports,
+                             ulong                        shard_idx ) {
+  ulong rx_cnt   = ports->rx_cnt;
+  ulong port_cnt = rx_cnt ? ports->sock_cnt / rx_cnt : 0UL;
+  int const * fds = fdgen_ports_socket_fds( ports );
+  for( ulong j=0UL; j<port_cnt; j++ ) {
+    int fd = fds[ ((shard_idx+j) % port_cnt) * rx_cnt ];
+    if( FD_LIKELY( fd>=0 ) ) return fd;
+  }
+  return -1;
+}
+
 /* fdgen_ports_socket_init creates an array of sockets.  Each port in
-   the port range will share rx_cnt sockets with SO_REUSEPORT.  Returns
-   sockets on success.  On failure, closes all sockets created so far,
-   logs warning, and returns NULL. */
+   the port range will share rx_cnt sockets with SO_REUSEPORT.  Each
+   socket is configured with the busy poll settings in poll (NULL for
+   none) and the buffer sizes in buf (NULL for system defaults, the
+   effective sizes of the first socket created are logged, even if
+   earlier ports were skipped).  Each socket also
+   reports destination addresses, kernel drop counts and RX timestamps
+   (see fdgen_socket_{recv_addrs,rxq_ovfl,timestamping}).
+
+   bulk (NULL for serial creation that aborts on any error) spreads
+   socket creation over multiple threads and selects how per-port
+   errors are handled.  Each port is handled by a single thread, so the
+   sockets of a port are always bound in tile order.  Every failing
+   port is logged with its error.  Skipped ports keep their slots
+   (holding -1) so the layout stays port-major.  If bulk->port_err is
+   set, every entry is written, also on failure: ports that were not
+   attempted because another port aborted init report ECANCELED.
+
+   Returns sockets on success.  On failure, closes all sockets created
+   so far, logs warning, and returns NULL. */
 
 fdgen_ports_socket_t *
-fdgen_ports_socket_init( fdgen_ports_socket_t * sockets,
-                         uint                   ip4,
-                         fdgen_port_range_t     port_range,
-                         ulong                  rx_cnt );
+fdgen_ports_socket_init( fdgen_ports_socket_t *      sockets,
+                         uint                        ip4,
+                         fdgen_port_range_t          port_range,
+                         ulong                       rx_cnt,
+                         fdgen_socket_poll_t const * poll,
+                         fdgen_socket_buf_t const *  buf,
+                         fdgen_socket_bulk_t const * bulk );
+
+/* fdgen_ports_socket_steer_cpu attaches a classic BPF program to the
+   SO_REUSEPORT group of every port (SO_ATTACH_REUSEPORT_CBPF) that
+   delivers each datagram to the socket of the receive tile pinned to
+   the CPU that processed the datagram in softirq context, so that
+   packet data stays in that CPU's cache.  tile_cpu[tile_idx] is the
+   CPU of each receive tile in [0,rx_cnt).  Datagrams processed on any
+   other CPU fall back to the kernel's flow hash.  Relies on the
+   sockets of each port being bound in tile order, as done by
+   fdgen_ports_socket_init.  Returns 0 on success.  On failure, logs
+   warning and returns errno-compatible error code. */
+
+int
+fdgen_ports_socket_steer_cpu( fdgen_ports_socket_t const * sockets,
+                              ulong const *                tile_cpu );
 
 /* fdgen_ports_socket_fini closes all sockets. */
 
@@ -70,8 +293,15 @@ void
 fdgen_ports_socket_fini( fdgen_ports_socket_t * sockets );
 
 /* fdgen_ports_socket_epoll_{join,leaves} adds or removes all sockets to
-   the epoll file descriptor with event listener EPOLLIN.   Returns 0 on
-   success.  On failure, returns errno-compatible error code. */
+   the epoll file descriptor with event listener EPOLLIN|EPOLLET
+   (edge-triggered).  The event user data holds the socket fd in the
+   low 32 bits, the bound UDP port in the next 16 bits and the socket
+   index in [0,sock_cnt) in the top 16 bits (matching
+   fdgen_tile_net_dgram_epoll_data_t).  Consumers must drain a socket
+   until EAGAIN before expecting another event for it, and should size
+   their event arrays to sock_cnt.  Fails with EINVAL if there are more
+   than USHORT_MAX+1 sockets to add.  Returns 0 on success.  On failure,
+   returns errno-compatible error code. */
 
 int
 fdgen_ports_socket_epoll_join( fdgen_ports_socket_t const * sockets,
@@ -81,4 +311,19 @@ int
 fdgen_ports_socket_epoll_leave( fdgen_ports_socket_t const * sockets,
                                 int                          epoll_fd );
 
+/* fdgen_ports_socket_epoll_{join,leave}_tile are the above restricted
+   to the sockets owned by receive tile tile_idx in [0,rx_cnt), one per
+   port.  The socket index in the event user data is the port index in
+   [0,port_cnt), so the tile's socket_max is port_cnt. */
+
+int
+fdgen_ports_socket_epoll_join_tile( fdgen_ports_socket_t const * sockets,
+                                    ulong                        tile_idx,
+                                    int                          epoll_fd );
+
+int
+fdgen_ports_socket_epoll_leave_tile( fdgen_ports_socket_t const * sockets,
+                                     ulong                        tile_idx,
+                                     int                          epoll_fd );
+
 FD_PROTOTYPES_END
@@ -5,6 +5,7 @@
 #include <firedancer/util/net/fd_ip4.h>
 
 #include <errno.h>       /* errno(3) */
+#include <string.h>      /* strlen(3) */
 #include <sched.h>       /* unshare(2) */
 #include <fcntl.h>       /* open(2) */
 #include <unistd.h>      /* close(2) */
@@ -18,6 +19,7 @@
 #include <linux/if_arp.h>           /* ARPHRD_NETROM */
 #include <linux/if_link.h>          /* IFLA_{...} */
 #include <linux/netlink.h>          /* NLM_{...} */
+#include <linux/pkt_sched.h>        /* TC_H_{...} */
 #include <linux/rtnetlink.h>        /* RTM_{...} */
 #include <linux/veth.h>             /* VETH_{...} */
 
@@ -454,6 +456,213 @@ fdgen_netlink_link_up( int  netlink,
   return 0;
 }
 
+/* fdgen_netlink_qdisc_replace creates or replaces the qdisc attached
+   to parent on the interface with index if_idx with a qdisc of the
+   given kind and handle (0 to let the kernel assign one).  Returns 0 on
+   success.  On failure, logs warning and returns -1. */
+
+static int
+fdgen_netlink_qdisc_replace( int          netlink,
+                             uint         if_idx,
+                             uint         parent,
+                             uint         handle,
+                             char const * kind ) {
+
+  /* Assemble netlink message: Replace qdisc (RTM_NEWQDISC) */
+
+  do {
+    uchar   req_buf[ 1024 ] = {0};
+    uchar * end = req_buf + sizeof(req_buf);
+
+#   define BOUNDS_CHECK( ptr ) \
+      if( FD_UNLIKELY( (ulong)(ptr) >= (ulong)end ) ) return fdgen_netlink_chk_fail()
+
+    struct nlmsghdr * nlh = fd_type_pun( req_buf );
+    BOUNDS_CHECK( nlh+1 );
+
+    nlh->nlmsg_type  = RTM_NEWQDISC;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE;
+    nlh->nlmsg_seq   = (uint)fd_tickcount();
+
+    struct tcmsg * tcm = NLMSG_DATA( nlh );
+    BOUNDS_CHECK( tcm+1 );
+
+    tcm->tcm_family  = AF_UNSPEC;
+    tcm->tcm_ifindex = (int)if_idx;
+    tcm->tcm_handle  = handle;
+    tcm->tcm_parent  = parent;
+
+    /* RTM_NEWQDISC -> TCA_KIND */
+
+    ulong kind_sz = strlen( kind )+1UL;
+    struct rtattr * rta = fd_type_pun( (uchar *)tcm + NLMSG_ALIGN( sizeof(struct tcmsg) ) );
+    BOUNDS_CHECK( (ulong)rta + NLA_HDRLEN + kind_sz );
+
+    rta->rta_type = TCA_KIND;
+    rta->rta_len  = (ushort)( NLA_HDRLEN + kind_sz );
+    fd_memcpy( RTA_DATA( rta ), kind, kind_sz );
+
+    /* Set netlink message len */
+
+    ulong nlh_tot_sz = (ulong)rta + RTA_ALIGN( rta->rta_len ) - (ulong)req_buf;
+    if( FD_UNLIKELY( nlh_tot_sz > UINT_MAX ) ) return fdgen_netlink_chk_fail();
+    nlh->nlmsg_len = (uint)nlh_tot_sz;
+
+    /* Send netlink message */
+
+#   undef BOUNDS_CHECK
+    FD_LOG_HEXDUMP_DEBUG(( "NETLINK_ROUTE RTM_NEWQDISC req", nlh, nlh->nlmsg_len ));
+
+    if( FD_UNLIKELY( send( netlink, nlh, nlh->nlmsg_len, 0 )<0 ) ) {
+      FD_LOG_WARNING(( "send(RTM_NEWQDISC) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
+      return -1;
+    }
+  } while(0);
+
+  /* Read response */
+
+  do {
+    uchar res_buf[ 1024 ] = {0};
+    long res_sz = recv( netlink, res_buf, sizeof(res_buf), 0 );
+    if( FD_UNLIKELY( res_sz<0L ) ) {
+      FD_LOG_WARNING(( "recv(AF_NETLINK) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
+      return -1;
+    }
+    uchar const * end = res_buf + res_sz;
+
+    FD_LOG_HEXDUMP_DEBUG(( "NETLINK_ROUTE RTM_NEWQDISC resp", res_buf, res_sz ));
+
+    struct nlmsghdr const * nlh = fd_type_pun_const( res_buf );
+    FD_TEST( (ulong)(nlh+1) <= (ulong)end );
+
+    if( FD_UNLIKELY( nlh->nlmsg_type != NLMSG_ERROR ) ) {
+      FD_LOG_WARNING(( "Unexpected netlink message type (%d)", nlh->nlmsg_type ));
+      return -1;
+    }
+
+    struct nlmsgerr const * nle = NLMSG_DATA( nlh );
+    FD_TEST( (ulong)(nle+1) <= (ulong)end );
+
+    if( FD_UNLIKELY( nle->error != 0 ) ) {
+      FD_LOG_WARNING(( "RTM_NEWQDISC(%s,parent %x:%x) failed (%d-%s)", kind, TC_H_MAJ( parent )>>16, TC_H_MIN( parent ),
+                       nle->error, fd_io_strerror( -nle->error ) ));
+      return -1;
+    }
+  } while(0);
+
+  return 0;
+}
+
+/* fdgen_netlink_tx_queue_cnt returns the number of TX queues of the
+   interface with index if_idx (IFLA_NUM_TX_QUEUES).  On failure, logs
+   warning and returns -1. */
+
+static long
+fdgen_netlink_tx_queue_cnt( int  netlink,
+                            uint if_idx ) {
+
+  /* Assemble netlink message: Get link (RTM_GETLINK) */
+
+  do {
+    uchar req_buf[ 1024 ] = {0};
+
+    struct nlmsghdr * nlh = fd_type_pun( req_buf );
+
+    nlh->nlmsg_type  = RTM_GETLINK;
+    nlh->nlmsg_flags = NLM_F_REQUEST;
+    nlh->nlmsg_len   = NLMSG_LENGTH( sizeof(struct ifinfomsg) );
+    nlh->nlmsg_seq   = (uint)fd_tickcount();
+
+    struct ifinfomsg * ifi = NLMSG_DATA( nlh );
+
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_index  = (int)if_idx;
+
+    FD_LOG_HEXDUMP_DEBUG(( "NETLINK_ROUTE RTM_GETLINK req", nlh, nlh->nlmsg_len ));
+
+    if( FD_UNLIKELY( send( netlink, nlh, nlh->nlmsg_len, 0 )<0 ) ) {
+      FD_LOG_WARNING(( "send(RTM_GETLINK) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
+      return -1L;
+    }
+  } while(0);
+
+  /* Read response.  Link messages carry stats and per-family config,
+     hence the larger buffer. */
+
+  do {
+    uchar res_buf[ 16384 ] = {0};
+    long res_sz = recv( netlink, res_buf, sizeof(res_buf), 0 );
+    if( FD_UNLIKELY( res_sz<0L ) ) {
+      FD_LOG_WARNING(( "recv(AF_NETLINK) failed (%d-%s)", errno, fd_io_strerror( errno ) ));
+      return -1L;
+    }
+    uchar const * end = res_buf + res_sz;
+
+    FD_LOG_HEXDUMP_DEBUG(( "NETLINK_ROUTE RTM_GETLINK resp", res_buf, res_sz ));
+
+    struct nlmsghdr const * nlh = fd_type_pun_const( res_buf );
+    FD_TEST( (ulong)(nlh+1) <= (ulong)end );
+
+    if( FD_UNLIKELY( nlh->nlmsg_type == NLMSG_ERROR ) ) {
+      struct nlmsgerr const * nle = NLMSG_DATA( nlh );
+      FD_TEST( (ulong)(nle+1) <= (ulong)end );
+      FD_LOG_WARNING(( "RTM_GETLINK(%u) failed (%d-%s)", if_idx, nle->error, fd_io_strerror( -nle->error ) ));
+      return -1L;
+    }
+    if( FD_UNLIKELY( nlh->nlmsg_type != RTM_NEWLINK ) ) {
+      FD_LOG_WARNING(( "Unexpected netlink message type (%d)", nlh->nlmsg_type ));
+      return -1L;
+    }
+    FD_TEST( (ulong)nlh + nlh->nlmsg_len <= (ulong)end );
+
+    struct ifinfomsg const * ifi = NLMSG_DATA( nlh );
+    int                      len = (int)IFLA_PAYLOAD( nlh );
+    for( struct rtattr const * rta = IFLA_RTA( ifi ); RTA_OK( rta, len ); rta = RTA_NEXT( rta, len ) ) {
+      if( rta->rta_type == IFLA_NUM_TX_QUEUES && RTA_PAYLOAD( rta ) >= sizeof(uint) ) {
+        return (long)FD_LOAD( uint, RTA_DATA( rta ) );
+      }
+    }
+    FD_LOG_WARNING(( "RTM_GETLINK(%u) response lacks IFLA_NUM_TX_QUEUES", if_idx ));
+  } while(0);
+
+  return -1L;
+}
+
+/* FDGEN_NETLINK_MQ_HANDLE is the handle (1:) of the mq root qdisc
+   installed by fdgen_netlink_qdisc_fq on multi-queue devices */
+
+#define FDGEN_NETLINK_MQ_HANDLE (0x10000U)
+
+int
+fdgen_netlink_qdisc_fq( int  netlink,
+                        uint if_idx ) {
+
+  long txq_cnt = fdgen_netlink_tx_queue_cnt( netlink, if_idx );
+  if( FD_UNLIKELY( txq_cnt<0L ) ) return -1;
+
+  /* Single queue devices get fq as the root qdisc */
+
+  if( txq_cnt<=1L ) {
+    if( FD_UNLIKELY( fdgen_netlink_qdisc_replace( netlink, if_idx, TC_H_ROOT, 0U, "fq" ) ) ) return -1;
+    FD_LOG_NOTICE(( "Replaced root qdisc of interface %u with fq", if_idx ));
+    return 0;
+  }
+
+  /* Multi-queue devices keep a mq root, so that each TX queue keeps its
+     own qdisc and lock, and get one fq per TX queue under it */
+
+  if( FD_UNLIKELY( txq_cnt>(long)TC_H_MIN_MASK ) ) {
+    FD_LOG_WARNING(( "interface %u has too many TX queues (%ld)", if_idx, txq_cnt ));
+    return -1;
+  }
+  if( FD_UNLIKELY( fdgen_netlink_qdisc_replace( netlink, if_idx, TC_H_ROOT, FDGEN_NETLINK_MQ_HANDLE, "mq" ) ) ) return -1;
+  for( uint q=0U; q<(uint)txq_cnt; q++ ) {
+    if( FD_UNLIKELY( fdgen_netlink_qdisc_replace( netlink, if_idx, TC_H_MAKE( FDGEN_NETLINK_MQ_HANDLE, q+1U ), 0U, "fq" ) ) ) return -1;
+  }
+  FD_LOG_NOTICE(( "Installed fq on the %ld TX queues of interface %u under a mq root (handle 1:)", txq_cnt, if_idx ));
+  return 0;
+}
+
 /* fdgen_nlctrl_get_ethtool queries the ID of the ethtool netlink
    family.  Why are these IDs variable?  sigh ... */
 
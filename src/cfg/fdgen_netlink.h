@@ -33,6 +33,22 @@ int
 fdgen_netlink_create_veth_pair( int                 netlink,
                                 fdgen_veth_params_t params[2] );
 
+/* fdgen_netlink_qdisc_fq installs the fq (Fair Queue) packet scheduler
+   on the interface with index if_idx.  fq honors the earliest departure
+   times set via SO_TXTIME, which paces socket transmission in the
+   kernel.  On a single queue device, fq replaces the root qdisc.  On a
+   multi-queue device, the root is replaced with mq (handle 1:) and
+   each TX queue gets its own fq child, so queues keep independent
+   locks instead of collapsing into a single root qdisc.  Any existing
+   root qdisc configuration is discarded; the change is logged.
+   netlink is a socket of type NETLINK_ROUTE.  Requires CAP_NET_ADMIN.
+   Returns 0 on success.  On failure, logs error details to warning log
+   and returns -1 (the device may be left with a partial setup). */
+
+int
+fdgen_netlink_qdisc_fq( int  netlink,
+                        uint if_idx );
+
 /* fdgen_create_veth_env is a convenience function to set up two network
    namespaces with a veth each.  env->{rx,tx}_queue_count specify the
    queue counts of the veth devices.  env->params is populated with
@@ -0,0 +1,499 @@
+#include "fdgen_tile_gen.h"
+
+#include <firedancer/tango/fd_tango_base.h>
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+
+/* GEN_WAIT_MAX bounds the ticks until the next frame is due.  Used as
+   the inverse refill rate of silent segments. */
+
+#define GEN_WAIT_MAX (1e18)
+
+/* gen_due returns the tick at which both token buckets will hold the
+   tokens needed for the next frame at the current refill rates. */
+
+static inline long
+gen_due( long   now,
+         double pkt_tok,
+         double pkt_need,
+         double tick_per_pkt,
+         double bit_tok,
+         double bit_need,
+         double tick_per_bit ) {
+  double wait = 0.0;
+  if( pkt_tok<pkt_need ) { double w = ( pkt_need-pkt_tok ) * tick_per_pkt; wait = w>wait ? w : wait; }
+  if( bit_tok<bit_need ) { double w = ( bit_need-bit_tok ) * tick_per_bit; wait = w>wait ? w : wait; }
+  wait = wait<GEN_WAIT_MAX ? wait : GEN_WAIT_MAX;
+  return now + (long)wait;
+}
+
+/* gen_seg_end returns the end tick of a segment of dur_ns starting at
+   tick start, saturating for segments that last forever. */
+
+static inline long
+gen_seg_end( long   start,
+             long   dur_ns,
+             double tick_per_ns ) {
+  double dur = (double)dur_ns * tick_per_ns;
+  return dur<GEN_WAIT_MAX ? start + (long)dur : LONG_MAX;
+}
+
+int
+fdgen_tile_gen_run( fdgen_tile_gen_cfg_t * cfg ) {
+
+  if( FD_UNLIKELY( !cfg ) ) { FD_LOG_WARNING(( "NULL cfg" )); return 1; }
+
+  /* load config */
+
+  ulong            orig        = cfg->orig;
+  long             lazy        = cfg->lazy;
+  double           tick_per_ns = cfg->tick_per_ns;
+  ulong            mtu         = cfg->mtu;
+  fd_cnc_t *       cnc         = cfg->cnc;
+  fd_frag_meta_t * mcache      = cfg->mcache;
+  uchar *          dcache      = cfg->dcache;
+  uchar *          base        = cfg->base;
+  fd_rng_t *       rng         = cfg->rng;
+  ulong            pkt_sz      = cfg->pkt_sz;
+  ulong            wire_ovh    = cfg->wire_overhead;
+
+  /* cnc state */
+  fdgen_tile_gen_diag_t * cnc_diag;
+  ulong cnc_diag_pub_cnt;
+  ulong cnc_diag_pub_sz;
+  ulong cnc_diag_sz_cnt[ FDGEN_TILE_GEN_SZ_BIN_CNT ];
+  ulong jit_sum_tick;   /* pacing delays since last housekeeping */
+  long  jit_max_tick;   /* largest pacing delay since boot */
+
+  /* out frag stream state */
+  ulong   depth;
+  ulong * sync;
+  ulong   seq;
+  ulong   chunk0;
+  ulong   wmark;
+  ulong   chunk;
+
+  /* housekeeping state */
+  ulong async_min; /* minimum number of ticks between processing a housekeeping event, positive integer power of 2 */
+
+  /* token bucket state.  Costs are zero for unlimited buckets, so their
+     checks always pass. */
+  double base_pkt_per_tick;  /* pps bucket refill rate at scale 1 */
+  double base_bit_per_tick;  /* bps bucket refill rate at scale 1 */
+  double pkt_per_tick;       /* pps bucket refill rate of the current segment */
+  double bit_per_tick;       /* bps bucket refill rate of the current segment */
+  double tick_per_pkt;       /* inverse refill rates, GEN_WAIT_MAX if unlimited or silent */
+  double tick_per_bit;
+  double pkt_unit;           /* pps tokens per packet, 0 if unlimited */
+  double pkt_cost;           /* pps tokens per frame at multiplier 1 */
+  double bit_cost;           /* bps tokens per frame at multiplier 1 */
+  double pkt_need;           /* pps tokens needed by the next frame */
+  double bit_need;           /* bps tokens needed by the next frame */
+  double pkt_cap;            /* pps bucket depth */
+  double bit_cap;            /* bps bucket depth */
+  double pkt_tok;
+  double bit_tok;
+  long   due;                /* tick at which the next frame became eligible */
+
+  /* shape state */
+  fdgen_tile_gen_shape_seg_t const * seg;
+  ulong                              seg_cnt;
+  ulong                              seg_idx;
+  long                               seg_end;   /* tick at which the current segment ends */
+  int                                seg_repeat;
+  double const *                     mul;       /* frame cost multipliers */
+  ulong                              mul_mask;
+
+  /* frame template */
+  fdgen_tile_gen_tmpl_t         tmpl[1];
+  fdgen_tile_gen_flow_set_t     flows[1];  /* local copy, the permutation position is per tile */
+  fdgen_tile_gen_size_t const * size;      /* frame size distribution, NULL for pkt_sz */
+  int                           udp_check;
+
+  /* frame pool state */
+  fdgen_tile_gen_pool_t const * pool;
+  ulong                         pool_idx;    /* next frame */
+  int                           pool_flows;  /* 1 to patch pool frames with the flow set */
+  ulong                         pool_tag;    /* offset of the per-packet tag in pool frames, 0 for none */
+  ulong                         frame_sz;    /* size of the next frame */
+  double                        bit_per_b;   /* bps tokens per frame byte, 0 if unlimited */
+
+  /* shred stream state */
+  fdgen_tile_gen_shred_t * shred;            /* NULL if disabled */
+  fdgen_tile_gen_shred_t   _shred[1];        /* local copy, the stream position is per tile */
+  ulong                    shred_burst_cnt;  /* shreds per burst, 0 to pace shreds individually */
+  double                   shred_burst_sz;   /* bytes per burst incl. headers and wire_overhead */
+
+  do {
+
+    FD_LOG_INFO(( "Booting gen" ));
+
+    /* cnc state init */
+
+    if( FD_UNLIKELY( !cnc ) ) { FD_LOG_WARNING(( "NULL cnc" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<sizeof(fdgen_tile_gen_diag_t) ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_signal_query( cnc )!=FD_CNC_SIGNAL_BOOT ) ) { FD_LOG_WARNING(( "already booted" )); return 1; }
+
+    cnc_diag = fd_cnc_app_laddr( cnc );
+
+    cnc_diag_pub_cnt = 0UL;
+    cnc_diag_pub_sz  = 0UL;
+    jit_sum_tick     = 0UL;
+    jit_max_tick     = 0L;
+    for( ulong b=0UL; b<FDGEN_TILE_GEN_SZ_BIN_CNT; b++ ) cnc_diag_sz_cnt[ b ] = 0UL;
+
+    cnc_diag->tgt_pps = cfg->pps;
+    cnc_diag->tgt_bps = cfg->bps;
+
+    /* out frag stream init */
+
+    if( FD_UNLIKELY( !mcache ) ) { FD_LOG_WARNING(( "NULL mcache" )); return 1; }
+    depth = fd_mcache_depth( mcache );
+    sync  = fd_mcache_seq_laddr( mcache );
+    seq   = fd_mcache_seq_query( sync );
+
+    if( FD_UNLIKELY( !dcache ) ) { FD_LOG_WARNING(( "NULL dcache" )); return 1; }
+    if( FD_UNLIKELY( !base   ) ) { FD_LOG_WARNING(( "NULL base"   )); return 1; }
+    if( FD_UNLIKELY( !fd_dcache_compact_is_safe( base, dcache, mtu, depth ) ) ) {
+      FD_LOG_WARNING(( "dcache not compatible with wksp base and mcache depth" ));
+      return 1;
+    }
+    chunk0 = fd_dcache_compact_chunk0( base, dcache );
+    wmark  = fd_dcache_compact_wmark ( base, dcache, mtu );
+    chunk  = chunk0;
+
+    /* frame pool init.  Frames that get patched must have plain
+       Ethernet/IPv4/UDP headers. */
+
+    pool       = cfg->pool;
+    pool_idx   = 0UL;
+    pool_flows = !!cfg->flows;
+    pool_tag   = cfg->pool_tag_off;
+    udp_check  = cfg->udp_check;
+    size       = NULL;
+    ulong sz_max;
+    shred           = NULL;
+    shred_burst_cnt = 0UL;
+    shred_burst_sz  = 0.0;
+    if( pool ) {
+      if( FD_UNLIKELY( cfg->shred           ) ) { FD_LOG_WARNING(( "pool and shred are exclusive" )); return 1; }
+      if( FD_UNLIKELY( !pool->frame_cnt     ) ) { FD_LOG_WARNING(( "empty pool" )); return 1; }
+      if( FD_UNLIKELY( pool->sz_max>mtu     ) ) { FD_LOG_WARNING(( "pool frame of %lu bytes exceeds mtu %lu", pool->sz_max, mtu )); return 1; }
+      if( FD_UNLIKELY( pool_tag && pool_tag<FDGEN_TILE_GEN_TMPL_SZ ) ) { FD_LOG_WARNING(( "pool_tag_off %lu within headers", pool_tag )); return 1; }
+      ulong sz_min = pool_tag ? pool_tag+8UL : FDGEN_TILE_GEN_TMPL_SZ;
+      for( ulong j=0UL; j<pool->frame_cnt && ( pool_flows | udp_check | !!pool_tag ); j++ ) {
+        uchar const *        frame   = fdgen_tile_gen_pool_frame( pool, j );
+        fd_eth_hdr_t const * eth_hdr = fd_type_pun_const( frame    );
+        fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( frame+14 );
+        if( FD_UNLIKELY( ( fdgen_tile_gen_pool_sz( pool, j )<sz_min                            ) |
+                         ( eth_hdr->net_type!=fd_ushort_bswap( FD_ETH_HDR_TYPE_IP )             ) |
+                         ( ip4_hdr->verihl!=FD_IP4_VERIHL( 4, 5 )                                ) |
+                         ( ip4_hdr->protocol!=FD_IP4_HDR_PROTOCOL_UDP                            ) ) ) {
+          FD_LOG_WARNING(( "pool frame %lu is not an Ethernet/IPv4/UDP frame without IP options of at least %lu bytes", j, sz_min ));
+          return 1;
+        }
+      }
+      sz_max   = pool->sz_max;
+      frame_sz = fdgen_tile_gen_pool_sz( pool, 0UL );
+      FD_LOG_INFO(( "Configuring frame pool (%lu frames, %lu bytes)", pool->frame_cnt, pool->sz_sum ));
+    } else if( cfg->shred ) {
+      shred    = _shred;
+      *shred   = *cfg->shred;
+      sz_max   = FDGEN_TILE_GEN_TMPL_SZ + FDGEN_SHRED_SZ_MAX;
+      frame_sz = FDGEN_TILE_GEN_TMPL_SZ + fdgen_tile_gen_shred_sz( shred );
+      if( FD_UNLIKELY( sz_max>mtu ) ) { FD_LOG_WARNING(( "shred frames of %lu bytes exceed mtu %lu", sz_max, mtu )); return 1; }
+      shred_burst_cnt = fdgen_tile_gen_shred_burst_cnt( shred );
+      shred_burst_sz  = (double)( fdgen_tile_gen_shred_burst_sz( shred ) + shred_burst_cnt*( FDGEN_TILE_GEN_TMPL_SZ + wire_ovh ) );
+      FD_LOG_INFO(( "Configuring shreds (slot %lu, %lu+%lu per FEC set, %lu shreds per burst)",
+                    shred->slot, shred->data_cnt, shred->code_cnt, shred_burst_cnt ));
+    } else if( cfg->size ) {
+      size = cfg->size;
+      if( FD_UNLIKELY( !size->cnt || size->cnt>FDGEN_TILE_GEN_SIZE_CNT_MAX ) ) {
+        FD_LOG_WARNING(( "size table of %lu entries out of range [1,%lu]", size->cnt, FDGEN_TILE_GEN_SIZE_CNT_MAX ));
+        return 1;
+      }
+      if( FD_UNLIKELY( size->sz_min<FDGEN_TILE_GEN_PKT_SZ_MIN ) ) {
+        FD_LOG_WARNING(( "frame size %lu below min %lu", size->sz_min, FDGEN_TILE_GEN_PKT_SZ_MIN ));
+        return 1;
+      }
+      if( FD_UNLIKELY( size->sz_max>mtu ) ) { FD_LOG_WARNING(( "frame size %lu exceeds mtu %lu", size->sz_max, mtu )); return 1; }
+      sz_max   = size->sz_max;
+      frame_sz = fdgen_tile_gen_size_sample( size, rng );
+      FD_LOG_INFO(( "Configuring frame sizes (%lu entries, sizes [%lu,%lu], average %.1f)",
+                    size->cnt, size->sz_min, size->sz_max, size->sz_avg ));
+    } else {
+      if( FD_UNLIKELY( pkt_sz<FDGEN_TILE_GEN_PKT_SZ_MIN || pkt_sz>mtu || pkt_sz>14UL+USHORT_MAX ) ) {
+        FD_LOG_WARNING(( "pkt_sz %lu out of range [%lu,%lu]", pkt_sz, FDGEN_TILE_GEN_PKT_SZ_MIN, mtu ));
+        return 1;
+      }
+      sz_max   = pkt_sz;
+      frame_sz = pkt_sz;
+    }
+
+    /* housekeeping init */
+
+    if( lazy<=0L ) lazy = fd_tempo_lazy_default( depth );
+    FD_LOG_INFO(( "Configuring housekeeping (lazy %li ns)", lazy ));
+
+    async_min = fd_tempo_async_min( lazy, 1UL /*event_cnt*/, (float)tick_per_ns );
+    if( FD_UNLIKELY( !async_min ) ) { FD_LOG_WARNING(( "bad lazy" )); return 1; }
+
+    /* shape init.  Without a shape, run at scale 1 forever. */
+
+    static fdgen_tile_gen_shape_seg_t const const_seg[1] = {{ .dur_ns = LONG_MAX, .scale = 1.0 }};
+    static double                     const const_mul[1] = { 1.0 };
+
+    fdgen_tile_gen_shape_t const * shape = cfg->shape;
+    double mul_max;
+    if( shape ) {
+      if( FD_UNLIKELY( !shape->seg_cnt || shape->seg_cnt>FDGEN_TILE_GEN_SHAPE_SEG_MAX ) ) { FD_LOG_WARNING(( "bad shape" )); return 1; }
+      seg        = shape->seg;
+      seg_cnt    = shape->seg_cnt;
+      seg_repeat = shape->repeat;
+      mul        = shape->mul;
+      mul_mask   = shape->mul_mask;
+      mul_max    = shape->mul_max;
+    } else {
+      seg        = const_seg;
+      seg_cnt    = 1UL;
+      seg_repeat = 0;
+      mul        = const_mul;
+      mul_mask   = 0UL;
+      mul_max    = 1.0;
+    }
+    seg_idx = 0UL;
+
+    /* token bucket init */
+
+    ulong  burst      = fd_ulong_max( cfg->burst, 1UL );
+    double tick_per_s = tick_per_ns*1e9;
+    double scale      = seg[0].scale;
+    base_pkt_per_tick = (double)cfg->pps / tick_per_s;
+    base_bit_per_tick = (double)cfg->bps / tick_per_s;
+    pkt_per_tick      = base_pkt_per_tick * scale;
+    bit_per_tick      = base_bit_per_tick * scale;
+    tick_per_pkt      = pkt_per_tick>0.0 ? 1.0/pkt_per_tick : GEN_WAIT_MAX;
+    tick_per_bit      = bit_per_tick>0.0 ? 1.0/bit_per_tick : GEN_WAIT_MAX;
+    pkt_unit          = cfg->pps ? 1.0 : 0.0;
+    pkt_cost          = pkt_unit;
+    bit_per_b         = cfg->bps ? 8.0 : 0.0;
+    bit_cost          = bit_per_b * (double)( frame_sz + wire_ovh );
+    double cap_mul    = (double)burst>mul_max ? (double)burst : mul_max;  /* the costliest frame must fit */
+    pkt_cap           = cap_mul * pkt_unit;
+    bit_cap           = cap_mul * bit_per_b * (double)( sz_max + wire_ovh );
+    if( shred_burst_cnt ) {
+      /* The first shred of a burst pays for all of it */
+      pkt_cost  = pkt_unit  * (double)shred_burst_cnt;
+      bit_cost  = bit_per_b * shred_burst_sz;
+      pkt_cap   = fd_double_max( pkt_cap, mul_max*pkt_cost );
+      bit_cap   = fd_double_max( bit_cap, mul_max*bit_cost );
+    }
+    double m          = mul[ fd_rng_uint( rng ) & mul_mask ];
+    pkt_need          = pkt_cost * m;
+    bit_need          = bit_cost * m;
+    pkt_tok           = scale>0.0 ? pkt_need : 0.0;  /* first frame leaves immediately */
+    bit_tok           = scale>0.0 ? bit_need : 0.0;
+
+    if( FD_UNLIKELY( shape && !cfg->pps && !cfg->bps ) ) { FD_LOG_WARNING(( "shape requires pps or bps" )); return 1; }
+
+    FD_LOG_INFO(( "Configuring pacing (pps %lu, bps %lu, burst %lu, pkt_sz %lu, wire_overhead %lu)",
+                  cfg->pps, cfg->bps, burst, sz_max, wire_ovh ));
+
+    /* frame template init */
+
+    fdgen_tile_gen_tmpl_init( tmpl, cfg->src_mac, cfg->dst_mac, cfg->src_ip, cfg->dst_ip, cfg->dst_port, 64 );
+
+    /* flow set init.  Without a flow set, send the single flow of the
+       config. */
+
+    if( cfg->flows ) {
+      flows[0] = *cfg->flows;
+    } else {
+      fdgen_tile_gen_flow_params_t flow_params = {
+        .src_ip   = cfg->src_ip,
+        .src_port = cfg->src_port,
+        .dst_ip   = cfg->dst_ip,
+        .dst_port = cfg->dst_port
+      };
+      if( FD_UNLIKELY( !fdgen_tile_gen_flow_set_init( flows, &flow_params, 0UL ) ) ) return 1;
+    }
+    FD_LOG_INFO(( "Configuring %lu flows", flows->flow_cnt ));
+
+    /* Zero the frame memory once so that only the headers and the tag
+       need to be written per frame */
+
+    fd_memset( dcache, 0, fd_dcache_data_sz( dcache ) );
+
+  } while(0);
+
+  FD_LOG_INFO(( "Running gen (orig %lu)", orig ));
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+  long  then    = fd_tickcount();
+  long  now     = then;
+  long  run0    = then;   /* tick of RUN, for achieved rates */
+  long  last    = then;   /* tick of last bucket refill */
+  ulong tot_cnt = 0UL;    /* frames published since RUN */
+  ulong tot_sz  = 0UL;    /* bytes published since RUN (incl. wire_overhead) */
+  due     = now;
+  seg_end = gen_seg_end( now, seg[0].dur_ns, tick_per_ns );
+  for(;;) {
+    now = fd_tickcount();
+
+    /* Do housekeeping at a low rate in the background */
+
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
+      /* Publish flow control info */
+      fd_mcache_seq_update( sync, seq );
+
+      /* Send diagnostic info */
+      tot_cnt += cnc_diag_pub_cnt;
+      tot_sz  += cnc_diag_pub_sz + cnc_diag_pub_cnt*wire_ovh;
+      double run_ns = fd_ulong_max( (ulong)( (double)( now-run0 ) / tick_per_ns ), 1UL );
+
+      fd_cnc_heartbeat( cnc, now );
+      FD_COMPILER_MFENCE();
+      cnc_diag->pub_cnt    += cnc_diag_pub_cnt;
+      cnc_diag->pub_sz     += cnc_diag_pub_sz;
+      cnc_diag->act_pps     = (ulong)( (double)tot_cnt     * 1e9 / run_ns );
+      cnc_diag->act_bps     = (ulong)( (double)tot_sz * 8. * 1e9 / run_ns );
+      cnc_diag->jit_sum_ns += (ulong)( (double)jit_sum_tick / tick_per_ns );
+      cnc_diag->jit_max_ns  = (ulong)( (double)jit_max_tick / tick_per_ns );
+      for( ulong b=0UL; b<FDGEN_TILE_GEN_SZ_BIN_CNT; b++ ) cnc_diag->sz_cnt[ b ] += cnc_diag_sz_cnt[ b ];
+      FD_COMPILER_MFENCE();
+      cnc_diag_pub_cnt = 0UL;
+      cnc_diag_pub_sz  = 0UL;
+      jit_sum_tick     = 0UL;
+      for( ulong b=0UL; b<FDGEN_TILE_GEN_SZ_BIN_CNT; b++ ) cnc_diag_sz_cnt[ b ] = 0UL;
+
+      /* Receive command-and-control signals */
+      ulong s = fd_cnc_signal_query( cnc );
+      if( FD_UNLIKELY( s!=FD_CNC_SIGNAL_RUN ) ) {
+        if( FD_LIKELY( s==FD_CNC_SIGNAL_HALT ) ) break;
+        fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+      }
+
+      /* Reload housekeeping timer */
+      then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
+
+    /* Refill token buckets */
+
+    double dt = (double)( now-last );
+    last    = now;
+    pkt_tok = pkt_tok + dt*pkt_per_tick;  pkt_tok = pkt_tok<pkt_cap ? pkt_tok : pkt_cap;
+    bit_tok = bit_tok + dt*bit_per_tick;  bit_tok = bit_tok<bit_cap ? bit_tok : bit_cap;
+
+    /* Advance the shape to the next segment */
+
+    if( FD_UNLIKELY( (now-seg_end)>=0L ) ) {
+      seg_idx++;
+      if( FD_LIKELY( seg_idx<seg_cnt ) ) {
+        seg_end = gen_seg_end( seg_end, seg[ seg_idx ].dur_ns, tick_per_ns );
+      } else if( seg_repeat ) {
+        seg_idx = 0UL;
+        seg_end = gen_seg_end( seg_end, seg[ 0 ].dur_ns, tick_per_ns );
+      } else {
+        seg_idx = seg_cnt-1UL;
+        seg_end = LONG_MAX;
+      }
+      double scale = seg[ seg_idx ].scale;
+      pkt_per_tick = base_pkt_per_tick * scale;
+      bit_per_tick = base_bit_per_tick * scale;
+      tick_per_pkt = pkt_per_tick>0.0 ? 1.0/pkt_per_tick : GEN_WAIT_MAX;
+      tick_per_bit = bit_per_tick>0.0 ? 1.0/bit_per_tick : GEN_WAIT_MAX;
+      if( (pkt_tok<pkt_need) | (bit_tok<bit_need) ) {
+        due = gen_due( now, pkt_tok, pkt_need, tick_per_pkt, bit_tok, bit_need, tick_per_bit );
+      }
+    }
+
+    if( FD_UNLIKELY( (pkt_tok<pkt_need) | (bit_tok<bit_need) ) ) {
+      FD_SPIN_PAUSE();
+      continue;
+    }
+
+    /* Account the delay between eligibility and publication */
+
+    long jit = now - due;
+    if( FD_LIKELY( jit>0L ) ) {
+      jit_sum_tick += (ulong)jit;
+      jit_max_tick  = fd_long_max( jit_max_tick, jit );
+    }
+
+    /* Write and publish the frame */
+
+    uchar * pkt = fd_chunk_to_laddr( base, chunk );
+    ulong   sz  = frame_sz;
+    ulong   sig;  /* flow index (pool frame index for unpatched pool frames), lets consumers shard by flow */
+    fdgen_tile_gen_flow_t flow;
+    if( pool ) {
+      fd_memcpy( pkt, fdgen_tile_gen_pool_frame( pool, pool_idx ), sz );
+      sig = pool_idx;
+      if( pool_flows ) {
+        sig = fdgen_tile_gen_flow_next( flows, &flow );
+        fdgen_tile_gen_frame_patch_flow( pkt, &flow );
+      }
+      if( pool_tag ) FD_STORE( ulong, pkt+pool_tag, seq );
+      /* A captured checksum is stale once the frame is tagged, and must
+         be cleared before it is recomputed */
+      if( udp_check | !!pool_tag ) ( (fd_udp_hdr_t *)( pkt+34 ) )->check = 0;
+      pool_idx++;
+      if( pool_idx>=pool->frame_cnt ) pool_idx = 0UL;
+      frame_sz = fdgen_tile_gen_pool_sz( pool, pool_idx );
+      bit_cost = bit_per_b * (double)( frame_sz + wire_ovh );
+    } else if( shred ) {
+      sig = fdgen_tile_gen_flow_next( flows, &flow );
+      ulong shred_sz = fdgen_tile_gen_shred_next( shred, pkt+FDGEN_TILE_GEN_TMPL_SZ );
+      fdgen_tile_gen_tmpl_write_flow( pkt, tmpl, &flow, (ushort)seq, shred_sz );
+      frame_sz = FDGEN_TILE_GEN_TMPL_SZ + fdgen_tile_gen_shred_sz( shred );
+      if( shred_burst_cnt ) {
+        int first = fdgen_tile_gen_shred_burst_first( shred );
+        pkt_cost  = first ? pkt_unit  * (double)shred_burst_cnt : 0.0;
+        bit_cost  = first ? bit_per_b * shred_burst_sz          : 0.0;
+      } else {
+        bit_cost  = bit_per_b * (double)( frame_sz + wire_ovh );
+      }
+    } else {
+      sig = fdgen_tile_gen_flow_next( flows, &flow );
+      fdgen_tile_gen_tmpl_write_flow( pkt, tmpl, &flow, (ushort)seq, sz-FDGEN_TILE_GEN_TMPL_SZ );
+      FD_STORE( ulong, pkt+FDGEN_TILE_GEN_TMPL_SZ, seq );
+      if( size ) {
+        frame_sz = fdgen_tile_gen_size_sample( size, rng );
+        bit_cost = bit_per_b * (double)( frame_sz + wire_ovh );
+      }
+    }
+    if( udp_check ) fdgen_udp4_check_fill( fd_type_pun_const( pkt+14 ), fd_type_pun( pkt+34 ), sz-34UL );
+
+    ulong ctl = fd_frag_meta_ctl( orig, 1 /* som */, 1 /* eom */, 0 /* err */ );
+    ulong ts  = fd_frag_meta_ts_comp( now );
+    fd_mcache_publish( mcache, depth, seq, sig, chunk, sz, ctl, ts, ts );
+
+    chunk = fd_dcache_compact_next( chunk, sz, chunk0, wmark );
+    seq   = fd_seq_inc( seq, 1UL );
+    cnc_diag_pub_cnt++;
+    cnc_diag_pub_sz += sz;
+    cnc_diag_sz_cnt[ fdgen_tile_gen_sz_bin( sz ) ]++;
+
+    /* Spend tokens, draw the cost of the next frame and derive when it
+       becomes eligible */
+
+    pkt_tok -= pkt_need;
+    bit_tok -= bit_need;
+    double m  = mul[ fd_rng_uint( rng ) & mul_mask ];
+    pkt_need  = pkt_cost * m;
+    bit_need  = bit_cost * m;
+    due       = gen_due( now, pkt_tok, pkt_need, tick_per_pkt, bit_tok, bit_need, tick_per_bit );
+  }
+
+  do {
+
+    fd_mcache_seq_update( sync, seq );
+
+    FD_LOG_INFO(( "Halted gen" ));
+    fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
+
+  } while(0);
+
+  return 0;
+}
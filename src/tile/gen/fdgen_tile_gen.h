@@ -0,0 +1,164 @@
+#pragma once
+
+/* The gen tile is a rate-controlled packet source.  It publishes
+   Ethernet/IPv4/UDP frames into an mcache/dcache pair at a configured
+   packet rate and/or bit rate, for consumption by a transmit tile
+   (net_dgram_tx, net_packet_tx, ...).
+
+   Pacing uses two token buckets refilled from fd_tickcount(): one
+   counting packets (pps), one counting bits (bps).  A frame is
+   published once both buckets hold enough tokens for it.  Token
+   arithmetic is done in ticks, so the schedule resolution is that of
+   the tick counter (well below a microsecond), not that of the
+   housekeeping interval.  Buckets hold at most burst frames worth of
+   tokens: a tile that fell behind catches up with at most burst
+   back-to-back frames, older credit is forfeited.
+
+   An optional shape (fdgen_tile_gen_shape.h) modulates the rates over
+   time (ramps, on/off bursts, Poisson arrivals, replayed curves).  The
+   shape is precomputed, the hot loop only checks for the end of the
+   current segment and looks up the cost of the next frame.
+
+   Headers are written from a template built at boot
+   (fdgen_tile_gen_tmpl.h).  The IP ID is the low 16 bits of the frame's
+   seq number, its IPv4 checksum is updated incrementally.  The first 8
+   bytes of the UDP payload carry the seq number (little endian).  The
+   rest of the payload is unspecified: it is not rewritten per frame,
+   so it holds whatever earlier frames left in the dcache (with varying
+   sizes, their headers and tags).  This layout applies to tagged
+   frames only, pool and shred frames are described below.  Addresses
+   and ports cycle through the flow set in pseudo-random order
+   (fdgen_tile_gen_flow.h), the frag sig is the flow index.  With
+   udp_check, the UDP checksum of each frame is computed with the SIMD
+   kernels of fdgen_csum.h.  The mcache is in unreliable mode: the tile
+   does not wait for consumers.
+
+   With a frame pool (fdgen_tile_gen_pool.h), frames are copied from
+   the pool in order instead, pkt_sz is ignored and bps pacing accounts
+   for the size of each frame.  Pool frames are sent verbatim unless a
+   flow set is given, in which case their addresses and ports are
+   replaced by those of the next flow.  The frag sig is the flow index,
+   or the pool frame index for verbatim frames.  With pool_tag_off, the
+   sequence number is also stored into each frame at that offset, which
+   makes every packet unique (e.g. the nonce or amount field of a
+   pre-signed payload, whose signature no longer verifies).  The
+   captured UDP checksum of a pool frame is recomputed with udp_check,
+   and cleared if the frame is patched or tagged without udp_check.
+
+   With a shred stream (fdgen_tile_gen_shred.h), the UDP payload of
+   each frame is the next shred of the stream instead of the seq tag,
+   pkt_sz is ignored and bps pacing accounts for the size of each
+   shred.  With FEC set bursts, the token buckets are charged per burst
+   on its first shred.
+
+   With a size distribution (fdgen_tile_gen_size.h), the size of each
+   tagged frame is drawn from it instead of pkt_sz (fixed, uniform,
+   IMIX or weighted table).  The size of the next frame is drawn right
+   after a publication, so bps pacing charges each frame its own size.
+
+   The cnc diag reports the target rates, the achieved rates since
+   RUN, the pacing jitter, i.e. the delay between the moment a frame
+   became eligible under the token buckets and its publication, and a
+   histogram of published frame sizes (all modes). */
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/util/fd_util_base.h>
+#include "fdgen_tile_gen_shape.h"
+#include "fdgen_tile_gen_tmpl.h"
+#include "fdgen_tile_gen_pool.h"
+#include "fdgen_tile_gen_shred.h"
+#include "fdgen_tile_gen_size.h"
+#include "../../util/fdgen_csum.h"
+
+/* FDGEN_TILE_GEN_PKT_SZ_MIN is the smallest supported frame size:
+   Ethernet, IPv4 and UDP headers plus the seq tag. */
+
+#define FDGEN_TILE_GEN_PKT_SZ_MIN (FDGEN_TILE_GEN_TMPL_SZ+8UL)
+
+/* FDGEN_TILE_GEN_WIRE_OVERHEAD is the per-frame Ethernet overhead not
+   covered by the frame bytes (preamble, SFD, FCS, inter-frame gap).
+   Pass it as wire_overhead to pace bps at the line rate. */
+
+#define FDGEN_TILE_GEN_WIRE_OVERHEAD (24UL)
+
+/* FDGEN_TILE_GEN_SZ_BIN_CNT is the number of frame size histogram bins
+   in the diag.  Bins are the RMON frame size ranges, on frame sizes
+   excl. the FCS: [0,64), [64,128), [128,256), [256,512), [512,1024),
+   [1024,1515) and [1515,inf). */
+
+#define FDGEN_TILE_GEN_SZ_BIN_CNT (7UL)
+
+struct fdgen_tile_gen_diag {
+  ulong pub_cnt;
+  ulong pub_sz;
+  ulong tgt_pps;      /* configured packet rate (at shape scale 1), 0 if unlimited */
+  ulong tgt_bps;      /* configured bit rate (at shape scale 1), 0 if unlimited */
+  ulong act_pps;      /* achieved packet rate since RUN */
+  ulong act_bps;      /* achieved bit rate since RUN (incl. wire_overhead) */
+  ulong jit_sum_ns;   /* sum of pacing delays */
+  ulong jit_max_ns;   /* largest pacing delay */
+  ulong sz_cnt[ FDGEN_TILE_GEN_SZ_BIN_CNT ];  /* frames published per size bin */
+};
+
+typedef struct fdgen_tile_gen_diag fdgen_tile_gen_diag_t;
+
+/* fdgen_tile_gen_cfg_t holds config and local joins required by the
+   gen tile. */
+
+struct fdgen_tile_gen_cfg {
+
+  ulong            orig;
+  long             lazy;
+  double           tick_per_ns;
+  ulong            mtu;
+
+  fd_cnc_t *       cnc;
+  fd_frag_meta_t * mcache;  /* gen -> tx frags */
+  uchar *          dcache;  /* frame memory */
+  uchar *          base;    /* frag base pointer */
+  fd_rng_t *       rng;
+
+  ulong  pps;            /* packets per second, 0 for unlimited */
+  ulong  bps;            /* bits per second, 0 for unlimited */
+  ulong  burst;          /* bucket depth in frames, 0 for 1 */
+  ulong  wire_overhead;  /* bytes added to each frame for bps accounting */
+
+  fdgen_tile_gen_shape_t const * shape;  /* rate profile, NULL for constant rate */
+
+  ulong  pkt_sz;         /* frame size incl. Ethernet header, in [FDGEN_TILE_GEN_PKT_SZ_MIN,mtu], ignored with a pool, shreds or sizes */
+  uchar  src_mac[ 6 ];
+  uchar  dst_mac[ 6 ];
+  uint   src_ip;         /* net order */
+  uint   dst_ip;         /* net order */
+  ushort src_port;       /* host order */
+  ushort dst_port;       /* host order */
+
+  fdgen_tile_gen_flow_set_t const * flows;  /* flow set, NULL for the single flow src_ip:src_port -> dst_ip:dst_port */
+  int    udp_check;      /* 1 to fill UDP checksums, 0 to leave them absent */
+
+  fdgen_tile_gen_pool_t const * pool;  /* pre-serialized frames, NULL to build frames from the template */
+  ulong  pool_tag_off;   /* offset of an 8 byte per-packet tag in pool frames (past the UDP header), 0 for none */
+
+  fdgen_tile_gen_shred_t const * shred;  /* shred stream at its start, NULL for tagged frames, exclusive with pool */
+  fdgen_tile_gen_size_t const *  size;   /* tagged frame size distribution, NULL for pkt_sz, ignored with a pool or shreds */
+
+};
+
+typedef struct fdgen_tile_gen_cfg fdgen_tile_gen_cfg_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_sz_bin returns the diag histogram bin of a frame of
+   sz bytes */
+
+FD_FN_CONST static inline ulong
+fdgen_tile_gen_sz_bin( ulong sz ) {
+  return (ulong)( (sz>=64UL) + (sz>=128UL) + (sz>=256UL) + (sz>=512UL) + (sz>=1024UL) + (sz>=1515UL) );
+}
+
+/* fdgen_tile_gen_run enters the tile main loop. */
+
+int
+fdgen_tile_gen_run( fdgen_tile_gen_cfg_t * cfg );
+
+FD_PROTOTYPES_END
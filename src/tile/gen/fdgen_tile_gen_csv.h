@@ -0,0 +1,20 @@
+#pragma once
+
+/* fdgen_tile_gen_csv.h provides helpers shared by the CSV parsers of
+   the gen tile (shapes and size tables). */
+
+#include <firedancer/util/fd_util_base.h>
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_csv_end returns 1 if a CSV field parsed up to end is
+   properly terminated, i.e. followed by blanks, then a comma or the
+   end of the line, and 0 if trailing garbage follows (e.g. "100x"). */
+
+static inline int
+fdgen_tile_gen_csv_end( char const * end ) {
+  while( *end==' ' || *end=='\t' ) end++;
+  return *end==',' || *end=='\n' || *end=='\r' || *end=='\0';
+}
+
+FD_PROTOTYPES_END
@@ -0,0 +1,56 @@
+#include "fdgen_tile_gen_flow.h"
+#include <firedancer/util/fd_util.h>
+
+fdgen_tile_gen_flow_set_t *
+fdgen_tile_gen_flow_set_init( fdgen_tile_gen_flow_set_t *          set,
+                              fdgen_tile_gen_flow_params_t const * params,
+                              ulong                                seed ) {
+
+  ulong base[ FDGEN_TILE_GEN_FLOW_DIM_CNT ] = {
+    [ FDGEN_TILE_GEN_FLOW_DIM_SRC_IP   ] = fd_uint_bswap( params->src_ip ),
+    [ FDGEN_TILE_GEN_FLOW_DIM_SRC_PORT ] = params->src_port,
+    [ FDGEN_TILE_GEN_FLOW_DIM_DST_IP   ] = fd_uint_bswap( params->dst_ip ),
+    [ FDGEN_TILE_GEN_FLOW_DIM_DST_PORT ] = params->dst_port
+  };
+  ulong cnt[ FDGEN_TILE_GEN_FLOW_DIM_CNT ] = {
+    [ FDGEN_TILE_GEN_FLOW_DIM_SRC_IP   ] = fd_ulong_max( params->src_ip_cnt,   1UL ),
+    [ FDGEN_TILE_GEN_FLOW_DIM_SRC_PORT ] = fd_ulong_max( params->src_port_cnt, 1UL ),
+    [ FDGEN_TILE_GEN_FLOW_DIM_DST_IP   ] = fd_ulong_max( params->dst_ip_cnt,   1UL ),
+    [ FDGEN_TILE_GEN_FLOW_DIM_DST_PORT ] = fd_ulong_max( params->dst_port_cnt, 1UL )
+  };
+  ulong lim[ FDGEN_TILE_GEN_FLOW_DIM_CNT ] = {
+    [ FDGEN_TILE_GEN_FLOW_DIM_SRC_IP   ] = 1UL<<32,
+    [ FDGEN_TILE_GEN_FLOW_DIM_SRC_PORT ] = 1UL<<16,
+    [ FDGEN_TILE_GEN_FLOW_DIM_DST_IP   ] = 1UL<<32,
+    [ FDGEN_TILE_GEN_FLOW_DIM_DST_PORT ] = 1UL<<16
+  };
+
+  ulong flow_cnt = 1UL;
+  for( ulong d=0UL; d<FDGEN_TILE_GEN_FLOW_DIM_CNT; d++ ) {
+    if( FD_UNLIKELY( base[ d ]+cnt[ d ]>lim[ d ] ) ) {
+      FD_LOG_WARNING(( "flow range %lu wraps (base %lu cnt %lu)", d, base[ d ], cnt[ d ] ));
+      return NULL;
+    }
+    if( FD_UNLIKELY( cnt[ d ]>FDGEN_TILE_GEN_FLOW_CNT_MAX/flow_cnt ) ) {
+      FD_LOG_WARNING(( "more than %lu flows", FDGEN_TILE_GEN_FLOW_CNT_MAX ));
+      return NULL;
+    }
+    flow_cnt *= cnt[ d ];
+
+    set->base[ d ] = (uint)base[ d ];
+    set->cnt [ d ] = cnt[ d ];
+    set->rcp [ d ] = cnt[ d ]>1UL ? ULONG_MAX/cnt[ d ] + 1UL : 0UL;
+  }
+
+  ulong pow2 = fd_ulong_pow2_up( flow_cnt );
+  int   k    = fd_ulong_find_msb( pow2 );
+
+  set->flow_cnt = flow_cnt;
+  set->mask     = pow2-1UL;
+  set->shift    = k/2 + 1;
+  set->key      =   fd_ulong_hash( seed                        ) & set->mask;
+  set->mul0     = ( fd_ulong_hash( seed ^ 0x9e3779b97f4a7c15UL ) | 1UL ) & set->mask;
+  set->mul1     = ( fd_ulong_hash( seed ^ 0xc2b2ae3d27d4eb4fUL ) | 1UL ) & set->mask;
+  set->ctr      = 0UL;
+  return set;
+}
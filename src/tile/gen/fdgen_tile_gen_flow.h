@@ -0,0 +1,136 @@
+#pragma once
+
+/* fdgen_tile_gen_flow.h provides flow sets for packet sources.
+
+   A flow set is the cross product of ranges of source IPs, source
+   ports, destination IPs and destination ports, up to 2^32 flows.
+   Spreading traffic over many flows exercises RSS queue selection and
+   flow tables of the device under test.
+
+   Flows are visited in a pseudo-random order without per-flow state:
+   a counter over the next power of two above the flow count is passed
+   through a keyed bijective mixer (xor, odd multiply and xorshift
+   rounds modulo 2^k) and outputs beyond the flow count are skipped
+   (cycle walking, less than two steps on average).  Every flow is
+   visited exactly once per period.  The flow index is decoded into
+   per-dimension indices with multiply-high reciprocals instead of
+   divisions, so picking the next flow is O(1) and allocation-free.
+
+   Dimension parameters are kept as parallel arrays indexed by
+   FDGEN_TILE_GEN_FLOW_DIM_*. */
+
+#include <firedancer/util/fd_util_base.h>
+
+#define FDGEN_TILE_GEN_FLOW_DIM_SRC_IP   (0)
+#define FDGEN_TILE_GEN_FLOW_DIM_SRC_PORT (1)
+#define FDGEN_TILE_GEN_FLOW_DIM_DST_IP   (2)
+#define FDGEN_TILE_GEN_FLOW_DIM_DST_PORT (3)
+#define FDGEN_TILE_GEN_FLOW_DIM_CNT      (4)
+
+/* FDGEN_TILE_GEN_FLOW_CNT_MAX is the max number of flows in a set */
+
+#define FDGEN_TILE_GEN_FLOW_CNT_MAX (1UL<<32)
+
+/* fdgen_tile_gen_flow_t is one flow (5-tuple with UDP implied) */
+
+struct fdgen_tile_gen_flow {
+  uint   src_ip;    /* net order */
+  uint   dst_ip;    /* net order */
+  ushort src_port;  /* host order */
+  ushort dst_port;  /* host order */
+};
+
+typedef struct fdgen_tile_gen_flow fdgen_tile_gen_flow_t;
+
+/* fdgen_tile_gen_flow_params_t describes the ranges of a flow set.  A
+   range starts at the given address or port and spans cnt consecutive
+   values (0 is treated as 1). */
+
+struct fdgen_tile_gen_flow_params {
+  uint   src_ip;        /* net order */
+  ulong  src_ip_cnt;
+  ushort src_port;      /* host order */
+  ulong  src_port_cnt;
+  uint   dst_ip;        /* net order */
+  ulong  dst_ip_cnt;
+  ushort dst_port;      /* host order */
+  ulong  dst_port_cnt;
+};
+
+typedef struct fdgen_tile_gen_flow_params fdgen_tile_gen_flow_params_t;
+
+struct fdgen_tile_gen_flow_set {
+
+  /* per dimension, indexed by FDGEN_TILE_GEN_FLOW_DIM_* */
+  uint  base[ FDGEN_TILE_GEN_FLOW_DIM_CNT ];  /* first value (host order) */
+  ulong cnt [ FDGEN_TILE_GEN_FLOW_DIM_CNT ];  /* range size */
+  ulong rcp [ FDGEN_TILE_GEN_FLOW_DIM_CNT ];  /* floor((2^64-1)/cnt)+1, 0 for cnt 1 */
+
+  ulong flow_cnt;  /* product of cnt */
+  ulong mask;      /* next power of two >= flow_cnt, minus one */
+  int   shift;     /* xorshift distance of the mixer */
+  ulong key;       /* mixer constants, derived from the seed */
+  ulong mul0;
+  ulong mul1;
+  ulong ctr;       /* position in the permutation */
+
+};
+
+typedef struct fdgen_tile_gen_flow_set fdgen_tile_gen_flow_set_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_flow_set_init initializes a flow set covering params.
+   seed selects the permutation.  Returns set on success, NULL on
+   failure (logs details). */
+
+fdgen_tile_gen_flow_set_t *
+fdgen_tile_gen_flow_set_init( fdgen_tile_gen_flow_set_t *          set,
+                              fdgen_tile_gen_flow_params_t const * params,
+                              ulong                                seed );
+
+/* fdgen_tile_gen_flow_mix is the keyed bijection on [0,mask] */
+
+FD_FN_PURE static inline ulong
+fdgen_tile_gen_flow_mix( fdgen_tile_gen_flow_set_t const * set,
+                         ulong                             x ) {
+  ulong mask = set->mask;
+  x  = ( x ^ set->key  ) & mask;
+  x  = ( x * set->mul0 ) & mask;
+  x ^= x >> set->shift;
+  x  = ( x * set->mul1 ) & mask;
+  x ^= x >> set->shift;
+  return x;
+}
+
+/* fdgen_tile_gen_flow_next stores the next flow of set into flow and
+   returns its index in [0,flow_cnt). */
+
+static inline ulong
+fdgen_tile_gen_flow_next( fdgen_tile_gen_flow_set_t * set,
+                          fdgen_tile_gen_flow_t *     flow ) {
+
+  ulong idx;
+  do {
+    idx = fdgen_tile_gen_flow_mix( set, set->ctr++ );
+  } while( FD_UNLIKELY( idx>=set->flow_cnt ) );
+
+  /* Mixed radix decode, idx < 2^32 so the reciprocals are exact */
+  uint  v[ FDGEN_TILE_GEN_FLOW_DIM_CNT ];
+  ulong rem = idx;
+  for( ulong d=0UL; d<FDGEN_TILE_GEN_FLOW_DIM_CNT; d++ ) {
+    ulong cnt = set->cnt[ d ];
+    ulong rcp = set->rcp[ d ];
+    ulong q   = rcp ? (ulong)( ( (uint128)rcp * (uint128)rem )>>64 ) : rem;
+    v[ d ]    = set->base[ d ] + (uint)( rem - q*cnt );
+    rem       = q;
+  }
+
+  flow->src_ip   = fd_uint_bswap( v[ FDGEN_TILE_GEN_FLOW_DIM_SRC_IP   ] );
+  flow->dst_ip   = fd_uint_bswap( v[ FDGEN_TILE_GEN_FLOW_DIM_DST_IP   ] );
+  flow->src_port = (ushort)v[ FDGEN_TILE_GEN_FLOW_DIM_SRC_PORT ];
+  flow->dst_port = (ushort)v[ FDGEN_TILE_GEN_FLOW_DIM_DST_PORT ];
+  return idx;
+}
+
+FD_PROTOTYPES_END
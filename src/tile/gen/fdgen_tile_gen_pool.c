@@ -0,0 +1,57 @@
+#include "fdgen_tile_gen_pool.h"
+#include <firedancer/util/fd_util.h>
+#include <firedancer/tango/fd_tango_base.h>
+
+static ulong
+pool_data_off( ulong frame_max ) {
+  return fd_ulong_align_up( sizeof(fdgen_tile_gen_pool_t) + frame_max*sizeof(ushort), FD_CHUNK_ALIGN );
+}
+
+FD_FN_CONST ulong
+fdgen_tile_gen_pool_align( void ) {
+  return FDGEN_TILE_GEN_POOL_ALIGN;
+}
+
+FD_FN_CONST ulong
+fdgen_tile_gen_pool_footprint( ulong frame_max,
+                               ulong mtu ) {
+  if( FD_UNLIKELY( !frame_max || !mtu || mtu>USHORT_MAX ) ) return 0UL;
+  ulong stride = fd_ulong_align_up( mtu, FD_CHUNK_ALIGN );
+  if( FD_UNLIKELY( frame_max>( ULONG_MAX>>1 )/stride ) ) return 0UL;
+  return fd_ulong_align_up( pool_data_off( frame_max ) + frame_max*stride, FDGEN_TILE_GEN_POOL_ALIGN );
+}
+
+fdgen_tile_gen_pool_t *
+fdgen_tile_gen_pool_new( void * mem,
+                         ulong  frame_max,
+                         ulong  mtu ) {
+
+  if( FD_UNLIKELY( !mem ) ) { FD_LOG_WARNING(( "NULL mem" )); return NULL; }
+  if( FD_UNLIKELY( !fd_ulong_is_aligned( (ulong)mem, FDGEN_TILE_GEN_POOL_ALIGN ) ) ) { FD_LOG_WARNING(( "misaligned mem" )); return NULL; }
+  if( FD_UNLIKELY( !fdgen_tile_gen_pool_footprint( frame_max, mtu ) ) ) {
+    FD_LOG_WARNING(( "invalid pool (frame_max %lu, mtu %lu)", frame_max, mtu ));
+    return NULL;
+  }
+
+  fdgen_tile_gen_pool_t * pool = mem;
+  pool->frame_cnt = 0UL;
+  pool->frame_max = frame_max;
+  pool->stride    = fd_ulong_align_up( mtu, FD_CHUNK_ALIGN );
+  pool->sz_max    = 0UL;
+  pool->sz_sum    = 0UL;
+  pool->data_off  = pool_data_off( frame_max );
+  return pool;
+}
+
+uchar *
+fdgen_tile_gen_pool_append( fdgen_tile_gen_pool_t * pool,
+                            ulong                   sz ) {
+  if( FD_UNLIKELY( pool->frame_cnt>=pool->frame_max ) ) return NULL;
+  if( FD_UNLIKELY( !sz || sz>pool->stride || sz>USHORT_MAX ) ) return NULL;
+
+  ulong idx = pool->frame_cnt++;
+  ( (ushort *)( pool+1 ) )[ idx ] = (ushort)sz;
+  pool->sz_max  = fd_ulong_max( pool->sz_max, sz );
+  pool->sz_sum += sz;
+  return (uchar *)pool + pool->data_off + idx*pool->stride;
+}
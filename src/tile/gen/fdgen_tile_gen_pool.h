@@ -0,0 +1,79 @@
+#pragma once
+
+/* fdgen_tile_gen_pool.h provides frame pools for the gen tile.
+
+   A frame pool holds pre-serialized Ethernet/IPv4/UDP frames built
+   before the tile starts (e.g. QUIC Initials, signed transactions).
+   Instead of writing frames from the header template, the gen tile
+   then cycles through the pool in order, copying one frame per
+   publish.  Frames may differ in size.  Expensive per-frame work
+   (encryption, signing) is thus done once at boot, the hot loop only
+   copies and optionally patches the flow tuple.
+
+   Frames are stored in fixed-size slots of mtu bytes (rounded up to
+   FD_CHUNK_ALIGN), sizes in a parallel array.  The pool is a single
+   contiguous region, so it can be placed in a workspace and shared
+   between tiles. */
+
+#include <firedancer/util/fd_util_base.h>
+
+#define FDGEN_TILE_GEN_POOL_ALIGN (128UL)
+
+struct __attribute__((aligned(FDGEN_TILE_GEN_POOL_ALIGN))) fdgen_tile_gen_pool {
+  ulong frame_cnt;  /* frames appended, in [0,frame_max] */
+  ulong frame_max;  /* capacity */
+  ulong stride;     /* bytes per frame slot */
+  ulong sz_max;     /* largest frame appended */
+  ulong sz_sum;     /* bytes appended */
+  ulong data_off;   /* offset of the first frame slot from the pool */
+  /* ushort sz[ frame_max ] follows */
+  /* frame slots follow at data_off */
+};
+
+typedef struct fdgen_tile_gen_pool fdgen_tile_gen_pool_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_pool_{align,footprint} specify the memory region of a
+   pool of up to frame_max frames of up to mtu bytes.  footprint returns
+   0 for invalid parameters. */
+
+FD_FN_CONST ulong
+fdgen_tile_gen_pool_align( void );
+
+FD_FN_CONST ulong
+fdgen_tile_gen_pool_footprint( ulong frame_max,
+                               ulong mtu );
+
+/* fdgen_tile_gen_pool_new formats mem as an empty pool.  Returns the
+   pool on success, NULL on failure (logs details). */
+
+fdgen_tile_gen_pool_t *
+fdgen_tile_gen_pool_new( void * mem,
+                         ulong  frame_max,
+                         ulong  mtu );
+
+/* fdgen_tile_gen_pool_append reserves the next frame slot for a frame
+   of sz bytes.  Returns the slot to write the frame into, NULL if the
+   pool is full or sz is out of range. */
+
+uchar *
+fdgen_tile_gen_pool_append( fdgen_tile_gen_pool_t * pool,
+                            ulong                   sz );
+
+/* fdgen_tile_gen_pool_{sz,frame} return the size and contents of frame
+   idx in [0,frame_cnt). */
+
+FD_FN_PURE static inline ulong
+fdgen_tile_gen_pool_sz( fdgen_tile_gen_pool_t const * pool,
+                        ulong                         idx ) {
+  return ( (ushort const *)( pool+1 ) )[ idx ];
+}
+
+FD_FN_PURE static inline uchar const *
+fdgen_tile_gen_pool_frame( fdgen_tile_gen_pool_t const * pool,
+                           ulong                         idx ) {
+  return (uchar const *)pool + pool->data_off + idx*pool->stride;
+}
+
+FD_PROTOTYPES_END
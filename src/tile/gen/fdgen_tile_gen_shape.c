@@ -0,0 +1,154 @@
+#include "fdgen_tile_gen_shape.h"
+#include "fdgen_tile_gen_csv.h"
+#include <firedancer/util/fd_util.h>
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* shape_reset sets the multiplier table to deterministic pacing and
+   clears the segment table. */
+
+static void
+shape_reset( fdgen_tile_gen_shape_t * shape,
+             int                      repeat ) {
+  shape->seg_cnt  = 0UL;
+  shape->repeat   = repeat;
+  shape->mul_mask = 0UL;
+  shape->mul_max  = 1.0;
+  shape->mul[0]   = 1.0;
+}
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_const( fdgen_tile_gen_shape_t * shape ) {
+  shape_reset( shape, 0 );
+  shape->seg[0]  = (fdgen_tile_gen_shape_seg_t){ .dur_ns = LONG_MAX, .scale = 1.0 };
+  shape->seg_cnt = 1UL;
+  return shape;
+}
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_ramp( fdgen_tile_gen_shape_t * shape,
+                                double                   lo,
+                                double                   hi,
+                                long                     dur_ns,
+                                ulong                    step_cnt ) {
+
+  int   linear  = !step_cnt;
+  ulong seg_cnt = linear ? FDGEN_TILE_GEN_SHAPE_SEG_MAX-1UL : step_cnt;  /* one segment left to hold hi */
+  if( FD_UNLIKELY( !(lo>=0.0) || !(hi>=0.0) || seg_cnt>FDGEN_TILE_GEN_SHAPE_SEG_MAX-1UL || dur_ns<(long)seg_cnt ) ) {
+    FD_LOG_WARNING(( "invalid ramp (lo %g hi %g dur_ns %li step_cnt %lu)", lo, hi, dur_ns, step_cnt ));
+    return NULL;
+  }
+
+  shape_reset( shape, 0 );
+
+  /* Linear: each step runs at the ramp value at its midpoint.
+     Stepped: step_cnt values from lo to hi inclusive. */
+
+  long t0 = 0L;
+  for( ulong i=0UL; i<seg_cnt; i++ ) {
+    long   t1 = (long)( ( (double)dur_ns * (double)(i+1UL) ) / (double)seg_cnt );
+    double f  = linear ? ( (double)i + 0.5 ) / (double)seg_cnt
+                       : ( seg_cnt>1UL ? (double)i / (double)(seg_cnt-1UL) : 1.0 );
+    shape->seg[i] = (fdgen_tile_gen_shape_seg_t){ .dur_ns = t1-t0, .scale = lo + (hi-lo)*f };
+    t0 = t1;
+  }
+
+  /* Hold hi after the ramp */
+  shape->seg[ seg_cnt ] = (fdgen_tile_gen_shape_seg_t){ .dur_ns = LONG_MAX, .scale = hi };
+  shape->seg_cnt = seg_cnt+1UL;
+  return shape;
+}
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_onoff( fdgen_tile_gen_shape_t * shape,
+                                 long                     period_ns,
+                                 double                   duty ) {
+
+  long on_ns = (long)( (double)period_ns * duty );
+  if( FD_UNLIKELY( !(duty>0.0) || duty>1.0 || on_ns<=0L ) ) {
+    FD_LOG_WARNING(( "invalid on/off shape (period_ns %li duty %g)", period_ns, duty ));
+    return NULL;
+  }
+
+  shape_reset( shape, 1 );
+  shape->seg[ shape->seg_cnt++ ] = (fdgen_tile_gen_shape_seg_t){ .dur_ns = on_ns, .scale = 1.0 };
+  if( on_ns<period_ns ) {
+    shape->seg[ shape->seg_cnt++ ] = (fdgen_tile_gen_shape_seg_t){ .dur_ns = period_ns-on_ns, .scale = 0.0 };
+  }
+  return shape;
+}
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_csv( fdgen_tile_gen_shape_t * shape,
+                               char const *             path,
+                               int                      repeat ) {
+
+  FILE * file = fopen( path, "r" );
+  if( FD_UNLIKELY( !file ) ) {
+    FD_LOG_WARNING(( "fopen(%s) failed (%i-%s)", path, errno, fd_io_strerror( errno ) ));
+    return NULL;
+  }
+
+  shape_reset( shape, repeat );
+
+  char  line[ 256 ];
+  ulong line_idx = 0UL;
+  while( fgets( line, sizeof(line), file ) ) {
+    line_idx++;
+    char * cur = line;
+    while( *cur==' ' || *cur=='\t' ) cur++;
+    if( *cur=='#' || *cur=='\n' || *cur=='\r' || *cur=='\0' ) continue;
+
+    char * end;
+    double dur_us = strtod( cur, &end );
+    if( FD_UNLIKELY( end==cur || *end!=',' ) ) goto bad_line;
+    cur = end+1;
+    double scale  = strtod( cur, &end );
+    if( FD_UNLIKELY( end==cur || !fdgen_tile_gen_csv_end( end ) ) ) goto bad_line;
+
+    long dur_ns = (long)( dur_us*1e3 );
+    if( FD_UNLIKELY( dur_ns<=0L || !(scale>=0.0) ) ) goto bad_line;
+    if( FD_UNLIKELY( shape->seg_cnt==FDGEN_TILE_GEN_SHAPE_SEG_MAX ) ) {
+      FD_LOG_WARNING(( "%s: more than %lu segments", path, FDGEN_TILE_GEN_SHAPE_SEG_MAX ));
+      fclose( file );
+      return NULL;
+    }
+    shape->seg[ shape->seg_cnt++ ] = (fdgen_tile_gen_shape_seg_t){ .dur_ns = dur_ns, .scale = scale };
+    continue;
+
+  bad_line:
+    FD_LOG_WARNING(( "%s:%lu: expected \"<dur_us>,<scale>\" with positive duration", path, line_idx ));
+    fclose( file );
+    return NULL;
+  }
+  fclose( file );
+
+  if( FD_UNLIKELY( !shape->seg_cnt ) ) {
+    FD_LOG_WARNING(( "%s: no segments", path ));
+    return NULL;
+  }
+  return shape;
+}
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_set_poisson( fdgen_tile_gen_shape_t * shape ) {
+
+  /* Midpoint quantiles of Exp(1), rescaled to a mean of exactly 1 so
+     the average rate is unaffected by the truncated tail */
+
+  double sum = 0.0;
+  for( ulong j=0UL; j<FDGEN_TILE_GEN_SHAPE_MUL_CNT; j++ ) {
+    double u = ( (double)j + 0.5 ) / (double)FDGEN_TILE_GEN_SHAPE_MUL_CNT;
+    shape->mul[j] = -log1p( -u );
+    sum += shape->mul[j];
+  }
+  double norm = (double)FDGEN_TILE_GEN_SHAPE_MUL_CNT / sum;
+  for( ulong j=0UL; j<FDGEN_TILE_GEN_SHAPE_MUL_CNT; j++ ) shape->mul[j] *= norm;
+
+  shape->mul_mask = FDGEN_TILE_GEN_SHAPE_MUL_CNT-1UL;
+  shape->mul_max  = shape->mul[ FDGEN_TILE_GEN_SHAPE_MUL_CNT-1UL ];
+  return shape;
+}
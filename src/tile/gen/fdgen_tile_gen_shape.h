@@ -0,0 +1,107 @@
+#pragma once
+
+/* fdgen_tile_gen_shape.h provides traffic shape profiles for the gen
+   tile.  A shape modulates the instantaneous rate of the tile around
+   its configured pps/bps.
+
+   A shape is precomputed at boot into two tables, so the tile hot loop
+   only does table lookups:
+
+   - A segment table.  The rate is piecewise constant: segment i lasts
+     seg[i].dur_ns and runs at seg[i].scale times the configured rate
+     (0 for silence).  After the last segment, the table either repeats
+     or holds the last segment forever.
+
+   - A cost multiplier table.  Each frame costs mul[j] token bucket
+     tokens instead of 1, with j drawn uniformly at random per frame.
+     All ones for deterministic pacing.  For Poisson arrivals, the table
+     holds quantiles of the unit exponential distribution, making
+     inter-arrival times exponential with the mean of the segment rate.
+
+   Ramps, on/off square waves and CSV curves fill the segment table.
+   Poisson arrivals fill the multiplier table and can be combined with
+   any segment table (e.g. Poisson bursts in the on phase of a square
+   wave). */
+
+#include <firedancer/util/fd_util_base.h>
+
+/* FDGEN_TILE_GEN_SHAPE_SEG_MAX is the max number of rate segments.  A
+   linear ramp is approximated by FDGEN_TILE_GEN_SHAPE_SEG_MAX-1 steps. */
+
+#define FDGEN_TILE_GEN_SHAPE_SEG_MAX (1024UL)
+
+/* FDGEN_TILE_GEN_SHAPE_MUL_CNT is the number of cost multipliers
+   sampled for Poisson arrivals (power of 2). */
+
+#define FDGEN_TILE_GEN_SHAPE_MUL_CNT (4096UL)
+
+struct fdgen_tile_gen_shape_seg {
+  long   dur_ns;  /* segment duration, positive */
+  double scale;   /* rate multiplier, non-negative */
+};
+
+typedef struct fdgen_tile_gen_shape_seg fdgen_tile_gen_shape_seg_t;
+
+struct fdgen_tile_gen_shape {
+  ulong  seg_cnt;   /* in [1,FDGEN_TILE_GEN_SHAPE_SEG_MAX] */
+  int    repeat;    /* 1 to loop the segment table, 0 to hold the last segment */
+  ulong  mul_mask;  /* multiplier count minus one (0 or FDGEN_TILE_GEN_SHAPE_MUL_CNT-1) */
+  double mul_max;   /* largest multiplier, sizes the token buckets */
+  fdgen_tile_gen_shape_seg_t seg[ FDGEN_TILE_GEN_SHAPE_SEG_MAX ];
+  double                     mul[ FDGEN_TILE_GEN_SHAPE_MUL_CNT ];
+};
+
+typedef struct fdgen_tile_gen_shape fdgen_tile_gen_shape_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_shape_init_const initializes a shape running at the
+   configured rate forever.  Returns shape. */
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_const( fdgen_tile_gen_shape_t * shape );
+
+/* fdgen_tile_gen_shape_init_ramp initializes a ramp from scale lo to
+   scale hi over dur_ns, holding hi afterwards.  With step_cnt==0 the
+   ramp is linear, otherwise it moves in step_cnt equal steps (at most
+   FDGEN_TILE_GEN_SHAPE_SEG_MAX-1), the first at lo and the last at hi.
+   Returns shape on success, NULL on failure (logs details). */
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_ramp( fdgen_tile_gen_shape_t * shape,
+                                double                   lo,
+                                double                   hi,
+                                long                     dur_ns,
+                                ulong                    step_cnt );
+
+/* fdgen_tile_gen_shape_init_onoff initializes a square wave of period
+   period_ns, on (scale 1) for the first duty fraction of each period
+   and silent for the rest.  duty is in (0,1].  Returns shape on
+   success, NULL on failure (logs details). */
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_onoff( fdgen_tile_gen_shape_t * shape,
+                                 long                     period_ns,
+                                 double                   duty );
+
+/* fdgen_tile_gen_shape_init_csv initializes a rate curve from the CSV
+   file at path.  Each line is "<dur_us>,<scale>": the rate is scale
+   times the configured rate for dur_us microseconds.  Further
+   comma-separated columns are ignored but a number followed by
+   anything else than blanks (e.g. "100x") fails.  Empty lines and
+   lines starting with '#' are ignored.  If repeat, the curve loops.
+   Returns shape on success, NULL on failure (logs details). */
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_init_csv( fdgen_tile_gen_shape_t * shape,
+                               char const *             path,
+                               int                      repeat );
+
+/* fdgen_tile_gen_shape_set_poisson makes frame arrivals of an
+   initialized shape a Poisson process (exponential inter-arrival
+   times) with the rate of the current segment.  Returns shape. */
+
+fdgen_tile_gen_shape_t *
+fdgen_tile_gen_shape_set_poisson( fdgen_tile_gen_shape_t * shape );
+
+FD_PROTOTYPES_END
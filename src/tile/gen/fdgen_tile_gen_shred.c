@@ -0,0 +1,83 @@
+#include "fdgen_tile_gen_shred.h"
+#include <firedancer/util/fd_util.h>
+
+/* shred_fill fills sz bytes at p with filler derived from seed */
+
+static void
+shred_fill( uchar * p,
+            ulong   sz,
+            ulong   seed ) {
+  for( ulong j=0UL; j<sz; j+=8UL ) {
+    ulong x = fd_ulong_hash( seed ^ j );
+    fd_memcpy( p+j, &x, fd_ulong_min( 8UL, sz-j ) );
+  }
+}
+
+fdgen_tile_gen_shred_t *
+fdgen_tile_gen_shred_init( fdgen_tile_gen_shred_t *              shred,
+                           fdgen_tile_gen_shred_params_t const * params ) {
+
+  ulong slot_step    = fd_ulong_max( params->slot_step,    1UL );
+  ulong fec_per_slot = fd_ulong_max( params->fec_per_slot, 1UL );
+  ulong data_cnt     = params->data_cnt;
+  ulong code_cnt     = params->code_cnt;
+
+  if( FD_UNLIKELY( !data_cnt || data_cnt>FDGEN_SHRED_FEC_SHRED_MAX || code_cnt>FDGEN_SHRED_FEC_SHRED_MAX ) ) {
+    FD_LOG_WARNING(( "FEC set of %lu data and %lu coding shreds out of range", data_cnt, code_cnt ));
+    return NULL;
+  }
+  if( FD_UNLIKELY( slot_step>USHORT_MAX || params->slot<slot_step ) ) {
+    FD_LOG_WARNING(( "slot %lu and slot_step %lu do not give a valid parent offset", params->slot, slot_step ));
+    return NULL;
+  }
+  /* Data and coding shred indices in a slot reach fec_per_slot times
+     data_cnt and code_cnt (data_cnt is non-zero here) */
+  if( FD_UNLIKELY( fec_per_slot>UINT_MAX/fd_ulong_max( data_cnt, code_cnt ) ) ) {
+    FD_LOG_WARNING(( "%lu FEC sets of %lu data and %lu coding shreds overflow the shred index", fec_per_slot, data_cnt, code_cnt ));
+    return NULL;
+  }
+  if( FD_UNLIKELY( params->order!=FDGEN_SHRED_ORDER_DATA_FIRST && params->order!=FDGEN_SHRED_ORDER_INTERLEAVE ) ) {
+    FD_LOG_WARNING(( "unsupported order %d", params->order ));
+    return NULL;
+  }
+
+  /* The Merkle tree spans the data and coding shreds of the set */
+
+  ulong set_cnt  = data_cnt+code_cnt;
+  ulong proof_sz = (ulong)fd_ulong_find_msb( fd_ulong_pow2_up( set_cnt ) );
+
+  shred->slot_step     = slot_step;
+  shred->fec_per_slot  = fec_per_slot;
+  shred->data_cnt      = data_cnt;
+  shred->code_cnt      = code_cnt;
+  shred->set_cnt       = set_cnt;
+  shred->pair_cnt      = params->order==FDGEN_SHRED_ORDER_INTERLEAVE ? fd_ulong_min( data_cnt, code_cnt ) : 0UL;
+  shred->burst_set_cnt = params->burst_set_cnt;
+  shred->slot          = params->slot;
+  shred->set_idx       = 0UL;
+  shred->set_seq       = 0UL;
+  shred->pos           = 0UL;
+  shred->ref_tick      = 0;
+
+  /* Data shred: full payload capacity */
+
+  uchar * d = shred->data_tmpl;
+  shred_fill( d, FDGEN_SHRED_DATA_SZ, params->seed );
+  d[ FDGEN_SHRED_VARIANT_OFF ] = (uchar)( FDGEN_SHRED_VARIANT_MERKLE_DATA | proof_sz );
+  FD_STORE( ushort, d+FDGEN_SHRED_VERSION_OFF,    params->version   );
+  FD_STORE( ushort, d+FDGEN_SHRED_PARENT_OFF_OFF, (ushort)slot_step );
+  FD_STORE( ushort, d+FDGEN_SHRED_SIZE_OFF,       (ushort)( FDGEN_SHRED_DATA_SZ - proof_sz*FDGEN_SHRED_PROOF_ENTRY_SZ ) );
+  d[ FDGEN_SHRED_FLAGS_OFF ] = 0;
+
+  /* Coding shred */
+
+  uchar * c = shred->code_tmpl;
+  shred_fill( c, FDGEN_SHRED_CODE_SZ, fd_ulong_hash( params->seed ) );
+  c[ FDGEN_SHRED_VARIANT_OFF ] = (uchar)( FDGEN_SHRED_VARIANT_MERKLE_CODE | proof_sz );
+  FD_STORE( ushort, c+FDGEN_SHRED_VERSION_OFF,  params->version  );
+  FD_STORE( ushort, c+FDGEN_SHRED_DATA_CNT_OFF, (ushort)data_cnt );
+  FD_STORE( ushort, c+FDGEN_SHRED_CODE_CNT_OFF, (ushort)code_cnt );
+  FD_STORE( ushort, c+FDGEN_SHRED_POS_OFF,      (ushort)0        );
+
+  return shred;
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+/* fdgen_tile_gen_shred.h provides shred streams for the gen tile, to
+   load test turbine ingest.
+
+   Frames carry Merkle shreds as sent by a leader: FEC sets of data_cnt
+   data shreds (1203 bytes) and code_cnt coding shreds (1228 bytes),
+   each shred with the common header (signature, variant, slot, index,
+   version, FEC set index) and its data or coding header.  The variant
+   encodes the Merkle proof size of the set, data headers carry the
+   parent offset, reference tick and DATA_COMPLETE / LAST_IN_SLOT
+   flags, coding headers the set geometry and the position.
+
+   One data and one coding shred are precomputed at init.  Per frame,
+   the matching template is copied and the slot, index, FEC set index,
+   flags and position patched in, so the cost per shred is a memcpy.
+
+   Progression: data shred indices are contiguous within a slot and
+   coding shred indices advance by code_cnt per set.  After fec_per_slot
+   sets the stream moves to slot+slot_step with indices restarting at
+   0 (slot_step>1 mimics skipped leader slots).  Within a set, data
+   shreds go first or data and coding shreds alternate.
+
+   Bursts: a leader emits each FEC set back to back once it is
+   erasure coded.  With burst_set_cnt, the first shred of every
+   burst_set_cnt sets is charged the token bucket cost of the whole
+   burst and the others nothing, so bursts leave back to back at the
+   configured average rate (Poisson bursts with a Poisson shape).
+
+   Signatures, payloads and Merkle proofs are filler: receivers that
+   verify leader signatures drop these shreds after parsing. */
+
+#include <firedancer/util/fd_util_base.h>
+
+/* FDGEN_SHRED_* give the layout of a Merkle shred */
+
+#define FDGEN_SHRED_DATA_SZ         (1203UL)
+#define FDGEN_SHRED_CODE_SZ         (1228UL)
+#define FDGEN_SHRED_SZ_MAX          (1228UL)
+#define FDGEN_SHRED_PROOF_ENTRY_SZ  (20UL)
+
+#define FDGEN_SHRED_SIG_OFF         (0UL)
+#define FDGEN_SHRED_VARIANT_OFF     (64UL)
+#define FDGEN_SHRED_SLOT_OFF        (65UL)
+#define FDGEN_SHRED_IDX_OFF         (73UL)
+#define FDGEN_SHRED_VERSION_OFF     (77UL)
+#define FDGEN_SHRED_FEC_SET_IDX_OFF (79UL)
+#define FDGEN_SHRED_PARENT_OFF_OFF  (83UL)  /* data */
+#define FDGEN_SHRED_FLAGS_OFF       (85UL)  /* data */
+#define FDGEN_SHRED_SIZE_OFF        (86UL)  /* data */
+#define FDGEN_SHRED_DATA_CNT_OFF    (83UL)  /* code */
+#define FDGEN_SHRED_CODE_CNT_OFF    (85UL)  /* code */
+#define FDGEN_SHRED_POS_OFF         (87UL)  /* code */
+#define FDGEN_SHRED_DATA_HDR_SZ     (88UL)
+#define FDGEN_SHRED_CODE_HDR_SZ     (89UL)
+
+#define FDGEN_SHRED_VARIANT_MERKLE_DATA (0x80)  /* | proof size */
+#define FDGEN_SHRED_VARIANT_MERKLE_CODE (0x40)  /* | proof size */
+
+#define FDGEN_SHRED_FLAG_REF_TICK_MASK (0x3f)
+#define FDGEN_SHRED_FLAG_DATA_COMPLETE (0x40)
+#define FDGEN_SHRED_FLAG_LAST_IN_SLOT  (0xc0)
+
+#define FDGEN_SHRED_TICKS_PER_SLOT (64UL)
+
+/* FDGEN_SHRED_FEC_SHRED_MAX bounds the data and the coding shreds of a
+   FEC set */
+
+#define FDGEN_SHRED_FEC_SHRED_MAX (67UL)
+
+#define FDGEN_SHRED_ORDER_DATA_FIRST (0)  /* data shreds, then coding shreds */
+#define FDGEN_SHRED_ORDER_INTERLEAVE (1)  /* alternate while both remain */
+
+/* fdgen_tile_gen_shred_params_t describes a shred stream */
+
+struct fdgen_tile_gen_shred_params {
+  ulong  slot;           /* first slot, at least slot_step */
+  ulong  slot_step;      /* slot increment, 0 is treated as 1, at most USHORT_MAX (parent offset) */
+  ulong  fec_per_slot;   /* FEC sets per slot, 0 is treated as 1, times data_cnt and code_cnt at most UINT_MAX */
+  ulong  data_cnt;       /* data shreds per FEC set, in [1,FDGEN_SHRED_FEC_SHRED_MAX] */
+  ulong  code_cnt;       /* coding shreds per FEC set, in [0,FDGEN_SHRED_FEC_SHRED_MAX] */
+  ushort version;        /* shred version of the cluster */
+  int    order;          /* FDGEN_SHRED_ORDER_* */
+  ulong  burst_set_cnt;  /* FEC sets sent back to back, 0 to pace shreds individually */
+  ulong  seed;           /* fills signatures, payloads and proofs */
+};
+
+typedef struct fdgen_tile_gen_shred_params fdgen_tile_gen_shred_params_t;
+
+struct fdgen_tile_gen_shred {
+
+  /* config */
+  ulong  slot_step;
+  ulong  fec_per_slot;
+  ulong  data_cnt;
+  ulong  code_cnt;
+  ulong  set_cnt;        /* data_cnt+code_cnt */
+  ulong  pair_cnt;       /* data/coding pairs alternated with FDGEN_SHRED_ORDER_INTERLEAVE, 0 otherwise */
+  ulong  burst_set_cnt;
+
+  /* position */
+  ulong  slot;
+  ulong  set_idx;        /* FEC set in slot, in [0,fec_per_slot) */
+  ulong  set_seq;        /* FEC sets completed */
+  ulong  pos;            /* shred in set, in [0,set_cnt) */
+  uchar  ref_tick;       /* reference tick of the current set */
+
+  uchar  data_tmpl[ FDGEN_SHRED_DATA_SZ ];
+  uchar  code_tmpl[ FDGEN_SHRED_CODE_SZ ];
+
+};
+
+typedef struct fdgen_tile_gen_shred fdgen_tile_gen_shred_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_shred_init initializes shred at the start of the
+   stream described by params.  Returns shred on success, NULL on
+   failure (logs details). */
+
+fdgen_tile_gen_shred_t *
+fdgen_tile_gen_shred_init( fdgen_tile_gen_shred_t *              shred,
+                           fdgen_tile_gen_shred_params_t const * params );
+
+/* fdgen_tile_gen_shred_burst_{cnt,sz} return the number of shreds and
+   the bytes of shreds in a burst, 0 if shreds are paced individually */
+
+FD_FN_PURE static inline ulong
+fdgen_tile_gen_shred_burst_cnt( fdgen_tile_gen_shred_t const * shred ) {
+  return shred->burst_set_cnt * shred->set_cnt;
+}
+
+FD_FN_PURE static inline ulong
+fdgen_tile_gen_shred_burst_sz( fdgen_tile_gen_shred_t const * shred ) {
+  return shred->burst_set_cnt * ( shred->data_cnt*FDGEN_SHRED_DATA_SZ + shred->code_cnt*FDGEN_SHRED_CODE_SZ );
+}
+
+/* fdgen_tile_gen_shred_burst_first returns 1 if the next shred starts
+   a burst */
+
+FD_FN_PURE static inline int
+fdgen_tile_gen_shred_burst_first( fdgen_tile_gen_shred_t const * shred ) {
+  return !shred->pos && shred->burst_set_cnt && !( shred->set_seq % shred->burst_set_cnt );
+}
+
+/* fdgen_tile_gen_shred_is_code returns 1 if the next shred is a coding
+   shred and stores its position among the data or coding shreds of
+   the set in *k. */
+
+static inline int
+fdgen_tile_gen_shred_is_code( fdgen_tile_gen_shred_t const * shred,
+                              ulong *                        k ) {
+  ulong pos = shred->pos;
+  if( pos<2UL*shred->pair_cnt ) { *k = pos>>1; return (int)( pos & 1UL ); }
+  if( shred->pair_cnt ) { *k = pos-shred->pair_cnt; return shred->data_cnt<shred->code_cnt; }
+  int is_code = pos>=shred->data_cnt;
+  *k = is_code ? pos-shred->data_cnt : pos;
+  return is_code;
+}
+
+/* fdgen_tile_gen_shred_sz returns the size of the next shred */
+
+static inline ulong
+fdgen_tile_gen_shred_sz( fdgen_tile_gen_shred_t const * shred ) {
+  ulong k;
+  return fdgen_tile_gen_shred_is_code( shred, &k ) ? FDGEN_SHRED_CODE_SZ : FDGEN_SHRED_DATA_SZ;
+}
+
+/* fdgen_tile_gen_shred_next writes the next shred of the stream to out
+   (up to FDGEN_SHRED_SZ_MAX bytes), advances the stream and returns
+   the size of the shred. */
+
+static inline ulong
+fdgen_tile_gen_shred_next( fdgen_tile_gen_shred_t * shred,
+                           uchar *                  out ) {
+
+  ulong k;
+  int   is_code     = fdgen_tile_gen_shred_is_code( shred, &k );
+  ulong set_idx     = shred->set_idx;
+  uint  fec_set_idx = (uint)( set_idx*shred->data_cnt );
+  ulong sz;
+  if( !is_code ) {
+    sz = FDGEN_SHRED_DATA_SZ;
+    fd_memcpy( out, shred->data_tmpl, sz );
+    uchar flags = shred->ref_tick;
+    if( k==shred->data_cnt-1UL ) {
+      flags |= (uchar)( set_idx==shred->fec_per_slot-1UL ? FDGEN_SHRED_FLAG_LAST_IN_SLOT : FDGEN_SHRED_FLAG_DATA_COMPLETE );
+    }
+    FD_STORE( uint, out+FDGEN_SHRED_IDX_OFF, fec_set_idx + (uint)k );
+    out[ FDGEN_SHRED_FLAGS_OFF ] = flags;
+  } else {
+    sz = FDGEN_SHRED_CODE_SZ;
+    fd_memcpy( out, shred->code_tmpl, sz );
+    FD_STORE( uint,   out+FDGEN_SHRED_IDX_OFF, (uint)( set_idx*shred->code_cnt + k ) );
+    FD_STORE( ushort, out+FDGEN_SHRED_POS_OFF, (ushort)k );
+  }
+  FD_STORE( ulong, out+FDGEN_SHRED_SLOT_OFF,        shred->slot );
+  FD_STORE( uint,  out+FDGEN_SHRED_FEC_SET_IDX_OFF, fec_set_idx );
+
+  /* Shreds of a set share the signature of its Merkle root */
+  FD_STORE( ulong, out+FDGEN_SHRED_SIG_OFF,     shred->slot );
+  FD_STORE( ulong, out+FDGEN_SHRED_SIG_OFF+8UL, set_idx     );
+
+  /* Advance */
+  shred->pos++;
+  if( FD_UNLIKELY( shred->pos==shred->set_cnt ) ) {
+    shred->pos = 0UL;
+    shred->set_seq++;
+    shred->set_idx++;
+    if( FD_UNLIKELY( shred->set_idx==shred->fec_per_slot ) ) {
+      shred->set_idx = 0UL;
+      shred->slot   += shred->slot_step;
+    }
+    shred->ref_tick = (uchar)( ( shred->set_idx*FDGEN_SHRED_TICKS_PER_SLOT / shred->fec_per_slot ) & FDGEN_SHRED_FLAG_REF_TICK_MASK );
+  }
+  return sz;
+}
+
+FD_PROTOTYPES_END
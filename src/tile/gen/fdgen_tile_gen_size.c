@@ -0,0 +1,183 @@
+#include "fdgen_tile_gen_size.h"
+#include "fdgen_tile_gen_csv.h"
+#include <firedancer/util/fd_util.h>
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* size_thresh converts the probability q in [0,1] of keeping the size
+   of an entry to a threshold on 32 random bits */
+
+static inline uint
+size_thresh( double q ) {
+  double t = q*4294967296.0 + 0.5;
+  return t<(double)UINT_MAX ? (uint)t : UINT_MAX;
+}
+
+static inline int
+size_is_valid( ulong sz ) {
+  return sz>=FDGEN_TILE_GEN_SIZE_MIN && sz<=FDGEN_TILE_GEN_SIZE_MAX;
+}
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_fixed( fdgen_tile_gen_size_t * size,
+                                ulong                   sz ) {
+  double weight = 1.0;
+  return fdgen_tile_gen_size_init_table( size, &sz, &weight, 1UL );
+}
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_uniform( fdgen_tile_gen_size_t * size,
+                                  ulong                   lo,
+                                  ulong                   hi ) {
+
+  if( FD_UNLIKELY( !size_is_valid( lo ) || !size_is_valid( hi ) || lo>hi ) ) {
+    FD_LOG_WARNING(( "invalid size range [%lu,%lu], sizes must be in [%lu,%lu]",
+                     lo, hi, FDGEN_TILE_GEN_SIZE_MIN, FDGEN_TILE_GEN_SIZE_MAX ));
+    return NULL;
+  }
+
+  /* Equal weights: every entry keeps its own size */
+
+  ulong  cnt = fd_ulong_min( hi-lo+1UL, FDGEN_TILE_GEN_SIZE_CNT_MAX );
+  double sum = 0.0;
+  for( ulong j=0UL; j<cnt; j++ ) {
+    ulong sz = cnt>1UL ? lo + ( j*( hi-lo ) )/( cnt-1UL ) : lo;
+    size->ent[ j ] = (fdgen_tile_gen_size_ent_t){ .thresh = UINT_MAX, .sz = { (ushort)sz, (ushort)sz } };
+    sum += (double)sz;
+  }
+  size->cnt    = cnt;
+  size->sz_min = lo;
+  size->sz_max = hi;
+  size->sz_avg = sum / (double)cnt;
+  return size;
+}
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_imix( fdgen_tile_gen_size_t * size ) {
+  static ulong  const sz    [ 3 ] = {  60UL, 590UL, 1514UL };
+  static double const weight[ 3 ] = {   7.0,   4.0,    1.0 };
+  return fdgen_tile_gen_size_init_table( size, sz, weight, 3UL );
+}
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_table( fdgen_tile_gen_size_t * size,
+                                ulong const *           sz,
+                                double const *          weight,
+                                ulong                   cnt ) {
+
+  if( FD_UNLIKELY( !cnt || cnt>FDGEN_TILE_GEN_SIZE_CNT_MAX ) ) {
+    FD_LOG_WARNING(( "%lu sizes out of range [1,%lu]", cnt, FDGEN_TILE_GEN_SIZE_CNT_MAX ));
+    return NULL;
+  }
+
+  double sum    = 0.0;
+  double sz_sum = 0.0;
+  ulong  sz_min = ULONG_MAX;
+  ulong  sz_max = 0UL;
+  for( ulong i=0UL; i<cnt; i++ ) {
+    if( FD_UNLIKELY( !size_is_valid( sz[ i ] ) || !( weight[ i ]>=0.0 ) || !isfinite( weight[ i ] ) ) ) {
+      FD_LOG_WARNING(( "size %lu (weight %g) invalid, sizes must be in [%lu,%lu] with finite non-negative weights",
+                       sz[ i ], weight[ i ], FDGEN_TILE_GEN_SIZE_MIN, FDGEN_TILE_GEN_SIZE_MAX ));
+      return NULL;
+    }
+    if( weight[ i ]>0.0 ) {
+      sum    += weight[ i ];
+      sz_sum += weight[ i ]*(double)sz[ i ];
+      sz_min  = fd_ulong_min( sz_min, sz[ i ] );
+      sz_max  = fd_ulong_max( sz_max, sz[ i ] );
+    }
+  }
+  if( FD_UNLIKELY( !( sum>0.0 ) || !isfinite( sum ) ) ) { FD_LOG_WARNING(( "weights must have a positive finite sum" )); return NULL; }
+
+  /* Vose: scale probabilities to a mean of 1, then repeatedly fill the
+     entry of a size below 1 with the excess of a size above 1 */
+
+  double q    [ FDGEN_TILE_GEN_SIZE_CNT_MAX ];
+  ushort small[ FDGEN_TILE_GEN_SIZE_CNT_MAX ];
+  ushort large[ FDGEN_TILE_GEN_SIZE_CNT_MAX ];
+  ulong  small_cnt = 0UL;
+  ulong  large_cnt = 0UL;
+  for( ulong i=0UL; i<cnt; i++ ) {
+    q[ i ] = weight[ i ]*(double)cnt / sum;
+    if( q[ i ]<1.0 ) small[ small_cnt++ ] = (ushort)i;
+    else             large[ large_cnt++ ] = (ushort)i;
+  }
+
+  while( small_cnt && large_cnt ) {
+    ulong s = small[ --small_cnt ];
+    ulong l = large[ large_cnt-1UL ];
+    size->ent[ s ] = (fdgen_tile_gen_size_ent_t){ .thresh = size_thresh( q[ s ] ), .sz = { (ushort)sz[ s ], (ushort)sz[ l ] } };
+    q[ l ] -= 1.0-q[ s ];
+    if( q[ l ]<1.0 ) { large_cnt--; small[ small_cnt++ ] = (ushort)l; }
+  }
+
+  /* Leftovers have a probability of 1 up to rounding */
+
+  while( large_cnt ) small[ small_cnt++ ] = large[ --large_cnt ];
+  while( small_cnt ) {
+    ulong i = small[ --small_cnt ];
+    size->ent[ i ] = (fdgen_tile_gen_size_ent_t){ .thresh = UINT_MAX, .sz = { (ushort)sz[ i ], (ushort)sz[ i ] } };
+  }
+
+  size->cnt    = cnt;
+  size->sz_min = sz_min;
+  size->sz_max = sz_max;
+  size->sz_avg = sz_sum / sum;
+  return size;
+}
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_csv( fdgen_tile_gen_size_t * size,
+                              char const *            path ) {
+
+  FILE * file = fopen( path, "r" );
+  if( FD_UNLIKELY( !file ) ) {
+    FD_LOG_WARNING(( "fopen(%s) failed (%i-%s)", path, errno, fd_io_strerror( errno ) ));
+    return NULL;
+  }
+
+  ulong  sz    [ FDGEN_TILE_GEN_SIZE_CNT_MAX ];
+  double weight[ FDGEN_TILE_GEN_SIZE_CNT_MAX ];
+  ulong  cnt = 0UL;
+
+  char  line[ 256 ];
+  ulong line_idx = 0UL;
+  while( fgets( line, sizeof(line), file ) ) {
+    line_idx++;
+    char * cur = line;
+    while( *cur==' ' || *cur=='\t' ) cur++;
+    if( *cur=='#' || *cur=='\n' || *cur=='\r' || *cur=='\0' ) continue;
+
+    char * end;
+    ulong  s = strtoul( cur, &end, 10 );
+    if( FD_UNLIKELY( end==cur || *end!=',' ) ) goto bad_line;
+    cur = end+1;
+    double w = strtod( cur, &end );
+    if( FD_UNLIKELY( end==cur || !fdgen_tile_gen_csv_end( end ) ) ) goto bad_line;
+
+    if( FD_UNLIKELY( cnt==FDGEN_TILE_GEN_SIZE_CNT_MAX ) ) {
+      FD_LOG_WARNING(( "%s: more than %lu sizes", path, FDGEN_TILE_GEN_SIZE_CNT_MAX ));
+      fclose( file );
+      return NULL;
+    }
+    sz    [ cnt ] = s;
+    weight[ cnt ] = w;
+    cnt++;
+    continue;
+
+  bad_line:
+    FD_LOG_WARNING(( "%s:%lu: expected \"<sz>,<weight>\"", path, line_idx ));
+    fclose( file );
+    return NULL;
+  }
+  fclose( file );
+
+  if( FD_UNLIKELY( !cnt ) ) {
+    FD_LOG_WARNING(( "%s: no sizes", path ));
+    return NULL;
+  }
+  return fdgen_tile_gen_size_init_table( size, sz, weight, cnt );
+}
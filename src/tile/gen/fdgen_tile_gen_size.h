@@ -0,0 +1,112 @@
+#pragma once
+
+/* fdgen_tile_gen_size.h provides frame size distributions for the gen
+   tile: a fixed size, a uniform range, IMIX, or a user-supplied table
+   of weighted sizes.
+
+   A distribution is precomputed into a Walker alias table of up to
+   FDGEN_TILE_GEN_SIZE_CNT_MAX entries, so sampling costs one random
+   number, one multiply, one table load and one compare per frame,
+   whatever the number of sizes.  Entry j holds a size, an alias size
+   and a threshold: a draw picks entry j uniformly from the high 32
+   bits of a random ulong and keeps its size if the low 32 bits are
+   below the threshold, the alias otherwise.  Tables are built with
+   Vose's method, in O(cnt).
+
+   Sizes are frame sizes incl. the Ethernet header and excl. the FCS,
+   like pkt_sz.  The probabilities of a table are exact up to the 2^-32
+   resolution of the thresholds. */
+
+#include "fdgen_tile_gen_tmpl.h"
+#include <firedancer/util/rng/fd_rng.h>
+
+/* FDGEN_TILE_GEN_SIZE_CNT_MAX is the max number of alias table
+   entries, i.e. of distinct weighted sizes.  Uniform ranges wider than
+   that are quantized to FDGEN_TILE_GEN_SIZE_CNT_MAX evenly spaced
+   sizes. */
+
+#define FDGEN_TILE_GEN_SIZE_CNT_MAX (4096UL)
+
+/* FDGEN_TILE_GEN_SIZE_{MIN,MAX} bound the sizes of a distribution (the
+   gen tile headers plus the seq tag, and the mcache sz range) */
+
+#define FDGEN_TILE_GEN_SIZE_MIN (FDGEN_TILE_GEN_TMPL_SZ+8UL)
+#define FDGEN_TILE_GEN_SIZE_MAX (65535UL)
+
+struct fdgen_tile_gen_size_ent {
+  uint   thresh;   /* draws with low bits below thresh pick sz[0], the others sz[1] */
+  ushort sz[ 2 ];  /* size, alias size */
+};
+
+typedef struct fdgen_tile_gen_size_ent fdgen_tile_gen_size_ent_t;
+
+struct fdgen_tile_gen_size {
+  ulong  cnt;      /* in [1,FDGEN_TILE_GEN_SIZE_CNT_MAX] */
+  ulong  sz_min;   /* smallest size of positive probability */
+  ulong  sz_max;   /* largest size of positive probability, sizes the dcache */
+  double sz_avg;   /* mean size */
+  fdgen_tile_gen_size_ent_t ent[ FDGEN_TILE_GEN_SIZE_CNT_MAX ];
+};
+
+typedef struct fdgen_tile_gen_size fdgen_tile_gen_size_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_size_init_fixed initializes a distribution of the
+   single size sz.  Returns size on success, NULL on failure (logs
+   details). */
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_fixed( fdgen_tile_gen_size_t * size,
+                                ulong                   sz );
+
+/* fdgen_tile_gen_size_init_uniform initializes a uniform distribution
+   over the sizes [lo,hi].  Returns size on success, NULL on failure
+   (logs details). */
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_uniform( fdgen_tile_gen_size_t * size,
+                                  ulong                   lo,
+                                  ulong                   hi );
+
+/* fdgen_tile_gen_size_init_imix initializes the simple IMIX: 7 parts
+   minimum size frames (40 byte IP packets padded to 60 bytes), 4 parts
+   590 byte frames (576 byte IP packets) and 1 part 1514 byte frames
+   (1500 byte IP packets).  Returns size. */
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_imix( fdgen_tile_gen_size_t * size );
+
+/* fdgen_tile_gen_size_init_table initializes the distribution picking
+   sz[i] with probability proportional to weight[i], for i in [0,cnt).
+   Weights are non-negative with a positive sum, sizes may repeat.
+   Returns size on success, NULL on failure (logs details). */
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_table( fdgen_tile_gen_size_t * size,
+                                ulong const *           sz,
+                                double const *          weight,
+                                ulong                   cnt );
+
+/* fdgen_tile_gen_size_init_csv initializes a table from the CSV file
+   at path.  Each line is "<sz>,<weight>", further comma-separated
+   columns are ignored but a number followed by anything else than
+   blanks (e.g. "100x") fails.  Empty lines and lines starting with '#'
+   are ignored.  Returns size on success, NULL on failure (logs
+   details). */
+
+fdgen_tile_gen_size_t *
+fdgen_tile_gen_size_init_csv( fdgen_tile_gen_size_t * size,
+                              char const *            path );
+
+/* fdgen_tile_gen_size_sample returns a size drawn from size */
+
+static inline ulong
+fdgen_tile_gen_size_sample( fdgen_tile_gen_size_t const * size,
+                            fd_rng_t *                    rng ) {
+  ulong                             r   = fd_rng_ulong( rng );
+  fdgen_tile_gen_size_ent_t const * ent = size->ent + ( ( ( r>>32 )*size->cnt )>>32 );
+  return (ulong)ent->sz[ (uint)r>=ent->thresh ];
+}
+
+FD_PROTOTYPES_END
@@ -0,0 +1,194 @@
+#pragma once
+
+/* fdgen_tile_gen_tmpl.h provides pre-built Ethernet/IPv4/UDP header
+   templates for packet sources.
+
+   A template holds the full 42 byte header of a flow, built once with
+   a valid IPv4 header checksum.  Per packet, fdgen_tile_gen_tmpl_write
+   copies the template and patches the fields that vary between packets
+   of a flow (UDP source port, IP ID, lengths).  The IPv4 checksum is
+   updated incrementally per RFC 1624 (HC' = ~(~HC + ~m + m')) instead
+   of being recomputed over the header.  The template is built with the
+   varying fields zeroed, so the update reduces to adding the new field
+   values to the complemented base checksum.
+
+   fdgen_tile_gen_tmpl_write_flow additionally patches addresses and
+   ports from a flow (fdgen_tile_gen_flow.h), so one template serves a
+   whole flow set.  fdgen_tile_gen_frame_patch_flow does the same for
+   a frame that was not built from a template (see
+   fdgen_tile_gen_pool.h).
+
+   The UDP checksum is left zero (no checksum, permitted for UDP over
+   IPv4). */
+
+#include <firedancer/util/fd_util_base.h>
+#include <firedancer/util/net/fd_eth.h>
+#include <firedancer/util/net/fd_ip4.h>
+#include <firedancer/util/net/fd_udp.h>
+#include "fdgen_tile_gen_flow.h"
+
+/* FDGEN_TILE_GEN_TMPL_SZ is the size of a templated header */
+
+#define FDGEN_TILE_GEN_TMPL_SZ (42UL)
+
+struct __attribute__((aligned(64))) fdgen_tile_gen_tmpl {
+  uchar  hdr[ FDGEN_TILE_GEN_TMPL_SZ ];  /* varying fields zeroed */
+  ushort check_base;                     /* ~(IPv4 checksum of hdr), folded */
+  ushort check_base_flow;                /* same with IP addresses zeroed */
+};
+
+typedef struct fdgen_tile_gen_tmpl fdgen_tile_gen_tmpl_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_ip4_check_update returns the IPv4 header checksum check after
+   replacing the 16-bit header word old_word with new_word per RFC 1624
+   eqn. 3.
+   All values are in the same (network) byte order. */
+
+FD_FN_CONST static inline ushort
+fdgen_ip4_check_update( ushort check,
+                        ushort old_word,
+                        ushort new_word ) {
+  uint sum = (uint)(ushort)~check + (uint)(ushort)~old_word + (uint)new_word;
+  sum = ( sum & 0xffffU ) + ( sum>>16 );
+  sum = ( sum & 0xffffU ) + ( sum>>16 );
+  return (ushort)~sum;
+}
+
+/* fdgen_tile_gen_tmpl_init builds the header template of a flow.  ip4
+   addresses are in net order, ports and ttl in host order.  Returns
+   tmpl. */
+
+static inline fdgen_tile_gen_tmpl_t *
+fdgen_tile_gen_tmpl_init( fdgen_tile_gen_tmpl_t * tmpl,
+                          uchar const             src_mac[ static 6 ],
+                          uchar const             dst_mac[ static 6 ],
+                          uint                    src_ip,
+                          uint                    dst_ip,
+                          ushort                  dst_port,
+                          uchar                   ttl ) {
+
+  memset( tmpl, 0, sizeof(fdgen_tile_gen_tmpl_t) );
+
+  fd_eth_hdr_t * eth_hdr = fd_type_pun( tmpl->hdr    );
+  fd_ip4_hdr_t * ip4_hdr = fd_type_pun( tmpl->hdr+14 );
+  fd_udp_hdr_t * udp_hdr = fd_type_pun( tmpl->hdr+34 );
+  memcpy( eth_hdr->dst, dst_mac, 6 );
+  memcpy( eth_hdr->src, src_mac, 6 );
+  eth_hdr->net_type = (ushort)fd_ushort_bswap( FD_ETH_HDR_TYPE_IP );
+  ip4_hdr[0] = (fd_ip4_hdr_t) {
+    .verihl       = FD_IP4_VERIHL( 4, 5 ),
+    .net_frag_off = (ushort)fd_ushort_bswap( FD_IP4_HDR_FRAG_OFF_DF ),
+    .ttl          = ttl,
+    .protocol     = FD_IP4_HDR_PROTOCOL_UDP
+  };
+  memcpy( ip4_hdr->saddr_c, &src_ip, 4 );
+  memcpy( ip4_hdr->daddr_c, &dst_ip, 4 );
+  udp_hdr->net_dport = (ushort)fd_ushort_bswap( dst_port );
+
+  tmpl->check_base = (ushort)~fd_ip4_hdr_check( ip4_hdr );
+
+  fd_ip4_hdr_t flow_hdr = *ip4_hdr;
+  memset( flow_hdr.saddr_c, 0, 4 );
+  memset( flow_hdr.daddr_c, 0, 4 );
+  flow_hdr.check = 0;
+  tmpl->check_base_flow = (ushort)~fd_ip4_hdr_check( &flow_hdr );
+  return tmpl;
+}
+
+/* fdgen_tile_gen_tmpl_write writes the header of a packet with a UDP
+   payload of payload_sz bytes to out (FDGEN_TILE_GEN_TMPL_SZ bytes).
+   src_port and ip_id are in host order.  Returns the frame size. */
+
+static inline ulong
+fdgen_tile_gen_tmpl_write( uchar *                       out,
+                           fdgen_tile_gen_tmpl_t const * tmpl,
+                           ushort                        src_port,
+                           ushort                        ip_id,
+                           ulong                         payload_sz ) {
+
+  ushort net_tot_len = (ushort)fd_ushort_bswap( (ushort)( 20UL+8UL+payload_sz ) );
+  ushort net_id      = (ushort)fd_ushort_bswap( ip_id );
+  ushort net_udp_len = (ushort)fd_ushort_bswap( (ushort)(      8UL+payload_sz ) );
+
+  /* Incremental checksum over the zeroed tot_len and id words */
+  uint sum = (uint)tmpl->check_base + (uint)net_tot_len + (uint)net_id;
+  sum = ( sum & 0xffffU ) + ( sum>>16 );
+  sum = ( sum & 0xffffU ) + ( sum>>16 );
+
+  fd_memcpy( out, tmpl->hdr, FDGEN_TILE_GEN_TMPL_SZ );
+  fd_ip4_hdr_t * ip4_hdr = fd_type_pun( out+14 );
+  fd_udp_hdr_t * udp_hdr = fd_type_pun( out+34 );
+  ip4_hdr->net_tot_len = net_tot_len;
+  ip4_hdr->net_id      = net_id;
+  ip4_hdr->check       = (ushort)~sum;
+  udp_hdr->net_sport   = (ushort)fd_ushort_bswap( src_port );
+  udp_hdr->net_len     = net_udp_len;
+  return FDGEN_TILE_GEN_TMPL_SZ + payload_sz;
+}
+
+/* fdgen_tile_gen_tmpl_write_flow is fdgen_tile_gen_tmpl_write with
+   the addresses and ports of flow instead of those of the template. */
+
+static inline ulong
+fdgen_tile_gen_tmpl_write_flow( uchar *                       out,
+                                fdgen_tile_gen_tmpl_t const * tmpl,
+                                fdgen_tile_gen_flow_t const * flow,
+                                ushort                        ip_id,
+                                ulong                         payload_sz ) {
+
+  ushort net_tot_len = (ushort)fd_ushort_bswap( (ushort)( 20UL+8UL+payload_sz ) );
+  ushort net_id      = (ushort)fd_ushort_bswap( ip_id );
+  ushort net_udp_len = (ushort)fd_ushort_bswap( (ushort)(      8UL+payload_sz ) );
+
+  /* Incremental checksum over the zeroed tot_len, id and address words */
+  ulong sum = (ulong)tmpl->check_base_flow + (ulong)net_tot_len + (ulong)net_id
+            + (ulong)( flow->src_ip & 0xffffU ) + (ulong)( flow->src_ip>>16 )
+            + (ulong)( flow->dst_ip & 0xffffU ) + (ulong)( flow->dst_ip>>16 );
+  sum = ( sum & 0xffffUL ) + ( sum>>16 );
+  sum = ( sum & 0xffffUL ) + ( sum>>16 );
+
+  fd_memcpy( out, tmpl->hdr, FDGEN_TILE_GEN_TMPL_SZ );
+  fd_ip4_hdr_t * ip4_hdr = fd_type_pun( out+14 );
+  fd_udp_hdr_t * udp_hdr = fd_type_pun( out+34 );
+  ip4_hdr->net_tot_len = net_tot_len;
+  ip4_hdr->net_id      = net_id;
+  ip4_hdr->check       = (ushort)~sum;
+  memcpy( ip4_hdr->saddr_c, &flow->src_ip, 4 );
+  memcpy( ip4_hdr->daddr_c, &flow->dst_ip, 4 );
+  udp_hdr->net_sport   = (ushort)fd_ushort_bswap( flow->src_port );
+  udp_hdr->net_dport   = (ushort)fd_ushort_bswap( flow->dst_port );
+  udp_hdr->net_len     = net_udp_len;
+  return FDGEN_TILE_GEN_TMPL_SZ + payload_sz;
+}
+
+/* fdgen_tile_gen_frame_patch_flow replaces the addresses and ports of
+   an Ethernet/IPv4/UDP frame with those of flow.  The IPv4 header must
+   be without options.  The IPv4 checksum is updated incrementally, the
+   UDP checksum is cleared. */
+
+static inline void
+fdgen_tile_gen_frame_patch_flow( uchar *                       frame,
+                                 fdgen_tile_gen_flow_t const * flow ) {
+
+  fd_ip4_hdr_t * ip4_hdr = fd_type_pun( frame+14 );
+  fd_udp_hdr_t * udp_hdr = fd_type_pun( frame+34 );
+
+  uint   saddr; memcpy( &saddr, ip4_hdr->saddr_c, 4 );
+  uint   daddr; memcpy( &daddr, ip4_hdr->daddr_c, 4 );
+  ushort check = ip4_hdr->check;
+  check = fdgen_ip4_check_update( check, (ushort)( saddr & 0xffffU ), (ushort)( flow->src_ip & 0xffffU ) );
+  check = fdgen_ip4_check_update( check, (ushort)( saddr>>16       ), (ushort)( flow->src_ip>>16       ) );
+  check = fdgen_ip4_check_update( check, (ushort)( daddr & 0xffffU ), (ushort)( flow->dst_ip & 0xffffU ) );
+  check = fdgen_ip4_check_update( check, (ushort)( daddr>>16       ), (ushort)( flow->dst_ip>>16       ) );
+
+  ip4_hdr->check     = check;
+  memcpy( ip4_hdr->saddr_c, &flow->src_ip, 4 );
+  memcpy( ip4_hdr->daddr_c, &flow->dst_ip, 4 );
+  udp_hdr->net_sport = (ushort)fd_ushort_bswap( flow->src_port );
+  udp_hdr->net_dport = (ushort)fd_ushort_bswap( flow->dst_port );
+  udp_hdr->check     = 0;
+}
+
+FD_PROTOTYPES_END
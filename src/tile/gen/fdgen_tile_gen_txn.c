@@ -0,0 +1,223 @@
+#include "fdgen_tile_gen_txn.h"
+#include "fdgen_tile_gen_tmpl.h"
+
+#include <firedancer/util/fd_util.h>
+#include <firedancer/ballet/ed25519/fd_ed25519.h>
+#include <firedancer/ballet/sha512/fd_sha512.h>
+
+/* TXN_PART_MAX bounds the number of parts (tiles incl. the caller) a
+   pool fill is split into */
+
+#define TXN_PART_MAX (256UL)
+
+#define TXN_PHASE_KEYS (0)  /* derive payer keys */
+#define TXN_PHASE_SIGN (1)  /* sign frames */
+
+#define TXN_KEY_DOMAIN_PAYER (1UL)
+#define TXN_KEY_DOMAIN_DEST  (2UL)
+
+/* txn_part_t is the share of a pool fill phase done by one tile.  Each
+   part covers a contiguous range of payers or frames. */
+
+struct txn_part {
+  fdgen_tile_gen_pool_t * pool;
+  uchar *                 keys;   /* payer_cnt x ( private key, public key ) */
+  ulong                   seed;
+  ulong                   idx0;   /* first payer or frame */
+  ulong                   idx1;   /* one past the last */
+  int                     phase;  /* TXN_PHASE_* */
+};
+
+typedef struct txn_part txn_part_t;
+
+FD_FN_CONST ulong
+fdgen_tile_gen_txn_scratch_align( void ) {
+  return 128UL;  /* arbitrarily large */
+}
+
+FD_FN_CONST ulong
+fdgen_tile_gen_txn_scratch_footprint( ulong payer_cnt ) {
+  return fd_ulong_align_up( fd_ulong_max( payer_cnt, 1UL )*64UL, fdgen_tile_gen_txn_scratch_align() );
+}
+
+/* txn_key_derive fills the 32 bytes at key from seed, a domain and an
+   index.  fd_ulong_hash is a bijection, so distinct inputs give
+   distinct keys. */
+
+static void
+txn_key_derive( uchar * key,
+                ulong   seed,
+                ulong   domain,
+                ulong   idx ) {
+  for( ulong k=0UL; k<4UL; k++ ) {
+    FD_STORE( ulong, key+8UL*k, fd_ulong_hash( seed ^ fd_ulong_hash( ( domain<<62 ) | ( idx<<2 ) | k ) ) );
+  }
+}
+
+static int
+txn_part_run( txn_part_t const * part ) {
+
+  fd_sha512_t _sha512[1];
+  fd_sha512_t * sha512 = fd_sha512_join( fd_sha512_new( _sha512 ) );
+  if( FD_UNLIKELY( !sha512 ) ) { FD_LOG_WARNING(( "fd_sha512_new failed" )); return 1; }
+
+  if( part->phase==TXN_PHASE_KEYS ) {
+    for( ulong j=part->idx0; j<part->idx1; j++ ) {
+      uchar * key = part->keys + 64UL*j;
+      txn_key_derive( key, part->seed, TXN_KEY_DOMAIN_PAYER, j );
+      fd_ed25519_public_from_private( key+32UL, key, sha512 );
+    }
+  } else {
+    for( ulong j=part->idx0; j<part->idx1; j++ ) {
+      uchar *       txn    = (uchar *)fdgen_tile_gen_pool_frame( part->pool, j ) + FDGEN_TXN_FRAME_OFF;
+      ulong         payer  = FD_LOAD( ulong, txn+FDGEN_TXN_SIG_OFF );  /* stashed by fill */
+      uchar const * key    = part->keys + 64UL*payer;
+      fd_ed25519_sign( txn+FDGEN_TXN_SIG_OFF, txn+FDGEN_TXN_MSG_OFF, FDGEN_TXN_MSG_SZ, key+32UL, key, sha512 );
+    }
+  }
+
+  fd_sha512_delete( fd_sha512_leave( sha512 ) );
+  return 0;
+}
+
+static int
+txn_part_main( int     argc,
+               char ** argv ) {
+  (void)argc;
+  return txn_part_run( fd_type_pun_const( argv[0] ) );
+}
+
+/* txn_parallel splits [lo,hi) of a phase over part_cnt parts, runs
+   parts 1 and up on tiles tile0 and up and part 0 on the caller, and
+   waits for all of them.  Returns 0 on success. */
+
+static int
+txn_parallel( txn_part_t const * proto,
+              ulong              lo,
+              ulong              hi,
+              ulong              part_cnt,
+              ulong              tile0 ) {
+
+  txn_part_t       part[ TXN_PART_MAX ];
+  fd_tile_exec_t * exec[ TXN_PART_MAX ];
+  char *           argv[ TXN_PART_MAX ][ 1 ];
+
+  for( ulong k=0UL; k<part_cnt; k++ ) {
+    part[ k ]      = *proto;
+    part[ k ].idx0 = lo + ( ( hi-lo )*k        )/part_cnt;
+    part[ k ].idx1 = lo + ( ( hi-lo )*( k+1UL ) )/part_cnt;
+  }
+
+  int err = 0;
+  for( ulong k=1UL; k<part_cnt; k++ ) {
+    argv[ k ][ 0 ] = fd_type_pun( &part[ k ] );
+    exec[ k ]      = fd_tile_exec_new( tile0+k-1UL, txn_part_main, 1, argv[ k ] );
+    if( FD_UNLIKELY( !exec[ k ] ) ) { FD_LOG_WARNING(( "fd_tile_exec_new( %lu ) failed", tile0+k-1UL )); err = 1; }
+  }
+
+  if( FD_LIKELY( !err ) ) err = txn_part_run( &part[ 0 ] );
+
+  for( ulong k=1UL; k<part_cnt; k++ ) {
+    if( FD_UNLIKELY( !exec[ k ] ) ) continue;
+    int          ret  = 0;
+    char const * fail = fd_tile_exec_delete( exec[ k ], &ret );
+    if( FD_UNLIKELY( fail || ret ) ) { FD_LOG_WARNING(( "tile %lu failed (%s)", tile0+k-1UL, fail ? fail : "ret" )); err = 1; }
+  }
+  return err;
+}
+
+ulong
+fdgen_tile_gen_txn_pool_fill( fdgen_tile_gen_pool_t *             pool,
+                              fdgen_tile_gen_txn_params_t const * params,
+                              void *                              scratch,
+                              ulong                               tile0,
+                              ulong                               tile_cnt ) {
+
+  if( FD_UNLIKELY( !pool    ) ) { FD_LOG_WARNING(( "NULL pool"    )); return 0UL; }
+  if( FD_UNLIKELY( !params  ) ) { FD_LOG_WARNING(( "NULL params"  )); return 0UL; }
+  if( FD_UNLIKELY( !scratch ) ) { FD_LOG_WARNING(( "NULL scratch" )); return 0UL; }
+  if( FD_UNLIKELY( !fd_ulong_is_aligned( (ulong)scratch, fdgen_tile_gen_txn_scratch_align() ) ) ) {
+    FD_LOG_WARNING(( "misaligned scratch" ));
+    return 0UL;
+  }
+  if( FD_UNLIKELY( pool->stride<FDGEN_TXN_FRAME_SZ ) ) {
+    FD_LOG_WARNING(( "pool slots of %lu bytes cannot hold %lu byte frames", pool->stride, FDGEN_TXN_FRAME_SZ ));
+    return 0UL;
+  }
+  if( FD_UNLIKELY( tile_cnt>=TXN_PART_MAX ) ) { FD_LOG_WARNING(( "tile_cnt %lu too large", tile_cnt )); return 0UL; }
+  if( FD_UNLIKELY( tile_cnt && tile0+tile_cnt>fd_tile_cnt() ) ) {
+    FD_LOG_WARNING(( "tiles [%lu,%lu) out of range", tile0, tile0+tile_cnt ));
+    return 0UL;
+  }
+
+  ulong   payer_cnt = fd_ulong_max( params->payer_cnt, 1UL );
+  ulong   dest_cnt  = fd_ulong_max( params->dest_cnt,  1UL );
+  ulong   part_cnt  = tile_cnt+1UL;
+  uchar * keys      = scratch;
+
+  long t0 = fd_log_wallclock();
+
+  /* Payer keys */
+
+  txn_part_t proto = {
+    .pool  = pool,
+    .keys  = keys,
+    .seed  = params->seed,
+    .phase = TXN_PHASE_KEYS
+  };
+  if( FD_UNLIKELY( txn_parallel( &proto, 0UL, payer_cnt, part_cnt, tile0 ) ) ) return 0UL;
+
+  /* Serialize frames.  The payer index is stashed in the signature
+     field for the signing phase. */
+
+  fdgen_tile_gen_tmpl_t tmpl[1];
+  fdgen_tile_gen_tmpl_init( tmpl, params->src_mac, params->dst_mac, params->src_ip, params->dst_ip, params->dst_port, 64 );
+
+  ulong frame0 = pool->frame_cnt;
+  for( ulong i=0UL; pool->frame_cnt<pool->frame_max; i++ ) {
+    ulong   frame_idx = pool->frame_cnt;
+    uchar * frame     = fdgen_tile_gen_pool_append( pool, FDGEN_TXN_FRAME_SZ );
+    fdgen_tile_gen_tmpl_write( frame, tmpl, params->src_port, (ushort)frame_idx, FDGEN_TXN_SZ );
+
+    ulong   payer = i % payer_cnt;
+    ulong   dest  = ( i / payer_cnt ) % dest_cnt;
+    uchar * txn   = frame + FDGEN_TXN_FRAME_OFF;
+    uchar * msg   = txn + FDGEN_TXN_MSG_OFF;
+
+    txn[ 0 ] = 1;                                           /* signature count */
+    fd_memset( txn+FDGEN_TXN_SIG_OFF, 0, 64UL );
+    FD_STORE( ulong, txn+FDGEN_TXN_SIG_OFF, payer );
+
+    msg[ 0 ] = 1;                                           /* required signatures */
+    msg[ 1 ] = 0;                                           /* read-only signed accounts */
+    msg[ 2 ] = 1;                                           /* read-only unsigned accounts (System Program) */
+    msg[ 3 ] = 3;                                           /* account count */
+    fd_memcpy( msg+  4, keys+64UL*payer+32UL, 32UL );       /* fee payer, writable signer */
+    txn_key_derive( msg+36, params->seed, TXN_KEY_DOMAIN_DEST, dest );
+    fd_memset( msg+ 68, 0, 32UL );                          /* System Program */
+    fd_memcpy( msg+100, params->blockhash, 32UL );
+    msg[ 132 ] = 1;                                         /* instruction count */
+    msg[ 133 ] = 2;                                         /* program account index */
+    msg[ 134 ] = 2;                                         /* account index count */
+    msg[ 135 ] = 0;                                         /* from */
+    msg[ 136 ] = 1;                                         /* to */
+    msg[ 137 ] = 12;                                        /* data size */
+    FD_STORE( uint,  msg+138, 2U );                         /* SystemInstruction::Transfer */
+    FD_STORE( ulong, msg+142, params->lamports + i );
+  }
+  ulong fill_cnt = pool->frame_cnt - frame0;
+
+  /* Sign */
+
+  long t1 = fd_log_wallclock();
+  proto.phase = TXN_PHASE_SIGN;
+  if( FD_UNLIKELY( txn_parallel( &proto, frame0, pool->frame_cnt, part_cnt, tile0 ) ) ) return 0UL;
+
+  long t2 = fd_log_wallclock();
+  FD_LOG_NOTICE(( "Built %lu transactions (%lu payers) on %lu tiles in %.3f s (keys and frames %.3f s, "
+                  "signing %.1f us/txn/tile), pool %lu bytes",
+                  fill_cnt, payer_cnt, part_cnt, (double)( t2-t0 )*1e-9, (double)( t1-t0 )*1e-9,
+                  (double)( t2-t1 )*1e-3*(double)part_cnt/(double)fd_ulong_max( fill_cnt, 1UL ),
+                  fdgen_tile_gen_pool_footprint( pool->frame_max, pool->stride ) ));
+  return fill_cnt;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+/* fdgen_tile_gen_txn.h fills frame pools (fdgen_tile_gen_pool.h) with
+   signed Solana transactions for load testing TPU ports.
+
+   Each frame is an Ethernet/IPv4/UDP datagram carrying one legacy
+   transaction: a System Program transfer from one of payer_cnt fee
+   payers to one of dest_cnt recipients, with the given recent
+   blockhash.  Transaction i of the pool transfers lamports+i, so every
+   message and signature in the pool is distinct and passes dedup.
+
+   Signing dominates the build (one ed25519 signature per frame) and is
+   spread over tiles: the pool is partitioned by frame index, each part
+   signed by one tile with its own sha512 state.  The gen tile then
+   replays the pool without signing on the hot path.
+
+   Keys are derived from the seed with fd_ulong_hash.  They are not
+   secret and must only be used for load tests.  Payer accounts must be
+   funded on the cluster under test for transactions to execute,
+   otherwise they exercise the TPU up to fee payer checks.
+
+   A pool is signed against one recent blockhash.  Refreshing the
+   blockhash means refilling the pool.  The gen tile can tag pool
+   frames per packet (see pool_tag_off in fdgen_tile_gen.h), e.g. with
+   FDGEN_TXN_FRAME_LAMPORTS_OFF to make every packet unique, at the
+   cost of invalidating its signature. */
+
+#include "fdgen_tile_gen_pool.h"
+
+/* FDGEN_TXN_* give the layout of a serialized transfer transaction:
+   signature count, signature, then the message (header, 3 account
+   keys, recent blockhash, 1 instruction with 12 bytes of data). */
+
+#define FDGEN_TXN_SIG_OFF       (1UL)
+#define FDGEN_TXN_MSG_OFF       (65UL)
+#define FDGEN_TXN_MSG_SZ        (150UL)
+#define FDGEN_TXN_PAYER_OFF     (FDGEN_TXN_MSG_OFF+4UL)
+#define FDGEN_TXN_BLOCKHASH_OFF (FDGEN_TXN_MSG_OFF+100UL)
+#define FDGEN_TXN_LAMPORTS_OFF  (FDGEN_TXN_MSG_OFF+142UL)
+#define FDGEN_TXN_SZ            (FDGEN_TXN_MSG_OFF+FDGEN_TXN_MSG_SZ)
+
+/* FDGEN_TXN_FRAME_* are the offsets of the transaction and of its
+   lamports field in a pool frame */
+
+#define FDGEN_TXN_FRAME_OFF          (42UL)
+#define FDGEN_TXN_FRAME_LAMPORTS_OFF (FDGEN_TXN_FRAME_OFF+FDGEN_TXN_LAMPORTS_OFF)
+#define FDGEN_TXN_FRAME_SZ           (FDGEN_TXN_FRAME_OFF+FDGEN_TXN_SZ)
+
+/* fdgen_tile_gen_txn_params_t describes the transactions of a pool and
+   the headers of the frames carrying them. */
+
+struct fdgen_tile_gen_txn_params {
+  uchar  src_mac[ 6 ];
+  uchar  dst_mac[ 6 ];
+  uint   src_ip;             /* net order */
+  uint   dst_ip;             /* net order */
+  ushort src_port;           /* host order */
+  ushort dst_port;           /* host order, e.g. the TPU port */
+
+  ulong  payer_cnt;          /* distinct fee payers (signers), 0 is treated as 1 */
+  ulong  dest_cnt;           /* distinct recipients, 0 is treated as 1 */
+  ulong  lamports;           /* amount of the first transfer */
+  uchar  blockhash[ 32 ];    /* recent blockhash */
+  ulong  seed;               /* key derivation seed */
+};
+
+typedef struct fdgen_tile_gen_txn_params fdgen_tile_gen_txn_params_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_gen_txn_scratch_{align,footprint} specify parameters of
+   the scratch memory region used while filling a pool (payer keys). */
+
+FD_FN_CONST ulong
+fdgen_tile_gen_txn_scratch_align( void );
+
+FD_FN_CONST ulong
+fdgen_tile_gen_txn_scratch_footprint( ulong payer_cnt );
+
+/* fdgen_tile_gen_txn_pool_fill fills pool up to its capacity with
+   transactions described by params.  Key derivation and signing run on
+   the caller and on tiles [tile0,tile0+tile_cnt), which must be idle
+   (tile_cnt 0 signs on the caller only).  pool must have room for
+   frames of FDGEN_TXN_FRAME_SZ bytes.  Logs the build time and the
+   pool footprint.  Returns the number of frames appended, 0 on failure
+   (logs details). */
+
+ulong
+fdgen_tile_gen_txn_pool_fill( fdgen_tile_gen_pool_t *             pool,
+                              fdgen_tile_gen_txn_params_t const * params,
+                              void *                              scratch,
+                              ulong                               tile0,
+                              ulong                               tile_cnt );
+
+/* fdgen_tile_gen_txn_payer returns the fee payer public key of the
+   transaction in pool frame, which is also its signer. */
+
+FD_FN_PURE static inline uchar const *
+fdgen_tile_gen_txn_payer( uchar const * frame ) {
+  return frame + FDGEN_TXN_FRAME_OFF + FDGEN_TXN_PAYER_OFF;
+}
+
+FD_PROTOTYPES_END
@@ -0,0 +1,832 @@
+#define _GNU_SOURCE
+#include "fdgen_tile_gen.h"
+#include "fdgen_tile_gen_txn.h"
+
+/* test_tile_gen.c runs the gen tile at fixed packet and bit rates and
+   checks the achieved rates and frame contents. */
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+#include <firedancer/util/net/fd_eth.h>
+#include <firedancer/util/net/fd_ip4.h>
+#include <firedancer/util/net/fd_udp.h>
+#include <firedancer/ballet/ed25519/fd_ed25519.h>
+#include <firedancer/ballet/sha512/fd_sha512.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>         /* mkstemp, calloc */
+#include <unistd.h>         /* unlink */
+
+static int
+gen_tile_main( int     argc,
+               char ** argv ) {
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, (uint)fd_tickcount(), 0UL ) );
+
+  fdgen_tile_gen_cfg_t * cfg = fd_type_pun( argv[0] );
+  cfg->rng  = rng;
+  cfg->lazy = 10000L;
+
+  int res = fdgen_tile_gen_run( cfg );
+
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return res;
+}
+
+/* test_rate runs the gen tile for duration ns, consumes every frame and
+   checks the achieved rate against the expected frame rate exp_pps.
+   Returns the coefficient of variation of frame inter-arrival times. */
+
+static double
+test_rate( fd_wksp_t *            wksp,
+           fd_cnc_t *             cnc,
+           fd_frag_meta_t *       mcache,
+           fdgen_tile_gen_cfg_t * cfg,
+           long                   duration,
+           double                 exp_pps ) {
+
+  FD_LOG_NOTICE(( "Testing pps %lu bps %lu pkt_sz %lu", cfg->pps, cfg->bps, cfg->pkt_sz ));
+
+  ulong depth = fd_mcache_depth( mcache );
+  ulong seq   = fd_mcache_seq_query( fd_mcache_seq_laddr( mcache ) );
+
+  fdgen_tile_gen_diag_t * diag = fd_cnc_app_laddr( cnc );
+  memset( diag, 0, sizeof(fdgen_tile_gen_diag_t) );
+
+  char * gen_tile_argv[1] = { fd_type_pun( cfg ) };
+  fd_tile_exec_t * gen_tile = fd_tile_exec_new( 1UL, gen_tile_main, 1, gen_tile_argv );
+  FD_TEST( gen_tile );
+  FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+  /* Consume frames, checking headers and tags */
+
+  ulong  rx_cnt   = 0UL;
+  long   ts_last  = 0L;
+  double gap_sum  = 0.0;
+  double gap_sum2 = 0.0;
+  long   deadline = fd_log_wallclock() + duration;
+  while( fd_log_wallclock()<deadline ) {
+    fd_frag_meta_t const * mline = mcache + fd_mcache_line_idx( seq, depth );
+    ulong seq_found = fd_frag_meta_seq_query( mline );
+    long  diff      = fd_seq_diff( seq_found, seq );
+    if( diff<0L ) { FD_SPIN_PAUSE(); continue; }
+    if( FD_UNLIKELY( diff>0L ) ) FD_LOG_ERR(( "overrun at seq %lu", seq ));
+
+    uchar const *        pkt     = fd_chunk_to_laddr_const( wksp, mline->chunk );
+    fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( pkt+14 );
+    fd_udp_hdr_t const * udp_hdr = fd_type_pun_const( pkt+34 );
+    if( cfg->size ) FD_TEST( mline->sz>=cfg->size->sz_min && mline->sz<=cfg->size->sz_max );
+    else            FD_TEST( mline->sz==cfg->pkt_sz );
+    FD_TEST( fd_ushort_bswap( ip4_hdr->net_tot_len )==mline->sz-14UL );
+    FD_TEST( fd_ushort_bswap( udp_hdr->net_dport   )==cfg->dst_port  );
+    FD_TEST( fd_ushort_bswap( ip4_hdr->net_id      )==(ushort)seq    );
+    FD_TEST( fdgen_udp4_frame_check( pkt, mline->sz ) );
+    FD_TEST( !udp_hdr->check==!cfg->udp_check );
+    FD_TEST( FD_LOAD( ulong, pkt+42 )==seq );
+    FD_TEST( mline->sig<( cfg->flows ? cfg->flows->flow_cnt : 1UL ) );
+    long ts = fd_frag_meta_ts_decomp( mline->tspub, fd_tickcount() );
+    FD_TEST( fd_seq_eq( fd_frag_meta_seq_query( mline ), seq ) );
+
+    if( rx_cnt ) {
+      double gap = (double)( ts-ts_last );
+      gap_sum  += gap;
+      gap_sum2 += gap*gap;
+    }
+    ts_last = ts;
+
+    seq = fd_seq_inc( seq, 1UL );
+    rx_cnt++;
+  }
+
+  FD_TEST( !fd_cnc_open( cnc ) );
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( cnc );
+  FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  fd_tile_exec_delete( gen_tile, NULL );
+
+  double jit_avg = (double)diag->jit_sum_ns / (double)fd_ulong_max( diag->pub_cnt, 1UL );
+  FD_LOG_NOTICE(( "gen: pub_cnt %lu act_pps %lu (tgt %lu) act_bps %lu (tgt %lu) jit_avg %.1f ns jit_max %lu ns",
+                  diag->pub_cnt, diag->act_pps, diag->tgt_pps, diag->act_bps, diag->tgt_bps, jit_avg, diag->jit_max_ns ));
+
+  /* Allow 5% for scheduling noise at startup and teardown */
+
+  double exp_cnt = exp_pps * (double)duration * 1e-9;
+  FD_TEST( (double)rx_cnt>=0.95*exp_cnt && (double)rx_cnt<=1.05*exp_cnt );
+  FD_TEST( (double)diag->act_pps>=0.95*exp_pps && (double)diag->act_pps<=1.05*exp_pps );
+
+  double gap_cnt  = (double)fd_ulong_max( rx_cnt, 2UL ) - 1.0;
+  double gap_mean = gap_sum / gap_cnt;
+  double gap_var  = gap_sum2 / gap_cnt - gap_mean*gap_mean;
+  return sqrt( gap_var>0.0 ? gap_var : 0.0 ) / gap_mean;
+}
+
+/* test_flow_set checks that a flow set visits every flow exactly once
+   per period and that flow indices decode to in-range fields */
+
+static void
+test_flow_set( void ) {
+  fdgen_tile_gen_flow_params_t params = {
+    .src_ip   = FD_IP4_ADDR( 10, 0, 0, 250 ), .src_ip_cnt   = 3UL,
+    .src_port = 1000,                         .src_port_cnt = 5UL,
+    .dst_ip   = FD_IP4_ADDR( 10, 1, 0, 1   ), .dst_ip_cnt   = 7UL,
+    .dst_port = 65534,                        .dst_port_cnt = 2UL
+  };
+  fdgen_tile_gen_flow_set_t set[1];
+  FD_TEST( fdgen_tile_gen_flow_set_init( set, &params, 42UL )==set );
+  FD_TEST( set->flow_cnt==210UL );
+
+  uchar seen[ 210 ];
+  for( ulong period=0UL; period<2UL; period++ ) {
+    memset( seen, 0, sizeof(seen) );
+    for( ulong i=0UL; i<210UL; i++ ) {
+      fdgen_tile_gen_flow_t flow;
+      ulong idx = fdgen_tile_gen_flow_next( set, &flow );
+      FD_TEST( idx<210UL && !seen[ idx ] );
+      seen[ idx ] = 1;
+
+      ulong src_ip   = fd_uint_bswap( flow.src_ip ) - fd_uint_bswap( params.src_ip );
+      ulong src_port = flow.src_port - params.src_port;
+      ulong dst_ip   = fd_uint_bswap( flow.dst_ip ) - fd_uint_bswap( params.dst_ip );
+      ulong dst_port = flow.dst_port - params.dst_port;
+      FD_TEST( src_ip<3UL && src_port<5UL && dst_ip<7UL && dst_port<2UL );
+      FD_TEST( idx==src_ip + 3UL*( src_port + 5UL*( dst_ip + 7UL*dst_port ) ) );
+    }
+  }
+
+  /* Larger set, coverage over one period */
+
+  params.src_ip_cnt   = 1024UL;
+  params.src_port     = 1024;
+  params.src_port_cnt = 4096UL;
+  params.dst_ip_cnt   = 1UL;
+  params.dst_port_cnt = 1UL;
+  FD_TEST( fdgen_tile_gen_flow_set_init( set, &params, 7UL )==set );
+  ulong   flow_cnt = set->flow_cnt;
+  ulong * bits     = calloc( flow_cnt/64UL, sizeof(ulong) );
+  FD_TEST( bits );
+  for( ulong i=0UL; i<flow_cnt; i++ ) {
+    fdgen_tile_gen_flow_t flow;
+    ulong idx = fdgen_tile_gen_flow_next( set, &flow );
+    ulong bit = 1UL<<( idx & 63UL );
+    FD_TEST( !( bits[ idx>>6 ] & bit ) );
+    bits[ idx>>6 ] |= bit;
+  }
+  free( bits );
+
+  /* Ranges must not wrap */
+
+  params.src_port     = 65000;
+  params.src_port_cnt = 1024UL;
+  FD_TEST( !fdgen_tile_gen_flow_set_init( set, &params, 0UL ) );
+}
+
+/* test_pool runs the gen tile over a pool of frames of varying sizes
+   carrying captured UDP checksums, verbatim, patched with a flow set,
+   tagged per packet and with checksums recomputed, and checks that
+   frames are sent in pool order with valid checksums */
+
+static void
+test_pool( fd_wksp_t *            wksp,
+           fd_cnc_t *             cnc,
+           fd_frag_meta_t *       mcache,
+           fdgen_tile_gen_cfg_t * cfg,
+           long                   duration ) {
+
+  static ulong const sz[] = { 60UL, 200UL, 1514UL, 90UL, 700UL };
+  ulong const        frame_cnt = sizeof(sz)/sizeof(sz[0]);
+
+  void *                  pool_mem = fd_wksp_alloc_laddr( wksp, fdgen_tile_gen_pool_align(), fdgen_tile_gen_pool_footprint( frame_cnt, cfg->mtu ), 1UL );
+  fdgen_tile_gen_pool_t * pool     = fdgen_tile_gen_pool_new( pool_mem, frame_cnt, cfg->mtu );
+  FD_TEST( pool );
+
+  fdgen_tile_gen_tmpl_t tmpl[1];
+  uchar mac[ 6 ] = {0};
+  fdgen_tile_gen_tmpl_init( tmpl, mac, mac, cfg->src_ip, cfg->dst_ip, cfg->dst_port, 64 );
+  for( ulong j=0UL; j<frame_cnt; j++ ) {
+    uchar * frame = fdgen_tile_gen_pool_append( pool, sz[ j ] );
+    FD_TEST( frame );
+    fdgen_tile_gen_tmpl_write( frame, tmpl, cfg->src_port, (ushort)j, sz[ j ]-FDGEN_TILE_GEN_TMPL_SZ );
+    memset( frame+FDGEN_TILE_GEN_TMPL_SZ, (int)j, sz[ j ]-FDGEN_TILE_GEN_TMPL_SZ );
+    fdgen_udp4_check_fill( fd_type_pun_const( frame+14 ), fd_type_pun( frame+34 ), sz[ j ]-34UL );
+    FD_TEST( ( (fd_udp_hdr_t const *)( frame+34 ) )->check );
+  }
+  FD_TEST( !fdgen_tile_gen_pool_append( pool, 60UL ) );
+  FD_TEST( pool->sz_max==1514UL && pool->sz_sum==2564UL );
+
+  fdgen_tile_gen_flow_params_t flow_params = {
+    .src_ip   = cfg->src_ip, .src_ip_cnt   = 4UL,
+    .src_port = 20000,       .src_port_cnt = 100UL,
+    .dst_ip   = cfg->dst_ip, .dst_ip_cnt   = 1UL,
+    .dst_port = 7000,        .dst_port_cnt = 1UL
+  };
+  fdgen_tile_gen_flow_set_t flows[1];
+  FD_TEST( fdgen_tile_gen_flow_set_init( flows, &flow_params, 3UL ) );
+
+  /* Modes: verbatim, flows with checksums, tag without checksums,
+     checksums only, tag with checksums */
+
+  static int const mode_patch[ 5 ] = { 0, 1, 0, 0, 0 };
+  static int const mode_tag  [ 5 ] = { 0, 0, 1, 0, 1 };
+  static int const mode_check[ 5 ] = { 0, 1, 0, 1, 1 };
+
+  cfg->pool = pool;
+  for( int mode=0; mode<5; mode++ ) {
+    FD_LOG_NOTICE(( "Testing pool (%lu frames, mode %d)", frame_cnt, mode ));
+
+    int patch = mode_patch[ mode ];
+    int tag   = mode_tag  [ mode ];
+    cfg->flows        = patch ? flows : NULL;
+    cfg->udp_check    = mode_check[ mode ];
+    cfg->pool_tag_off = tag ? FDGEN_TILE_GEN_TMPL_SZ : 0UL;
+
+    ulong depth = fd_mcache_depth( mcache );
+    ulong seq0  = fd_mcache_seq_query( fd_mcache_seq_laddr( mcache ) );
+    ulong seq   = seq0;
+
+    fdgen_tile_gen_diag_t * diag = fd_cnc_app_laddr( cnc );
+    memset( diag, 0, sizeof(fdgen_tile_gen_diag_t) );
+
+    char * gen_tile_argv[1] = { fd_type_pun( cfg ) };
+    fd_tile_exec_t * gen_tile = fd_tile_exec_new( 1UL, gen_tile_main, 1, gen_tile_argv );
+    FD_TEST( gen_tile );
+    FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+    ulong rx_sz    = 0UL;
+    long  deadline = fd_log_wallclock() + duration;
+    while( fd_log_wallclock()<deadline ) {
+      fd_frag_meta_t const * mline = mcache + fd_mcache_line_idx( seq, depth );
+      long diff = fd_seq_diff( fd_frag_meta_seq_query( mline ), seq );
+      if( diff<0L ) { FD_SPIN_PAUSE(); continue; }
+      if( FD_UNLIKELY( diff>0L ) ) FD_LOG_ERR(( "overrun at seq %lu", seq ));
+
+      ulong                idx     = (ulong)fd_seq_diff( seq, seq0 ) % frame_cnt;
+      uchar const *        pkt     = fd_chunk_to_laddr_const( wksp, mline->chunk );
+      fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( pkt+14 );
+      fd_udp_hdr_t const * udp_hdr = fd_type_pun_const( pkt+34 );
+      FD_TEST( mline->sz==sz[ idx ] );
+      FD_TEST( fd_ushort_bswap( ip4_hdr->net_id )==idx );
+      FD_TEST( pkt[ mline->sz-1UL ]==idx );
+      FD_TEST( fdgen_udp4_frame_check( pkt, mline->sz ) );
+      FD_TEST( !udp_hdr->check==( tag && !cfg->udp_check ) );  /* captured or recomputed unless stale */
+      if( patch ) {
+        ushort sport = fd_ushort_bswap( udp_hdr->net_sport );
+        FD_TEST( mline->sig<flows->flow_cnt );
+        FD_TEST( sport>=20000 && sport<20100 );
+        FD_TEST( fd_ushort_bswap( udp_hdr->net_dport )==7000 );
+      } else {
+        FD_TEST( mline->sig==idx );
+        FD_TEST( fd_ushort_bswap( udp_hdr->net_sport )==cfg->src_port );
+      }
+      if( tag ) FD_TEST( FD_LOAD( ulong, pkt+FDGEN_TILE_GEN_TMPL_SZ )==seq );
+      rx_sz += mline->sz;
+      FD_TEST( fd_seq_eq( fd_frag_meta_seq_query( mline ), seq ) );
+      seq = fd_seq_inc( seq, 1UL );
+    }
+
+    FD_TEST( !fd_cnc_open( cnc ) );
+    fd_cnc_signal( cnc, FD_CNC_SIGNAL_HALT );
+    fd_cnc_close( cnc );
+    FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+    fd_tile_exec_delete( gen_tile, NULL );
+
+    /* bps pacing charges each frame its own size */
+
+    FD_LOG_NOTICE(( "gen: pub_cnt %lu act_bps %lu (tgt %lu)", diag->pub_cnt, diag->act_bps, diag->tgt_bps ));
+    double exp_sz = (double)cfg->bps * (double)duration * 1e-9 / 8.0;
+    FD_TEST( (double)rx_sz>=0.95*exp_sz && (double)rx_sz<=1.05*exp_sz );
+  }
+
+  cfg->pool         = NULL;
+  cfg->pool_tag_off = 0UL;
+  cfg->flows        = NULL;
+  cfg->udp_check    = 0;
+  fd_wksp_free_laddr( pool_mem );
+}
+
+/* test_txn_pool fills a pool with signed transfers, signing on all
+   tiles, and checks frame layout, signatures and uniqueness */
+
+static void
+test_txn_pool( fd_wksp_t * wksp,
+               ulong       mtu ) {
+
+  ulong frame_cnt = 4096UL;
+  fdgen_tile_gen_txn_params_t params = {
+    .src_ip    = FD_IP4_ADDR( 127, 0, 0, 1 ),
+    .dst_ip    = FD_IP4_ADDR( 127, 0, 0, 1 ),
+    .src_port  = 9500,
+    .dst_port  = 8001,
+    .payer_cnt = 64UL,
+    .dest_cnt  = 16UL,
+    .lamports  = 1000UL,
+    .seed      = 5UL
+  };
+  for( ulong j=0UL; j<32UL; j++ ) params.blockhash[ j ] = (uchar)j;
+
+  void *                  pool_mem = fd_wksp_alloc_laddr( wksp, fdgen_tile_gen_pool_align(), fdgen_tile_gen_pool_footprint( frame_cnt, mtu ), 1UL );
+  fdgen_tile_gen_pool_t * pool     = fdgen_tile_gen_pool_new( pool_mem, frame_cnt, mtu );
+  void *                  scratch  = fd_wksp_alloc_laddr( wksp, fdgen_tile_gen_txn_scratch_align(), fdgen_tile_gen_txn_scratch_footprint( params.payer_cnt ), 1UL );
+  FD_TEST( pool && scratch );
+  FD_TEST( fdgen_tile_gen_txn_pool_fill( pool, &params, scratch, 1UL, fd_tile_cnt()-1UL )==frame_cnt );
+  FD_TEST( pool->frame_cnt==frame_cnt && pool->sz_max==FDGEN_TXN_FRAME_SZ );
+
+  fd_sha512_t _sha512[1];
+  fd_sha512_t * sha512 = fd_sha512_join( fd_sha512_new( _sha512 ) );
+  for( ulong i=0UL; i<frame_cnt; i++ ) {
+    uchar const * frame = fdgen_tile_gen_pool_frame( pool, i );
+    uchar const * txn   = frame + FDGEN_TXN_FRAME_OFF;
+    FD_TEST( fdgen_tile_gen_pool_sz( pool, i )==FDGEN_TXN_FRAME_SZ );
+    FD_TEST( fdgen_udp4_frame_check( frame, FDGEN_TXN_FRAME_SZ ) );
+    FD_TEST( txn[ 0 ]==1 && txn[ FDGEN_TXN_MSG_OFF+3UL ]==3 );
+    FD_TEST( !memcmp( txn+FDGEN_TXN_BLOCKHASH_OFF, params.blockhash, 32UL ) );
+    FD_TEST( FD_LOAD( ulong, frame+FDGEN_TXN_FRAME_LAMPORTS_OFF )==params.lamports+i );
+    FD_TEST( fd_ed25519_verify( txn+FDGEN_TXN_MSG_OFF, FDGEN_TXN_MSG_SZ, txn+FDGEN_TXN_SIG_OFF,
+                                fdgen_tile_gen_txn_payer( frame ), sha512 )==FD_ED25519_SUCCESS );
+  }
+
+  /* Payers cycle, and a mutated message no longer verifies */
+
+  uchar * frame = (uchar *)fdgen_tile_gen_pool_frame( pool, 0UL );
+  FD_TEST( !memcmp( fdgen_tile_gen_txn_payer( frame ), fdgen_tile_gen_txn_payer( fdgen_tile_gen_pool_frame( pool, 64UL ) ), 32UL ) );
+  FD_TEST(  memcmp( fdgen_tile_gen_txn_payer( frame ), fdgen_tile_gen_txn_payer( fdgen_tile_gen_pool_frame( pool,  1UL ) ), 32UL ) );
+  frame[ FDGEN_TXN_FRAME_LAMPORTS_OFF ]++;
+  FD_TEST( fd_ed25519_verify( frame+FDGEN_TXN_FRAME_OFF+FDGEN_TXN_MSG_OFF, FDGEN_TXN_MSG_SZ, frame+FDGEN_TXN_FRAME_OFF+FDGEN_TXN_SIG_OFF,
+                              fdgen_tile_gen_txn_payer( frame ), sha512 )!=FD_ED25519_SUCCESS );
+
+  fd_sha512_delete( fd_sha512_leave( sha512 ) );
+  fd_wksp_free_laddr( scratch );
+  fd_wksp_free_laddr( pool_mem );
+}
+
+/* test_shred checks shred stream progression, then runs the gen tile
+   on a shred stream with FEC set bursts */
+
+static void
+test_shred( fd_wksp_t *            wksp,
+            fd_cnc_t *             cnc,
+            fd_frag_meta_t *       mcache,
+            fdgen_tile_gen_cfg_t * cfg,
+            long                   duration ) {
+
+  /* 2 slots of 3 sets of 4 data and 3 coding shreds, interleaved */
+
+  fdgen_tile_gen_shred_params_t params = {
+    .slot         = 100UL,
+    .slot_step    = 2UL,
+    .fec_per_slot = 3UL,
+    .data_cnt     = 4UL,
+    .code_cnt     = 3UL,
+    .version      = 4242,
+    .order        = FDGEN_SHRED_ORDER_INTERLEAVE,
+    .seed         = 9UL
+  };
+  fdgen_tile_gen_shred_t * shred = fd_wksp_alloc_laddr( wksp, alignof(fdgen_tile_gen_shred_t), sizeof(fdgen_tile_gen_shred_t), 1UL );
+  FD_TEST( shred );
+  FD_TEST( fdgen_tile_gen_shred_init( shred, &params )==shred );
+
+  uchar buf[ FDGEN_SHRED_SZ_MAX ];
+  for( ulong slot_i=0UL; slot_i<2UL; slot_i++ ) {
+    for( ulong set=0UL; set<3UL; set++ ) {
+      for( ulong pos=0UL; pos<7UL; pos++ ) {
+        int   is_code = pos<6UL ? (int)( pos & 1UL ) : 0;
+        ulong k       = pos<6UL ? pos>>1 : 3UL;
+        ulong sz      = fdgen_tile_gen_shred_sz( shred );
+        FD_TEST( fdgen_tile_gen_shred_next( shred, buf )==sz );
+        FD_TEST( sz==( is_code ? FDGEN_SHRED_CODE_SZ : FDGEN_SHRED_DATA_SZ ) );
+        FD_TEST( buf[ FDGEN_SHRED_VARIANT_OFF ]==( ( is_code ? FDGEN_SHRED_VARIANT_MERKLE_CODE : FDGEN_SHRED_VARIANT_MERKLE_DATA ) | 3 ) );
+        FD_TEST( FD_LOAD( ulong,  buf+FDGEN_SHRED_SLOT_OFF        )==100UL+2UL*slot_i );
+        FD_TEST( FD_LOAD( ushort, buf+FDGEN_SHRED_VERSION_OFF     )==4242             );
+        FD_TEST( FD_LOAD( uint,   buf+FDGEN_SHRED_FEC_SET_IDX_OFF )==4UL*set          );
+        if( is_code ) {
+          FD_TEST( FD_LOAD( uint,   buf+FDGEN_SHRED_IDX_OFF      )==3UL*set+k );
+          FD_TEST( FD_LOAD( ushort, buf+FDGEN_SHRED_DATA_CNT_OFF )==4         );
+          FD_TEST( FD_LOAD( ushort, buf+FDGEN_SHRED_CODE_CNT_OFF )==3         );
+          FD_TEST( FD_LOAD( ushort, buf+FDGEN_SHRED_POS_OFF      )==k         );
+        } else {
+          uchar flags = buf[ FDGEN_SHRED_FLAGS_OFF ];
+          uchar exp   = k<3UL ? 0 : ( set==2UL ? FDGEN_SHRED_FLAG_LAST_IN_SLOT : FDGEN_SHRED_FLAG_DATA_COMPLETE );
+          FD_TEST( FD_LOAD( uint,   buf+FDGEN_SHRED_IDX_OFF        )==4UL*set+k );
+          FD_TEST( FD_LOAD( ushort, buf+FDGEN_SHRED_PARENT_OFF_OFF )==2         );
+          FD_TEST( FD_LOAD( ushort, buf+FDGEN_SHRED_SIZE_OFF       )==FDGEN_SHRED_DATA_SZ-3UL*FDGEN_SHRED_PROOF_ENTRY_SZ );
+          FD_TEST( ( flags & ~FDGEN_SHRED_FLAG_REF_TICK_MASK )==exp );
+          FD_TEST( ( flags &  FDGEN_SHRED_FLAG_REF_TICK_MASK )==set*FDGEN_SHRED_TICKS_PER_SLOT/3UL );
+        }
+      }
+    }
+  }
+
+  params.slot = 1UL;
+  FD_TEST( !fdgen_tile_gen_shred_init( shred, &params ) );  /* parent before slot 0 */
+  params.slot     = 100UL;
+  params.data_cnt = 0UL;
+  FD_TEST( !fdgen_tile_gen_shred_init( shred, &params ) );
+
+  /* Shred indices must fit in 32 bits, for coding shreds too and
+     without the product wrapping around */
+
+  params.data_cnt     = 1UL;
+  params.code_cnt     = 2UL;
+  params.fec_per_slot = (ulong)UINT_MAX/2UL;
+  FD_TEST( fdgen_tile_gen_shred_init( shred, &params )==shred );
+  params.fec_per_slot = (ulong)UINT_MAX/2UL+1UL;
+  FD_TEST( !fdgen_tile_gen_shred_init( shred, &params ) );
+  params.data_cnt     = 3UL;
+  params.fec_per_slot = ULONG_MAX/3UL+1UL;  /* product wraps to 2 */
+  FD_TEST( !fdgen_tile_gen_shred_init( shred, &params ) );
+
+  /* Gen run: 32+32 sets sent data first, one set per burst */
+
+  params.slot_step     = 1UL;
+  params.fec_per_slot  = 8UL;
+  params.data_cnt      = 32UL;
+  params.code_cnt      = 32UL;
+  params.order         = FDGEN_SHRED_ORDER_DATA_FIRST;
+  params.burst_set_cnt = 1UL;
+  FD_TEST( fdgen_tile_gen_shred_init( shred, &params )==shred );
+
+  FD_LOG_NOTICE(( "Testing shreds at pps %lu (%lu+%lu per FEC set, burst %lu sets)",
+                  cfg->pps, params.data_cnt, params.code_cnt, params.burst_set_cnt ));
+
+  cfg->shred = shred;
+
+  ulong depth = fd_mcache_depth( mcache );
+  ulong seq   = fd_mcache_seq_query( fd_mcache_seq_laddr( mcache ) );
+
+  fdgen_tile_gen_diag_t * diag = fd_cnc_app_laddr( cnc );
+  memset( diag, 0, sizeof(fdgen_tile_gen_diag_t) );
+
+  char * gen_tile_argv[1] = { fd_type_pun( cfg ) };
+  fd_tile_exec_t * gen_tile = fd_tile_exec_new( 1UL, gen_tile_main, 1, gen_tile_argv );
+  FD_TEST( gen_tile );
+  FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+  ulong rx_cnt   = 0UL;
+  long  deadline = fd_log_wallclock() + duration;
+  while( fd_log_wallclock()<deadline ) {
+    fd_frag_meta_t const * mline = mcache + fd_mcache_line_idx( seq, depth );
+    long diff = fd_seq_diff( fd_frag_meta_seq_query( mline ), seq );
+    if( diff<0L ) { FD_SPIN_PAUSE(); continue; }
+    if( FD_UNLIKELY( diff>0L ) ) FD_LOG_ERR(( "overrun at seq %lu", seq ));
+
+    uchar const * pkt   = fd_chunk_to_laddr_const( wksp, mline->chunk );
+    uchar const * s     = pkt + FDGEN_TILE_GEN_TMPL_SZ;
+    ulong         pos   = rx_cnt % 64UL;
+    ulong         set   = rx_cnt / 64UL;
+    FD_TEST( fdgen_udp4_frame_check( pkt, mline->sz ) );
+    FD_TEST( mline->sz==FDGEN_TILE_GEN_TMPL_SZ + ( pos<32UL ? FDGEN_SHRED_DATA_SZ : FDGEN_SHRED_CODE_SZ ) );
+    FD_TEST( FD_LOAD( ulong, s+FDGEN_SHRED_SLOT_OFF        )==100UL + set/8UL     );
+    FD_TEST( FD_LOAD( uint,  s+FDGEN_SHRED_FEC_SET_IDX_OFF )==32UL*( set % 8UL ) );
+    FD_TEST( FD_LOAD( uint,  s+FDGEN_SHRED_IDX_OFF         )==32UL*( set % 8UL ) + ( pos % 32UL ) );
+    FD_TEST( fd_seq_eq( fd_frag_meta_seq_query( mline ), seq ) );
+    seq = fd_seq_inc( seq, 1UL );
+    rx_cnt++;
+  }
+
+  FD_TEST( !fd_cnc_open( cnc ) );
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( cnc );
+  FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  fd_tile_exec_delete( gen_tile, NULL );
+
+  /* Bursts keep the average rate, within one burst */
+
+  FD_LOG_NOTICE(( "gen: pub_cnt %lu act_pps %lu (tgt %lu)", diag->pub_cnt, diag->act_pps, diag->tgt_pps ));
+  double exp_cnt = (double)cfg->pps * (double)duration * 1e-9;
+  FD_TEST( (double)rx_cnt>=0.95*exp_cnt-64.0 && (double)rx_cnt<=1.05*exp_cnt+64.0 );
+
+  cfg->shred = NULL;
+  fd_wksp_free_laddr( shred );
+}
+
+/* size_prob returns the probability of sz under the alias table of
+   size */
+
+static double
+size_prob( fdgen_tile_gen_size_t const * size,
+           ulong                         sz ) {
+  double p = 0.0;
+  for( ulong j=0UL; j<size->cnt; j++ ) {
+    double keep = (double)size->ent[j].thresh / 4294967296.0;
+    if( size->ent[j].sz[0]==sz ) p += keep;
+    if( size->ent[j].sz[1]==sz ) p += 1.0-keep;
+  }
+  return p / (double)size->cnt;
+}
+
+/* test_size_tables checks alias tables of size distributions, exactly
+   and by sampling */
+
+static void
+test_size_tables( fdgen_tile_gen_size_t * size,
+                  fd_rng_t *              rng ) {
+
+  /* Fixed */
+  FD_TEST( fdgen_tile_gen_size_init_fixed( size, 100UL )==size );
+  FD_TEST( size->cnt==1UL && size->sz_min==100UL && size->sz_max==100UL );
+  for( ulong i=0UL; i<1000UL; i++ ) FD_TEST( fdgen_tile_gen_size_sample( size, rng )==100UL );
+  FD_TEST( !fdgen_tile_gen_size_init_fixed( size, FDGEN_TILE_GEN_PKT_SZ_MIN-1UL ) );
+
+  /* Uniform, exact and quantized */
+  FD_TEST( fdgen_tile_gen_size_init_uniform( size, 64UL, 127UL )==size );
+  FD_TEST( size->cnt==64UL && size->sz_avg==95.5 );
+  for( ulong sz=64UL; sz<128UL; sz++ ) FD_TEST( fabs( size_prob( size, sz ) - 1.0/64.0 )<1e-9 );
+  FD_TEST( fdgen_tile_gen_size_init_uniform( size, 64UL, 9000UL )==size );
+  FD_TEST( size->cnt==FDGEN_TILE_GEN_SIZE_CNT_MAX && size->ent[0].sz[0]==64 && size->ent[ size->cnt-1UL ].sz[0]==9000 );
+  FD_TEST( !fdgen_tile_gen_size_init_uniform( size, 128UL, 64UL ) );
+
+  /* Skewed table with a zero weight and a repeated size */
+  ulong  sz    [ 5 ] = { 60UL, 200UL, 1514UL, 300UL, 200UL };
+  double weight[ 5 ] = { 10.0,   1.0,    0.5,   0.0,   2.5 };
+  FD_TEST( fdgen_tile_gen_size_init_table( size, sz, weight, 5UL )==size );
+  FD_TEST( size->sz_min==60UL && size->sz_max==1514UL );
+  FD_TEST( fabs( size->sz_avg - ( 600.0+700.0+757.0 )/14.0 )<1e-9 );
+  FD_TEST( fabs( size_prob( size,   60UL ) - 10.0/14.0 )<1e-6 );
+  FD_TEST( fabs( size_prob( size,  200UL ) -  3.5/14.0 )<1e-6 );
+  FD_TEST( fabs( size_prob( size, 1514UL ) -  0.5/14.0 )<1e-6 );
+  FD_TEST( size_prob( size, 300UL )==0.0 );
+  weight[0] = -1.0;
+  FD_TEST( !fdgen_tile_gen_size_init_table( size, sz, weight, 5UL ) );
+  double zero[ 1 ] = { 0.0 };
+  FD_TEST( !fdgen_tile_gen_size_init_table( size, sz, zero, 1UL ) );
+
+  /* IMIX, sampled: each share within 1% */
+  FD_TEST( fdgen_tile_gen_size_init_imix( size )==size );
+  FD_TEST( fabs( size->sz_avg - ( 7.0*60.0 + 4.0*590.0 + 1514.0 )/12.0 )<1e-9 );
+  ulong cnt[ 3 ] = { 0UL, 0UL, 0UL };
+  ulong draw_cnt = 1UL<<20;
+  for( ulong i=0UL; i<draw_cnt; i++ ) {
+    ulong s = fdgen_tile_gen_size_sample( size, rng );
+    FD_TEST( s==60UL || s==590UL || s==1514UL );
+    cnt[ (s>=590UL) + (s>=1514UL) ]++;
+  }
+  FD_TEST( fabs( (double)cnt[0]/(double)draw_cnt - 7.0/12.0 )<0.01 );
+  FD_TEST( fabs( (double)cnt[1]/(double)draw_cnt - 4.0/12.0 )<0.01 );
+  FD_TEST( fabs( (double)cnt[2]/(double)draw_cnt - 1.0/12.0 )<0.01 );
+
+  /* CSV */
+  char path[] = "/tmp/test_tile_gen_size.XXXXXX";
+  int  fd     = mkstemp( path );
+  FD_TEST( fd>=0 );
+  FILE * file = fdopen( fd, "w" );
+  FD_TEST( file );
+  fputs( "# sz,weight\n64,3\n\n1024,1\n", file );
+  fclose( file );
+  FD_TEST( fdgen_tile_gen_size_init_csv( size, path )==size );
+  FD_TEST( size->cnt==2UL && size->sz_min==64UL && size->sz_max==1024UL );
+  FD_TEST( fabs( size_prob( size, 64UL ) - 0.75 )<1e-6 );
+  file = fopen( path, "w" );
+  FD_TEST( file );
+  fputs( "64,3 \n1024,1x\n", file );  /* trailing garbage after the weight */
+  fclose( file );
+  FD_TEST( !fdgen_tile_gen_size_init_csv( size, path ) );
+  unlink( path );
+
+  /* Histogram bins */
+  FD_TEST( fdgen_tile_gen_sz_bin(   60UL )==0UL );
+  FD_TEST( fdgen_tile_gen_sz_bin(   64UL )==1UL );
+  FD_TEST( fdgen_tile_gen_sz_bin(  590UL )==4UL );
+  FD_TEST( fdgen_tile_gen_sz_bin( 1514UL )==5UL );
+  FD_TEST( fdgen_tile_gen_sz_bin( 1515UL )==6UL );
+}
+
+/* test_shape_tables checks precomputed shape tables */
+
+static void
+test_shape_tables( fdgen_tile_gen_shape_t * shape ) {
+
+  /* Step ramp 0.25 -> 1 in 4 steps over 4 ms, then hold */
+  FD_TEST( fdgen_tile_gen_shape_init_ramp( shape, 0.25, 1.0, (long)4e6, 4UL )==shape );
+  FD_TEST( shape->seg_cnt==5UL && !shape->repeat );
+  for( ulong i=0UL; i<4UL; i++ ) {
+    FD_TEST( shape->seg[i].dur_ns==(long)1e6 );
+    FD_TEST( fabs( shape->seg[i].scale - ( 0.25 + 0.25*(double)i ) )<1e-9 );
+  }
+  FD_TEST( shape->seg[4].scale==1.0 && shape->seg[4].dur_ns==LONG_MAX );
+
+  /* Linear ramp: monotonic, total duration preserved */
+  FD_TEST( fdgen_tile_gen_shape_init_ramp( shape, 0.0, 2.0, (long)1e9, 0UL )==shape );
+  long dur = 0L;
+  for( ulong i=0UL; i<shape->seg_cnt-1UL; i++ ) {
+    dur += shape->seg[i].dur_ns;
+    if( i ) FD_TEST( shape->seg[i].scale>shape->seg[i-1UL].scale );
+  }
+  FD_TEST( dur==(long)1e9 );
+  FD_TEST( !fdgen_tile_gen_shape_init_ramp( shape, -1.0, 1.0, (long)1e9, 0UL ) );
+
+  /* On/off */
+  FD_TEST( fdgen_tile_gen_shape_init_onoff( shape, (long)1e6, 0.25 )==shape );
+  FD_TEST( shape->seg_cnt==2UL && shape->repeat );
+  FD_TEST( shape->seg[0].dur_ns==(long)250e3 && shape->seg[0].scale==1.0 );
+  FD_TEST( shape->seg[1].dur_ns==(long)750e3 && shape->seg[1].scale==0.0 );
+  FD_TEST( !fdgen_tile_gen_shape_init_onoff( shape, (long)1e6, 0.0 ) );
+
+  /* CSV */
+  char path[] = "/tmp/test_tile_gen_shape.XXXXXX";
+  int  fd     = mkstemp( path );
+  FD_TEST( fd>=0 );
+  FILE * file = fdopen( fd, "w" );
+  FD_TEST( file );
+  fputs( "# dur_us,scale\n100,0.5\n\n250.5,2\n", file );
+  fclose( file );
+  FD_TEST( fdgen_tile_gen_shape_init_csv( shape, path, 1 )==shape );
+  FD_TEST( shape->seg_cnt==2UL && shape->repeat );
+  FD_TEST( shape->seg[0].dur_ns==100000L && shape->seg[0].scale==0.5 );
+  FD_TEST( shape->seg[1].dur_ns==250500L && shape->seg[1].scale==2.0 );
+  char const * bad_csv[ 3 ] = { "100x,0.5\n", "100,0.5x\n", "100,0.5 1\n" };
+  for( ulong j=0UL; j<3UL; j++ ) {
+    file = fopen( path, "w" );
+    FD_TEST( file );
+    fputs( bad_csv[ j ], file );
+    fclose( file );
+    FD_TEST( !fdgen_tile_gen_shape_init_csv( shape, path, 1 ) );
+  }
+  unlink( path );
+
+  /* Poisson: unit mean */
+  FD_TEST( fdgen_tile_gen_shape_set_poisson( shape )==shape );
+  double sum = 0.0;
+  for( ulong j=0UL; j<=shape->mul_mask; j++ ) sum += shape->mul[j];
+  FD_TEST( fabs( sum/(double)(shape->mul_mask+1UL) - 1.0 )<1e-9 );
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  fd_boot( &argc, &argv );
+
+  ulong cpu_idx = fd_tile_cpu_id( fd_tile_idx() );
+  if( cpu_idx>=fd_shmem_cpu_cnt() ) cpu_idx = 0UL;
+
+  char const * _page_sz   = fd_env_strip_cmdline_cstr ( &argc, &argv, "--page-sz",    NULL, "gigantic"                 );
+  ulong        page_cnt   = fd_env_strip_cmdline_ulong( &argc, &argv, "--page-cnt",   NULL, 1UL                        );
+  ulong        numa_idx   = fd_env_strip_cmdline_ulong( &argc, &argv, "--numa-idx",   NULL, fd_shmem_numa_idx(cpu_idx) );
+  ulong        depth      = fd_env_strip_cmdline_ulong( &argc, &argv, "--depth",      NULL, 4096UL                     );
+  ulong        pps        = fd_env_strip_cmdline_ulong( &argc, &argv, "--pps",        NULL, 1000000UL                  );
+  ulong        bps        = fd_env_strip_cmdline_ulong( &argc, &argv, "--bps",        NULL, 1000000000UL               );
+  long         duration   = fd_env_strip_cmdline_long ( &argc, &argv, "--duration",   NULL, (long)200e6                );
+
+  if( FD_UNLIKELY( fd_tile_cnt()<2UL ) ) FD_LOG_ERR(( "This test requires at least 2 tiles" ));
+
+  ulong page_sz = fd_cstr_to_shmem_page_sz( _page_sz );
+  if( FD_UNLIKELY( !page_sz ) ) FD_LOG_ERR(( "unsupported --page-sz" ));
+
+  ulong mtu = 2048UL;
+
+  FD_LOG_NOTICE(( "Creating workspace with --page-cnt %lu --page-sz %s pages on --numa-idx %lu", page_cnt, _page_sz, numa_idx ));
+  fd_wksp_t * wksp = fd_wksp_new_anonymous( page_sz, page_cnt, fd_shmem_cpu_idx( numa_idx ), "wksp", 0UL );
+  FD_TEST( wksp );
+
+  void *     cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 128UL ), 1UL );
+  fd_cnc_t * cnc     = fd_cnc_join( fd_cnc_new( cnc_mem, 128UL, 1UL, fd_tickcount() ) );
+  FD_TEST( cnc );
+
+  void *           mcache_mem = fd_wksp_alloc_laddr( wksp, fd_mcache_align(), fd_mcache_footprint( depth, 0UL ), 1UL );
+  fd_frag_meta_t * mcache     = fd_mcache_join( fd_mcache_new( mcache_mem, depth, 0UL, 0UL ) );
+  FD_TEST( mcache );
+
+  ulong   dcache_data_sz = fd_dcache_req_data_sz( mtu, depth, 1UL, 1 );
+  void *  dcache_mem     = fd_wksp_alloc_laddr( wksp, fd_dcache_align(), fd_dcache_footprint( dcache_data_sz, 0UL ), 1UL );
+  uchar * dcache         = fd_dcache_join( fd_dcache_new( dcache_mem, dcache_data_sz, 0UL ) );
+  FD_TEST( dcache );
+
+  fdgen_tile_gen_cfg_t cfg[1] = {{
+    .orig        = 1UL,
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+    .mtu         = mtu,
+
+    .cnc    = cnc,
+    .mcache = mcache,
+    .dcache = dcache,
+    .base   = (uchar *)wksp,
+
+    .burst    = 1UL,
+    .src_ip   = FD_IP4_ADDR( 127, 0, 0, 1 ),
+    .dst_ip   = FD_IP4_ADDR( 127, 0, 0, 1 ),
+    .src_port = 9400,
+    .dst_port = 9401
+  }};
+
+  /* Packet rate, minimum size frames */
+
+  cfg->pps    = pps;
+  cfg->bps    = 0UL;
+  cfg->pkt_sz = FDGEN_TILE_GEN_PKT_SZ_MIN;
+  test_rate( wksp, cnc, mcache, cfg, duration, (double)pps );
+
+  /* Bit rate at line rate accounting, 1500 byte IP packets */
+
+  cfg->pps           = 0UL;
+  cfg->bps           = bps;
+  cfg->pkt_sz        = 1514UL;
+  cfg->wire_overhead = FDGEN_TILE_GEN_WIRE_OVERHEAD;
+  cfg->udp_check     = 1;
+  test_rate( wksp, cnc, mcache, cfg, duration, (double)bps / (double)( 8UL*( 1514UL+FDGEN_TILE_GEN_WIRE_OVERHEAD ) ) );
+
+  /* Flow sets */
+
+  test_flow_set();
+
+  fdgen_tile_gen_flow_params_t flow_params = {
+    .src_ip   = FD_IP4_ADDR( 127, 0, 0, 1 ), .src_ip_cnt   = 256UL,
+    .src_port = 10000,                       .src_port_cnt = 1000UL,
+    .dst_ip   = FD_IP4_ADDR( 127, 1, 0, 1 ), .dst_ip_cnt   = 16UL,
+    .dst_port = cfg->dst_port,               .dst_port_cnt = 1UL
+  };
+  fdgen_tile_gen_flow_set_t flows[1];
+  FD_TEST( fdgen_tile_gen_flow_set_init( flows, &flow_params, 1UL ) );
+
+  cfg->pps           = pps;
+  cfg->bps           = 0UL;
+  cfg->pkt_sz        = FDGEN_TILE_GEN_PKT_SZ_MIN;
+  cfg->wire_overhead = 0UL;
+  cfg->flows         = flows;
+  test_rate( wksp, cnc, mcache, cfg, duration, (double)pps );
+  cfg->flows         = NULL;
+
+  /* Frame pools, bit rate paced */
+
+  cfg->pps           = 0UL;
+  cfg->bps           = bps;
+  test_pool( wksp, cnc, mcache, cfg, duration );
+  test_txn_pool( wksp, mtu );
+
+  /* Shred streams, packet rate paced */
+
+  cfg->pps = pps;
+  cfg->bps = 0UL;
+  test_shred( wksp, cnc, mcache, cfg, duration );
+
+  /* Size distributions: IMIX paced by bit rate, so each frame must be
+     charged its own size, and the diag histogram must follow 7:4:1 */
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, 1234U, 0UL ) );
+  fdgen_tile_gen_size_t * size = fd_wksp_alloc_laddr( wksp, alignof(fdgen_tile_gen_size_t), sizeof(fdgen_tile_gen_size_t), 1UL );
+  FD_TEST( size );
+  test_size_tables( size, rng );
+
+  FD_TEST( fdgen_tile_gen_size_init_imix( size ) );
+  cfg->pps           = 0UL;
+  cfg->bps           = bps;
+  cfg->wire_overhead = FDGEN_TILE_GEN_WIRE_OVERHEAD;
+  cfg->udp_check     = 1;
+  cfg->size          = size;
+  test_rate( wksp, cnc, mcache, cfg, duration, (double)bps / ( 8.0*( size->sz_avg + (double)FDGEN_TILE_GEN_WIRE_OVERHEAD ) ) );
+  cfg->size          = NULL;
+
+  fdgen_tile_gen_diag_t const * diag = fd_cnc_app_laddr_const( cnc );
+  ulong bin_sum = 0UL;
+  for( ulong b=0UL; b<FDGEN_TILE_GEN_SZ_BIN_CNT; b++ ) bin_sum += diag->sz_cnt[ b ];
+  FD_LOG_NOTICE(( "imix: sz_cnt <64 %lu 512-1023 %lu 1024-1514 %lu",
+                  diag->sz_cnt[0], diag->sz_cnt[4], diag->sz_cnt[5] ));
+  FD_TEST( bin_sum==diag->pub_cnt && diag->pub_cnt );
+  FD_TEST( diag->sz_cnt[0]+diag->sz_cnt[4]+diag->sz_cnt[5]==bin_sum );
+  FD_TEST( fabs( (double)diag->sz_cnt[0]/(double)bin_sum - 7.0/12.0 )<0.05 );
+  FD_TEST( fabs( (double)diag->sz_cnt[4]/(double)bin_sum - 4.0/12.0 )<0.05 );
+  FD_TEST( fabs( (double)diag->sz_cnt[5]/(double)bin_sum - 1.0/12.0 )<0.05 );
+
+  fd_wksp_free_laddr( size );
+  fd_rng_delete( fd_rng_leave( rng ) );
+
+  /* Shapes */
+
+  fdgen_tile_gen_shape_t * shape = fd_wksp_alloc_laddr( wksp, alignof(fdgen_tile_gen_shape_t), sizeof(fdgen_tile_gen_shape_t), 1UL );
+  FD_TEST( shape );
+  test_shape_tables( shape );
+
+  cfg->pps           = pps;
+  cfg->bps           = 0UL;
+  cfg->pkt_sz        = FDGEN_TILE_GEN_PKT_SZ_MIN;
+  cfg->wire_overhead = 0UL;
+  cfg->udp_check     = 0;
+  cfg->shape         = shape;
+
+  /* On/off, 25% duty: a quarter of the peak rate on average */
+
+  FD_TEST( fdgen_tile_gen_shape_init_onoff( shape, duration/20L, 0.25 ) );
+  test_rate( wksp, cnc, mcache, cfg, duration, 0.25*(double)pps );
+
+  /* Poisson arrivals: exponential gaps have a coefficient of variation
+     of 1 */
+
+  FD_TEST( fdgen_tile_gen_shape_init_const( shape ) );
+  FD_TEST( fdgen_tile_gen_shape_set_poisson( shape ) );
+  double cv = test_rate( wksp, cnc, mcache, cfg, duration, (double)pps );
+  FD_LOG_NOTICE(( "poisson: inter-arrival cv %.3f", cv ));
+  FD_TEST( cv>0.8 && cv<1.2 );
+
+  fd_wksp_free_laddr( shape );
+
+  FD_LOG_INFO(( "Cleaning up" ));
+
+  fd_wksp_free_laddr( fd_dcache_delete( fd_dcache_leave( dcache ) ) );
+  fd_wksp_free_laddr( fd_mcache_delete( fd_mcache_leave( mcache ) ) );
+  fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( cnc ) ) );
+  fd_wksp_delete_anonymous( wksp );
+
+  FD_LOG_NOTICE(( "pass" ));
+  fd_halt();
+  return 0;
+}
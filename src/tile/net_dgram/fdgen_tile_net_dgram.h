@@ -6,8 +6,33 @@
 
 #include <firedancer/util/fd_util.h>
 #include <firedancer/tango/dcache/fd_dcache.h>
+#include <errno.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
+
+/* FDGEN_TILE_NET_DGRAM_RX_HIST_CNT is the number of buckets in the RX
+   round histogram.  Bucket i counts drain rounds that serviced
+   [2^i,2^(i+1)) sockets, the last bucket also counts larger rounds. */
+
+#define FDGEN_TILE_NET_DGRAM_RX_HIST_CNT (16UL)
+
+/* FDGEN_TILE_NET_DGRAM_RX_CMSG_SZ is the size of the per-slot ancillary
+   data buffer for received datagrams.  Fits IP_PKTINFO, IP_ORIGDSTADDR,
+   SO_RXQ_OVFL and SCM_TIMESTAMPING (struct scm_timestamping) control
+   messages. */
+
+#define FDGEN_TILE_NET_DGRAM_RX_CMSG_SZ                \
+  ( CMSG_SPACE( sizeof(struct in_pktinfo)      ) +     \
+    CMSG_SPACE( sizeof(struct sockaddr_in)     ) +     \
+    CMSG_SPACE( sizeof(uint)                   ) +     \
+    CMSG_SPACE( 3UL*sizeof(struct timespec)    ) )
+
+/* FDGEN_TILE_NET_DGRAM_TX_CMSG_SZ is the size of the per-slot ancillary
+   data buffer for sent datagrams.  Fits an SCM_TXTIME control message. */
+
+#define FDGEN_TILE_NET_DGRAM_TX_CMSG_SZ ( CMSG_SPACE( sizeof(ulong) ) )
 
 struct fdgen_tile_net_dgram_diag {
   ulong backp_cnt;
@@ -17,6 +42,14 @@ struct fdgen_tile_net_dgram_diag {
   ulong rx_cnt;
   ulong rx_sz;
   ulong overnp_cnt;
+  ulong tx_sent_cnt;  /* datagrams accepted by the kernel */
+  ulong tx_drop_cnt;  /* datagrams dropped after exhausting retries or on send error */
+  ulong rx_kern_drop_cnt;  /* datagrams dropped by the kernel at the socket (SO_RXQ_OVFL) */
+  ulong rx_ts_cnt;         /* datagrams whose tsorig is a kernel RX timestamp (software or hardware) */
+  ulong rx_hwts_cnt;       /* datagrams whose tsorig is a hardware RX timestamp */
+  ulong conn_hit_cnt;      /* datagrams sent via a cached connected socket */
+  ulong conn_miss_cnt;     /* datagrams whose destination was not cached */
+  ulong rx_round_hist[ FDGEN_TILE_NET_DGRAM_RX_HIST_CNT ];  /* sockets serviced per drain round, log2 buckets */
 };
 
 typedef struct fdgen_tile_net_dgram_diag fdgen_tile_net_dgram_diag_t;
@@ -24,7 +57,10 @@ typedef struct fdgen_tile_net_dgram_diag fdgen_tile_net_dgram_diag_t;
 FD_PROTOTYPES_BEGIN
 
 /* fdgen_tile_net_dgram_scratch_{align,footprint} specify parameters of
-   the scratch memory region for a given configuration. */
+   the scratch memory region for a given configuration.  socket_max is
+   the number of sockets registered with the RX epoll fd (0 for tiles
+   that do not receive).  is_tx is non-zero for the tx tile, whose
+   cmsg, sort and route arrays are not needed by the rxtx tile. */
 
 FD_FN_CONST static inline ulong
 fdgen_tile_net_dgram_scratch_align( void ) {
@@ -32,19 +68,29 @@ fdgen_tile_net_dgram_scratch_align( void ) {
 }
 
 FD_FN_CONST static inline ulong
-fdgen_tile_net_dgram_scratch_footprint( ulong rx_depth,
+fdgen_tile_net_dgram_scratch_footprint( int   is_tx,
+                                        ulong rx_depth,
                                         ulong rx_burst,
                                         ulong tx_burst,
-                                        ulong mtu ) {
+                                        ulong mtu,
+                                        ulong socket_max ) {
   ulong rx_slot_max = rx_depth + 2*rx_burst;
+  ulong tx_only_max = is_tx ? tx_burst : 0UL;
   ulong l = FD_LAYOUT_INIT;
   l = FD_LAYOUT_APPEND( l, alignof(struct sockaddr_storage), tx_burst    *sizeof(struct sockaddr_storage) );
   l = FD_LAYOUT_APPEND( l, alignof(struct iovec),            tx_burst    *sizeof(struct iovec)            );
   l = FD_LAYOUT_APPEND( l, alignof(struct mmsghdr),          tx_burst    *sizeof(struct mmsghdr)          );
   l = FD_LAYOUT_APPEND( l, FD_CHUNK_ALIGN,                   tx_burst    *mtu                             );
+  l = FD_LAYOUT_APPEND( l, alignof(struct cmsghdr),          tx_only_max *FDGEN_TILE_NET_DGRAM_TX_CMSG_SZ );
+  l = FD_LAYOUT_APPEND( l, alignof(struct mmsghdr),          tx_only_max *sizeof(struct mmsghdr)          );
+  l = FD_LAYOUT_APPEND( l, alignof(uchar),                   tx_only_max *2UL                             );
   l = FD_LAYOUT_APPEND( l, alignof(struct sockaddr_storage), rx_slot_max *sizeof(struct sockaddr_storage) );
   l = FD_LAYOUT_APPEND( l, alignof(struct iovec),            rx_slot_max *sizeof(struct iovec)            );
   l = FD_LAYOUT_APPEND( l, alignof(struct mmsghdr),          rx_slot_max *sizeof(struct mmsghdr)          );
+  l = FD_LAYOUT_APPEND( l, alignof(struct cmsghdr),          rx_slot_max *FDGEN_TILE_NET_DGRAM_RX_CMSG_SZ );
+  l = FD_LAYOUT_APPEND( l, alignof(struct epoll_event),      socket_max  *sizeof(struct epoll_event)      );
+  l = FD_LAYOUT_APPEND( l, alignof(ulong),                   socket_max  *sizeof(ulong)                   );
+  l = FD_LAYOUT_APPEND( l, alignof(uint),                    socket_max  *sizeof(uint)                    );
   return FD_LAYOUT_FINI( l, 128UL );
 }
 
@@ -60,4 +106,47 @@ fdgen_tile_net_dgram_dcache_data_sz( ulong rx_depth,
   return rx_slot_max * mtu;
 }
 
+/* fdgen_tile_net_dgram_tx_flush submits the first *batch_cnt entries
+   of batch to send_fd via sendmmsg(2).  On return, the entries that
+   the kernel did not accept are moved to the front of batch and
+   *batch_cnt is set to their count, so they go out with the next
+   flush.  Entries are swapped rather than copied, so each mmsghdr
+   keeps ownership of its address, iovec and payload buffers.
+
+   If the first entry fails with an error other than EAGAIN, ENOBUFS
+   or EINTR, retrying it would fail again, so it is discarded and
+   *drop_cnt is incremented.  Returns the number of datagrams accepted
+   by the kernel. */
+
+static inline ulong
+fdgen_tile_net_dgram_tx_flush( int              send_fd,
+                               struct mmsghdr * batch,
+                               uint *           batch_cnt,
+                               ulong *          drop_cnt ) {
+
+  uint  cnt  = *batch_cnt;
+  long  res  = sendmmsg( send_fd, batch, cnt, MSG_DONTWAIT );
+  ulong sent = 0UL;
+  uint  done = 0U;
+  if( FD_LIKELY( res>=0L ) ) {
+    sent = (ulong)res;
+    done = (uint)res;
+  } else {
+    int err = errno;
+    if( FD_UNLIKELY( err!=EAGAIN && err!=ENOBUFS && err!=EINTR ) ) {
+      done = 1U;
+      (*drop_cnt)++;
+    }
+  }
+
+  uint rem = cnt - done;
+  for( uint j=0U; j<rem; j++ ) {
+    struct mmsghdr tmp = batch[ j ];
+    batch[ j      ]    = batch[ done+j ];
+    batch[ done+j ]    = tmp;
+  }
+  *batch_cnt = rem;
+  return sent;
+}
+
 FD_PROTOTYPES_END
@@ -8,6 +8,7 @@
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/ip.h>
 
 #include <firedancer/tango/fd_tango_base.h>
 #include <firedancer/tango/cnc/fd_cnc.h>
@@ -59,7 +60,10 @@
 
 /* Transmit Side *******************************************************
 
-   TODO */
+   Batching and flushing works like in net_dgram_tx, including the last
+   flush at halt.  This tile cannot block waiting for POLLOUT without
+   stalling receive, so the unsent suffix of a partial send is retried
+   when the flush deadline expires again instead. */
 
 #define HEADROOM (42UL)  /* Ethernet header, IPv4 header, UDP header */
 
@@ -83,6 +87,7 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
   uchar *          rx_dcache   = cfg->rx_dcache;
   uchar *          rx_base     = cfg->rx_base;
   int              epoll_fd    = cfg->epoll_fd;
+  ulong            socket_max  = cfg->socket_max;
   int              send_fd     = cfg->send_fd;
 
   /* cnc state */
@@ -94,6 +99,12 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
   ulong   cnc_diag_rx_cnt;
   ulong   cnc_diag_rx_sz;
   ulong   cnc_diag_overnp_cnt;
+  ulong   cnc_diag_tx_sent_cnt;
+  ulong   cnc_diag_tx_drop_cnt;
+  ulong   cnc_diag_rx_kern_drop_cnt;
+  ulong   cnc_diag_rx_ts_cnt;
+  ulong   cnc_diag_rx_hwts_cnt;
+  ulong   cnc_diag_rx_round_hist[ FDGEN_TILE_NET_DGRAM_RX_HIST_CNT ];
 
   /* tx (in) frag stream state */
   ulong   tx_depth;
@@ -108,13 +119,26 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
   ulong async_min; /* minimum number of ticks between processing a housekeeping event, positive integer power of 2 */
 
   /* epoll state */
-  struct epoll_event events[ FD_TILE_NET_DGRAM_SOCKET_MAX ];
-  int                event_idx = -1;
+  struct epoll_event * rx_ready;      /* sockets with pending data, in [0,socket_max) */
+  ulong                rx_ready_cnt;
+  ulong *              rx_more;       /* scratch for sockets to revisit next round */
+  uint *               rx_drop_last;  /* last SO_RXQ_OVFL value seen per socket, indexed by sock_idx */
+  long                 rx_budget;     /* max ticks spent servicing sockets per round */
+
+  /* RX timestamp conversion */
+  long                 rx_ts_wall0;   /* CLOCK_REALTIME ns at rx_ts_tick0 */
+  long                 rx_ts_tick0;   /* tick counter at rx_ts_wall0 */
 
   /* TX batching */
   struct mmsghdr * tx_batch;
   uint             tx_batch_cnt;
   uint             tx_burst;
+  uint             tx_burst_eff;      /* adaptive flush threshold, in [1,tx_burst] */
+  long             tx_burst_timeout;  /* max ticks a frag may wait in a partial batch */
+  long             tx_deadline;       /* flush partial batch at this tick, set when first frag enters batch */
+  ulong            tx_retry_cnt;      /* consecutive flushes that made no progress */
+  ulong            tx_retry_max;
+  int              tx_backp;          /* batch holds an unsent suffix, only flush on deadline */
 
   /* RX batching */
   struct mmsghdr * rx_msg;
@@ -142,7 +166,7 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
     /* scratch init */
 
     FD_SCRATCH_ALLOC_INIT( scratch, cfg->scratch );
-    if( FD_UNLIKELY( fdgen_tile_net_dgram_scratch_footprint( rx_depth, cfg->rx_burst, cfg->tx_burst, mtu )
+    if( FD_UNLIKELY( fdgen_tile_net_dgram_scratch_footprint( 0, rx_depth, cfg->rx_burst, cfg->tx_burst, mtu, socket_max )
                      > cfg->scratch_sz ) ) {
       FD_LOG_WARNING(( "undersz scratch region" ));
       return 1;
@@ -151,7 +175,7 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
     /* cnc state init */
 
     if( FD_UNLIKELY( !cnc ) ) { FD_LOG_WARNING(( "NULL cnc" )); return 1; }
-    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<64UL ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<sizeof(fdgen_tile_net_dgram_diag_t) ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
     if( FD_UNLIKELY( fd_cnc_signal_query( cnc )!=FD_CNC_SIGNAL_BOOT ) ) { FD_LOG_WARNING(( "already booted" )); return 1; }
 
     cnc_diag = fd_cnc_app_laddr( cnc );
@@ -163,6 +187,12 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
     cnc_diag_tx_filt_cnt = 0UL;
     cnc_diag_rx_cnt      = 0UL;
     cnc_diag_rx_sz       = 0UL;
+    cnc_diag_tx_sent_cnt = 0UL;
+    cnc_diag_tx_drop_cnt = 0UL;
+    cnc_diag_rx_kern_drop_cnt = 0UL;
+    cnc_diag_rx_ts_cnt        = 0UL;
+    cnc_diag_rx_hwts_cnt      = 0UL;
+    fd_memset( cnc_diag_rx_round_hist, 0, sizeof(cnc_diag_rx_round_hist) );
 
     /* tx frag stream init */
 
@@ -181,6 +211,11 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
     }
 
     tx_batch_cnt = 0U;
+    tx_burst_eff = tx_burst;
+    tx_deadline  = LONG_MAX;
+    tx_retry_cnt = 0UL;
+    tx_retry_max = cfg->tx_retry_max;
+    tx_backp     = 0;
     struct sockaddr_storage * tx_addrs;
     struct iovec *            tx_iov;
     uchar *                   tx_buf;
@@ -220,9 +255,11 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
 
     struct sockaddr_storage * rx_addrs;  /* consider using sockaddr_in instead */
     struct iovec *            rx_iov;
+    uchar *                   rx_cmsg;
     rx_addrs = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(struct sockaddr_storage), rx_slot_max*sizeof(struct sockaddr_storage) );
     rx_iov   = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(struct iovec),            rx_slot_max*sizeof(struct iovec)            );
     rx_msg   = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(struct mmsghdr),          rx_slot_max*sizeof(struct mmsghdr)          );
+    rx_cmsg  = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(struct cmsghdr),          rx_slot_max*FDGEN_TILE_NET_DGRAM_RX_CMSG_SZ );
     fd_memset( rx_msg, 0, rx_slot_max*sizeof(struct mmsghdr) );
     uchar * rx_cur = rx_dcache;
     for( ulong j=0UL; j<rx_slot_max; j++ ) {
@@ -230,11 +267,29 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
       rx_msg[ j ].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
       rx_msg[ j ].msg_hdr.msg_iov     = rx_iov + j;
       rx_msg[ j ].msg_hdr.msg_iovlen  = 1;
+      rx_msg[ j ].msg_hdr.msg_control    = rx_cmsg + j*FDGEN_TILE_NET_DGRAM_RX_CMSG_SZ;
+      rx_msg[ j ].msg_hdr.msg_controllen = FDGEN_TILE_NET_DGRAM_RX_CMSG_SZ;
       rx_iov[ j ].iov_base            = rx_cur + HEADROOM;
       rx_iov[ j ].iov_len             = mtu    - HEADROOM;
       rx_cur += mtu;
     }
 
+    /* epoll init */
+
+    if( FD_UNLIKELY( !socket_max || socket_max>FDGEN_TILE_NET_DGRAM_SOCKET_MAX ) ) {
+      FD_LOG_WARNING(( "socket_max %lu out of range [1,%lu]", socket_max, FDGEN_TILE_NET_DGRAM_SOCKET_MAX ));
+      return 1;
+    }
+    if( FD_UNLIKELY( !fdgen_socket_poll_valid( &cfg->poll ) ) ) return 1;
+    if( FD_UNLIKELY( fdgen_socket_epoll_busy_poll( epoll_fd, &cfg->poll ) ) ) {
+      FD_LOG_WARNING(( "epoll busy polling unavailable, relying on socket busy polling" ));
+    }
+    rx_ready     = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(struct epoll_event), socket_max*sizeof(struct epoll_event) );
+    rx_more      = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(ulong),              socket_max*sizeof(ulong)              );
+    rx_drop_last = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(uint),               socket_max*sizeof(uint)               );
+    fd_memset( rx_drop_last, 0, socket_max*sizeof(uint) );
+    rx_ready_cnt = 0UL;
+
     /* housekeeping init */
 
     if( lazy<=0L ) lazy = fd_tempo_lazy_default( rx_depth );
@@ -243,6 +298,21 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
     async_min = fd_tempo_async_min( lazy, 1UL /*event_cnt*/, (float)tick_per_ns );
     if( FD_UNLIKELY( !async_min ) ) { FD_LOG_WARNING(( "bad lazy" )); return 1; }
 
+    /* tx flush timeout init */
+
+    tx_burst_timeout = cfg->tx_burst_timeout;
+    if( tx_burst_timeout<=0L ) tx_burst_timeout = (long)async_min;
+    FD_LOG_INFO(( "Configuring tx flush (burst %u, timeout %li ticks, retry max %lu)", tx_burst, tx_burst_timeout, tx_retry_max ));
+
+    rx_budget = cfg->rx_budget;
+    if( rx_budget<=0L ) rx_budget = tx_burst_timeout;
+    FD_LOG_INFO(( "Configuring rx drain (%lu sockets, budget %li ticks)", socket_max, rx_budget ));
+
+    /* rx timestamp init */
+
+    rx_ts_tick0 = fd_tickcount();
+    rx_ts_wall0 = fd_log_wallclock();
+
     /* Sanity check that scratch allocations were within bounds */
     assert( _scratch <= (ulong)cfg->scratch + cfg->scratch_sz );
 
@@ -257,7 +327,7 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
 
     /* Do housekeeping at a low rate in the background */
 
-    if( FD_UNLIKELY( (now-then)>=0L || tx_batch_cnt==tx_burst ) ) {
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
       /* Send synchronization info */
       fd_mcache_seq_update( rx_sync, rx_seq );
 
@@ -271,6 +341,12 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
       cnc_diag->rx_cnt      += cnc_diag_rx_cnt;
       cnc_diag->rx_sz       += cnc_diag_rx_sz;
       cnc_diag->overnp_cnt  += cnc_diag_overnp_cnt;
+      cnc_diag->tx_sent_cnt += cnc_diag_tx_sent_cnt;
+      cnc_diag->tx_drop_cnt += cnc_diag_tx_drop_cnt;
+      cnc_diag->rx_kern_drop_cnt += cnc_diag_rx_kern_drop_cnt;
+      cnc_diag->rx_ts_cnt        += cnc_diag_rx_ts_cnt;
+      cnc_diag->rx_hwts_cnt      += cnc_diag_rx_hwts_cnt;
+      for( ulong j=0UL; j<FDGEN_TILE_NET_DGRAM_RX_HIST_CNT; j++ ) cnc_diag->rx_round_hist[ j ] += cnc_diag_rx_round_hist[ j ];
       FD_COMPILER_MFENCE();
       cnc_diag_backp_cnt   = 0UL;
       cnc_diag_tx_pub_cnt  = 0UL;
@@ -279,6 +355,16 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
       cnc_diag_rx_cnt      = 0UL;
       cnc_diag_rx_sz       = 0UL;
       cnc_diag_overnp_cnt  = 0UL;
+      cnc_diag_tx_sent_cnt = 0UL;
+      cnc_diag_tx_drop_cnt = 0UL;
+      cnc_diag_rx_kern_drop_cnt = 0UL;
+      cnc_diag_rx_ts_cnt        = 0UL;
+      cnc_diag_rx_hwts_cnt      = 0UL;
+      fd_memset( cnc_diag_rx_round_hist, 0, sizeof(cnc_diag_rx_round_hist) );
+
+      /* Resync the tick counter to the RX timestamp clock */
+      rx_ts_tick0 = fd_tickcount();
+      rx_ts_wall0 = fd_log_wallclock();
 
       /* Receive command-and-control signals */
       ulong s = fd_cnc_signal_query( cnc );
@@ -289,14 +375,36 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
 
       /* Reload housekeeping timer */
       then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
 
-      /* Flush TX batch */
-      if( tx_batch_cnt ) {
-        long send_cnt = sendmmsg( send_fd, tx_batch, tx_batch_cnt, MSG_DONTWAIT );
-        if( send_cnt!=(long)tx_batch_cnt ) cnc_diag_backp_cnt++;
-        tx_batch_cnt = 0U;
-        goto flush_rx; /* Always do RX after TX flush */
+    /* Flush TX batch once full or past its deadline, adapting the
+       effective burst size to the offered rate (see net_dgram_tx) */
+
+    if( FD_UNLIKELY( ( (tx_batch_cnt>=tx_burst_eff) & !tx_backp ) | ( (now-tx_deadline)>=0L ) ) ) {
+      if( tx_batch_cnt>=tx_burst_eff ) tx_burst_eff = fd_uint_min( tx_burst_eff<<1, tx_burst );
+      else                             tx_burst_eff = fd_uint_max( tx_batch_cnt,    1U       );
+
+      ulong sent_cnt = fdgen_tile_net_dgram_tx_flush( send_fd, tx_batch, &tx_batch_cnt, &cnc_diag_tx_drop_cnt );
+      cnc_diag_tx_sent_cnt += sent_cnt;
+      tx_deadline           = LONG_MAX;
+      if( FD_UNLIKELY( tx_batch_cnt ) ) {
+        /* Socket buffer is full, retry the unsent suffix later */
+        cnc_diag_backp_cnt++;
+        tx_retry_cnt = fd_ulong_if( !!sent_cnt, 0UL, tx_retry_cnt+1UL );
+        if( FD_UNLIKELY( tx_retry_cnt>tx_retry_max ) ) {
+          cnc_diag_tx_drop_cnt += tx_batch_cnt;
+          tx_batch_cnt = 0U;
+          tx_retry_cnt = 0UL;
+          tx_backp     = 0;
+        } else {
+          tx_deadline = now + tx_burst_timeout;
+          tx_backp    = 1;
+        }
+      } else {
+        tx_retry_cnt = 0UL;
+        tx_backp     = 0;
       }
+      goto flush_rx; /* Always do RX after TX flush */
     }
 
     /* Check if there is a new outgoing packet */
@@ -317,7 +425,7 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
       continue;
     }
 
-    if( tx_diff==0UL ) {
+    if( tx_diff==0UL && tx_batch_cnt<tx_burst ) {
 
       /* We have a packet to transmit */
       struct mmsghdr *     hdr     = tx_batch + tx_batch_cnt;
@@ -338,10 +446,10 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
 
       /* Stateless verify, impossible with well-behaving producer even
          in case of torn read (reads guaranteed atomic) */
-      if( FD_UNLIKELY( ( eth_hdr->net_type != FD_ETH_HDR_TYPE_IP ) |
-                       ( FD_IP4_GET_VERSION( *ip4_hdr ) != 4     ) |
-                       ( sz > mtu                                ) |
-                       ( data_sz_ < 0                            ) ) ) {
+      if( FD_UNLIKELY( ( eth_hdr->net_type != fd_ushort_bswap( FD_ETH_HDR_TYPE_IP ) ) |
+                       ( FD_IP4_GET_VERSION( *ip4_hdr ) != 4                           ) |
+                       ( sz > mtu                                                      ) |
+                       ( data_sz_ < 0                                                  ) ) ) {
         cnc_diag_tx_filt_cnt++;
         tx_seq = fd_seq_inc( tx_seq, 1 );
         continue;
@@ -367,6 +475,7 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
       }
 
       /* Wind up for the next iteration */
+      if( !tx_batch_cnt ) tx_deadline = now + tx_burst_timeout;
       tx_batch_cnt++;
       tx_seq = fd_seq_inc( tx_seq, 1 );
       continue;
@@ -376,91 +485,178 @@ fdgen_tile_net_dgram_rxtx_run( fdgen_tile_net_dgram_rxtx_cfg_t * cfg ) {
     /* Pull incoming packets */
 
 flush_rx:
-    if( event_idx<0 ) {
-      int event_cnt = epoll_wait( epoll_fd, events, FD_TILE_NET_DGRAM_SOCKET_MAX, 0 );
-      if( event_cnt<0 ) {
+    /* Pick up newly ready sockets.  Sockets are registered edge-
+       triggered, so epoll reports each socket once per arrival burst.
+       Sockets that may still hold data stay on the ready list until a
+       short read shows they are drained. */
+
+    if( rx_ready_cnt<socket_max ) {
+      int event_cnt = epoll_wait( epoll_fd, rx_ready+rx_ready_cnt, (int)( socket_max-rx_ready_cnt ), 0 );
+      if( FD_UNLIKELY( event_cnt<0 ) ) {
         int err = errno;
         if( FD_LIKELY( err==EINTR ) ) continue;
         FD_LOG_WARNING(( "epoll_wait failed (%i-%s)", err, fd_io_strerror( err ) ));
         return 1;
       }
-      event_idx = event_cnt-1;
-      continue;
+      rx_ready_cnt += (ulong)event_cnt;
     }
-
-    /* RX available, receive packets into dcache */
-
-    fdgen_tile_net_dgram_epoll_data_t user_data;
-    user_data.u64 = events[ event_idx ].data.u64;
-    struct mmsghdr * rx_batch = rx_msg + rx_slot_idx;
-
-    long rx_batch_cnt_ = recvmmsg( user_data.fd, rx_batch, rx_burst, MSG_DONTWAIT, NULL );
-    if( rx_batch_cnt_<0 ) {
-      int err = errno;
-      if( FD_LIKELY( err==EAGAIN ) ) {
-        now = fd_tickcount();
-        continue;
+    if( !rx_ready_cnt ) continue;
+
+    /* Service every ready socket once, round-robin, until the list is
+       exhausted or the cycle budget runs out.  At least one socket is
+       serviced per round. */
+
+    long  rx_round_end = now + rx_budget;
+    ulong rx_more_cnt  = 0UL;
+    ulong rx_svc_cnt;
+    for( rx_svc_cnt=0UL; rx_svc_cnt<rx_ready_cnt; rx_svc_cnt++ ) {
+      if( FD_UNLIKELY( rx_svc_cnt && (now-rx_round_end)>=0L ) ) break;
+
+      fdgen_tile_net_dgram_epoll_data_t user_data;
+      user_data.u64 = rx_ready[ rx_svc_cnt ].data.u64;
+      ulong sock_idx = user_data.sock_idx;
+      struct mmsghdr * rx_batch = rx_msg + rx_slot_idx;
+
+      long rx_batch_cnt_ = recvmmsg( user_data.fd, rx_batch, rx_burst, MSG_DONTWAIT, NULL );
+      now = fd_tickcount();
+      if( rx_batch_cnt_<0 ) {
+        int err = errno;
+        if( FD_LIKELY( err==EAGAIN ) ) continue;
+        if( FD_LIKELY( err==EINTR  ) ) { rx_more[ rx_more_cnt++ ] = user_data.u64; continue; }
+        FD_LOG_WARNING(( "recvmmsg failed (%i-%s)", err, fd_io_strerror( err ) ));
+        return 1;
       }
-      FD_LOG_WARNING(( "recvmmsg failed (%i-%s)", err, fd_io_strerror( err ) ));
-      return 1;
-    }
-    ulong rx_batch_cnt = (ulong)rx_batch_cnt_;
-
-    /* Burst publish and wind up for next receive */
-
-    for( ulong j=0UL; j<rx_batch_cnt; j++ ) {
-      /* Packet info */
-      struct mmsghdr *     msg      = rx_batch + j;
-      ulong                sz       = (ulong)msg->msg_len + HEADROOM;
-      ulong                sig      = 0UL;  /* TODO format sig for filtering */
-      uchar *              udp_data = msg->msg_hdr.msg_iov->iov_base;
-      uchar *              frame    = udp_data - HEADROOM;
-      struct sockaddr_in * saddr4   = fd_type_pun( msg->msg_hdr.msg_name );
-      if( FD_UNLIKELY( saddr4->sin_family!=AF_INET ) ) {
-        FD_LOG_WARNING(( "unexpected address family %d", saddr4->sin_family ));
-        continue;
+      ulong rx_batch_cnt = (ulong)rx_batch_cnt_;
+
+      /* Burst publish and wind up for next receive */
+
+      for( ulong j=0UL; j<rx_batch_cnt; j++ ) {
+        /* Packet info */
+        struct mmsghdr *     msg      = rx_batch + j;
+        ulong                sz       = (ulong)msg->msg_len + HEADROOM;
+        uchar *              udp_data = msg->msg_hdr.msg_iov->iov_base;
+        uchar *              frame    = udp_data - HEADROOM;
+        struct sockaddr_in * saddr4   = fd_type_pun( msg->msg_hdr.msg_name );
+
+        /* Recover the destination address (values are in net order),
+           the socket's cumulative kernel drop counter and the kernel
+           RX timestamp. */
+        uint   daddr     = 0U;
+        ushort dport     = (ushort)fd_ushort_bswap( (ushort)user_data.dport );
+        int    have_orig = 0;
+        long   ts_tick   = now;
+        for( struct cmsghdr * cmsg = CMSG_FIRSTHDR( &msg->msg_hdr );
+             cmsg;
+             cmsg = CMSG_NXTHDR( &msg->msg_hdr, cmsg ) ) {
+          if( cmsg->cmsg_level==SOL_SOCKET && cmsg->cmsg_type==SO_RXQ_OVFL ) {
+            uint drop_cnt; memcpy( &drop_cnt, CMSG_DATA( cmsg ), sizeof(uint) );
+            cnc_diag_rx_kern_drop_cnt += (uint)( drop_cnt - rx_drop_last[ sock_idx ] );  /* wraps */
+            rx_drop_last[ sock_idx ]   = drop_cnt;
+          } else if( cmsg->cmsg_level==IPPROTO_IP && cmsg->cmsg_type==IP_ORIGDSTADDR ) {
+            struct sockaddr_in const * dst = fd_type_pun_const( CMSG_DATA( cmsg ) );
+            daddr     = dst->sin_addr.s_addr;
+            dport     = dst->sin_port;
+            have_orig = 1;
+          } else if( cmsg->cmsg_level==IPPROTO_IP && cmsg->cmsg_type==IP_PKTINFO && !have_orig ) {
+            struct in_pktinfo const * pktinfo = fd_type_pun_const( CMSG_DATA( cmsg ) );
+            daddr = pktinfo->ipi_addr.s_addr;
+          } else if( cmsg->cmsg_level==SOL_SOCKET && cmsg->cmsg_type==SCM_TIMESTAMPING ) {
+            /* ts[0] is software, ts[2] is raw hardware (zero if none) */
+            struct timespec ts[3]; memcpy( ts, CMSG_DATA( cmsg ), sizeof(ts) );
+            int  hw    = !!( ts[2].tv_sec | ts[2].tv_nsec );
+            long ts_ns = hw ? ts[2].tv_sec*(long)1e9 + ts[2].tv_nsec
+                            : ts[0].tv_sec*(long)1e9 + ts[0].tv_nsec;
+            if( FD_LIKELY( ts_ns ) ) {
+              ts_tick = rx_ts_tick0 + (long)( (double)( ts_ns - rx_ts_wall0 ) * tick_per_ns );
+              ts_tick = fd_long_min( ts_tick, now );  /* never in the future */
+              cnc_diag_rx_ts_cnt++;
+              cnc_diag_rx_hwts_cnt += (ulong)hw;
+            }
+          }
+        }
+
+        /* Reset msghdr fields */
+        msg->msg_hdr.msg_namelen    = sizeof(struct sockaddr_storage);
+        msg->msg_hdr.msg_controllen = FDGEN_TILE_NET_DGRAM_RX_CMSG_SZ;
+
+        if( FD_UNLIKELY( saddr4->sin_family!=AF_INET ) ) {
+          FD_LOG_WARNING(( "unexpected address family %d", saddr4->sin_family ));
+          continue;
+        }
+
+        /* The sig is a hash of the flow 4-tuple (net order), so frags
+           of a flow share a sig and sig sharding keeps them together */
+        ulong sig = fd_ulong_hash( ( ( (ulong)saddr4->sin_addr.s_addr<<32 ) | (ulong)daddr ) ^
+                                   fd_ulong_hash( ( (ulong)saddr4->sin_port<<16 ) | (ulong)dport ) );
+
+        /* Craft packet headers */
+        fd_eth_hdr_t * eth_hdr = fd_type_pun( frame    );
+        fd_ip4_hdr_t * ip4_hdr = fd_type_pun( frame+14 );
+        fd_udp_hdr_t * udp_hdr = fd_type_pun( frame+34 );
+        fd_memset( eth_hdr, 0, sizeof(fd_eth_hdr_t) );
+        eth_hdr->net_type = (ushort)fd_ushort_bswap( FD_ETH_HDR_TYPE_IP );
+        ip4_hdr[0] = (fd_ip4_hdr_t) {
+          .verihl       = FD_IP4_VERIHL( 4, 5 ),
+          .net_tot_len  = (ushort)fd_ushort_bswap( (ushort)( msg->msg_len + 28U ) ),
+          .net_frag_off = (ushort)fd_ushort_bswap( FD_IP4_HDR_FRAG_OFF_DF ),
+          .ttl          = 64,
+          .protocol     = FD_IP4_HDR_PROTOCOL_UDP
+        };
+        memcpy( ip4_hdr->saddr_c, &saddr4->sin_addr.s_addr, 4UL );
+        memcpy( ip4_hdr->daddr_c, &daddr,                   4UL );
+        ip4_hdr->check = fd_ip4_hdr_check( ip4_hdr );
+        udp_hdr[0] = (fd_udp_hdr_t) {
+          .net_sport = (ushort)saddr4->sin_port,  /* already net order */
+          .net_dport = dport,
+          .net_len   = (ushort)fd_ushort_bswap( (ushort)( msg->msg_len + 8U ) ),
+          .check     = 0
+        };
+
+        /* Publish to fd_tango */
+        ulong chunk  = fd_laddr_to_chunk( rx_base, frame );
+        ulong ctl    = fd_frag_meta_ctl( orig, 1 /*som*/, 1 /*eom*/, 0 /*err*/ );
+        ulong tsorig = fd_frag_meta_ts_comp( ts_tick );
+        ulong tspub  = fd_frag_meta_ts_comp( now     );
+        fd_mcache_publish( rx_mcache, rx_depth, rx_seq, sig, chunk, sz, ctl, tsorig, tspub );
+        rx_seq = fd_seq_inc( rx_seq, 1UL );
+
+        cnc_diag_rx_cnt++;
+        cnc_diag_rx_sz += sz;
       }
+      rx_slot_idx += rx_batch_cnt;
+      if( rx_slot_idx>rx_slot_wmark ) rx_slot_idx = 0UL; /* cmov */
 
-      /* Craft fake packet headers */
-      fd_eth_hdr_t * eth_hdr = fd_type_pun( frame    );
-      fd_ip4_hdr_t * ip4_hdr = fd_type_pun( frame+14 );
-      fd_udp_hdr_t * udp_hdr = fd_type_pun( frame+54 );
-      eth_hdr->net_type = FD_ETH_HDR_TYPE_IP;
-      ip4_hdr[0] = (fd_ip4_hdr_t) {
-        .verihl       = FD_IP4_VERIHL( 4, 10 ),  /* padded up to IPv6 header size */
-        .net_tot_len  = (ushort)fd_ushort_bswap( (ushort)sz ),
-        .net_frag_off = (ushort)fd_ushort_bswap( FD_IP4_HDR_FRAG_OFF_DF ),
-        .ttl          = 1,
-        .protocol     = FD_IP4_HDR_PROTOCOL_UDP
-      };
-      udp_hdr[0] = (fd_udp_hdr_t) {
-        .net_sport = (ushort)fd_ushort_bswap( (ushort)saddr4->sin_port ),
-        .net_dport = (ushort)fd_ushort_bswap( (ushort)user_data.dport ),
-        .net_len   = sizeof(fd_udp_hdr_t),
-        .check     = 0
-      };
-
-      /* Publish to fd_tango */
-      ulong chunk  = fd_laddr_to_chunk( rx_base, frame );
-      ulong ctl    = fd_frag_meta_ctl( orig, 1 /*som*/, 1 /*eom*/, 0 /*err*/ );
-      ulong tsorig = fd_frag_meta_ts_comp( now );
-      ulong tspub  = tsorig;
-      fd_mcache_publish( rx_mcache, rx_depth, rx_seq, sig, chunk, sz, ctl, tsorig, tspub );
-      rx_seq = fd_seq_inc( rx_seq, 1UL );
-
-      /* Reset msghdr fields */
-      msg->msg_hdr.msg_iov->iov_len = msg->msg_len;  /* FIXME unnecessary? */
-      msg->msg_hdr.msg_namelen      = sizeof(struct sockaddr_storage);
+      /* A full batch means the socket may hold more data */
+      if( rx_batch_cnt==rx_burst ) rx_more[ rx_more_cnt++ ] = user_data.u64;
     }
-    rx_slot_idx += rx_batch_cnt;
-    if( rx_slot_idx>rx_slot_wmark ) rx_slot_idx = 0UL; /* cmov */
-    event_idx--;
+
+    cnc_diag_rx_round_hist[ fd_ulong_min( (ulong)fd_ulong_find_msb( rx_svc_cnt ), FDGEN_TILE_NET_DGRAM_RX_HIST_CNT-1UL ) ]++;
+
+    /* Carry over to the next round: sockets skipped due to the budget
+       go first, then sockets that may hold more data. */
+
+    ulong rx_tail_cnt = rx_ready_cnt - rx_svc_cnt;
+    memmove( rx_ready, rx_ready+rx_svc_cnt, rx_tail_cnt*sizeof(struct epoll_event) );
+    for( ulong j=0UL; j<rx_more_cnt; j++ ) rx_ready[ rx_tail_cnt+j ].data.u64 = rx_more[ j ];
+    rx_ready_cnt = rx_tail_cnt + rx_more_cnt;
 
   }
 
   do {
 
     FD_LOG_INFO(( "Halted net_dgram_rxtx" ));
+
+    /* Flush frags still batched (see net_dgram_tx) */
+    if( tx_batch_cnt ) {
+      ulong drop_cnt = 0UL;
+      ulong sent_cnt = fdgen_tile_net_dgram_tx_flush( send_fd, tx_batch, &tx_batch_cnt, &drop_cnt );
+      FD_COMPILER_MFENCE();
+      cnc_diag->tx_sent_cnt += sent_cnt;
+      cnc_diag->tx_drop_cnt += drop_cnt + tx_batch_cnt;
+      FD_COMPILER_MFENCE();
+      tx_batch_cnt = 0U;
+    }
+
     fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
 
   } while(0);
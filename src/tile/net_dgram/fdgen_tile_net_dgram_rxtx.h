@@ -8,35 +8,77 @@
    This tile receives from multiple sockets simultaneously via epoll.
    Resolving event metadata is done via fdgen_tile_net_dgram_epoll_data_t.
 
+   Sockets are registered edge-triggered (EPOLLET).  The tile keeps a
+   list of ready sockets and services them round-robin with one
+   recvmmsg(2) each per round, so a single busy socket cannot starve
+   the others.  A socket stays on the list until a short read shows it
+   is drained.  A round ends early once rx_budget ticks have elapsed;
+   the remaining sockets are serviced first in the next round.
+
+   If poll is of mode BUSY, the tile applies its busy poll parameters to
+   epoll_fd at boot (see fdgen_socket_epoll_busy_poll), so epoll_wait(2)
+   busy polls the device queues.  Boot fails on an invalid poll config;
+   kernels without epoll busy poll (older than 6.9) fall back to the
+   socket options, which the caller applies per socket (see
+   fdgen_socket_busy_poll).
+
    # RX flow
 
    Received packets are published onto the rx_{mcache,dcache} pair.
-   Each packet contains a 62 byte dummy header encoding IP/UDP src/dst.
-   The IPv4 header at offset 14 is extended to 40 bytes (IHL 10).
+   Each frag is laid out like a frame delivered by net_xsk_rx: a 14 byte
+   Ethernet header (zero MAC addresses), a 20 byte IPv4 header and an
+   8 byte UDP header, followed by the UDP payload.  The IPv4 src/dst
+   addresses and UDP ports are those of the received datagram.  The
+   destination is recovered from IP_RECVORIGDSTADDR (falling back to
+   IP_PKTINFO and the epoll user data), so sockets should have both
+   options enabled (see fdgen_socket_recv_addrs).  TTL is synthesized
+   and the UDP checksum is left zero.
+
+   The sig is a hash of the 4-tuple (src/dst address and port), like
+   the flow hash published by net_packet_rx, so all frags of a flow
+   carry the same sig and sig-based sharding keeps flows together.
+
+   If sockets have SO_RXQ_OVFL enabled (see fdgen_socket_rxq_ovfl), the
+   datagrams dropped by the kernel at the socket receive buffer are
+   accumulated into the rx_kern_drop_cnt diag.
+
+   tspub is the tick at which the batch was received.  If sockets have
+   SO_TIMESTAMPING enabled (see fdgen_socket_timestamping), tsorig is
+   the per-datagram kernel RX timestamp converted to ticks, so
+   tspub-tsorig is the time spent in the network stack and socket
+   buffer.  Raw hardware timestamps are preferred over software ones
+   when present (counted in rx_hwts_cnt); they are in the NIC's PHC
+   time base and assume the PHC is disciplined to CLOCK_REALTIME (e.g.
+   by phc2sys).  Without timestamps, tsorig equals tspub.
    rx_mache is in unreliable mode, i.e. it does not respect consumer
    flow control credits and consumers may be overrun while reading.
 
    # TX flow
 
-   TODO
+   Frags consumed from tx_mcache are stripped of their Ethernet, IPv4
+   and UDP headers and sent via sendmmsg(2) in batches of up to
+   tx_burst.  Partial batches are flushed after tx_burst_timeout ticks
+   (see net_dgram_tx).
 
    The IPv4 and UDP length fields are ignored. */
 
+#include "../../cfg/fdgen_cfg_net_socket.h"
 #include <firedancer/tango/cnc/fd_cnc.h>
 #include <stdint.h>  /* uint64_t */
 
-/* FD_TILE_NET_DGRAM_SOCKET_MAX is the max number of file descriptors
-   that may be registered with the epoll fd. */
+/* epoll user data is expected to be fdgen_tile_net_dgram_epoll_data_t */
 
-#define FD_TILE_NET_DGRAM_SOCKET_MAX (64)
+/* FDGEN_TILE_NET_DGRAM_SOCKET_MAX bounds socket_max, so that every
+   socket has its own sock_idx */
 
-/* epoll user data is expected to be fdgen_tile_net_dgram_epoll_data_t */
+#define FDGEN_TILE_NET_DGRAM_SOCKET_MAX (USHORT_MAX+1UL)
 
 union fdgen_tile_net_dgram_epoll_data {
   uint64_t u64;
   struct {
     int    fd;
-    ushort dport;
+    ushort dport;     /* host order, fallback if IP_RECVORIGDSTADDR is off */
+    ushort sock_idx;  /* in [0,socket_max), indexes per-socket tile state */
   };
 };
 
@@ -59,11 +101,16 @@ struct fdgen_tile_net_dgram_rxtx_cfg {
   uchar *          rx_dcache;
 
   ulong tx_burst;          /* sendmmsg batch limit */
-  long  tx_burst_timeout;  /* sendmmsg flush timeout (ticks) */
+  long  tx_burst_timeout;  /* sendmmsg flush timeout (ticks), <=0 for housekeeping interval */
+  ulong tx_retry_max;      /* flushes without progress before dropping unsent datagrams, 0 drops on the first one */
   ulong rx_burst;          /* recvmmsg batch lmit */
+  long  rx_budget;         /* max ticks spent draining sockets per round, <=0 for tx_burst_timeout */
+
+  int   epoll_fd;    /* edge-triggered epoll with fdgen_tile_net_dgram_epoll_data_t user datas */
+  ulong socket_max;  /* number of sockets registered with epoll_fd, in [1,FDGEN_TILE_NET_DGRAM_SOCKET_MAX], user data sock_idx in [0,socket_max) */
+  int   send_fd;     /* unbound AF_INET SOCK_DGRAM socket */
 
-  int epoll_fd;  /* level-triggered epoll with fdgen_tile_net_dgram_epoll_data_t user datas */
-  int send_fd;   /* unbound AF_INET SOCK_DGRAM socket */
+  fdgen_socket_poll_t poll;  /* busy polling of epoll_fd, applied at boot */
 
   uchar * scratch;
   ulong   scratch_sz;
@@ -5,9 +5,13 @@
 #include <assert.h>
 #include <errno.h>
 #include <sys/types.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <unistd.h>
+#include <linux/net_tstamp.h>
 
 #include <firedancer/tango/fd_tango_base.h>
 #include <firedancer/tango/cnc/fd_cnc.h>
@@ -20,10 +24,184 @@
 
 /* Transmit Side *******************************************************
 
-   TODO */
+   Outgoing frags are copied into a sendmmsg(2) batch.  A batch is
+   flushed when it reaches the effective burst size or when the first
+   frag that entered it has waited tx_burst_timeout ticks, whichever
+   comes first.  The effective burst size adapts to the offered rate:
+   it drops to the observed batch size on every timeout flush
+   and doubles up to tx_burst on every full flush.  At low rates this
+   bounds per-frag latency by the timeout, at high rates it amortizes
+   syscall cost over full batches.
+
+   If the socket buffer is full, sendmmsg(2) accepts only a prefix of
+   the batch.  The unsent suffix stays at the front of the batch and is
+   retried after the tile waits for POLLOUT (at most one housekeeping
+   interval).  After tx_retry_max consecutive flushes without progress,
+   the suffix is dropped (with tx_retry_max 0, on the first flush
+   without progress).  Frags still batched at halt get one last flush,
+   whatever the kernel does not accept is dropped.  tx_sent_cnt and
+   tx_drop_cnt account for every frag that entered a batch.
+
+   When sharded, frags that belong to other shards are skipped right
+   after reading their metadata, before touching the payload. */
 
 #define HEADROOM (42UL)  /* Ethernet header, IPv4 header, UDP header */
 
+/* Connected socket cache *********************************************
+
+   Each batch entry is tagged with a route: the index of the cached
+   connected socket it goes out on, or CONN_UNBOUND for send_fd.  At
+   flush time the batch is stably partitioned by route and each
+   partition is sent with its own sendmmsg(2) call. */
+
+#define CONN_UNBOUND ((uchar)FDGEN_TILE_NET_DGRAM_TX_CONN_MAX)
+
+struct conn {
+  uint   ip4;        /* net order */
+  ushort port;       /* net order */
+  int    fd;         /* -1 if entry is free */
+  long   last;       /* tick of last use */
+  uint   batch_cnt;  /* entries of the current batch routed via this entry */
+};
+
+/* conn_sock creates a socket bound with SO_REUSEPORT to local.
+   Applies a send buffer size of sndbuf bytes if non-zero and enables
+   SO_TXTIME if txtime_cfg is non-NULL.  Returns the socket on success.
+   On failure, logs warning and returns -1. */
+
+static int
+conn_sock( struct sockaddr_in const * local,
+           int                        sndbuf,
+           struct sock_txtime const * txtime_cfg ) {
+
+  int fd = socket( AF_INET, SOCK_DGRAM, 0 );
+  if( FD_UNLIKELY( fd<0 ) ) {
+    FD_LOG_WARNING(( "socket(AF_INET,SOCK_DGRAM,0) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    return -1;
+  }
+  int reuse = 1;
+  if( FD_UNLIKELY( 0!=setsockopt( fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(int) ) ||
+                   0!=bind( fd, fd_type_pun_const( local ), sizeof(struct sockaddr_in) ) ) ) {
+    FD_LOG_WARNING(( "bind(" FD_IP4_ADDR_FMT ":%u) failed (%i-%s)",
+                     FD_IP4_ADDR_FMT_ARGS( local->sin_addr.s_addr ), fd_ushort_bswap( local->sin_port ),
+                     errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return -1;
+  }
+  if( sndbuf &&
+      FD_UNLIKELY( 0!=setsockopt( fd, SOL_SOCKET, SO_SNDBUFFORCE, &sndbuf, sizeof(int) ) &&
+                   0!=setsockopt( fd, SOL_SOCKET, SO_SNDBUF,      &sndbuf, sizeof(int) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(SO_SNDBUF,%d) failed (%i-%s)", sndbuf, errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return -1;
+  }
+  if( txtime_cfg &&
+      FD_UNLIKELY( 0!=setsockopt( fd, SOL_SOCKET, SO_TXTIME, txtime_cfg, sizeof(struct sock_txtime) ) ) ) {
+    FD_LOG_WARNING(( "setsockopt(SO_TXTIME) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return -1;
+  }
+  return fd;
+}
+
+/* conn_open creates a socket connected to ip4:port (net order), in the
+   source port group of local (see conn_sock).  Returns the socket on
+   success.  On failure, logs warning and returns -1. */
+
+static int
+conn_open( uint                       ip4,
+           ushort                     port,
+           struct sockaddr_in const * local,
+           int                        sndbuf,
+           struct sock_txtime const * txtime_cfg ) {
+
+  int fd = conn_sock( local, sndbuf, txtime_cfg );
+  if( FD_UNLIKELY( fd<0 ) ) return -1;
+  struct sockaddr_in dst = {
+    .sin_family = AF_INET,
+    .sin_addr   = { .s_addr = ip4 },
+    .sin_port   = port
+  };
+  if( FD_UNLIKELY( 0!=connect( fd, fd_type_pun_const( &dst ), sizeof(struct sockaddr_in) ) ) ) {
+    FD_LOG_WARNING(( "connect(" FD_IP4_ADDR_FMT ":%u) failed (%i-%s)",
+                     FD_IP4_ADDR_FMT_ARGS( ip4 ), fd_ushort_bswap( port ), errno, fd_io_strerror( errno ) ));
+    close( fd );
+    return -1;
+  }
+  return fd;
+}
+
+/* tx_flush_routed is fdgen_tile_net_dgram_tx_flush for a batch whose
+   entries are spread over multiple sockets.  route[j] is the route of
+   batch[j].  sort and sort_route are scratch arrays with room for
+   *batch_cnt entries.  On return, unsent entries are at the front of
+   batch (with route permuted alongside), and conn[].batch_cnt counts
+   them.  Entries are only permuted, never duplicated, so each mmsghdr
+   keeps ownership of its buffers. */
+
+static ulong
+tx_flush_routed( int              send_fd,
+                 struct conn *    conn,
+                 struct mmsghdr * batch,
+                 uchar *          route,
+                 struct mmsghdr * sort,
+                 uchar *          sort_route,
+                 uint *           batch_cnt,
+                 ulong *          drop_cnt ) {
+
+  uint cnt = *batch_cnt;
+  uint seg_start[ FDGEN_TILE_NET_DGRAM_TX_CONN_MAX+1UL ] = {0};
+  uint seg_cnt  [ FDGEN_TILE_NET_DGRAM_TX_CONN_MAX+1UL ] = {0};
+  uint seg_rem  [ FDGEN_TILE_NET_DGRAM_TX_CONN_MAX+1UL ];
+
+  /* Stable counting sort by route */
+  for( uint j=0U; j<cnt; j++ ) seg_cnt[ route[ j ] ]++;
+  for( ulong r=1UL; r<=FDGEN_TILE_NET_DGRAM_TX_CONN_MAX; r++ ) seg_start[ r ] = seg_start[ r-1UL ] + seg_cnt[ r-1UL ];
+  uint seg_pos[ FDGEN_TILE_NET_DGRAM_TX_CONN_MAX+1UL ];
+  memcpy( seg_pos, seg_start, sizeof(seg_pos) );
+  for( uint j=0U; j<cnt; j++ ) {
+    uint k = seg_pos[ route[ j ] ]++;
+    sort      [ k ] = batch[ j ];
+    sort_route[ k ] = route[ j ];
+  }
+
+  /* Send each partition */
+  ulong sent = 0UL;
+  for( ulong r=0UL; r<=FDGEN_TILE_NET_DGRAM_TX_CONN_MAX; r++ ) {
+    seg_rem[ r ] = seg_cnt[ r ];
+    if( !seg_cnt[ r ] ) continue;
+    int fd = r==CONN_UNBOUND ? send_fd : conn[ r ].fd;
+    sent += fdgen_tile_net_dgram_tx_flush( fd, sort + seg_start[ r ], &seg_rem[ r ], drop_cnt );
+    if( r<CONN_UNBOUND ) conn[ r ].batch_cnt = seg_rem[ r ];
+  }
+
+  /* Unsent entries first, then sent ones (to keep buffer ownership) */
+  uint out = 0U;
+  for( int pass=0; pass<2; pass++ ) {
+    for( ulong r=0UL; r<=FDGEN_TILE_NET_DGRAM_TX_CONN_MAX; r++ ) {
+      uint lo = pass ? seg_start[ r ] + seg_rem[ r ] : seg_start[ r ];
+      uint hi = pass ? seg_start[ r ] + seg_cnt[ r ] : seg_start[ r ] + seg_rem[ r ];
+      for( uint k=lo; k<hi; k++ ) {
+        batch[ out ] = sort      [ k ];
+        route[ out ] = sort_route[ k ];
+        out++;
+      }
+    }
+    if( !pass ) *batch_cnt = out;
+  }
+  return sent;
+}
+
+/* mono_ns returns the current CLOCK_MONOTONIC time in ns, the clock
+   SO_TXTIME departure times are expressed in. */
+
+static inline long
+mono_ns( void ) {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec*(long)1e9 + ts.tv_nsec;
+}
+
 int
 fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
 
@@ -40,6 +218,9 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
   fd_frag_meta_t * tx_mcache   = cfg->tx_mcache;
   uchar *          tx_base     = cfg->tx_base;
   int              send_fd     = cfg->send_fd;
+  ulong            shard_cnt   = fd_ulong_max( cfg->shard_cnt, 1UL );
+  ulong            shard_idx   = cfg->shard_idx;
+  int              shard_sig   = cfg->shard_mode==FDGEN_TILE_NET_DGRAM_SHARD_SIG;
 
   /* cnc state */
   fdgen_tile_net_dgram_diag_t * cnc_diag;
@@ -48,6 +229,10 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
   ulong   cnc_diag_tx_pub_sz;
   ulong   cnc_diag_tx_filt_cnt;
   ulong   cnc_diag_overnp_cnt;
+  ulong   cnc_diag_tx_sent_cnt;
+  ulong   cnc_diag_tx_drop_cnt;
+  ulong   cnc_diag_conn_hit_cnt;
+  ulong   cnc_diag_conn_miss_cnt;
 
   /* tx (in) frag stream state */
   ulong   tx_depth;
@@ -60,6 +245,32 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
   struct mmsghdr * tx_batch;
   uint             tx_batch_cnt;
   uint             tx_burst;
+  uint             tx_burst_eff;      /* adaptive flush threshold, in [1,tx_burst] */
+  long             tx_burst_timeout;  /* max ticks a frag may wait in a partial batch */
+  long             tx_deadline;       /* flush partial batch at this tick, set when first frag enters batch */
+  ulong            tx_retry_cnt;      /* consecutive flushes that made no progress */
+  ulong            tx_retry_max;
+  struct timespec  tx_wait;           /* max time to block for POLLOUT */
+
+  /* TX pacing */
+  int              pace;              /* SO_TXTIME enabled */
+  double           pace_pkt_ns;       /* min departure gap per datagram (ns) */
+  double           pace_bit_ns;       /* min departure gap per payload bit (ns) */
+  long             pace_next;         /* earliest departure of next datagram (CLOCK_MONOTONIC ns) */
+  long             pace_tick0;        /* tick counter at pace_mono0 */
+  long             pace_mono0;        /* CLOCK_MONOTONIC ns at pace_tick0 */
+
+  /* TX connected socket cache */
+  ulong              conn_cnt = cfg->conn_cnt;
+  int                conn_admit;        /* new cache entries may be created */
+  struct conn        conn[ FDGEN_TILE_NET_DGRAM_TX_CONN_MAX ];
+  uchar *            tx_route;          /* route of each batch entry */
+  uchar *            tx_sort_route;
+  struct mmsghdr *   tx_sort;
+  struct sockaddr_in conn_local;        /* source address of connected sockets */
+  int                conn_anchor;       /* holds the source port of connected sockets, -1 if none */
+  int                conn_sndbuf;       /* send buffer size of send_fd (bytes) */
+  struct sock_txtime conn_txtime_cfg = { .clockid = CLOCK_MONOTONIC, .flags = 0 };
 
   do {
 
@@ -74,7 +285,7 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
     /* scratch init */
 
     FD_SCRATCH_ALLOC_INIT( scratch, cfg->scratch );
-    if( FD_UNLIKELY( fdgen_tile_net_dgram_scratch_footprint( 0, 0, cfg->tx_burst, mtu )
+    if( FD_UNLIKELY( fdgen_tile_net_dgram_scratch_footprint( 1, 0, 0, cfg->tx_burst, mtu, 0 )
                      > cfg->scratch_sz ) ) {
       FD_LOG_WARNING(( "undersz scratch region" ));
       return 1;
@@ -83,7 +294,7 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
     /* cnc state init */
 
     if( FD_UNLIKELY( !cnc ) ) { FD_LOG_WARNING(( "NULL cnc" )); return 1; }
-    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<64UL ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<sizeof(fdgen_tile_net_dgram_diag_t) ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
     if( FD_UNLIKELY( fd_cnc_signal_query( cnc )!=FD_CNC_SIGNAL_BOOT ) ) { FD_LOG_WARNING(( "already booted" )); return 1; }
 
     cnc_diag = fd_cnc_app_laddr( cnc );
@@ -93,6 +304,10 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
     cnc_diag_tx_pub_cnt  = 0UL;
     cnc_diag_tx_pub_sz   = 0UL;
     cnc_diag_tx_filt_cnt = 0UL;
+    cnc_diag_tx_sent_cnt = 0UL;
+    cnc_diag_tx_drop_cnt = 0UL;
+    cnc_diag_conn_hit_cnt  = 0UL;
+    cnc_diag_conn_miss_cnt = 0UL;
 
     /* tx frag stream init */
 
@@ -102,6 +317,19 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
 
     if( FD_UNLIKELY( !tx_base ) ) { FD_LOG_WARNING(( "NULL tx_base" )); return 1; }
 
+    /* shard init */
+
+    if( FD_UNLIKELY( shard_idx>=shard_cnt ) ) {
+      FD_LOG_WARNING(( "invalid shard_idx %lu (shard_cnt %lu)", shard_idx, shard_cnt ));
+      return 1;
+    }
+    if( FD_UNLIKELY( cfg->shard_mode!=FDGEN_TILE_NET_DGRAM_SHARD_SEQ &&
+                     cfg->shard_mode!=FDGEN_TILE_NET_DGRAM_SHARD_SIG ) ) {
+      FD_LOG_WARNING(( "invalid shard_mode %d", cfg->shard_mode ));
+      return 1;
+    }
+    FD_LOG_INFO(( "Configuring tx shard %lu of %lu (by %s)", shard_idx, shard_cnt, shard_sig ? "sig" : "seq" ));
+
     /* tx batch init */
 
     tx_burst = cfg->tx_burst;
@@ -111,6 +339,10 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
     }
 
     tx_batch_cnt = 0U;
+    tx_burst_eff = tx_burst;
+    tx_deadline  = LONG_MAX;
+    tx_retry_cnt = 0UL;
+    tx_retry_max = cfg->tx_retry_max;
     struct sockaddr_storage * tx_addrs;
     struct iovec *            tx_iov;
     uchar *                   tx_buf;
@@ -129,13 +361,116 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
       tx_buf += mtu;
     }
 
+    /* tx pacing init */
+
+    pace = cfg->pace_pps || cfg->pace_bps;
+    if( pace ) {
+      struct sock_txtime txtime_cfg = { .clockid = CLOCK_MONOTONIC, .flags = 0 };
+      if( FD_UNLIKELY( 0!=setsockopt( send_fd, SOL_SOCKET, SO_TXTIME, &txtime_cfg, sizeof(struct sock_txtime) ) ) ) {
+        FD_LOG_WARNING(( "setsockopt(SO_TXTIME) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+        return 1;
+      }
+
+      /* Each datagram owns one SCM_TXTIME control message.  The
+         buffers move with their mmsghdr when unsent entries are
+         swapped to the front of the batch. */
+      uchar * tx_cmsg = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(struct cmsghdr), tx_burst*FDGEN_TILE_NET_DGRAM_TX_CMSG_SZ );
+      fd_memset( tx_cmsg, 0, tx_burst*FDGEN_TILE_NET_DGRAM_TX_CMSG_SZ );
+      for( ulong j=0UL; j<tx_burst; j++ ) {
+        struct msghdr * msg  = &tx_batch[ j ].msg_hdr;
+        msg->msg_control     = tx_cmsg + j*FDGEN_TILE_NET_DGRAM_TX_CMSG_SZ;
+        msg->msg_controllen  = FDGEN_TILE_NET_DGRAM_TX_CMSG_SZ;
+        struct cmsghdr * cm  = CMSG_FIRSTHDR( msg );
+        cm->cmsg_level       = SOL_SOCKET;
+        cm->cmsg_type        = SCM_TXTIME;
+        cm->cmsg_len         = CMSG_LEN( sizeof(ulong) );
+      }
+    }
+    pace_pkt_ns = cfg->pace_pps ? 1e9 / (double)cfg->pace_pps : 0.0;
+    pace_bit_ns = cfg->pace_bps ? 1e9 / (double)cfg->pace_bps : 0.0;
+    pace_next   = 0L;
+    pace_tick0  = fd_tickcount();
+    pace_mono0  = mono_ns();
+    FD_LOG_INFO(( "Configuring tx pacing (%lu pkt/s, %lu bit/s)", cfg->pace_pps, cfg->pace_bps ));
+
+    /* tx connected socket cache init */
+
+    if( FD_UNLIKELY( conn_cnt>FDGEN_TILE_NET_DGRAM_TX_CONN_MAX ) ) {
+      FD_LOG_WARNING(( "conn_cnt %lu exceeds max %lu", conn_cnt, FDGEN_TILE_NET_DGRAM_TX_CONN_MAX ));
+      return 1;
+    }
+    conn_admit = 1;
+    for( ulong j=0UL; j<FDGEN_TILE_NET_DGRAM_TX_CONN_MAX; j++ ) {
+      conn[ j ] = (struct conn){ .fd = -1 };
+    }
+    tx_route      = NULL;
+    tx_sort_route = NULL;
+    tx_sort       = NULL;
+    conn_anchor   = -1;
+    conn_sndbuf   = 0;
+    fd_memset( &conn_local, 0, sizeof(struct sockaddr_in) );
+    if( conn_cnt ) {
+      tx_sort       = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(struct mmsghdr), tx_burst*sizeof(struct mmsghdr) );
+      tx_route      = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(uchar),          tx_burst*2UL                    );
+      tx_sort_route = tx_route + tx_burst;
+
+      socklen_t local_sz = sizeof(struct sockaddr_in);
+      if( FD_UNLIKELY( 0!=getsockname( send_fd, fd_type_pun( &conn_local ), &local_sz ) ) ) {
+        FD_LOG_WARNING(( "getsockname(send_fd) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+        return 1;
+      }
+      if( FD_UNLIKELY( conn_local.sin_family!=AF_INET ) ) {
+        FD_LOG_WARNING(( "send_fd is not an AF_INET socket" ));
+        return 1;
+      }
+
+      /* Connected sockets get the same send buffer as send_fd */
+      socklen_t sndbuf_sz = sizeof(int);
+      if( FD_UNLIKELY( 0!=getsockopt( send_fd, SOL_SOCKET, SO_SNDBUF, &conn_sndbuf, &sndbuf_sz ) ) ) {
+        FD_LOG_WARNING(( "getsockopt(send_fd,SO_SNDBUF) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+        return 1;
+      }
+      conn_sndbuf /= 2;  /* kernel reports twice the usable size */
+
+      /* Connected sockets must not join the SO_REUSEPORT group of
+         send_fd's port, which may be shared with RX sockets: a
+         connected member sets reuseport_has_conns and disables steering
+         of the whole group.  Instead they share a dedicated source
+         port on send_fd's address, held by an anchor socket for the
+         lifetime of the tile such that it stays stable across cache
+         evictions. */
+      conn_local.sin_port = 0;
+      conn_anchor = conn_sock( &conn_local, 0, NULL );
+      if( FD_UNLIKELY( conn_anchor<0 ) ) return 1;
+      if( FD_UNLIKELY( 0!=getsockname( conn_anchor, fd_type_pun( &conn_local ), &local_sz ) ) ) {
+        FD_LOG_WARNING(( "getsockname(conn_anchor) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+        close( conn_anchor );
+        return 1;
+      }
+    }
+    FD_LOG_INFO(( "Configuring tx connected socket cache (%lu entries, source " FD_IP4_ADDR_FMT ":%u)",
+                  conn_cnt, FD_IP4_ADDR_FMT_ARGS( conn_local.sin_addr.s_addr ), fd_ushort_bswap( conn_local.sin_port ) ));
+
     /* housekeeping init */
 
     if( lazy<=0L ) lazy = fd_tempo_lazy_default( tx_depth );
     FD_LOG_INFO(( "Configuring housekeeping (lazy %li ns)", lazy ));
 
     async_min = fd_tempo_async_min( lazy, 1UL /*event_cnt*/, (float)tick_per_ns );
-    if( FD_UNLIKELY( !async_min ) ) { FD_LOG_WARNING(( "bad lazy" )); return 1; }
+    if( FD_UNLIKELY( !async_min ) ) {
+      FD_LOG_WARNING(( "bad lazy" ));
+      if( conn_anchor>=0 ) close( conn_anchor );
+      return 1;
+    }
+
+    /* tx flush timeout init */
+
+    tx_burst_timeout = cfg->tx_burst_timeout;
+    if( tx_burst_timeout<=0L ) tx_burst_timeout = (long)async_min;
+    FD_LOG_INFO(( "Configuring tx flush (burst %u, timeout %li ticks, retry max %lu)", tx_burst, tx_burst_timeout, tx_retry_max ));
+
+    tx_wait.tv_sec  = lazy / (long)1e9;
+    tx_wait.tv_nsec = lazy % (long)1e9;
 
     /* Sanity check that scratch allocations were within bounds */
     assert( _scratch <= (ulong)cfg->scratch + cfg->scratch_sz );
@@ -151,7 +486,7 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
 
     /* Do housekeeping at a low rate in the background */
 
-    if( FD_UNLIKELY( (now-then)>=0L || tx_batch_cnt==tx_burst ) ) {
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
       /* Send diagnostic info */
       fd_cnc_heartbeat( cnc, now );
       FD_COMPILER_MFENCE();
@@ -160,12 +495,26 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
       cnc_diag->tx_pub_sz   += cnc_diag_tx_pub_sz;
       cnc_diag->tx_filt_cnt += cnc_diag_tx_filt_cnt;
       cnc_diag->overnp_cnt  += cnc_diag_overnp_cnt;
+      cnc_diag->tx_sent_cnt += cnc_diag_tx_sent_cnt;
+      cnc_diag->tx_drop_cnt += cnc_diag_tx_drop_cnt;
+      cnc_diag->conn_hit_cnt  += cnc_diag_conn_hit_cnt;
+      cnc_diag->conn_miss_cnt += cnc_diag_conn_miss_cnt;
       FD_COMPILER_MFENCE();
       cnc_diag_backp_cnt   = 0UL;
       cnc_diag_tx_pub_cnt  = 0UL;
       cnc_diag_tx_pub_sz   = 0UL;
       cnc_diag_tx_filt_cnt = 0UL;
       cnc_diag_overnp_cnt  = 0UL;
+      cnc_diag_tx_sent_cnt = 0UL;
+      cnc_diag_tx_drop_cnt = 0UL;
+      cnc_diag_conn_hit_cnt  = 0UL;
+      cnc_diag_conn_miss_cnt = 0UL;
+
+      /* Resync the tick counter to the pacing clock */
+      if( pace ) {
+        pace_tick0 = fd_tickcount();
+        pace_mono0 = mono_ns();
+      }
 
       /* Receive command-and-control signals */
       ulong s = fd_cnc_signal_query( cnc );
@@ -176,14 +525,48 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
 
       /* Reload housekeeping timer */
       then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
+
+    /* Flush TX batch once it reaches the effective burst size or once
+       its oldest frag has waited tx_burst_timeout ticks.  A flush
+       triggered by the deadline means the offered rate is too low to
+       fill tx_burst_eff frags per timeout, so shrink the threshold to
+       what actually arrived.  A flush triggered by a full batch means
+       the rate picked up again, so grow it back towards tx_burst. */
+
+    if( FD_UNLIKELY( tx_batch_cnt>=tx_burst_eff || (now-tx_deadline)>=0L ) ) {
+      if( tx_batch_cnt>=tx_burst_eff ) tx_burst_eff = fd_uint_min( tx_burst_eff<<1, tx_burst );
+      else                             tx_burst_eff = fd_uint_max( tx_batch_cnt,    1U       );
+
+      ulong sent_cnt;
+      if( conn_cnt ) sent_cnt = tx_flush_routed( send_fd, conn, tx_batch, tx_route, tx_sort, tx_sort_route, &tx_batch_cnt, &cnc_diag_tx_drop_cnt );
+      else           sent_cnt = fdgen_tile_net_dgram_tx_flush( send_fd, tx_batch, &tx_batch_cnt, &cnc_diag_tx_drop_cnt );
+      cnc_diag_tx_sent_cnt += sent_cnt;
+      tx_deadline           = LONG_MAX;
+      if( FD_LIKELY( !tx_batch_cnt ) ) {
+        tx_retry_cnt = 0UL;
+        continue;
+      }
 
-      /* Flush TX batch */
-      if( tx_batch_cnt ) {
-        long send_cnt = sendmmsg( send_fd, tx_batch, tx_batch_cnt, MSG_DONTWAIT );
-        if( send_cnt!=(long)tx_batch_cnt ) cnc_diag_backp_cnt++;
+      /* Socket buffer is full.  Keep the unsent suffix, give up on it
+         if the kernel has not made progress for too long, otherwise
+         wait until the socket drains and retry right away. */
+      cnc_diag_backp_cnt++;
+      tx_retry_cnt = fd_ulong_if( !!sent_cnt, 0UL, tx_retry_cnt+1UL );
+      if( FD_UNLIKELY( tx_retry_cnt>tx_retry_max ) ) {
+        cnc_diag_tx_drop_cnt += tx_batch_cnt;
         tx_batch_cnt = 0U;
+        tx_retry_cnt = 0UL;
+        for( ulong j=0UL; j<conn_cnt; j++ ) conn[ j ].batch_cnt = 0U;
         continue;
       }
+      /* Any blocked socket is a good enough proxy for the NIC queue */
+      int wait_fd = send_fd;
+      if( conn_cnt && tx_route[ 0 ]!=CONN_UNBOUND ) wait_fd = conn[ tx_route[ 0 ] ].fd;
+      struct pollfd pfd = { .fd = wait_fd, .events = POLLOUT };
+      ppoll( &pfd, 1, &tx_wait, NULL );
+      tx_deadline = fd_tickcount();
+      continue;
     }
 
     /* Check if there is a new outgoing packet
@@ -210,6 +593,13 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
       continue;
     }
 
+    /* Skip frags owned by other shards */
+    ulong shard_key = fd_ulong_if( shard_sig, fd_ulong_hash( fd_frag_meta_sse0_sig( tx_mline_sse0 ) ), tx_seq );
+    if( shard_cnt>1UL && (shard_key % shard_cnt)!=shard_idx ) {
+      tx_seq = fd_seq_inc( tx_seq, 1 );
+      continue;
+    }
+
     /* We have a packet to transmit */
     struct mmsghdr *     hdr     = tx_batch + tx_batch_cnt;
     struct sockaddr_in * saddr4  = fd_type_pun( hdr->msg_hdr.msg_name );
@@ -229,10 +619,10 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
 
     /* Stateless verify, impossible with well-behaving producer even
         in case of torn read (reads guaranteed atomic) */
-    if( FD_UNLIKELY( ( eth_hdr->net_type != FD_ETH_HDR_TYPE_IP ) |
-                      ( FD_IP4_GET_VERSION( *ip4_hdr ) != 4     ) |
-                      ( sz > mtu                                ) |
-                      ( data_sz_ < 0                            ) ) ) {
+    if( FD_UNLIKELY( ( eth_hdr->net_type != fd_ushort_bswap( FD_ETH_HDR_TYPE_IP ) ) |
+                      ( FD_IP4_GET_VERSION( *ip4_hdr ) != 4                           ) |
+                      ( sz > mtu                                                      ) |
+                      ( data_sz_ < 0                                                  ) ) ) {
       cnc_diag_tx_filt_cnt++;
       tx_seq = fd_seq_inc( tx_seq, 1 );
       continue;
@@ -257,7 +647,65 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
       continue;
     }
 
+    /* Route via a connected socket if the destination is cached */
+    if( conn_cnt ) {
+      uint   dst_ip4  = saddr4->sin_addr.s_addr;
+      ushort dst_port = saddr4->sin_port;
+      ulong  route    = CONN_UNBOUND;
+      ulong  lru      = 0UL;
+      ulong  free_idx = CONN_UNBOUND;
+      for( ulong j=0UL; j<conn_cnt; j++ ) {
+        if( conn[ j ].fd<0 ) { free_idx = j; continue; }
+        if( conn[ j ].ip4==dst_ip4 && conn[ j ].port==dst_port ) { route = j; break; }
+        if( conn[ j ].last<conn[ lru ].last || conn[ lru ].fd<0 ) lru = j;
+      }
+
+      if( FD_UNLIKELY( route==CONN_UNBOUND ) ) {
+        cnc_diag_conn_miss_cnt++;
+
+        /* Pick a victim: a free entry, else the LRU entry if idle for
+           a housekeeping interval and not referenced by the batch */
+        ulong victim = free_idx;
+        if( victim==CONN_UNBOUND && conn_admit && !conn[ lru ].batch_cnt &&
+            (now-conn[ lru ].last)>=(long)async_min ) {
+          close( conn[ lru ].fd );
+          conn[ lru ].fd = -1;
+          victim = lru;
+        }
+        if( conn_admit && victim!=CONN_UNBOUND ) {
+          int fd = conn_open( dst_ip4, dst_port, &conn_local, conn_sndbuf, pace ? &conn_txtime_cfg : NULL );
+          if( FD_LIKELY( fd>=0 ) ) {
+            conn[ victim ] = (struct conn){ .ip4 = dst_ip4, .port = dst_port, .fd = fd };
+            route = victim;
+          } else {
+            FD_LOG_WARNING(( "disabling connected socket cache" ));
+            conn_admit = 0;
+          }
+        }
+      } else {
+        cnc_diag_conn_hit_cnt++;
+      }
+
+      if( route!=CONN_UNBOUND ) {
+        hdr->msg_hdr.msg_namelen = 0;
+        conn[ route ].last = now;
+        conn[ route ].batch_cnt++;
+      }
+      tx_route[ tx_batch_cnt ] = (uchar)route;
+    }
+
+    /* Schedule departure */
+    if( pace ) {
+      long mono_now = pace_mono0 + (long)( (double)(now-pace_tick0) / tick_per_ns );
+      long txtime   = fd_long_max( pace_next, mono_now );
+      double gap_ns = pace_bit_ns*(double)(data_sz<<3);
+      gap_ns        = gap_ns>pace_pkt_ns ? gap_ns : pace_pkt_ns;
+      pace_next     = txtime + (long)gap_ns;
+      FD_STORE( ulong, CMSG_DATA( CMSG_FIRSTHDR( &hdr->msg_hdr ) ), (ulong)txtime );
+    }
+
     /* Wind up for the next iteration */
+    if( !tx_batch_cnt ) tx_deadline = now + tx_burst_timeout;
     tx_batch_cnt++;
     tx_seq = fd_seq_inc( tx_seq, 1 );
     continue;
@@ -266,9 +714,53 @@ fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg ) {
   do {
 
     FD_LOG_INFO(( "Halted net_dgram_tx" ));
+
+    /* Flush frags still batched.  Housekeeping just published the
+       local diag counters, so account for them directly. */
+    if( tx_batch_cnt ) {
+      ulong sent_cnt;
+      ulong drop_cnt = 0UL;
+      if( conn_cnt ) sent_cnt = tx_flush_routed( send_fd, conn, tx_batch, tx_route, tx_sort, tx_sort_route, &tx_batch_cnt, &drop_cnt );
+      else           sent_cnt = fdgen_tile_net_dgram_tx_flush( send_fd, tx_batch, &tx_batch_cnt, &drop_cnt );
+      FD_COMPILER_MFENCE();
+      cnc_diag->tx_sent_cnt += sent_cnt;
+      cnc_diag->tx_drop_cnt += drop_cnt + tx_batch_cnt;
+      FD_COMPILER_MFENCE();
+      tx_batch_cnt = 0U;
+    }
+
+    for( ulong j=0UL; j<conn_cnt; j++ ) {
+      if( conn[ j ].fd>=0 ) close( conn[ j ].fd );
+    }
+    if( conn_anchor>=0 ) close( conn_anchor );
     fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
 
   } while(0);
 
   return 0;
 }
+
+double
+fdgen_tile_net_dgram_tx_shard_report( fdgen_tile_net_dgram_diag_t const * const * diag,
+                                      ulong                                       shard_cnt,
+                                      ulong *                                     last_sent,
+                                      long                                        dt ) {
+
+  if( FD_UNLIKELY( !shard_cnt || dt<=0L ) ) return 0.0;
+
+  double rate_sum = 0.0;
+  double rate_max = 0.0;
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    ulong sent   = FD_VOLATILE_CONST( diag[j]->tx_sent_cnt );
+    double rate  = (double)( sent - last_sent[j] ) * 1e9 / (double)dt;
+    last_sent[j] = sent;
+    rate_sum    += rate;
+    rate_max     = rate>rate_max ? rate : rate_max;
+    FD_LOG_INFO(( "tx shard %2lu: %10.0f pkt/s", j, rate ));
+  }
+
+  double rate_mean = rate_sum / (double)shard_cnt;
+  double imbalance = rate_mean>0.0 ? rate_max / rate_mean : 1.0;
+  FD_LOG_NOTICE(( "tx %lu shards: %10.0f pkt/s total, imbalance %.3f", shard_cnt, rate_sum, imbalance ));
+  return imbalance;
+}
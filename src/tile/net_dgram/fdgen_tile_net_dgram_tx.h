@@ -3,12 +3,61 @@
 /* The net_dgram_tx tile forwards UDP datagrams from fd_tango to an
    unbound AF_INET SOCK_DGRAM socket.
 
-   TODO
+   # Sharding
+
+   A single tile tops out at one core's worth of sendmmsg(2) calls.
+   Multiple net_dgram_tx tiles may consume the same tx mcache in
+   parallel, each one taking a disjoint subset of frags (a shard).
+   Frags are assigned to shards by sequence number (seq % shard_cnt) or
+   by a hash of the frag signature.  Sig sharding keeps all frags with
+   the same sig on the same tile, which preserves their ordering.  Each
+   shard should be given its own send_fd, ideally bound to a distinct
+   source port (see fdgen_ports_socket_shard_fd) such that kernel TX
+   queues and the receiver's RSS spread as well.
+
+   # Connected sockets
+
+   Sending through an unbound socket makes the kernel resolve the route
+   and neighbor for every datagram.  If conn_cnt is non-zero, the tile
+   keeps a cache of up to conn_cnt sockets connect(2)ed to recently
+   seen (dst ip, dst port) pairs.  Frags to a cached destination are
+   sent on its connected socket without msg_name, all others go through
+   send_fd.  New destinations take a free cache entry or evict the least
+   recently used one, but only if it has been idle for a housekeeping
+   interval, so workloads with more destinations than entries fall back
+   to send_fd instead of thrashing.  Connected sockets use the local
+   address and send buffer size of send_fd, but share a dedicated source
+   port picked at boot, so they never join an SO_REUSEPORT group of RX
+   sockets.  conn_hit_cnt and conn_miss_cnt report the hit rate.
+
+   # Pacing
+
+   If pace_pps or pace_bps is set, the tile enables SO_TXTIME on send_fd
+   and attaches an SCM_TXTIME earliest departure time (CLOCK_MONOTONIC)
+   to each datagram.  Departure times are spaced by 1/pace_pps seconds
+   or by the payload size at pace_bps, whichever is longer.  The
+   schedule never runs behind the current time, so idle periods do not
+   cause catch-up bursts.  The kernel enforces departure times only if
+   the egress interface uses the fq qdisc (see fdgen_netlink_qdisc_fq);
+   otherwise datagrams leave immediately.  Rates apply per tile, so
+   sharded tiles should each be configured with their share.
 
    The IPv4 and UDP length fields are ignored. */
 
 #include <firedancer/tango/cnc/fd_cnc.h>
 #include <stdint.h>  /* uint64_t */
+#include "fdgen_tile_net_dgram.h"
+
+/* FDGEN_TILE_NET_DGRAM_TX_CONN_MAX is the max number of connected
+   sockets cached by a net_dgram_tx tile. */
+
+#define FDGEN_TILE_NET_DGRAM_TX_CONN_MAX (16UL)
+
+/* FDGEN_TILE_NET_DGRAM_SHARD_{SEQ,SIG} select how frags are assigned
+   to net_dgram_tx shards. */
+
+#define FDGEN_TILE_NET_DGRAM_SHARD_SEQ (0)
+#define FDGEN_TILE_NET_DGRAM_SHARD_SIG (1)
 
 struct fdgen_tile_net_dgram_tx_cfg {
 
@@ -23,7 +72,17 @@ struct fdgen_tile_net_dgram_tx_cfg {
   fd_frag_meta_t * tx_mcache;
 
   ulong tx_burst;          /* sendmmsg batch limit */
-  long  tx_burst_timeout;  /* sendmmsg flush timeout (ticks) */
+  long  tx_burst_timeout;  /* sendmmsg flush timeout (ticks), <=0 for housekeeping interval */
+  ulong tx_retry_max;      /* flushes without progress before dropping unsent datagrams, 0 drops on the first one */
+
+  ulong shard_cnt;   /* number of tiles consuming tx_mcache, 0 or 1 to disable sharding */
+  ulong shard_idx;   /* index of this tile in [0,shard_cnt) */
+  int   shard_mode;  /* FDGEN_TILE_NET_DGRAM_SHARD_{SEQ,SIG} */
+
+  ulong conn_cnt;  /* connected socket cache size in [0,FDGEN_TILE_NET_DGRAM_TX_CONN_MAX], 0 to disable */
+
+  ulong pace_pps;  /* SO_TXTIME pacing rate in datagrams per second, 0 for none */
+  ulong pace_bps;  /* SO_TXTIME pacing rate in UDP payload bits per second, 0 for none */
 
   int send_fd;   /* unbound AF_INET SOCK_DGRAM socket */
 
@@ -41,4 +100,17 @@ FD_PROTOTYPES_BEGIN
 int
 fdgen_tile_net_dgram_tx_run( fdgen_tile_net_dgram_tx_cfg_t * cfg );
 
+/* fdgen_tile_net_dgram_tx_shard_report logs the send rate of each of
+   shard_cnt net_dgram_tx shards over the last dt nanoseconds, given
+   their cnc diags.  last_sent[i] holds the tx_sent_cnt of shard i at
+   the previous report and is updated in place.  Also logs the shard
+   imbalance, i.e. the rate of the busiest shard divided by the mean
+   rate.  Returns the imbalance (1.0 is perfectly balanced). */
+
+double
+fdgen_tile_net_dgram_tx_shard_report( fdgen_tile_net_dgram_diag_t const * const * diag,
+                                      ulong                                       shard_cnt,
+                                      ulong *                                     last_sent,
+                                      long                                        dt );
+
 FD_PROTOTYPES_BEGIN
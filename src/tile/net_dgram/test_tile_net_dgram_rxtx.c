@@ -1,6 +1,8 @@
 #define _GNU_SOURCE
 #include "fdgen_tile_net_dgram_rxtx.h"
 #include "fdgen_tile_net_dgram.h"
+#include "../../cfg/fdgen_cfg_net_socket.h"
+#include "../gen/fdgen_tile_gen_tmpl.h"
 #include <firedancer/tango/cnc/fd_cnc.h>
 #include <firedancer/tango/mcache/fd_mcache.h>
 #include <firedancer/tango/dcache/fd_dcache.h>
@@ -77,6 +79,11 @@ send_tile_main( int     argc,
   fd_rng_t _rng[1];
   fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, seed, 0UL ) );
 
+  /* Build the header template once */
+  static uchar const mac0[6] = {0};
+  fdgen_tile_gen_tmpl_t tmpl[1];
+  fdgen_tile_gen_tmpl_init( tmpl, mac0, mac0, FD_IP4_ADDR( 127, 0, 0, 1 ), dst_ip, dst_port, 1 );
+
   /* Configure housekeeping */
   float tick_per_ns = (float)fd_tempo_tick_per_ns( NULL );
   ulong async_min = fd_tempo_async_min( args->lazy, 1UL /*event_cnt*/, tick_per_ns );
@@ -97,27 +104,9 @@ send_tile_main( int     argc,
       then = now + (long)fd_tempo_async_reload( rng, async_min );
     }
 
-    uchar *        pkt     = fd_chunk_to_laddr( base, chunk );
-    fd_eth_hdr_t * eth_hdr = fd_type_pun( pkt    );
-    fd_ip4_hdr_t * ip4_hdr = fd_type_pun( pkt+14 );
-    fd_udp_hdr_t * udp_hdr = fd_type_pun( pkt+34 );
-    eth_hdr->net_type = FD_ETH_HDR_TYPE_IP;
-    ip4_hdr[0] = (fd_ip4_hdr_t) {
-      .verihl       = FD_IP4_VERIHL( 4, 5 ),
-      .net_tot_len  = (ushort)fd_ushort_bswap( 64 ),
-      .net_frag_off = (ushort)fd_ushort_bswap( FD_IP4_HDR_FRAG_OFF_DF ),
-      .ttl          = 1,
-      .protocol     = FD_IP4_HDR_PROTOCOL_UDP
-    };
-    memcpy( ip4_hdr->daddr_c, &dst_ip, 4 );
-    udp_hdr[0] = (fd_udp_hdr_t) {
-      .net_sport = (ushort)fd_ushort_bswap( 0x1234 ),
-      .net_dport = (ushort)fd_ushort_bswap( (ushort)dst_port ),
-      .net_len   = (ushort)fd_ushort_bswap( 8 ),
-      .check     = 0
-    };
+    uchar * pkt = fd_chunk_to_laddr( base, chunk );
+    ulong   sz  = fdgen_tile_gen_tmpl_write( pkt, tmpl, 0x1234, (ushort)seq, 0UL );
 
-    ulong sz     = 42UL;
     ulong ctl    = fd_frag_meta_ctl( orig, 1, 1, 0 );
     ulong sig    = 0UL;
     ulong tsorig = 0UL;
@@ -142,6 +131,13 @@ struct test_recv_args {
 
   long lazy;
   uint seed;
+
+  uint   dst_ip;   /* net order, expected IPv4 daddr of received frags */
+  ushort dst_port; /* host order, expected UDP dport of received frags */
+
+  ulong  frag_tot; /* out, frags received */
+  long   lat_tot;  /* out, sum of tspub-tsorig (ticks) over frags received */
+  ulong  flow_sig; /* out, sig of the first frag received */
 };
 
 typedef struct test_recv_args test_recv_args_t;
@@ -178,6 +174,7 @@ recv_tile_main( int     argc,
 
   long  then = fd_log_wallclock();
   ulong iter = 0UL;
+  long  lat_sum = 0L;  /* sum of tspub-tsorig (ticks), stack latency with SO_TIMESTAMPING */
 
   fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
   for(;;) {
@@ -194,8 +191,7 @@ recv_tile_main( int     argc,
     ulong tspub;
     FD_MCACHE_WAIT_REG( sig, chunk, sz, ctl, tsorig, tspub, mline, seq_found, diff, async_rem, mcache, depth, seq );
 
-    /* FIXME look at message data */
-    (void)tspub; (void)tsorig; (void)ctl; (void)sz; (void)chunk; (void)sig; (void)base;
+    (void)ctl;
 
     if( FD_UNLIKELY( !async_rem ) ) {
       long now = fd_log_wallclock();
@@ -204,7 +200,10 @@ recv_tile_main( int     argc,
       long dt = now - then;
       if( FD_UNLIKELY( dt > (long)1e9 ) ) {
         float mfps = (1e3f*(float)iter) / (float)dt;
-        FD_LOG_NOTICE(( "%7.3f Mfrag/s rx (ovrnp %lu ovrnr %lu)", (double)mfps, ovrnp_cnt, ovrnr_cnt ));
+        float lat  = iter ? (float)lat_sum / ((float)iter*tick_per_ns) : 0.f;
+        FD_LOG_NOTICE(( "%7.3f Mfrag/s rx (ovrnp %lu ovrnr %lu) stack latency %.0f ns",
+                        (double)mfps, ovrnp_cnt, ovrnr_cnt, (double)lat ));
+        lat_sum   = 0L;
         ovrnp_cnt = 0UL;
         ovrnr_cnt = 0UL;
         then      = now;
@@ -227,12 +226,36 @@ recv_tile_main( int     argc,
       continue;
     }
 
+    /* Speculatively check synthesized headers */
+    uchar const *        pkt     = fd_chunk_to_laddr_const( base, chunk );
+    fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( pkt+14 );
+    fd_udp_hdr_t const * udp_hdr = fd_type_pun_const( pkt+34 );
+    uint daddr; memcpy( &daddr, ip4_hdr->daddr_c, 4UL );
+    int hdr_ok = ( sz>=42UL                                              ) &
+                 ( FD_IP4_GET_IHL( *ip4_hdr )==5                         ) &
+                 ( daddr==args->dst_ip                                   ) &
+                 ( fd_ushort_bswap( udp_hdr->net_dport )==args->dst_port ) &
+                 ( fd_ushort_bswap( ip4_hdr->net_tot_len )==sz-14UL      );
+
     seq_found = fd_frag_meta_seq_query( mline );
     if( FD_UNLIKELY( fd_seq_ne( seq_found, seq ) ) ) {
       ovrnr_cnt++;
       seq = seq_found;
       continue;
     }
+    if( FD_UNLIKELY( !hdr_ok ) ) FD_LOG_ERR(( "bad synthesized header (seq %lu)", seq ));
+
+    /* All datagrams come from the rxtx tile's send socket to the same
+       port, i.e. a single flow, so they share one nonzero sig */
+    if( !args->frag_tot ) args->flow_sig = sig;
+    if( FD_UNLIKELY( !sig || sig!=args->flow_sig ) ) FD_LOG_ERR(( "sig %016lx of seq %lu, flow sig %016lx", sig, seq, args->flow_sig ));
+
+    long ts_ref = fd_tickcount();
+    long lat    = fd_frag_meta_ts_decomp( tspub, ts_ref ) - fd_frag_meta_ts_decomp( tsorig, ts_ref );
+    if( FD_UNLIKELY( lat<0L ) ) FD_LOG_ERR(( "tsorig after tspub (seq %lu)", seq ));
+    lat_sum += lat;
+    args->lat_tot += lat;
+    args->frag_tot++;
 
     seq = fd_seq_inc( seq, 1UL );
     iter++;
@@ -258,9 +281,14 @@ struct test_rxtx_args {
 
   ulong tx_burst;
   long  tx_burst_timeout;
+  ulong tx_retry_max;
   ulong rx_burst;
-  ulong so_rcvbuf;
-  ulong so_sndbuf;
+  ulong so_rcvbuf;  /* 0 to auto-size */
+  ulong so_sndbuf;  /* 0 to auto-size */
+  ulong pkt_rate;   /* expected datagrams per second, for auto-sizing */
+  long  drain_ns;   /* target socket drain latency, for auto-sizing */
+
+  fdgen_socket_poll_t poll;
 
   uint   bind_ip;   /* net order */
   ushort bind_port; /* host order */
@@ -289,10 +317,14 @@ rxtx_tile_main( int     argc,
     FD_LOG_WARNING(( "socket(AF_INET,SOCK_DGRAM,0) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
     return 1;
   }
-  if( FD_UNLIKELY( 0!=setsockopt( listen_fd, SOL_SOCKET, SO_RCVBUF, &args->so_rcvbuf, sizeof(ulong) ) ) ) {
-    FD_LOG_WARNING(( "setsockopt(SO_RCVBUF) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
-    return 1;
-  }
+  fdgen_socket_buf_t rx_buf = {
+    .rcvbuf_sz = args->so_rcvbuf ? args->so_rcvbuf : fdgen_socket_buf_sz( args->rx_burst, args->mtu, args->pkt_rate, args->drain_ns )
+  };
+  if( FD_UNLIKELY( fdgen_socket_buf_apply( listen_fd, &rx_buf, 1 ) ) ) return 1;
+  if( FD_UNLIKELY( fdgen_socket_busy_poll( listen_fd, &args->poll ) ) ) return 1;
+  if( FD_UNLIKELY( fdgen_socket_recv_addrs( listen_fd ) ) ) return 1;
+  if( FD_UNLIKELY( fdgen_socket_rxq_ovfl  ( listen_fd ) ) ) return 1;
+  if( FD_UNLIKELY( fdgen_socket_timestamping( listen_fd ) ) ) return 1;
   struct sockaddr_in listen_addr = {
     .sin_family = AF_INET,
     .sin_addr   = { .s_addr = args->bind_ip },
@@ -302,9 +334,9 @@ rxtx_tile_main( int     argc,
     FD_LOG_WARNING(( "bind(" FD_IP4_ADDR_FMT ":%u) failed (%i-%s)", FD_IP4_ADDR_FMT_ARGS( args->bind_ip ), 9090, errno, fd_io_strerror( errno ) ));
     return 1;
   }
-  fdgen_tile_net_dgram_epoll_data_t epoll_data = { .fd = listen_fd, .dport = args->bind_port };
+  fdgen_tile_net_dgram_epoll_data_t epoll_data = { .fd = listen_fd, .dport = args->bind_port, .sock_idx = 0 };
   struct epoll_event epoll_ev = {
-    .events = EPOLLIN,
+    .events = EPOLLIN | EPOLLET,
     .data   = { .u64 = epoll_data.u64 }
   };
   if( FD_UNLIKELY( 0!=epoll_ctl( epoll_fd, EPOLL_CTL_ADD, listen_fd, &epoll_ev ) ) ) {
@@ -317,13 +349,13 @@ rxtx_tile_main( int     argc,
     FD_LOG_WARNING(( "socket(AF_INET,SOCK_DGRAM,0) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
     return 1;
   }
-  if( FD_UNLIKELY( 0!=setsockopt( listen_fd, SOL_SOCKET, SO_SNDBUF, &args->so_sndbuf, sizeof(ulong) ) ) ) {
-    FD_LOG_WARNING(( "setsockopt(SO_SNDBUF) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
-    return 1;
-  }
+  fdgen_socket_buf_t tx_buf = {
+    .sndbuf_sz = args->so_sndbuf ? args->so_sndbuf : fdgen_socket_buf_sz( args->tx_burst, args->mtu, args->pkt_rate, args->drain_ns )
+  };
+  if( FD_UNLIKELY( fdgen_socket_buf_apply( send_fd, &tx_buf, 1 ) ) ) return 1;
 
   ulong   rx_depth   = fd_mcache_depth( args->rx_mcache );
-  ulong   scratch_sz = fdgen_tile_net_dgram_scratch_footprint( rx_depth, args->rx_burst, args->tx_burst, args->mtu );
+  ulong   scratch_sz = fdgen_tile_net_dgram_scratch_footprint( 0, rx_depth, args->rx_burst, args->tx_burst, args->mtu, 1UL );
   uchar * scratch    = fd_wksp_alloc_laddr( args->wksp, fdgen_tile_net_dgram_scratch_align(), scratch_sz, 1UL );
 
   double tick_per_ns = fd_tempo_tick_per_ns( NULL );
@@ -344,10 +376,13 @@ rxtx_tile_main( int     argc,
 
     .tx_burst         = args->tx_burst,
     .tx_burst_timeout = args->tx_burst_timeout,
+    .tx_retry_max     = args->tx_retry_max,
     .rx_burst         = args->rx_burst,
 
-    .epoll_fd = epoll_fd,
-    .send_fd  = send_fd,
+    .epoll_fd   = epoll_fd,
+    .socket_max = 1UL,
+    .send_fd    = send_fd,
+    .poll       = args->poll,
 
     .scratch    = scratch,
     .scratch_sz = scratch_sz,
@@ -361,6 +396,124 @@ rxtx_tile_main( int     argc,
   return res;
 }
 
+/* CPU steering *******************************************************
+
+   Two receive tiles share STEER_PORT_CNT ports, with the reuseport
+   groups steered by CPU (fdgen_ports_socket_steer_cpu).  On loopback,
+   the sender's CPU also processes the datagram in softirq context, so
+   everything sent from the CPU of tile t must land on the sockets of
+   receive tile t, as seen through its own epoll fd. */
+
+#define STEER_PORT_LO  (9200)
+#define STEER_PORT_CNT (4UL)
+#define STEER_PKT_CNT  (64UL)
+
+/* steer_send_main sends STEER_PKT_CNT datagrams to each bound port of
+   the ports object in argv[0] from the CPU of the calling tile. */
+
+static int
+steer_send_main( int     argc,
+                 char ** argv ) {
+
+  assert( argc==1 );
+  fdgen_ports_socket_t const * ports = fd_type_pun_const( argv[0] );
+  int const *                  fds   = fdgen_ports_socket_fds( ports );
+
+  int fd = socket( AF_INET, SOCK_DGRAM, 0 );
+  if( FD_UNLIKELY( fd<0 ) ) FD_LOG_ERR(( "socket(AF_INET,SOCK_DGRAM,0) failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+  for( ulong p=0UL; p<STEER_PORT_CNT; p++ ) {
+    if( fds[ p*ports->rx_cnt ]<0 ) continue;  /* skipped port */
+    struct sockaddr_in dst = {
+      .sin_family = AF_INET,
+      .sin_addr   = { .s_addr = FD_IP4_ADDR( 127, 0, 0, 1 ) },
+      .sin_port   = (ushort)fd_ushort_bswap( (ushort)( STEER_PORT_LO+p ) )
+    };
+    for( ulong j=0UL; j<STEER_PKT_CNT; j++ ) {
+      if( FD_UNLIKELY( sendto( fd, &j, sizeof(ulong), 0, fd_type_pun_const( &dst ), sizeof(struct sockaddr_in) )<0 ) )
+        FD_LOG_ERR(( "sendto failed (%i-%s)", errno, fd_io_strerror( errno ) ));
+    }
+  }
+  close( fd );
+  return 0;
+}
+
+/* steer_drain drains every socket that epoll_fd reports readable.
+   Checks that the event user data matches the socket.  Returns the
+   number of datagrams received. */
+
+static ulong
+steer_drain( int epoll_fd ) {
+  struct epoll_event ev[ STEER_PORT_CNT ];
+  int ev_cnt = epoll_wait( epoll_fd, ev, (int)STEER_PORT_CNT, 100 );
+  FD_TEST( ev_cnt>=0 );
+
+  ulong rx_cnt = 0UL;
+  for( int k=0; k<ev_cnt; k++ ) {
+    fdgen_tile_net_dgram_epoll_data_t data = { .u64 = ev[ k ].data.u64 };
+    FD_TEST( data.sock_idx<STEER_PORT_CNT );
+    FD_TEST( data.dport==STEER_PORT_LO+data.sock_idx );
+
+    struct sockaddr_in local;
+    socklen_t          local_sz = sizeof(struct sockaddr_in);
+    FD_TEST( 0==getsockname( data.fd, fd_type_pun( &local ), &local_sz ) );
+    FD_TEST( fd_ushort_bswap( local.sin_port )==data.dport );
+
+    ulong buf;
+    while( recv( data.fd, &buf, sizeof(ulong), MSG_DONTWAIT )==(long)sizeof(ulong) ) rx_cnt++;
+    FD_TEST( errno==EAGAIN || errno==EWOULDBLOCK );
+  }
+  return rx_cnt;
+}
+
+static void
+test_steer_cpu( fd_wksp_t * wksp ) {
+
+  ulong tile_cpu[ 2 ] = { fd_tile_cpu_id( 1UL ), fd_tile_cpu_id( 2UL ) };
+  if( FD_UNLIKELY( tile_cpu[ 0 ]>=fd_shmem_cpu_cnt() || tile_cpu[ 1 ]>=fd_shmem_cpu_cnt() ||
+                   tile_cpu[ 0 ]==tile_cpu[ 1 ] ) ) {
+    FD_LOG_WARNING(( "skip: CPU steering test requires tiles 1 and 2 pinned to distinct CPUs" ));
+    return;
+  }
+
+  void * ports_mem = fd_wksp_alloc_laddr( wksp, fdgen_ports_socket_align(), fdgen_ports_socket_footprint( 2UL, STEER_PORT_CNT ), 1UL );
+  fdgen_ports_socket_t * ports = fdgen_ports_socket_join( fdgen_ports_socket_new( ports_mem, 2UL, STEER_PORT_CNT ) );
+  FD_TEST( ports );
+
+  fdgen_port_range_t  port_range = { .lo = STEER_PORT_LO, .hi = (ushort)( STEER_PORT_LO+STEER_PORT_CNT ) };
+  fdgen_socket_buf_t  buf        = { .rcvbuf_sz = fdgen_socket_buf_sz( STEER_PKT_CNT, 64UL, 0UL, 0L ) };
+  fdgen_socket_bulk_t bulk       = { .thread_cnt = 1UL, .err_mode = FDGEN_PORTS_SOCKET_ERR_SKIP };
+  FD_TEST( fdgen_ports_socket_init( ports, FD_IP4_ADDR( 127, 0, 0, 1 ), port_range, 2UL, NULL, &buf, &bulk ) );
+  FD_TEST( !fdgen_ports_socket_steer_cpu( ports, tile_cpu ) );
+  ulong port_cnt = STEER_PORT_CNT - ports->skip_cnt;
+
+  int epoll_fd[ 2 ];
+  for( ulong t=0UL; t<2UL; t++ ) {
+    epoll_fd[ t ] = epoll_create1( 0 );
+    FD_TEST( epoll_fd[ t ]>=0 );
+    FD_TEST( !fdgen_ports_socket_epoll_join_tile( ports, t, epoll_fd[ t ] ) );
+  }
+
+  for( ulong t=0UL; t<2UL; t++ ) {
+    char * send_argv[1] = { fd_type_pun( ports ) };
+    fd_tile_exec_t * send_exec = fd_tile_exec_new( 1UL+t, steer_send_main, 1, send_argv );
+    FD_TEST( send_exec );
+    FD_TEST( !fd_tile_exec_delete( send_exec, NULL ) );
+
+    ulong rx_cnt[ 2 ] = { steer_drain( epoll_fd[ 0 ] ), steer_drain( epoll_fd[ 1 ] ) };
+    FD_LOG_NOTICE(( "steer: sent %lu from cpu %lu, received %lu on tile 0 (cpu %lu), %lu on tile 1 (cpu %lu)",
+                    port_cnt*STEER_PKT_CNT, tile_cpu[ t ], rx_cnt[ 0 ], tile_cpu[ 0 ], rx_cnt[ 1 ], tile_cpu[ 1 ] ));
+    FD_TEST( rx_cnt[ t     ]==port_cnt*STEER_PKT_CNT );
+    FD_TEST( rx_cnt[ t^1UL ]==0UL );
+  }
+
+  for( ulong t=0UL; t<2UL; t++ ) {
+    FD_TEST( !fdgen_ports_socket_epoll_leave_tile( ports, t, epoll_fd[ t ] ) );
+    close( epoll_fd[ t ] );
+  }
+  fdgen_ports_socket_fini( ports );
+  fd_wksp_free_laddr( fdgen_ports_socket_delete( fdgen_ports_socket_leave( ports ) ) );
+}
+
 int
 main( int     argc,
       char ** argv ) {
@@ -376,10 +529,25 @@ main( int     argc,
   ulong        tx_depth  = fd_env_strip_cmdline_ulong( &argc, &argv, "--tx-depth",     NULL, 1024UL                     );
   ulong        rx_burst  = fd_env_strip_cmdline_ulong( &argc, &argv, "--rx-burst",     NULL,  128UL                     );
   ulong        tx_burst  = fd_env_strip_cmdline_ulong( &argc, &argv, "--tx-burst",     NULL,  128UL                     );
-  ulong        so_rcvbuf = fd_env_strip_cmdline_ulong( &argc, &argv, "--so-rcvbuf",    NULL, 1UL<<17                    );
-  ulong        so_sndbuf = fd_env_strip_cmdline_ulong( &argc, &argv, "--so-sndbuf",    NULL, 1UL<<17                    );
+  long         tx_flush  = fd_env_strip_cmdline_long ( &argc, &argv, "--tx-flush-ns",  NULL, 10000L                     );
+  ulong        tx_retry  = fd_env_strip_cmdline_ulong( &argc, &argv, "--tx-retry-max", NULL,    8UL                     );
+  ulong        so_rcvbuf = fd_env_strip_cmdline_ulong( &argc, &argv, "--so-rcvbuf",    NULL,    0UL                     );
+  ulong        so_sndbuf = fd_env_strip_cmdline_ulong( &argc, &argv, "--so-sndbuf",    NULL,    0UL                     );
+  ulong        pkt_rate  = fd_env_strip_cmdline_ulong( &argc, &argv, "--pkt-rate",     NULL, 1000000UL                  );
+  long         drain_ns  = fd_env_strip_cmdline_long ( &argc, &argv, "--drain-ns",     NULL, 1000000L                   );
   ulong        mtu       = fd_env_strip_cmdline_ulong( &argc, &argv, "--mtu",          NULL, 1500UL                     );
   uint         seed      = fd_env_strip_cmdline_uint ( &argc, &argv, "--seed",         NULL,    0U                      );
+  char const * _poll     = fd_env_strip_cmdline_cstr ( &argc, &argv, "--poll-mode",    NULL, "none"                     );
+  uint         bp_usecs  = fd_env_strip_cmdline_uint ( &argc, &argv, "--busy-poll-usecs",  NULL,   50U                  );
+  uint         bp_budget = fd_env_strip_cmdline_uint ( &argc, &argv, "--busy-poll-budget", NULL,   64U                  );
+
+  int poll_mode = fdgen_cstr_to_socket_poll_mode( _poll );
+  if( FD_UNLIKELY( poll_mode<0 ) ) FD_LOG_ERR(( "invalid --poll-mode (%s)", _poll ));
+  FD_LOG_NOTICE(( "--poll-mode %s", _poll ));
+  if( poll_mode==FDGEN_SOCKET_POLL_MODE_BUSY ) {
+    FD_LOG_NOTICE(( "--busy-poll-usecs %u",  bp_usecs  ));
+    FD_LOG_NOTICE(( "--busy-poll-budget %u", bp_budget ));
+  }
 
   ulong page_sz = fd_cstr_to_shmem_page_sz( _page_sz );
   if( FD_UNLIKELY( !page_sz ) ) FD_LOG_ERR(( "unsupported --page-sz" ));
@@ -390,10 +558,13 @@ main( int     argc,
   fd_wksp_t * wksp = fd_wksp_new_anonymous( page_sz, page_cnt, fd_shmem_cpu_idx( numa_idx ), "wksp", 0UL );
   FD_TEST( wksp );
 
+  test_steer_cpu( wksp );
+
   /* Allocate objects */
 
-  void *     rxtx_cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 64UL ), 1UL );
-  fd_cnc_t * rxtx_cnc     = fd_cnc_join( fd_cnc_new( rxtx_cnc_mem, 64UL, 1UL, fd_tickcount() ) );
+  ulong      rxtx_cnc_app_sz = fd_ulong_align_up( sizeof(fdgen_tile_net_dgram_diag_t), 64UL );
+  void *     rxtx_cnc_mem    = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( rxtx_cnc_app_sz ), 1UL );
+  fd_cnc_t * rxtx_cnc        = fd_cnc_join( fd_cnc_new( rxtx_cnc_mem, rxtx_cnc_app_sz, 1UL, fd_tickcount() ) );
   FD_TEST( rxtx_cnc );
 
   void *     send_cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 64UL ), 1UL );
@@ -443,6 +614,9 @@ main( int     argc,
     .mcache = rx_mcache,
     .lazy   = 1e6, /* 1ms is sufficient for housekeeping */
     .seed   = seed,
+
+    .dst_ip   = send_args.dst_ip,
+    .dst_port = send_args.dst_port,
   };
   char * recv_tile_argv[1] = { fd_type_pun( &recv_args ) };
 
@@ -455,11 +629,16 @@ main( int     argc,
 
     .tx_mcache = tx_mcache,
     .tx_burst  = tx_burst,
+    .tx_burst_timeout = (long)( (double)tx_flush * fd_tempo_tick_per_ns( NULL ) ),
+    .tx_retry_max     = tx_retry,
     .rx_mcache = rx_mcache,
     .rx_dcache = rx_dcache,
     .rx_burst  = rx_burst,
     .so_rcvbuf = so_rcvbuf,
     .so_sndbuf = so_sndbuf,
+    .pkt_rate  = pkt_rate,
+    .drain_ns  = drain_ns,
+    .poll      = { .mode = poll_mode, .busy_poll_usecs = bp_usecs, .busy_poll_budget = bp_budget },
 
     .bind_ip   = send_args.dst_ip,
     .bind_port = send_args.dst_port
@@ -498,6 +677,27 @@ main( int     argc,
   fd_tile_exec_delete( rxtx_tile, NULL );
   fd_tile_exec_delete( send_tile, NULL );
 
+  fdgen_tile_net_dgram_diag_t const * rxtx_diag = fd_cnc_app_laddr_const( rxtx_cnc );
+  FD_LOG_NOTICE(( "rxtx: tx_sent_cnt %lu tx_drop_cnt %lu backp_cnt %lu overnp_cnt %lu rx_cnt %lu rx_kern_drop_cnt %lu rx_ts_cnt %lu rx_hwts_cnt %lu",
+                  rxtx_diag->tx_sent_cnt, rxtx_diag->tx_drop_cnt, rxtx_diag->backp_cnt,
+                  rxtx_diag->overnp_cnt,  rxtx_diag->rx_cnt,      rxtx_diag->rx_kern_drop_cnt,
+                  rxtx_diag->rx_ts_cnt,   rxtx_diag->rx_hwts_cnt ));
+
+  /* Every datagram carries a software RX timestamp, so tsorig predates
+     tspub by the kernel-to-publish latency */
+  FD_TEST( rxtx_diag->rx_cnt );
+  FD_TEST( rxtx_diag->rx_ts_cnt==rxtx_diag->rx_cnt );
+  FD_TEST( recv_args.frag_tot );
+  FD_TEST( recv_args.lat_tot>0L );
+  FD_TEST( recv_args.flow_sig );
+  FD_LOG_NOTICE(( "recv: %lu frags, mean stack latency %.0f ns", recv_args.frag_tot,
+                  (double)recv_args.lat_tot / ( (double)recv_args.frag_tot*fd_tempo_tick_per_ns( NULL ) ) ));
+  for( ulong j=0UL; j<FDGEN_TILE_NET_DGRAM_RX_HIST_CNT; j++ ) {
+    if( !rxtx_diag->rx_round_hist[ j ] ) continue;
+    FD_LOG_NOTICE(( "rxtx: rx rounds servicing [%lu,%lu) sockets: %lu",
+                    1UL<<j, 2UL<<j, rxtx_diag->rx_round_hist[ j ] ));
+  }
+
   fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( rxtx_cnc ) ) );
   fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( recv_cnc ) ) );
   fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( send_cnc ) ) );
@@ -0,0 +1,695 @@
+#define _GNU_SOURCE
+#include "fdgen_tile_net_dgram_tx.h"
+#include "fdgen_tile_net_dgram.h"
+#include "../../cfg/fdgen_cfg_net_socket.h"
+#include "../../cfg/fdgen_netlink.h"
+#include "../gen/fdgen_tile_gen_tmpl.h"
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+#include <firedancer/util/net/fd_eth.h>
+#include <firedancer/util/net/fd_ip4.h>
+#include <firedancer/util/net/fd_udp.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+
+/* test_tile_net_dgram_tx.c tests sharded transmit.  Multiple net_dgram_tx
+   tiles consume the same tx mcache, each sending from its own source
+   port to a sink socket on loopback.
+
+   Topology:
+
+               ┌────┐
+             ┌─►tx 0├─┐
+    ┌────┐   │ └────┘ │  ┌────┐
+    │send├───┤  ...   ├──► lo │
+    └────┘   │ ┌────┐ │  └────┘
+             └─►tx N├─┘
+               └────┘
+
+*/
+
+#define SHARD_MAX (16UL)
+
+/* TRICKLE_{...} configure the deadline flush check */
+
+#define TRICKLE_CNT      (32UL)
+#define TRICKLE_GAP_NS   ((long)5e6)
+#define TRICKLE_SLACK_NS ((long)1e6)
+
+/* PACE_{...} configure the pacing check.  PACE_CNT is kept well below
+   the default fq flow_limit (100 packets), since every datagram of a
+   shard is queued in fq at once. */
+
+#define PACE_CNT (64UL)
+#define PACE_TOL (0.1)
+
+/* Tile 1: send (tango) ***********************************************/
+
+struct test_send_args {
+  fd_wksp_t *      wksp;
+  fd_cnc_t *       cnc;
+  fd_frag_meta_t * mcache;
+  uchar *          dcache;
+
+  uint   seed;
+  long   lazy;
+  ulong  mtu;
+  uint   dst_ip;   /* net order */
+  ushort dst_port; /* host order */
+  ulong  pkt_cnt;  /* frags to publish before returning, 0 to run until halted */
+  long   gap_ns;   /* min time between publishes, 0 for back to back */
+};
+
+typedef struct test_send_args test_send_args_t;
+
+static int
+send_tile_main( int     argc,
+                char ** argv ) {
+
+  assert( argc==1 );
+  test_send_args_t * args = fd_type_pun( argv[0] );
+
+  void * base     = (void *)args->wksp;
+  ulong  orig     = fd_tile_idx();
+  uint   dst_ip   = args->dst_ip;
+  ushort dst_port = args->dst_port;
+
+  fd_cnc_t * cnc = args->cnc;
+
+  fd_frag_meta_t * mcache = args->mcache;
+  ulong            depth  = fd_mcache_depth( mcache );
+  ulong *          sync   = fd_mcache_seq_laddr( mcache );
+  ulong            seq    = fd_mcache_seq_query( sync );
+  ulong            seq_end = fd_seq_inc( seq, args->pkt_cnt );
+
+  uchar * dcache = args->dcache;
+  ulong   chunk0 = fd_dcache_compact_chunk0( base, dcache );
+  ulong   wmark  = fd_dcache_compact_wmark ( base, dcache, args->mtu );
+  ulong   chunk  = chunk0;
+
+  uint seed = (uint)( args->seed + fd_tile_idx() );
+  fd_rng_t _rng[1];
+  fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, seed, 0UL ) );
+
+  static uchar const mac0[6] = {0};
+  fdgen_tile_gen_tmpl_t tmpl[1];
+  fdgen_tile_gen_tmpl_init( tmpl, mac0, mac0, FD_IP4_ADDR( 127, 0, 0, 1 ), dst_ip, dst_port, 1 );
+
+  float tick_per_ns = (float)fd_tempo_tick_per_ns( NULL );
+  ulong async_min = fd_tempo_async_min( args->lazy, 1UL /*event_cnt*/, tick_per_ns );
+  if( FD_UNLIKELY( !async_min ) ) FD_LOG_ERR(( "bad lazy" ));
+  long gap = (long)( (float)args->gap_ns * tick_per_ns );
+
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+  long now  = fd_tickcount();
+  long then = now;
+  long next = now;
+  for(;;) {
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
+      fd_mcache_seq_update( sync, seq );
+      fd_cnc_heartbeat( cnc, now );
+      ulong s = fd_cnc_signal_query( cnc );
+      if( FD_UNLIKELY( s!=FD_CNC_SIGNAL_RUN ) ) {
+        if( FD_UNLIKELY( s!=FD_CNC_SIGNAL_HALT ) ) FD_LOG_ERR(( "Unexpected signal" ));
+        break;
+      }
+      then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
+    if( FD_UNLIKELY( args->pkt_cnt && seq==seq_end ) ) break;
+    if( FD_UNLIKELY( (now-next)<0L ) ) {
+      FD_SPIN_PAUSE();
+      now = fd_tickcount();
+      continue;
+    }
+
+    /* The payload is the seq number and the publish wallclock */
+    uchar * pkt = fd_chunk_to_laddr( base, chunk );
+    ulong   sz  = fdgen_tile_gen_tmpl_write( pkt, tmpl, 0x1234, (ushort)seq, 2UL*sizeof(ulong) );
+    FD_STORE( ulong, pkt+FDGEN_TILE_GEN_TMPL_SZ,               seq                );
+    FD_STORE( long,  pkt+FDGEN_TILE_GEN_TMPL_SZ+sizeof(ulong), fd_log_wallclock() );
+
+    ulong ctl    = fd_frag_meta_ctl( orig, 1, 1, 0 );
+    ulong sig    = seq;
+    ulong tsorig = 0UL;
+    ulong tspub  = 0UL;
+    fd_mcache_publish( mcache, depth, seq, sig, chunk, sz, ctl, tsorig, tspub );
+
+    chunk = fd_dcache_compact_next( chunk, sz, chunk0, wmark );
+    seq   = fd_seq_inc( seq, 1UL );
+    now   = fd_tickcount();
+    next  = now + gap;
+  }
+
+  fd_mcache_seq_update( sync, seq );
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return 0;
+}
+
+/* Tiles 2..: tx shards ***********************************************/
+
+struct test_tx_args {
+  fd_wksp_t *      wksp;
+  fd_cnc_t *       cnc;
+  fd_frag_meta_t * tx_mcache;
+  long             lazy;
+  ulong            mtu;
+  uint             seed;
+
+  ulong tx_burst;
+  long  tx_burst_timeout;
+  ulong tx_retry_max;
+
+  ulong shard_cnt;
+  ulong shard_idx;
+  int   shard_mode;
+  int   send_fd;
+
+  ulong conn_cnt;
+  ulong pace_pps;
+};
+
+typedef struct test_tx_args test_tx_args_t;
+
+static int
+tx_tile_main( int     argc,
+              char ** argv ) {
+
+  assert( argc==1 );
+  test_tx_args_t * args = fd_type_pun( argv[0] );
+
+  fd_rng_t  _rng[1];
+  fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, args->seed + (uint)args->shard_idx, 0UL ) );
+
+  ulong   scratch_sz = fdgen_tile_net_dgram_scratch_footprint( 1, 0UL, 0UL, args->tx_burst, args->mtu, 0UL );
+  uchar * scratch    = fd_wksp_alloc_laddr( args->wksp, fdgen_tile_net_dgram_scratch_align(), scratch_sz, 1UL );
+  FD_TEST( scratch );
+
+  fdgen_tile_net_dgram_tx_cfg_t cfg[1] = {{
+    .orig        = args->shard_idx,
+    .lazy        = args->lazy,
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+    .mtu         = args->mtu,
+
+    .rng       = rng,
+    .cnc       = args->cnc,
+    .tx_base   = (void *)args->wksp,
+    .tx_mcache = args->tx_mcache,
+
+    .tx_burst         = args->tx_burst,
+    .tx_burst_timeout = args->tx_burst_timeout,
+    .tx_retry_max     = args->tx_retry_max,
+
+    .shard_cnt  = args->shard_cnt,
+    .shard_idx  = args->shard_idx,
+    .shard_mode = args->shard_mode,
+
+    .conn_cnt = args->conn_cnt,
+    .pace_pps = args->pace_pps,
+
+    .send_fd = args->send_fd,
+
+    .scratch    = scratch,
+    .scratch_sz = scratch_sz,
+  }};
+
+  int res = fdgen_tile_net_dgram_tx_run( cfg );
+
+  fd_wksp_free_laddr( scratch );
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return res;
+}
+
+/* Port errors *********************************************************
+
+   test_port_err holds one port of a range with a socket that does not
+   set SO_REUSEPORT, then checks how each FDGEN_PORTS_SOCKET_ERR_{...}
+   mode handles it and what it reports in port_err. */
+
+#define ERR_PORT_LO   (9300)
+#define ERR_PORT_CNT  (4UL)
+#define ERR_PORT_BUSY (2UL)
+
+static void
+test_port_err( fd_wksp_t * wksp ) {
+
+  uint ip4 = FD_IP4_ADDR( 127, 0, 0, 1 );
+
+  int busy_fd = socket( AF_INET, SOCK_DGRAM, 0 );
+  FD_TEST( busy_fd>=0 );
+  struct sockaddr_in busy_addr = {
+    .sin_family = AF_INET,
+    .sin_addr   = { .s_addr = ip4 },
+    .sin_port   = (ushort)fd_ushort_bswap( (ushort)( ERR_PORT_LO+ERR_PORT_BUSY ) )
+  };
+  if( FD_UNLIKELY( 0!=bind( busy_fd, fd_type_pun( &busy_addr ), sizeof(struct sockaddr_in) ) ) ) {
+    FD_LOG_WARNING(( "skip: port %lu unavailable (%i-%s)", ERR_PORT_LO+ERR_PORT_BUSY, errno, fd_io_strerror( errno ) ));
+    close( busy_fd );
+    return;
+  }
+
+  void * ports_mem = fd_wksp_alloc_laddr( wksp, fdgen_ports_socket_align(), fdgen_ports_socket_footprint( 2UL, ERR_PORT_CNT ), 1UL );
+  fdgen_ports_socket_t * ports = fdgen_ports_socket_join( fdgen_ports_socket_new( ports_mem, 2UL, ERR_PORT_CNT ) );
+  FD_TEST( ports );
+  fdgen_port_range_t port_range = { .lo = ERR_PORT_LO, .hi = (ushort)( ERR_PORT_LO+ERR_PORT_CNT ) };
+  int                port_err[ ERR_PORT_CNT ];
+
+  /* ABORT fails on the busy port.  With a single thread, the ports
+     after it are never attempted. */
+
+  fdgen_socket_bulk_t bulk = { .thread_cnt = 1UL, .err_mode = FDGEN_PORTS_SOCKET_ERR_ABORT, .port_err = port_err };
+  for( ulong j=0UL; j<ERR_PORT_CNT; j++ ) port_err[ j ] = -1;
+  FD_TEST( !fdgen_ports_socket_init( ports, ip4, port_range, 2UL, NULL, NULL, &bulk ) );
+  for( ulong j=0UL; j<ERR_PORT_CNT; j++ ) {
+    int expected = j<ERR_PORT_BUSY ? 0 : j==ERR_PORT_BUSY ? EADDRINUSE : ECANCELED;
+    FD_TEST( port_err[ j ]==expected );
+  }
+  FD_TEST( !ports->sock_cnt );
+
+  /* SKIP and PARTIAL skip the busy port and bind all others */
+
+  int const mode[ 2 ] = { FDGEN_PORTS_SOCKET_ERR_SKIP, FDGEN_PORTS_SOCKET_ERR_PARTIAL };
+  for( ulong m=0UL; m<2UL; m++ ) {
+    for( ulong thread_cnt=1UL; thread_cnt<=ERR_PORT_CNT; thread_cnt*=2UL ) {
+      bulk = (fdgen_socket_bulk_t){ .thread_cnt = thread_cnt, .err_mode = mode[ m ], .port_err = port_err };
+      for( ulong j=0UL; j<ERR_PORT_CNT; j++ ) port_err[ j ] = -1;
+      FD_TEST( fdgen_ports_socket_init( ports, ip4, port_range, 2UL, NULL, NULL, &bulk ) );
+      FD_TEST( ports->skip_cnt==1UL );
+      int const * fds = fdgen_ports_socket_fds( ports );
+      for( ulong j=0UL; j<ERR_PORT_CNT; j++ ) {
+        FD_TEST( port_err[ j ]==( j==ERR_PORT_BUSY ? EADDRINUSE : 0 ) );
+        for( ulong t=0UL; t<2UL; t++ ) FD_TEST( ( fds[ j*2UL+t ]<0 )==( j==ERR_PORT_BUSY ) );
+      }
+      FD_TEST( fdgen_ports_socket_shard_fd( ports, ERR_PORT_BUSY )==fds[ (ERR_PORT_BUSY+1UL)*2UL ] );
+      fdgen_ports_socket_fini( ports );
+    }
+  }
+
+  /* A range of busy ports only fails in every mode */
+
+  fdgen_port_range_t busy_range = { .lo = (ushort)( ERR_PORT_LO+ERR_PORT_BUSY ), .hi = (ushort)( ERR_PORT_LO+ERR_PORT_BUSY+1UL ) };
+  for( ulong m=0UL; m<2UL; m++ ) {
+    bulk = (fdgen_socket_bulk_t){ .thread_cnt = 1UL, .err_mode = mode[ m ], .port_err = port_err };
+    port_err[ 0 ] = -1;
+    FD_TEST( !fdgen_ports_socket_init( ports, ip4, busy_range, 2UL, NULL, NULL, &bulk ) );
+    FD_TEST( port_err[ 0 ]==EADDRINUSE );
+  }
+
+  fd_wksp_free_laddr( fdgen_ports_socket_delete( fdgen_ports_socket_leave( ports ) ) );
+  close( busy_fd );
+  FD_LOG_NOTICE(( "port_err: pass" ));
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  fd_boot( &argc, &argv );
+
+  ulong cpu_idx = fd_tile_cpu_id( fd_tile_idx() );
+  if( cpu_idx>=fd_shmem_cpu_cnt() ) cpu_idx = 0UL;
+
+  char const * _page_sz   = fd_env_strip_cmdline_cstr ( &argc, &argv, "--page-sz",      NULL, "gigantic"                 );
+  ulong        page_cnt   = fd_env_strip_cmdline_ulong( &argc, &argv, "--page-cnt",     NULL, 1UL                        );
+  ulong        numa_idx   = fd_env_strip_cmdline_ulong( &argc, &argv, "--numa-idx",     NULL, fd_shmem_numa_idx(cpu_idx) );
+  ulong        tx_depth   = fd_env_strip_cmdline_ulong( &argc, &argv, "--tx-depth",     NULL, 1024UL                     );
+  ulong        tx_burst   = fd_env_strip_cmdline_ulong( &argc, &argv, "--tx-burst",     NULL,  128UL                     );
+  long         tx_flush   = fd_env_strip_cmdline_long ( &argc, &argv, "--tx-flush-ns",  NULL, 10000L                     );
+  ulong        tx_retry   = fd_env_strip_cmdline_ulong( &argc, &argv, "--tx-retry-max", NULL,    8UL                     );
+  ulong        shard_cnt  = fd_env_strip_cmdline_ulong( &argc, &argv, "--shard-cnt",    NULL,    2UL                     );
+  char const * _shard_by  = fd_env_strip_cmdline_cstr ( &argc, &argv, "--shard-by",     NULL, "seq"                      );
+  ulong        mtu        = fd_env_strip_cmdline_ulong( &argc, &argv, "--mtu",          NULL, 1500UL                     );
+  uint         seed       = fd_env_strip_cmdline_uint ( &argc, &argv, "--seed",         NULL,    0U                      );
+  ulong        conn_cnt   = fd_env_strip_cmdline_ulong( &argc, &argv, "--conn-cnt",     NULL,    4UL                     );
+  ulong        pace_pps   = fd_env_strip_cmdline_ulong( &argc, &argv, "--pace-pps",     NULL,    0UL                     );
+  char const * fq_ifname  = fd_env_strip_cmdline_cstr ( &argc, &argv, "--fq-ifname",    NULL, NULL                       );
+  ulong        pkt_cnt    = fd_env_strip_cmdline_ulong( &argc, &argv, "--pkt-cnt",      NULL,  256UL                     );
+
+  ulong page_sz = fd_cstr_to_shmem_page_sz( _page_sz );
+  if( FD_UNLIKELY( !page_sz ) ) FD_LOG_ERR(( "unsupported --page-sz" ));
+
+  int shard_mode;
+  if(      0==strcmp( _shard_by, "seq" ) ) shard_mode = FDGEN_TILE_NET_DGRAM_SHARD_SEQ;
+  else if( 0==strcmp( _shard_by, "sig" ) ) shard_mode = FDGEN_TILE_NET_DGRAM_SHARD_SIG;
+  else FD_LOG_ERR(( "invalid --shard-by (%s)", _shard_by ));
+
+  if( FD_UNLIKELY( !shard_cnt || shard_cnt>SHARD_MAX ) ) FD_LOG_ERR(( "--shard-cnt must be in [1,%lu]", SHARD_MAX ));
+  if( FD_UNLIKELY( fd_tile_cnt()<2UL+shard_cnt ) ) FD_LOG_ERR(( "This test requires at least %lu tiles", 2UL+shard_cnt ));
+  if( FD_UNLIKELY( !pkt_cnt || pkt_cnt>tx_depth ) ) FD_LOG_ERR(( "--pkt-cnt must be in [1,--tx-depth]" ));
+
+  if( fq_ifname ) {
+    uint if_idx = if_nametoindex( fq_ifname );
+    if( FD_UNLIKELY( !if_idx ) ) FD_LOG_ERR(( "unknown --fq-ifname (%s)", fq_ifname ));
+    int netlink = fdgen_netlink_connect( NETLINK_ROUTE );
+    FD_TEST( netlink>=0 );
+    FD_TEST( 0==fdgen_netlink_qdisc_fq( netlink, if_idx ) );
+    close( netlink );
+    FD_LOG_NOTICE(( "Installed fq qdisc on %s", fq_ifname ));
+  }
+  if( pace_pps ) FD_LOG_NOTICE(( "Pacing each shard to --pace-pps %lu", pace_pps ));
+
+  FD_LOG_NOTICE(( "Creating workspace with --page-cnt %lu --page-sz %s pages on --numa-idx %lu", page_cnt, _page_sz, numa_idx ));
+  fd_wksp_t * wksp = fd_wksp_new_anonymous( page_sz, page_cnt, fd_shmem_cpu_idx( numa_idx ), "wksp", 0UL );
+  FD_TEST( wksp );
+
+  test_port_err( wksp );
+
+  /* Create sink socket */
+
+  uint   sink_ip   = FD_IP4_ADDR( 127, 0, 0, 1 );
+  ushort sink_port = 9090;
+
+  int sink_fd = socket( AF_INET, SOCK_DGRAM, 0 );
+  FD_TEST( sink_fd>=0 );
+  struct sockaddr_in sink_addr = {
+    .sin_family = AF_INET,
+    .sin_addr   = { .s_addr = sink_ip },
+    .sin_port   = (ushort)fd_ushort_bswap( sink_port )
+  };
+  FD_TEST( 0==bind( sink_fd, fd_type_pun( &sink_addr ), sizeof(struct sockaddr_in) ) );
+  fdgen_socket_buf_t sink_buf = { .rcvbuf_sz = fdgen_socket_buf_sz( pkt_cnt, 2UL*sizeof(ulong), 0UL, 0L ) };
+  FD_TEST( 0==fdgen_socket_buf_apply( sink_fd, &sink_buf, 1 ) );
+  struct timeval sink_timeout = { .tv_sec = 1 };
+  FD_TEST( 0==setsockopt( sink_fd, SOL_SOCKET, SO_RCVTIMEO, &sink_timeout, sizeof(struct timeval) ) );
+
+  /* Create one source port per shard */
+
+  fdgen_port_range_t src_ports = { .lo = 9100, .hi = (ushort)( 9100UL+shard_cnt ) };
+  void * ports_mem = fd_wksp_alloc_laddr( wksp, fdgen_ports_socket_align(), fdgen_ports_socket_footprint( 1UL, shard_cnt ), 1UL );
+  fdgen_ports_socket_t * ports = fdgen_ports_socket_join( fdgen_ports_socket_new( ports_mem, 1UL, shard_cnt ) );
+  FD_TEST( ports );
+  fdgen_socket_buf_t src_buf = { .sndbuf_sz = fdgen_socket_buf_sz( tx_burst, mtu, 0UL, 0L ) };
+  int                 src_err[ SHARD_MAX ];
+  fdgen_socket_bulk_t src_bulk = { .thread_cnt = shard_cnt, .err_mode = FDGEN_PORTS_SOCKET_ERR_SKIP, .port_err = src_err };
+  FD_TEST( fdgen_ports_socket_init( ports, sink_ip, src_ports, 1UL, NULL, &src_buf, &src_bulk ) );
+  if( ports->skip_cnt ) FD_LOG_NOTICE(( "%lu source ports busy, shards share the others", ports->skip_cnt ));
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    if( src_err[ j ] ) FD_LOG_NOTICE(( "source port %lu skipped (%i-%s)", src_ports.lo+j, src_err[ j ], fd_io_strerror( src_err[ j ] ) ));
+  }
+
+  /* Allocate objects */
+
+  void *     send_cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 64UL ), 1UL );
+  fd_cnc_t * send_cnc     = fd_cnc_join( fd_cnc_new( send_cnc_mem, 64UL, 1UL, fd_tickcount() ) );
+  FD_TEST( send_cnc );
+
+  ulong      tx_cnc_app_sz = fd_ulong_align_up( sizeof(fdgen_tile_net_dgram_diag_t), 64UL );
+  fd_cnc_t * tx_cnc[ SHARD_MAX ];
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    void * tx_cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( tx_cnc_app_sz ), 1UL );
+    tx_cnc[j] = fd_cnc_join( fd_cnc_new( tx_cnc_mem, tx_cnc_app_sz, 1UL, fd_tickcount() ) );
+    FD_TEST( tx_cnc[j] );
+  }
+
+  void *           tx_mcache_mem = fd_wksp_alloc_laddr( wksp, fd_mcache_align(), fd_mcache_footprint( tx_depth, 0UL ), 1UL );
+  fd_frag_meta_t * tx_mcache     = fd_mcache_join( fd_mcache_new( tx_mcache_mem, tx_depth, 0UL, /* seq0 */ 0UL ) );
+  FD_TEST( tx_mcache );
+
+  ulong   tx_dcache_data_sz = fd_dcache_req_data_sz( mtu, tx_depth, 1UL, 1 );
+  void *  tx_dcache_mem     = fd_wksp_alloc_laddr( wksp, fd_dcache_align(), fd_dcache_footprint( tx_dcache_data_sz, 0UL ), 1UL );
+  uchar * tx_dcache         = fd_dcache_join( fd_dcache_new( tx_dcache_mem, tx_dcache_data_sz, 0UL ) );
+  FD_TEST( tx_dcache );
+
+  /* Spawn tiles */
+
+  test_send_args_t send_args = {
+    .wksp     = wksp,
+    .cnc      = send_cnc,
+    .mcache   = tx_mcache,
+    .dcache   = tx_dcache,
+    .seed     = seed,
+    .lazy     = 1e6, /* 1ms is sufficient for housekeeping */
+    .mtu      = mtu,
+    .dst_ip   = sink_ip,
+    .dst_port = sink_port,
+  };
+  char * send_tile_argv[1] = { fd_type_pun( &send_args ) };
+
+  test_tx_args_t   tx_args       [ SHARD_MAX ];
+  char *           tx_tile_argv  [ SHARD_MAX ][1];
+  fd_tile_exec_t * tx_tile       [ SHARD_MAX ];
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    tx_args[j] = (test_tx_args_t) {
+      .wksp      = wksp,
+      .cnc       = tx_cnc[j],
+      .tx_mcache = tx_mcache,
+      .lazy      = (long)1e5,  /* 100us, bounds POLLOUT waits and diag latency */
+      .mtu       = mtu,
+      .seed      = seed,
+
+      .tx_burst         = tx_burst,
+      .tx_burst_timeout = (long)( (double)tx_flush * fd_tempo_tick_per_ns( NULL ) ),
+      .tx_retry_max     = tx_retry,
+
+      .shard_cnt  = shard_cnt,
+      .shard_idx  = j,
+      .shard_mode = shard_mode,
+      .send_fd    = fdgen_ports_socket_shard_fd( ports, j ),
+      .conn_cnt   = conn_cnt,
+      .pace_pps   = pace_pps,
+    };
+    tx_tile_argv[j][0] = fd_type_pun( &tx_args[j] );
+  }
+
+  /* Shards boot first, so they start at the first published seq */
+
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    tx_tile[j] = fd_tile_exec_new( 2UL+j, tx_tile_main, 1, tx_tile_argv[j] );
+  }
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    FD_TEST( fd_cnc_wait( tx_cnc[j], FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+  }
+
+  fdgen_tile_net_dgram_diag_t const * tx_diag[ SHARD_MAX ];
+  ulong                               tx_last[ SHARD_MAX ] = {0};
+  for( ulong j=0UL; j<shard_cnt; j++ ) tx_diag[j] = fd_cnc_app_laddr_const( tx_cnc[j] );
+
+  /* Check that shards are disjoint and together cover every frag.
+     Publish pkt_cnt frags (no more than tx_depth, so no shard can be
+     overrun), receive each one exactly once at the sink, and check that
+     every shard sent exactly the frags its seq or sig maps to. */
+
+  do {
+    ulong shard_exp[ SHARD_MAX ] = {0};
+    for( ulong seq=0UL; seq<pkt_cnt; seq++ ) {
+      ulong key = shard_mode==FDGEN_TILE_NET_DGRAM_SHARD_SIG ? fd_ulong_hash( seq ) : seq;  /* sig is seq */
+      shard_exp[ key % shard_cnt ]++;
+    }
+
+    send_args.pkt_cnt = pkt_cnt;
+    fd_tile_exec_t * send_tile = fd_tile_exec_new( 1UL, send_tile_main, 1, send_tile_argv );
+    FD_TEST( send_tile );
+
+    uchar * seen = fd_wksp_alloc_laddr( wksp, 1UL, pkt_cnt, 1UL );
+    FD_TEST( seen );
+    fd_memset( seen, 0, pkt_cnt );
+    ulong rcv_cnt = 0UL;
+    while( rcv_cnt<pkt_cnt ) {
+      ulong msg[ 2 ];
+      long  rcv_sz = recv( sink_fd, msg, sizeof(msg), 0 );
+      if( FD_UNLIKELY( rcv_sz<0L ) ) {
+        FD_LOG_WARNING(( "recv failed after %lu of %lu datagrams (%i-%s)", rcv_cnt, pkt_cnt, errno, fd_io_strerror( errno ) ));
+        break;
+      }
+      FD_TEST( rcv_sz==(long)sizeof(msg) );
+      ulong seq = msg[ 0 ];
+      FD_TEST( seq<pkt_cnt );
+      FD_TEST( !seen[ seq ] );  /* sent by a single shard */
+      seen[ seq ] = 1;
+      rcv_cnt++;
+    }
+    FD_TEST( rcv_cnt==pkt_cnt );
+    fd_wksp_free_laddr( seen );
+
+    FD_TEST( !fd_tile_exec_delete( send_tile, NULL ) );
+
+    /* Diag counters are published at housekeeping */
+    long deadline = fd_log_wallclock() + (long)5e9;
+    for(;;) {
+      ulong acct_cnt = 0UL;
+      for( ulong j=0UL; j<shard_cnt; j++ ) acct_cnt += tx_diag[j]->tx_sent_cnt + tx_diag[j]->tx_drop_cnt;
+      if( acct_cnt==pkt_cnt ) break;
+      FD_TEST( fd_log_wallclock()<deadline );
+      fd_log_sleep( (long)1e6 );
+    }
+    for( ulong j=0UL; j<shard_cnt; j++ ) {
+      FD_LOG_NOTICE(( "tx shard %lu: sent %lu of %lu frags (expected %lu)", j, tx_diag[j]->tx_sent_cnt, pkt_cnt, shard_exp[j] ));
+      FD_TEST( tx_diag[j]->tx_sent_cnt==shard_exp[j] );
+      FD_TEST( !tx_diag[j]->tx_drop_cnt );
+      FD_TEST( !tx_diag[j]->overnp_cnt  );
+      tx_last[j] = tx_diag[j]->tx_sent_cnt;
+    }
+  } while(0);
+
+  /* Check that a trickle flushes on the deadline.  Frags are published
+     TRICKLE_GAP_NS apart, far too slow to fill a batch of tx_burst, so
+     each one waits in a partial batch until tx_burst_timeout expires.
+     Every frag must reach the sink within the timeout plus
+     TRICKLE_SLACK_NS of scheduling noise, well before the next one is
+     published. */
+
+  do {
+    long  flush_ns    = tx_flush>0L ? tx_flush : tx_args[0].lazy;
+    long  max_lat_ns  = flush_ns + TRICKLE_SLACK_NS;
+    ulong trickle_seq = pkt_cnt;
+    if( FD_UNLIKELY( tx_burst<2UL || max_lat_ns>=TRICKLE_GAP_NS ) ) {
+      FD_LOG_WARNING(( "skip trickle: needs --tx-burst >1 and --tx-flush-ns below %li", TRICKLE_GAP_NS-TRICKLE_SLACK_NS ));
+      break;
+    }
+
+    send_args.pkt_cnt = TRICKLE_CNT;
+    send_args.gap_ns  = TRICKLE_GAP_NS;
+    fd_tile_exec_t * send_tile = fd_tile_exec_new( 1UL, send_tile_main, 1, send_tile_argv );
+    FD_TEST( send_tile );
+
+    long lat_max = 0L;
+    for( ulong j=0UL; j<TRICKLE_CNT; j++ ) {
+      ulong msg[ 2 ];
+      long  rcv_sz = recv( sink_fd, msg, sizeof(msg), 0 );
+      long  rcv_ts = fd_log_wallclock();
+      if( FD_UNLIKELY( rcv_sz<0L ) ) FD_LOG_ERR(( "trickle frag %lu not sent (%i-%s)", j, errno, fd_io_strerror( errno ) ));
+      FD_TEST( rcv_sz==(long)sizeof(msg) );
+      FD_TEST( msg[ 0 ]==trickle_seq+j );
+      long lat = rcv_ts - (long)msg[ 1 ];
+      if( FD_UNLIKELY( lat>max_lat_ns ) ) FD_LOG_ERR(( "trickle frag %lu sent after %li ns (deadline %li ns)", j, lat, max_lat_ns ));
+      lat_max = fd_long_max( lat_max, lat );
+    }
+    FD_TEST( !fd_tile_exec_delete( send_tile, NULL ) );
+    FD_LOG_NOTICE(( "trickle: %lu frags %li ns apart, max latency %li ns (deadline %li ns)",
+                    TRICKLE_CNT, TRICKLE_GAP_NS, lat_max, max_lat_ns ));
+
+    long deadline = fd_log_wallclock() + (long)5e9;
+    for(;;) {
+      ulong acct_cnt = 0UL;
+      for( ulong j=0UL; j<shard_cnt; j++ ) acct_cnt += tx_diag[j]->tx_sent_cnt + tx_diag[j]->tx_drop_cnt;
+      if( acct_cnt==pkt_cnt+TRICKLE_CNT ) break;
+      FD_TEST( fd_log_wallclock()<deadline );
+      fd_log_sleep( (long)1e6 );
+    }
+    for( ulong j=0UL; j<shard_cnt; j++ ) {
+      FD_TEST( !tx_diag[j]->tx_drop_cnt );
+      tx_last[j] = tx_diag[j]->tx_sent_cnt;
+    }
+  } while(0);
+
+  /* Check that pacing holds each shard to pace_pps.  Frags are
+     published back to back, so each shard schedules its share at once
+     and fq releases them 1/pace_pps apart.  The mean inter-arrival time
+     of each shard's datagrams at the sink must match within PACE_TOL.
+     The first datagram of a shard may leave early and anchors the
+     measurement. */
+
+  do {
+    if( FD_UNLIKELY( !pace_pps || !fq_ifname ) ) {
+      FD_LOG_WARNING(( "skip pacing: needs --pace-pps and --fq-ifname (e.g. lo)" ));
+      break;
+    }
+
+    ulong pace_seq = fd_mcache_seq_query( fd_mcache_seq_laddr( tx_mcache ) );
+
+    send_args.pkt_cnt = PACE_CNT;
+    send_args.gap_ns  = 0L;
+    fd_tile_exec_t * send_tile = fd_tile_exec_new( 1UL, send_tile_main, 1, send_tile_argv );
+    FD_TEST( send_tile );
+
+    ulong rcv_cnt[ SHARD_MAX ] = {0};
+    long  rcv_ts0[ SHARD_MAX ] = {0};
+    long  rcv_ts1[ SHARD_MAX ] = {0};
+    for( ulong j=0UL; j<PACE_CNT; j++ ) {
+      ulong msg[ 2 ];
+      long  rcv_sz = recv( sink_fd, msg, sizeof(msg), 0 );
+      long  rcv_ts = fd_log_wallclock();
+      if( FD_UNLIKELY( rcv_sz<0L ) ) FD_LOG_ERR(( "paced frag %lu not sent (%i-%s)", j, errno, fd_io_strerror( errno ) ));
+      FD_TEST( rcv_sz==(long)sizeof(msg) );
+      ulong seq = msg[ 0 ];
+      FD_TEST( seq-pace_seq<PACE_CNT );
+      ulong key   = shard_mode==FDGEN_TILE_NET_DGRAM_SHARD_SIG ? fd_ulong_hash( seq ) : seq;  /* sig is seq */
+      ulong shard = key % shard_cnt;
+      if( !rcv_cnt[ shard ] ) rcv_ts0[ shard ] = rcv_ts;
+      rcv_ts1[ shard ] = rcv_ts;
+      rcv_cnt[ shard ]++;
+    }
+    FD_TEST( !fd_tile_exec_delete( send_tile, NULL ) );
+
+    double gap_ns = 1e9 / (double)pace_pps;
+    for( ulong j=0UL; j<shard_cnt; j++ ) {
+      if( rcv_cnt[j]<2UL ) continue;
+      double obs_ns = (double)( rcv_ts1[j]-rcv_ts0[j] ) / (double)( rcv_cnt[j]-1UL );
+      FD_LOG_NOTICE(( "pacing shard %lu: %lu frags, mean gap %.0f ns (expected %.0f ns)", j, rcv_cnt[j], obs_ns, gap_ns ));
+      if( FD_UNLIKELY( fabs( obs_ns-gap_ns )>PACE_TOL*gap_ns ) )
+        FD_LOG_ERR(( "pacing shard %lu: mean gap %.0f ns off by more than %.0f%% of %.0f ns", j, obs_ns, 100.0*PACE_TOL, gap_ns ));
+    }
+
+    long deadline = fd_log_wallclock() + (long)5e9;
+    for(;;) {
+      ulong acct_cnt = 0UL;
+      for( ulong j=0UL; j<shard_cnt; j++ ) acct_cnt += tx_diag[j]->tx_sent_cnt + tx_diag[j]->tx_drop_cnt;
+      if( acct_cnt==pace_seq+PACE_CNT ) break;
+      FD_TEST( fd_log_wallclock()<deadline );
+      fd_log_sleep( (long)1e6 );
+    }
+    for( ulong j=0UL; j<shard_cnt; j++ ) {
+      FD_TEST( !tx_diag[j]->tx_drop_cnt );
+      tx_last[j] = tx_diag[j]->tx_sent_cnt;
+    }
+  } while(0);
+
+  /* Report per-shard rates */
+
+  send_args.pkt_cnt = 0UL;
+  send_args.gap_ns  = 0L;
+  fd_tile_exec_t * send_tile = fd_tile_exec_new( 1UL, send_tile_main, 1, send_tile_argv );
+  FD_TEST( fd_cnc_wait( send_cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+  long dt = (long)1e9;
+  for( ulong iter=0UL; iter<10UL; iter++ ) {
+    fd_log_sleep( dt );
+    fdgen_tile_net_dgram_tx_shard_report( tx_diag, shard_cnt, tx_last, dt );
+  }
+
+  FD_LOG_INFO(( "Cleaning up" ));
+
+  FD_TEST( !fd_cnc_open( send_cnc ) );
+  fd_cnc_signal( send_cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( send_cnc );
+  FD_TEST( fd_cnc_wait( send_cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    FD_TEST( !fd_cnc_open( tx_cnc[j] ) );
+    fd_cnc_signal( tx_cnc[j], FD_CNC_SIGNAL_HALT );
+    fd_cnc_close( tx_cnc[j] );
+    FD_TEST( fd_cnc_wait( tx_cnc[j], FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  }
+
+  fd_tile_exec_delete( send_tile, NULL );
+  for( ulong j=0UL; j<shard_cnt; j++ ) {
+    fd_tile_exec_delete( tx_tile[j], NULL );
+    FD_TEST( tx_diag[j]->tx_sent_cnt );
+    ulong conn_hit  = tx_diag[j]->conn_hit_cnt;
+    ulong conn_miss = tx_diag[j]->conn_miss_cnt;
+    FD_LOG_NOTICE(( "tx shard %lu: conn cache %lu hits, %lu misses (%.1f%% hit)", j, conn_hit, conn_miss,
+                    100.0*(double)conn_hit / (double)fd_ulong_max( conn_hit+conn_miss, 1UL ) ));
+    if( conn_cnt ) FD_TEST( conn_hit );
+    fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( tx_cnc[j] ) ) );
+  }
+  fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( send_cnc ) ) );
+
+  fdgen_ports_socket_fini( ports );
+  fd_wksp_free_laddr( fdgen_ports_socket_delete( fdgen_ports_socket_leave( ports ) ) );
+  close( sink_fd );
+
+  fd_wksp_delete_anonymous( wksp );
+
+  FD_LOG_NOTICE(( "pass" ));
+  fd_halt();
+  return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <firedancer/util/fd_util_base.h>
+
+/* fdgen_tile_net_packet.h contains common AF_PACKET tile definitions */
+
+struct fdgen_tile_net_packet_rx_diag {
+  ulong in_backp;
+  ulong backp_cnt;
+  ulong pub_cnt;
+  ulong pub_sz;
+  ulong filt_cnt;       /* frames dropped for exceeding the MTU */
+  ulong blk_cnt;        /* blocks returned to the kernel */
+  ulong kern_drop_cnt;  /* frames dropped by the kernel for lack of ring space (PACKET_STATISTICS) */
+};
+
+typedef struct fdgen_tile_net_packet_rx_diag fdgen_tile_net_packet_rx_diag_t;
+
+struct fdgen_tile_net_packet_tx_diag {
+  ulong backp_cnt;   /* waits for a free TX ring slot */
+  ulong overnp_cnt;  /* frags overrun by the producer */
+  ulong filt_cnt;    /* frags dropped for not fitting a TX ring slot */
+  ulong tx_cnt;      /* frames handed to the kernel */
+  ulong tx_sz;       /* frame bytes handed to the kernel */
+  ulong kick_cnt;    /* sendto(2) calls */
+  ulong kick_err_cnt;  /* sendto(2) calls failing with an error other than EAGAIN/ENOBUFS */
+};
+
+typedef struct fdgen_tile_net_packet_tx_diag fdgen_tile_net_packet_tx_diag_t;
@@ -0,0 +1,244 @@
+#include "fdgen_tile_net_packet.h"
+#include "fdgen_tile_net_packet_rx.h"
+
+#include <errno.h>
+#include <linux/if_packet.h>
+#include <sys/socket.h>
+
+#include <firedancer/tango/fd_tango_base.h>
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+
+int
+fdgen_tile_net_packet_rx_run( fdgen_tile_net_packet_rx_cfg_t * cfg ) {
+
+  if( FD_UNLIKELY( !cfg ) ) { FD_LOG_WARNING(( "NULL cfg" )); return 1; }
+
+  /* load config */
+
+  fd_cnc_t *                  cnc         = cfg->cnc;
+  ulong                       orig        = cfg->orig;
+  fd_rng_t *                  rng         = cfg->rng;
+  fd_frag_meta_t *            mcache      = cfg->mcache;
+  uchar *                     dcache      = cfg->dcache;
+  uchar *                     base        = cfg->base;
+  long                        lazy        = cfg->lazy;
+  double                      tick_per_ns = cfg->tick_per_ns;
+  ulong                       mtu         = cfg->mtu;
+  fdgen_packet_ring_t const * ring        = cfg->ring;
+
+  /* cnc state */
+  fdgen_tile_net_packet_rx_diag_t * cnc_diag;
+  ulong   cnc_diag_in_backp;      /* is the run loop currently waiting for the kernel, in [0,1] */
+  ulong   cnc_diag_backp_cnt;     /* Accumulates number of transitions of tile to backpressured between housekeeping events */
+  ulong   cnc_diag_pub_cnt;       /* Accumulates number of frags published between housekeeping events */
+  ulong   cnc_diag_pub_sz;        /* Accumulates payload bytes publised between housekeeping events */
+  ulong   cnc_diag_filt_cnt;
+  ulong   cnc_diag_blk_cnt;
+
+  /* out frag stream state */
+  ulong   mcache_depth; /* ==fd_mcache_depth( mcache ), depth of the mcache / positive integer power of 2 */
+  ulong * sync;         /* ==fd_mcache_seq_laddr( mcache ), local addr where mcache sync info is published */
+  ulong   seq;          /* frag sequence number to publish */
+  ulong   chunk0;       /* first dcache chunk */
+  ulong   wmark;        /* wrap back to chunk0 past this chunk */
+  ulong   chunk;        /* next dcache chunk to write */
+
+  /* housekeeping state */
+  ulong async_min; /* minimum number of ticks between processing a housekeeping event, positive integer power of 2 */
+
+  /* block ring state */
+  uchar * blk_mem;
+  ulong   blk_sz;
+  ulong   blk_cnt;
+  ulong   blk_idx;      /* next block to consume */
+
+  /* RX timestamp conversion */
+  long    ts_wall0;     /* CLOCK_REALTIME ns at ts_tick0 */
+  long    ts_tick0;     /* tick counter at ts_wall0 */
+
+  do {
+
+    FD_LOG_INFO(( "Booting net_packet_rx" ));
+
+    /* cnc state init */
+
+    if( FD_UNLIKELY( !cnc ) ) { FD_LOG_WARNING(( "NULL cnc" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<sizeof(fdgen_tile_net_packet_rx_diag_t) ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_signal_query( cnc )!=FD_CNC_SIGNAL_BOOT ) ) { FD_LOG_WARNING(( "already booted" )); return 1; }
+
+    cnc_diag = fd_cnc_app_laddr( cnc );
+
+    cnc_diag_in_backp  = 1UL;
+    cnc_diag_backp_cnt = 0UL;
+    cnc_diag_pub_cnt   = 0UL;
+    cnc_diag_pub_sz    = 0UL;
+    cnc_diag_filt_cnt  = 0UL;
+    cnc_diag_blk_cnt   = 0UL;
+
+    /* out frag stream init */
+
+    if( FD_UNLIKELY( !mcache ) ) { FD_LOG_WARNING(( "NULL mcache" )); return 1; }
+    mcache_depth = fd_mcache_depth    ( mcache );
+    sync         = fd_mcache_seq_laddr( mcache );
+
+    seq = cfg->seq0;
+
+    if( FD_UNLIKELY( !dcache ) ) { FD_LOG_WARNING(( "NULL dcache" )); return 1; }
+    if( FD_UNLIKELY( !base   ) ) { FD_LOG_WARNING(( "NULL base"   )); return 1; }
+    if( FD_UNLIKELY( !mtu    ) ) { FD_LOG_WARNING(( "zero mtu"    )); return 1; }
+    if( FD_UNLIKELY( !fd_dcache_compact_is_safe( base, dcache, mtu, mcache_depth ) ) ) {
+      FD_LOG_WARNING(( "dcache too small for mcache depth %lu at mtu %lu", mcache_depth, mtu ));
+      return 1;
+    }
+    chunk0 = fd_dcache_compact_chunk0( base, dcache );
+    wmark  = fd_dcache_compact_wmark ( base, dcache, mtu );
+    chunk  = chunk0;
+
+    /* block ring init */
+
+    if( FD_UNLIKELY( !ring || !ring->rx_mem ) ) { FD_LOG_WARNING(( "NULL ring" )); return 1; }
+    blk_mem = ring->rx_mem;
+    blk_sz  = ring->block_sz;
+    blk_cnt = ring->block_cnt;
+    blk_idx = 0UL;
+    if( FD_UNLIKELY( !blk_sz || !blk_cnt ) ) { FD_LOG_WARNING(( "empty ring" )); return 1; }
+
+    /* Reset kernel drop statistics (reading clears them) */
+    struct tpacket_stats_v3 stats;
+    socklen_t               stats_sz = sizeof(struct tpacket_stats_v3);
+    getsockopt( ring->fd, SOL_PACKET, PACKET_STATISTICS, &stats, &stats_sz );
+
+    /* rx timestamp init */
+
+    ts_tick0 = fd_tickcount();
+    ts_wall0 = fd_log_wallclock();
+
+    /* housekeeping init */
+
+    if( lazy<=0L ) lazy = fd_tempo_lazy_default( mcache_depth );
+    FD_LOG_INFO(( "Configuring housekeeping (lazy %li ns)", lazy ));
+
+    async_min = fd_tempo_async_min( lazy, 1UL /*event_cnt*/, (float)tick_per_ns );
+    if( FD_UNLIKELY( !async_min ) ) { FD_LOG_WARNING(( "bad lazy" )); return 1; }
+
+  } while(0);
+
+  FD_LOG_INFO(( "Running AF_PACKET recv (orig %lu, %lu blocks of %lu bytes)", orig, blk_cnt, blk_sz ));
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+  long then = fd_tickcount();
+  long now  = then;
+  for(;;) {
+
+    /* Do housekeeping at a low rate in the background */
+
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
+      /* Send synchronization info */
+      fd_mcache_seq_update( sync, seq );
+
+      /* Collect kernel drops */
+      struct tpacket_stats_v3 stats = {0};
+      socklen_t               stats_sz = sizeof(struct tpacket_stats_v3);
+      getsockopt( ring->fd, SOL_PACKET, PACKET_STATISTICS, &stats, &stats_sz );
+
+      /* Send diagnostic info */
+      fd_cnc_heartbeat( cnc, now );
+      FD_COMPILER_MFENCE();
+      cnc_diag->in_backp       = cnc_diag_in_backp;
+      cnc_diag->backp_cnt     += cnc_diag_backp_cnt;
+      cnc_diag->pub_cnt       += cnc_diag_pub_cnt;
+      cnc_diag->pub_sz        += cnc_diag_pub_sz;
+      cnc_diag->filt_cnt      += cnc_diag_filt_cnt;
+      cnc_diag->blk_cnt       += cnc_diag_blk_cnt;
+      cnc_diag->kern_drop_cnt += stats.tp_drops;
+      FD_COMPILER_MFENCE();
+      cnc_diag_backp_cnt = 0UL;
+      cnc_diag_pub_cnt   = 0UL;
+      cnc_diag_pub_sz    = 0UL;
+      cnc_diag_filt_cnt  = 0UL;
+      cnc_diag_blk_cnt   = 0UL;
+
+      /* Resync the tick counter to the RX timestamp clock */
+      ts_tick0 = fd_tickcount();
+      ts_wall0 = fd_log_wallclock();
+
+      /* Receive command-and-control signals */
+      ulong s = fd_cnc_signal_query( cnc );
+      if( FD_UNLIKELY( s!=FD_CNC_SIGNAL_RUN ) ) {
+        if( FD_LIKELY( s==FD_CNC_SIGNAL_HALT ) ) break;
+        fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+      }
+
+      /* Reload housekeeping timer */
+      then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
+
+    /* Check if the kernel handed over the next block */
+
+    struct tpacket_block_desc * blk = fd_type_pun( blk_mem + blk_idx*blk_sz );
+    if( !( FD_VOLATILE_CONST( blk->hdr.bh1.block_status ) & TP_STATUS_USER ) ) {
+      cnc_diag_backp_cnt += (ulong)!cnc_diag_in_backp;
+      cnc_diag_in_backp   = 1;
+      FD_SPIN_PAUSE();
+      now = fd_tickcount();
+      continue;
+    }
+    cnc_diag_in_backp = 0;
+    FD_COMPILER_MFENCE();
+
+    /* Publish all frames of the block */
+
+    uint          pkt_cnt = blk->hdr.bh1.num_pkts;
+    uchar const * cur     = (uchar const *)blk + blk->hdr.bh1.offset_to_first_pkt;
+
+    now = fd_tickcount();
+    ulong tspub = fd_frag_meta_ts_comp( now );
+    ulong ctl   = fd_frag_meta_ctl( orig, 1 /* som */, 1 /* eom */, 0 /* err */ );
+
+    for( uint j=0U; j<pkt_cnt; j++ ) {
+      struct tpacket3_hdr const * hdr = fd_type_pun_const( cur );
+      uchar const * frame = cur + hdr->tp_mac;
+      ulong         sz    = hdr->tp_snaplen;
+      long          ts_ns = (long)hdr->tp_sec*(long)1e9 + (long)hdr->tp_nsec;
+      ulong         sig   = (ulong)hdr->hv1.tp_rxhash;
+      cur += hdr->tp_next_offset;
+
+      if( FD_UNLIKELY( sz>mtu ) ) {
+        cnc_diag_filt_cnt++;
+        continue;
+      }
+
+      fd_memcpy( fd_chunk_to_laddr( base, chunk ), frame, sz );
+
+      long ts_tick = ts_tick0 + (long)( (double)( ts_ns - ts_wall0 ) * tick_per_ns );
+      ts_tick      = fd_long_min( ts_tick, now );  /* never in the future */
+
+      fd_mcache_publish( mcache, mcache_depth, seq, sig, chunk, sz, ctl, fd_frag_meta_ts_comp( ts_tick ), tspub );
+
+      chunk = fd_dcache_compact_next( chunk, sz, chunk0, wmark );
+      seq   = fd_seq_inc( seq, 1UL );
+      cnc_diag_pub_cnt++;
+      cnc_diag_pub_sz += sz;
+    }
+
+    /* Return the block to the kernel */
+
+    FD_COMPILER_MFENCE();
+    FD_VOLATILE( blk->hdr.bh1.block_status ) = TP_STATUS_KERNEL;
+    FD_COMPILER_MFENCE();
+
+    blk_idx = fd_ulong_if( blk_idx+1UL==blk_cnt, 0UL, blk_idx+1UL );
+    cnc_diag_blk_cnt++;
+  }
+
+  do {
+
+    FD_LOG_INFO(( "Halted net_packet_rx" ));
+    fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
+
+  } while(0);
+
+  return 0;
+}
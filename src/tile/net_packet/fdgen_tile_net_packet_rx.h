@@ -0,0 +1,59 @@
+#pragma once
+
+/* The net_packet_rx tile forwards frames received on an AF_PACKET
+   TPACKET_V3 ring to an mcache.
+
+   The kernel fills the ring block by block.  A block is handed to the
+   tile once it is full or its retire timeout expires.  The tile walks
+   all frames of a block in one pass, then returns the block to the
+   kernel, so the status handshake is paid once per block instead of
+   once per frame.
+
+   Unlike AF_XDP, the ring memory belongs to the kernel, so each frame is
+   copied into the dcache (compact, wrapping at the mtu watermark).
+   Published frags start at the Ethernet header, the same layout as
+   net_xsk_rx.  The sig is the flow hash of the frame (the NIC's RSS
+   hash if available, else computed by the kernel), so consumers can
+   shard by flow without parsing headers.  tsorig is the kernel RX
+   timestamp of the frame converted to ticks, tspub the tick of
+   publication.  The mcache is in unreliable mode.  Frames longer than
+   mtu are dropped (filt_cnt).
+
+   When run with fanout, one tile per ring of the fanout group shares
+   the traffic of the interface.
+
+   Kernel side drops (ring full) are read from PACKET_STATISTICS during
+   housekeeping. */
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include "../../cfg/fdgen_cfg_net_packet.h"
+
+/* fdgen_tile_net_packet_rx_cfg_t holds config and local joins required
+   by the net_packet_rx tile. */
+
+struct fdgen_tile_net_packet_rx_cfg {
+
+  ulong            orig;
+  long             lazy;
+  double           tick_per_ns;
+  ulong            seq0;    /* first seq to produce */
+  ulong            mtu;
+
+  fd_cnc_t *       cnc;
+  fd_frag_meta_t * mcache;  /* packet_rx -> downstream frags */
+  uchar *          dcache;  /* frag copies */
+  uchar *          base;    /* frag base pointer */
+  fd_rng_t *       rng;
+
+  fdgen_packet_ring_t const * ring;
+
+};
+
+typedef struct fdgen_tile_net_packet_rx_cfg fdgen_tile_net_packet_rx_cfg_t;
+
+FD_PROTOTYPES_BEGIN
+
+int
+fdgen_tile_net_packet_rx_run( fdgen_tile_net_packet_rx_cfg_t * cfg );
+
+FD_PROTOTYPES_END
@@ -0,0 +1,301 @@
+#define _GNU_SOURCE
+#include "fdgen_tile_net_packet.h"
+#include "fdgen_tile_net_packet_tx.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <linux/if_packet.h>
+#include <sys/socket.h>
+
+#include <firedancer/tango/fd_tango_base.h>
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+
+int
+fdgen_tile_net_packet_tx_run( fdgen_tile_net_packet_tx_cfg_t * cfg ) {
+
+  if( FD_UNLIKELY( !cfg ) ) { FD_LOG_WARNING(( "NULL cfg" )); return 1; }
+
+  /* load config */
+
+  ulong                          orig        = cfg->orig;
+  long                           lazy        = cfg->lazy;
+  double                         tick_per_ns = cfg->tick_per_ns;
+  fd_cnc_t *                     cnc         = cfg->cnc;
+  fd_rng_t *                     rng         = cfg->rng;
+  fd_frag_meta_t *               tx_mcache   = cfg->tx_mcache;
+  uchar *                        tx_base     = cfg->tx_base;
+  fdgen_packet_tx_ring_t const * ring        = cfg->ring;
+
+  /* cnc state */
+  fdgen_tile_net_packet_tx_diag_t * cnc_diag;
+  ulong   cnc_diag_backp_cnt;
+  ulong   cnc_diag_overnp_cnt;
+  ulong   cnc_diag_filt_cnt;
+  ulong   cnc_diag_tx_cnt;
+  ulong   cnc_diag_tx_sz;
+  ulong   cnc_diag_kick_cnt;
+  ulong   cnc_diag_kick_err_cnt;
+
+  /* tx (in) frag stream state */
+  ulong   tx_depth;
+  ulong   tx_seq;
+
+  /* housekeeping state */
+  ulong async_min; /* minimum number of ticks between processing a housekeeping event, positive integer power of 2 */
+
+  /* TX ring state */
+  int              tx_fd;
+  uchar *          slot_mem;
+  ulong            slot_sz;
+  ulong            slot_cnt;
+  ulong            slot_idx;          /* next slot to fill */
+  ulong            slot_data_max;     /* max frame size per slot */
+
+  /* TX batching */
+  ulong            tx_burst;
+  ulong            tx_pending;        /* slots marked SEND_REQUEST since the last successful kick */
+  ulong            tx_batch;          /* slots marked SEND_REQUEST since the last kick attempt */
+  int              tx_kick_fail;      /* 1 if the last kick failed, its slots are still pending */
+  long             tx_burst_timeout;  /* max ticks a frame may wait before a kick */
+  long             tx_deadline;       /* kick at this tick, set when first frame becomes pending */
+  struct timespec  tx_wait;           /* max time to block for POLLOUT */
+  struct timespec  tx_retry_wait;     /* time for the device queue to drain before kicking again */
+
+  do {
+
+    FD_LOG_INFO(( "Booting net_packet_tx" ));
+
+    /* cnc state init */
+
+    if( FD_UNLIKELY( !cnc ) ) { FD_LOG_WARNING(( "NULL cnc" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<sizeof(fdgen_tile_net_packet_tx_diag_t) ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_signal_query( cnc )!=FD_CNC_SIGNAL_BOOT ) ) { FD_LOG_WARNING(( "already booted" )); return 1; }
+
+    cnc_diag = fd_cnc_app_laddr( cnc );
+
+    cnc_diag_backp_cnt    = 0UL;
+    cnc_diag_overnp_cnt   = 0UL;
+    cnc_diag_filt_cnt     = 0UL;
+    cnc_diag_tx_cnt       = 0UL;
+    cnc_diag_tx_sz        = 0UL;
+    cnc_diag_kick_cnt     = 0UL;
+    cnc_diag_kick_err_cnt = 0UL;
+
+    /* tx frag stream init */
+
+    if( FD_UNLIKELY( !tx_mcache ) ) { FD_LOG_WARNING(( "NULL tx_mcache")); return 1; }
+    tx_depth = fd_mcache_depth( tx_mcache );
+    tx_seq   = fd_mcache_seq_query( fd_mcache_seq_laddr( tx_mcache ) );
+
+    if( FD_UNLIKELY( !tx_base ) ) { FD_LOG_WARNING(( "NULL tx_base" )); return 1; }
+
+    /* TX ring init */
+
+    if( FD_UNLIKELY( !ring || !ring->tx_mem ) ) { FD_LOG_WARNING(( "NULL ring" )); return 1; }
+    tx_fd         = ring->fd;
+    slot_mem      = ring->tx_mem;
+    slot_sz       = ring->frame_sz;
+    slot_cnt      = ring->frame_cnt;
+    slot_idx      = 0UL;
+    slot_data_max = slot_sz - FDGEN_PACKET_TX_DATA_OFF;
+
+    /* tx batch init */
+
+    tx_burst = cfg->tx_burst;
+    if( FD_UNLIKELY( !tx_burst ) ) {
+      FD_LOG_WARNING(( "zero tx_burst" ));
+      return 1;
+    }
+    tx_pending   = 0UL;
+    tx_batch     = 0UL;
+    tx_kick_fail = 0;
+    tx_deadline  = LONG_MAX;
+
+    /* housekeeping init */
+
+    if( lazy<=0L ) lazy = fd_tempo_lazy_default( tx_depth );
+    FD_LOG_INFO(( "Configuring housekeeping (lazy %li ns)", lazy ));
+
+    async_min = fd_tempo_async_min( lazy, 1UL /*event_cnt*/, (float)tick_per_ns );
+    if( FD_UNLIKELY( !async_min ) ) { FD_LOG_WARNING(( "bad lazy" )); return 1; }
+
+    /* tx kick timeout init */
+
+    tx_burst_timeout = cfg->tx_burst_timeout;
+    if( tx_burst_timeout<=0L ) tx_burst_timeout = (long)async_min;
+    FD_LOG_INFO(( "Configuring tx kick (burst %lu, timeout %li ticks, %lu slots of %lu bytes)",
+                  tx_burst, tx_burst_timeout, slot_cnt, slot_sz ));
+
+    tx_wait.tv_sec  = lazy / (long)1e9;
+    tx_wait.tv_nsec = lazy % (long)1e9;
+
+    long retry_ns = fd_long_max( (long)( (double)tx_burst_timeout / tick_per_ns ), 1L );
+    tx_retry_wait.tv_sec  = retry_ns / (long)1e9;
+    tx_retry_wait.tv_nsec = retry_ns % (long)1e9;
+
+  } while(0);
+
+  FD_LOG_INFO(( "Running AF_PACKET send (orig %lu)", orig ));
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+  long then = fd_tickcount();
+  long now  = then;
+  for(;;) {
+    now = fd_tickcount();
+
+    /* Do housekeeping at a low rate in the background */
+
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
+      /* Send diagnostic info */
+      fd_cnc_heartbeat( cnc, now );
+      FD_COMPILER_MFENCE();
+      cnc_diag->backp_cnt    += cnc_diag_backp_cnt;
+      cnc_diag->overnp_cnt   += cnc_diag_overnp_cnt;
+      cnc_diag->filt_cnt     += cnc_diag_filt_cnt;
+      cnc_diag->tx_cnt       += cnc_diag_tx_cnt;
+      cnc_diag->tx_sz        += cnc_diag_tx_sz;
+      cnc_diag->kick_cnt     += cnc_diag_kick_cnt;
+      cnc_diag->kick_err_cnt += cnc_diag_kick_err_cnt;
+      FD_COMPILER_MFENCE();
+      cnc_diag_backp_cnt    = 0UL;
+      cnc_diag_overnp_cnt   = 0UL;
+      cnc_diag_filt_cnt     = 0UL;
+      cnc_diag_tx_cnt       = 0UL;
+      cnc_diag_tx_sz        = 0UL;
+      cnc_diag_kick_cnt     = 0UL;
+      cnc_diag_kick_err_cnt = 0UL;
+
+      /* Receive command-and-control signals */
+      ulong s = fd_cnc_signal_query( cnc );
+      if( FD_UNLIKELY( s!=FD_CNC_SIGNAL_RUN ) ) {
+        if( FD_LIKELY( s==FD_CNC_SIGNAL_HALT ) ) break;
+        fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+      }
+
+      /* Reload housekeeping timer */
+      then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
+
+    /* Kick the kernel once enough frames are pending or the oldest
+       pending frame has waited tx_burst_timeout ticks.  A kick with
+       MSG_DONTWAIT transmits every slot marked SEND_REQUEST.  A failed
+       kick (EAGAIN and ENOBUFS when the socket send buffer or the
+       device queue is full) leaves the remaining slots in SEND_REQUEST:
+       they stay pending and are kicked again after tx_burst_timeout
+       ticks, or as soon as the ring runs out of slots. */
+
+    if( FD_UNLIKELY( tx_batch>=tx_burst || (now-tx_deadline)>=0L ) ) {
+      cnc_diag_kick_cnt++;
+      tx_batch = 0UL;
+      if( FD_LIKELY( sendto( tx_fd, NULL, 0UL, MSG_DONTWAIT, NULL, 0 )>=0 ) ) {
+        tx_pending   = 0UL;
+        tx_kick_fail = 0;
+        tx_deadline  = LONG_MAX;
+      } else {
+        int err = errno;
+        if( FD_UNLIKELY( err!=EAGAIN && err!=ENOBUFS && err!=EINTR ) ) {
+          if( !tx_kick_fail ) FD_LOG_WARNING(( "sendto(AF_PACKET) failed (%i-%s)", err, fd_io_strerror( err ) ));
+          cnc_diag_kick_err_cnt++;
+        }
+        tx_kick_fail = 1;
+        tx_deadline  = now + tx_burst_timeout;
+      }
+      continue;
+    }
+
+    /* Check if the next TX ring slot is free */
+
+    struct tpacket2_hdr * slot = fd_type_pun( slot_mem + slot_idx*slot_sz );
+    uint status = FD_VOLATILE_CONST( slot->tp_status );
+    if( FD_UNLIKELY( status!=TP_STATUS_AVAILABLE ) ) {
+      /* The kernel still owns the slot.  A slot still in SEND_REQUEST
+         was never picked up, and POLLOUT is only raised once the head
+         slot is AVAILABLE: kick again (after letting the device queue
+         drain if the last kick failed) instead of waiting for it.
+         Otherwise the kernel is sending, wait until the ring drains. */
+      cnc_diag_backp_cnt++;
+      struct pollfd pfd = { .fd = tx_fd, .events = POLLOUT };
+      if( tx_pending || status==TP_STATUS_SEND_REQUEST ) {
+        if( tx_kick_fail ) ppoll( &pfd, 1, &tx_retry_wait, NULL );
+        tx_deadline = now;
+        continue;
+      }
+      ppoll( &pfd, 1, &tx_wait, NULL );
+      continue;
+    }
+
+    /* Check if there is a new outgoing frame */
+
+    fd_frag_meta_t const * tx_mline = tx_mcache + fd_mcache_line_idx( tx_seq, tx_depth );
+
+    FD_COMPILER_MFENCE();
+    __m128i tx_mline_sse0 = _mm_load_si128( &tx_mline->sse0 );
+    FD_COMPILER_MFENCE();
+    __m128i tx_mline_sse1 = _mm_load_si128( &tx_mline->sse1 );
+    FD_COMPILER_MFENCE();
+
+    ulong tx_seq_found = fd_frag_meta_sse0_seq( tx_mline_sse0 );
+    long  tx_diff      = fd_seq_diff( tx_seq_found, tx_seq );
+    if( FD_UNLIKELY( tx_diff>0L ) ) {
+      cnc_diag_overnp_cnt++;
+      tx_seq = tx_seq_found;
+      continue;
+    }
+
+    if( tx_diff!=0UL ) {
+      FD_SPIN_PAUSE();
+      continue;
+    }
+
+    /* Speculative copy into the slot, invisible to the kernel until
+       the status flips */
+
+    ulong         sz    = fd_frag_meta_sse1_sz( tx_mline_sse1 );
+    uchar const * frame = fd_chunk_to_laddr_const( tx_base, fd_frag_meta_sse1_chunk( tx_mline_sse1 ) );
+    if( FD_UNLIKELY( sz<14UL || sz>slot_data_max ) ) {
+      cnc_diag_filt_cnt++;
+      tx_seq = fd_seq_inc( tx_seq, 1 );
+      continue;
+    }
+    fd_memcpy( (uchar *)slot + FDGEN_PACKET_TX_DATA_OFF, frame, sz );
+    FD_COMPILER_MFENCE();
+
+    /* Detect overrun.  The producer is ahead, resync to the line but
+       never move backwards. */
+    tx_seq_found = fd_frag_meta_seq_query( tx_mline );
+    if( FD_UNLIKELY( tx_seq!=tx_seq_found ) ) {
+      cnc_diag_overnp_cnt++;
+      if( fd_seq_gt( tx_seq_found, tx_seq ) ) tx_seq = tx_seq_found;
+      continue;
+    }
+
+    /* Hand the slot to the kernel */
+    slot->tp_len = (uint)sz;
+    FD_COMPILER_MFENCE();
+    FD_VOLATILE( slot->tp_status ) = TP_STATUS_SEND_REQUEST;
+    FD_COMPILER_MFENCE();
+
+    /* Wind up for the next iteration */
+    if( !tx_pending ) tx_deadline = now + tx_burst_timeout;
+    tx_pending++;
+    tx_batch++;
+    slot_idx = fd_ulong_if( slot_idx+1UL==slot_cnt, 0UL, slot_idx+1UL );
+    tx_seq   = fd_seq_inc( tx_seq, 1 );
+    cnc_diag_tx_cnt++;
+    cnc_diag_tx_sz += sz;
+  }
+
+  do {
+
+    /* Flush frames still pending */
+    if( tx_pending ) sendto( tx_fd, NULL, 0UL, MSG_DONTWAIT, NULL, 0 );
+
+    FD_LOG_INFO(( "Halted net_packet_tx" ));
+    fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
+
+  } while(0);
+
+  return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+/* The net_packet_tx tile transmits raw Ethernet frames from fd_tango
+   via an AF_PACKET TPACKET_V2 TX ring.
+
+   Unlike net_dgram_tx, frags are sent verbatim: the Ethernet, IPv4 and
+   UDP headers crafted by the producer reach the wire unchanged, so
+   spoofed sources, custom TTLs, IP options or non-UDP payloads can be
+   generated.  The producer is responsible for valid checksums.
+
+   Each frag is copied into the next free TX ring slot and marked
+   TP_STATUS_SEND_REQUEST.  The kernel is kicked with a single
+   sendto(2) once tx_burst frames are pending or the oldest pending
+   frame has waited tx_burst_timeout ticks.  A kick that fails because
+   the socket send buffer or the device queue is full leaves its frames
+   pending, they are kicked again after tx_burst_timeout.  If the next
+   slot is still owned by the kernel, the tile kicks again if that slot
+   was not picked up yet, and waits for POLLOUT otherwise.
+
+   Frags shorter than an Ethernet header or larger than a ring slot are
+   dropped (filt_cnt).  Frames the kernel rejects as malformed are
+   discarded by the kernel (PACKET_LOSS).
+
+   For maximum rate, create the ring with qdisc_bypass (see
+   fdgen_packet_tx_ring_init), so frames skip the qdisc layer. */
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include "../../cfg/fdgen_cfg_net_packet.h"
+
+struct fdgen_tile_net_packet_tx_cfg {
+
+  ulong  orig;
+  long   lazy;
+  double tick_per_ns;
+
+  fd_rng_t *       rng;
+  fd_cnc_t *       cnc;
+  uchar *          tx_base;
+  fd_frag_meta_t * tx_mcache;
+
+  ulong tx_burst;          /* frames per sendto(2) kick */
+  long  tx_burst_timeout;  /* kick timeout (ticks), <=0 for housekeeping interval */
+
+  fdgen_packet_tx_ring_t const * ring;
+
+};
+
+typedef struct fdgen_tile_net_packet_tx_cfg fdgen_tile_net_packet_tx_cfg_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_net_packet_tx_run enters the tile main loop. */
+
+int
+fdgen_tile_net_packet_tx_run( fdgen_tile_net_packet_tx_cfg_t * cfg );
+
+FD_PROTOTYPES_END
@@ -0,0 +1,191 @@
+#include "fdgen_tile_net_packet.h"
+#include "fdgen_tile_net_packet_rx.h"
+
+/* test_tile_net_packet_rx.c tests the AF_PACKET TPACKET_V3 receive
+   tile on the loopback interface.  Requires CAP_NET_RAW. */
+
+#include <errno.h>          /* errno(3) */
+#include <unistd.h>         /* close(2) */
+#include <net/if.h>         /* if_nametoindex */
+#include <netinet/in.h>     /* sockaddr_in */
+#include <sys/socket.h>
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+#include <firedancer/util/net/fd_eth.h>
+#include <firedancer/util/net/fd_ip4.h>
+#include <firedancer/util/net/fd_udp.h>
+
+static int
+rx_tile_main( int     argc,
+              char ** argv ) {
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, fd_tickcount(), 0UL ) );
+
+  fdgen_tile_net_packet_rx_cfg_t * cfg = fd_type_pun( argv[0] );
+  cfg->rng  = rng;
+  cfg->lazy = 100L;
+
+  FD_LOG_NOTICE(( "Starting AF_PACKET receive" ));
+
+  int res = fdgen_tile_net_packet_rx_run( cfg );
+
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return res;
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  fd_boot( &argc, &argv );
+
+  ulong cpu_idx = fd_tile_cpu_id( fd_tile_idx() );
+  if( cpu_idx>=fd_shmem_cpu_cnt() ) cpu_idx = 0UL;
+
+  char const * _page_sz   = fd_env_strip_cmdline_cstr ( &argc, &argv, "--page-sz",    NULL, "gigantic"                 );
+  ulong        page_cnt   = fd_env_strip_cmdline_ulong( &argc, &argv, "--page-cnt",   NULL, 1UL                        );
+  ulong        numa_idx   = fd_env_strip_cmdline_ulong( &argc, &argv, "--numa-idx",   NULL, fd_shmem_numa_idx(cpu_idx) );
+  ulong        depth      = fd_env_strip_cmdline_ulong( &argc, &argv, "--depth",      NULL, 1024UL                     );
+  ulong        block_sz   = fd_env_strip_cmdline_ulong( &argc, &argv, "--block-sz",   NULL, 1UL<<16                    );
+  ulong        block_cnt  = fd_env_strip_cmdline_ulong( &argc, &argv, "--block-cnt",  NULL, 64UL                       );
+  ulong        pkt_cnt    = fd_env_strip_cmdline_ulong( &argc, &argv, "--pkt-cnt",    NULL, 256UL                      );
+
+  if( FD_UNLIKELY( fd_tile_cnt()<2UL   ) ) FD_LOG_ERR(( "This test requires at least 2 tiles" ));
+  if( FD_UNLIKELY( 2UL*pkt_cnt>=depth ) ) FD_LOG_ERR(( "--pkt-cnt must be below half of --depth" ));  /* ICMP replies */
+
+  ulong page_sz = fd_cstr_to_shmem_page_sz( _page_sz );
+  if( FD_UNLIKELY( !page_sz ) ) FD_LOG_ERR(( "unsupported --page-sz" ));
+
+  ulong  mtu     = 2048UL;
+  uint   dst_ip  = FD_IP4_ADDR( 127, 0, 0, 1 );
+  ushort dst_port = 9300;
+
+  /* Create ring on loopback */
+
+  uint if_idx = if_nametoindex( "lo" );
+  FD_TEST( if_idx );
+
+  fdgen_packet_params_t params = {
+    .block_sz    = block_sz,
+    .block_cnt   = block_cnt,
+    .frame_sz    = mtu,
+    .retire_ms   = 1U,
+    .fanout_mode = FDGEN_PACKET_FANOUT_NONE
+  };
+  fdgen_packet_ring_t ring[1];
+  if( FD_UNLIKELY( !fdgen_packet_ring_init( ring, if_idx, &params ) ) ) {
+    FD_LOG_WARNING(( "skip: cannot create AF_PACKET ring (missing CAP_NET_RAW?)" ));
+    fd_halt();
+    return 0;
+  }
+
+  /* Allocate objects */
+
+  FD_LOG_NOTICE(( "Creating workspace with --page-cnt %lu --page-sz %s pages on --numa-idx %lu", page_cnt, _page_sz, numa_idx ));
+  fd_wksp_t * wksp = fd_wksp_new_anonymous( page_sz, page_cnt, fd_shmem_cpu_idx( numa_idx ), "wksp", 0UL );
+  FD_TEST( wksp );
+
+  void *     rx_cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 64UL ), 1UL );
+  fd_cnc_t * rx_cnc     = fd_cnc_join( fd_cnc_new( rx_cnc_mem, 64UL, 1UL, fd_tickcount() ) );
+  FD_TEST( rx_cnc );
+
+  void *           mcache_mem = fd_wksp_alloc_laddr( wksp, fd_mcache_align(), fd_mcache_footprint( depth, 0UL ), 1UL );
+  fd_frag_meta_t * mcache     = fd_mcache_join( fd_mcache_new( mcache_mem, depth, 0UL, 0UL ) );
+  FD_TEST( mcache );
+
+  ulong   dcache_data_sz = fd_dcache_req_data_sz( mtu, depth, 1UL, 1 );
+  void *  dcache_mem     = fd_wksp_alloc_laddr( wksp, fd_dcache_align(), fd_dcache_footprint( dcache_data_sz, 0UL ), 1UL );
+  uchar * dcache         = fd_dcache_join( fd_dcache_new( dcache_mem, dcache_data_sz, 0UL ) );
+  FD_TEST( dcache );
+
+  fdgen_tile_net_packet_rx_cfg_t rx_cfg[1] = {{
+    .orig        = 1UL,
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+    .seq0        = fd_mcache_seq0( mcache ),
+    .mtu         = mtu,
+
+    .cnc    = rx_cnc,
+    .mcache = mcache,
+    .dcache = dcache,
+    .base   = (uchar *)wksp,
+
+    .ring = ring
+  }};
+
+  char * rx_tile_argv[1] = { fd_type_pun( rx_cfg ) };
+  fd_tile_exec_t * rx_tile = fd_tile_exec_new( 1UL, rx_tile_main, 1, rx_tile_argv );
+  FD_TEST( rx_tile );
+  FD_TEST( fd_cnc_wait( rx_cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+  /* Send datagrams tagged with their index */
+
+  int send_fd = socket( AF_INET, SOCK_DGRAM, 0 );
+  FD_TEST( send_fd>=0 );
+  struct sockaddr_in dst = {
+    .sin_family = AF_INET,
+    .sin_addr   = { .s_addr = dst_ip },
+    .sin_port   = (ushort)fd_ushort_bswap( dst_port )
+  };
+  for( ulong j=0UL; j<pkt_cnt; j++ ) {
+    FD_TEST( sizeof(ulong)==sendto( send_fd, &j, sizeof(ulong), 0, fd_type_pun_const( &dst ), sizeof(struct sockaddr_in) ) );
+  }
+
+  /* Check published frames.  Other loopback traffic is skipped. */
+
+  ulong seq      = fd_mcache_seq0( mcache );
+  ulong next_tag = 0UL;
+  ulong flow_sig = 0UL;
+  long  deadline = fd_log_wallclock() + (long)5e9;
+  while( next_tag<pkt_cnt ) {
+    fd_frag_meta_t const * mline = mcache + fd_mcache_line_idx( seq, depth );
+    if( fd_seq_ne( fd_frag_meta_seq_query( mline ), seq ) ) {
+      if( FD_UNLIKELY( fd_log_wallclock()>deadline ) ) FD_LOG_ERR(( "timed out at frame %lu of %lu", next_tag, pkt_cnt ));
+      FD_SPIN_PAUSE();
+      continue;
+    }
+
+    uchar const *        frame   = fd_chunk_to_laddr_const( wksp, mline->chunk );
+    fd_eth_hdr_t const * eth_hdr = fd_type_pun_const( frame );
+    fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( frame+14 );
+    fd_udp_hdr_t const * udp_hdr = fd_type_pun_const( frame+14+(FD_IP4_GET_IHL( *ip4_hdr )<<2) );
+    FD_TEST( eth_hdr->net_type==fd_ushort_bswap( FD_ETH_HDR_TYPE_IP ) );
+    FD_TEST( mline->sz>=14UL+20UL+8UL );
+
+    if( ip4_hdr->protocol==FD_IP4_HDR_PROTOCOL_UDP && fd_ushort_bswap( udp_hdr->net_dport )==dst_port ) {
+      ulong tag; memcpy( &tag, (uchar const *)( udp_hdr+1 ), sizeof(ulong) );
+      FD_TEST( tag==next_tag );
+      /* All datagrams belong to one flow, so they share its hash */
+      if( !next_tag ) flow_sig = mline->sig;
+      FD_TEST( mline->sig && mline->sig==flow_sig );
+      FD_TEST( fd_frag_meta_ts_decomp( mline->tsorig, fd_tickcount() ) <= fd_frag_meta_ts_decomp( mline->tspub, fd_tickcount() ) );
+      next_tag++;
+    }
+    seq = fd_seq_inc( seq, 1UL );
+  }
+
+  FD_LOG_INFO(( "Cleaning up" ));
+
+  FD_TEST( !fd_cnc_open( rx_cnc ) );
+  fd_cnc_signal( rx_cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( rx_cnc );
+  FD_TEST( fd_cnc_wait( rx_cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  fd_tile_exec_delete( rx_tile, NULL );
+
+  fdgen_tile_net_packet_rx_diag_t const * rx_diag = fd_cnc_app_laddr_const( rx_cnc );
+  FD_LOG_NOTICE(( "packet_rx: pub_cnt %lu blk_cnt %lu filt_cnt %lu kern_drop_cnt %lu",
+                  rx_diag->pub_cnt, rx_diag->blk_cnt, rx_diag->filt_cnt, rx_diag->kern_drop_cnt ));
+  FD_TEST( rx_diag->pub_cnt>=pkt_cnt );
+
+  close( send_fd );
+  fdgen_packet_ring_fini( ring );
+  fd_wksp_free_laddr( fd_dcache_delete( fd_dcache_leave( dcache ) ) );
+  fd_wksp_free_laddr( fd_mcache_delete( fd_mcache_leave( mcache ) ) );
+  fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( rx_cnc ) ) );
+  fd_wksp_delete_anonymous( wksp );
+
+  FD_LOG_NOTICE(( "pass" ));
+  fd_halt();
+  return 0;
+}
@@ -0,0 +1,263 @@
+#include "fdgen_tile_net_packet.h"
+#include "fdgen_tile_net_packet_tx.h"
+
+/* test_tile_net_packet_tx.c tests the AF_PACKET TX ring transmit tile
+   on the loopback interface.  Frames carry a spoofed source address
+   and a custom TTL to check that producer-crafted headers reach the
+   receiver unchanged.  The ring socket gets a tiny SO_SNDBUF and
+   several ring sizes of frames are sent, so kicks run out of send
+   buffer and the ring wraps onto slots still pending.  Requires
+   CAP_NET_RAW. */
+
+#include <errno.h>          /* errno(3) */
+#include <unistd.h>         /* close(2) */
+#include <net/if.h>         /* if_nametoindex */
+#include <netinet/in.h>     /* sockaddr_in */
+#include <sys/socket.h>
+#include <sys/uio.h>        /* struct iovec */
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+#include <firedancer/util/net/fd_eth.h>
+#include <firedancer/util/net/fd_ip4.h>
+#include <firedancer/util/net/fd_udp.h>
+
+#define TEST_TTL (7)
+
+static int
+tx_tile_main( int     argc,
+              char ** argv ) {
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, fd_tickcount(), 0UL ) );
+
+  fdgen_tile_net_packet_tx_cfg_t * cfg = fd_type_pun( argv[0] );
+  cfg->rng  = rng;
+  cfg->lazy = 100L;
+
+  FD_LOG_NOTICE(( "Starting AF_PACKET send" ));
+
+  int res = fdgen_tile_net_packet_tx_run( cfg );
+
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return res;
+}
+
+/* recv_check receives the datagram tagged j with the given recvmsg(2)
+   flags and checks its source and TTL.  Returns 1 if received, 0 if
+   none was available. */
+
+static int
+recv_check( int   recv_fd,
+            ulong j,
+            uint  src_ip,
+            int   flags ) {
+  ulong              tag;
+  struct sockaddr_in src;
+  uchar              cmsg_buf[ CMSG_SPACE( sizeof(int) ) ];
+  struct iovec       iov = { .iov_base = &tag, .iov_len = sizeof(ulong) };
+  struct msghdr      msg = {
+    .msg_name       = &src,
+    .msg_namelen    = sizeof(struct sockaddr_in),
+    .msg_iov        = &iov,
+    .msg_iovlen     = 1,
+    .msg_control    = cmsg_buf,
+    .msg_controllen = sizeof(cmsg_buf)
+  };
+  long res = recvmsg( recv_fd, &msg, flags );
+  if( res<0 && ( flags & MSG_DONTWAIT ) && errno==EAGAIN ) return 0;
+  if( FD_UNLIKELY( res<0 ) ) FD_LOG_ERR(( "recvmsg failed at datagram %lu (%i-%s)", j, errno, fd_io_strerror( errno ) ));
+  FD_TEST( res==sizeof(ulong) );
+  FD_TEST( tag==j );
+  FD_TEST( src.sin_addr.s_addr==src_ip );
+
+  struct cmsghdr * cmsg = CMSG_FIRSTHDR( &msg );
+  FD_TEST( cmsg && cmsg->cmsg_level==IPPROTO_IP && cmsg->cmsg_type==IP_TTL );
+  int ttl; memcpy( &ttl, CMSG_DATA( cmsg ), sizeof(int) );
+  FD_TEST( ttl==TEST_TTL );
+  return 1;
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  fd_boot( &argc, &argv );
+
+  ulong cpu_idx = fd_tile_cpu_id( fd_tile_idx() );
+  if( cpu_idx>=fd_shmem_cpu_cnt() ) cpu_idx = 0UL;
+
+  char const * _page_sz   = fd_env_strip_cmdline_cstr ( &argc, &argv, "--page-sz",    NULL, "gigantic"                 );
+  ulong        page_cnt   = fd_env_strip_cmdline_ulong( &argc, &argv, "--page-cnt",   NULL, 1UL                        );
+  ulong        numa_idx   = fd_env_strip_cmdline_ulong( &argc, &argv, "--numa-idx",   NULL, fd_shmem_numa_idx(cpu_idx) );
+  ulong        depth      = fd_env_strip_cmdline_ulong( &argc, &argv, "--depth",      NULL, 4096UL                     );
+  ulong        frame_cnt  = fd_env_strip_cmdline_ulong( &argc, &argv, "--frame-cnt",  NULL, 256UL                      );
+  ulong        tx_burst   = fd_env_strip_cmdline_ulong( &argc, &argv, "--tx-burst",   NULL, 16UL                       );
+  ulong        pkt_cnt    = fd_env_strip_cmdline_ulong( &argc, &argv, "--pkt-cnt",    NULL, 2048UL                     );
+  int          sndbuf     = fd_env_strip_cmdline_int  ( &argc, &argv, "--sndbuf",     NULL, 4096                       );
+  int          bypass     = fd_env_strip_cmdline_int  ( &argc, &argv, "--qdisc-bypass", NULL, 0                        );
+
+  if( FD_UNLIKELY( fd_tile_cnt()<2UL  ) ) FD_LOG_ERR(( "This test requires at least 2 tiles" ));
+  if( FD_UNLIKELY( pkt_cnt>=depth    ) ) FD_LOG_ERR(( "--pkt-cnt must be below --depth" ));
+
+  ulong page_sz = fd_cstr_to_shmem_page_sz( _page_sz );
+  if( FD_UNLIKELY( !page_sz ) ) FD_LOG_ERR(( "unsupported --page-sz" ));
+
+  ulong  mtu      = 2048UL;
+  uint   src_ip   = FD_IP4_ADDR( 127, 0, 0, 2 );
+  uint   dst_ip   = FD_IP4_ADDR( 127, 0, 0, 1 );
+  ushort dst_port = 9301;
+
+  /* Create TX ring on loopback */
+
+  uint if_idx = if_nametoindex( "lo" );
+  FD_TEST( if_idx );
+
+  fdgen_packet_tx_ring_t ring[1];
+  if( FD_UNLIKELY( !fdgen_packet_tx_ring_init( ring, if_idx, mtu, frame_cnt, bypass ) ) ) {
+    FD_LOG_WARNING(( "skip: cannot create AF_PACKET TX ring (missing CAP_NET_RAW?)" ));
+    fd_halt();
+    return 0;
+  }
+
+  /* Shrink the ring socket send buffer below a ring's worth of frames
+     (the kernel rounds it up to its minimum) */
+
+  FD_TEST( !setsockopt( ring->fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(int) ) );
+
+  /* Create receiving socket, reporting the TTL of each datagram */
+
+  int recv_fd = socket( AF_INET, SOCK_DGRAM, 0 );
+  FD_TEST( recv_fd>=0 );
+  int one = 1;
+  FD_TEST( !setsockopt( recv_fd, IPPROTO_IP, IP_RECVTTL, &one, sizeof(int) ) );
+  int rcvbuf = 1<<23;  /* holds the frames in flight, SO_RCVBUF caps at rmem_max */
+  if( setsockopt( recv_fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(int) ) ) {
+    FD_TEST( !setsockopt( recv_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(int) ) );
+  }
+  struct timeval recv_timeout = { .tv_sec = 5 };
+  FD_TEST( !setsockopt( recv_fd, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(struct timeval) ) );
+  struct sockaddr_in bind_addr = {
+    .sin_family = AF_INET,
+    .sin_addr   = { .s_addr = dst_ip },
+    .sin_port   = (ushort)fd_ushort_bswap( dst_port )
+  };
+  FD_TEST( !bind( recv_fd, fd_type_pun_const( &bind_addr ), sizeof(struct sockaddr_in) ) );
+
+  /* Allocate objects */
+
+  FD_LOG_NOTICE(( "Creating workspace with --page-cnt %lu --page-sz %s pages on --numa-idx %lu", page_cnt, _page_sz, numa_idx ));
+  fd_wksp_t * wksp = fd_wksp_new_anonymous( page_sz, page_cnt, fd_shmem_cpu_idx( numa_idx ), "wksp", 0UL );
+  FD_TEST( wksp );
+
+  void *     tx_cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 64UL ), 1UL );
+  fd_cnc_t * tx_cnc     = fd_cnc_join( fd_cnc_new( tx_cnc_mem, 64UL, 1UL, fd_tickcount() ) );
+  FD_TEST( tx_cnc );
+
+  void *           mcache_mem = fd_wksp_alloc_laddr( wksp, fd_mcache_align(), fd_mcache_footprint( depth, 0UL ), 1UL );
+  fd_frag_meta_t * mcache     = fd_mcache_join( fd_mcache_new( mcache_mem, depth, 0UL, 0UL ) );
+  FD_TEST( mcache );
+
+  ulong   dcache_data_sz = fd_dcache_req_data_sz( mtu, depth, 1UL, 1 );
+  void *  dcache_mem     = fd_wksp_alloc_laddr( wksp, fd_dcache_align(), fd_dcache_footprint( dcache_data_sz, 0UL ), 1UL );
+  uchar * dcache         = fd_dcache_join( fd_dcache_new( dcache_mem, dcache_data_sz, 0UL ) );
+  FD_TEST( dcache );
+
+  fdgen_tile_net_packet_tx_cfg_t tx_cfg[1] = {{
+    .orig        = 0UL,
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+
+    .cnc       = tx_cnc,
+    .tx_base   = (uchar *)wksp,
+    .tx_mcache = mcache,
+
+    .tx_burst         = tx_burst,
+    .tx_burst_timeout = 0L,
+
+    .ring = ring
+  }};
+
+  char * tx_tile_argv[1] = { fd_type_pun( tx_cfg ) };
+  fd_tile_exec_t * tx_tile = fd_tile_exec_new( 1UL, tx_tile_main, 1, tx_tile_argv );
+  FD_TEST( tx_tile );
+  FD_TEST( fd_cnc_wait( tx_cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+  /* Publish crafted frames tagged with their index, receiving while
+     publishing so the receive buffer does not overflow.  pkt_cnt is
+     below depth, so the tile cannot be overrun. */
+
+  ulong chunk0 = fd_dcache_compact_chunk0( wksp, dcache );
+  ulong wmark  = fd_dcache_compact_wmark ( wksp, dcache, mtu );
+  ulong chunk  = chunk0;
+  ulong seq    = fd_mcache_seq0( mcache );
+  ulong rx_cnt = 0UL;
+
+  for( ulong j=0UL; j<pkt_cnt; j++ ) {
+    /* Keep at most two rings of frames in flight */
+    while( j-rx_cnt>=2UL*frame_cnt ) { recv_check( recv_fd, rx_cnt, src_ip, 0 ); rx_cnt++; }
+
+    uchar *        pkt     = fd_chunk_to_laddr( wksp, chunk );
+    fd_eth_hdr_t * eth_hdr = fd_type_pun( pkt    );
+    fd_ip4_hdr_t * ip4_hdr = fd_type_pun( pkt+14 );
+    fd_udp_hdr_t * udp_hdr = fd_type_pun( pkt+34 );
+    memset( eth_hdr, 0, sizeof(fd_eth_hdr_t) );
+    eth_hdr->net_type = (ushort)fd_ushort_bswap( FD_ETH_HDR_TYPE_IP );
+    ip4_hdr[0] = (fd_ip4_hdr_t) {
+      .verihl       = FD_IP4_VERIHL( 4, 5 ),
+      .net_tot_len  = (ushort)fd_ushort_bswap( 20+8+sizeof(ulong) ),
+      .net_id       = (ushort)fd_ushort_bswap( (ushort)j ),
+      .net_frag_off = (ushort)fd_ushort_bswap( FD_IP4_HDR_FRAG_OFF_DF ),
+      .ttl          = TEST_TTL,
+      .protocol     = FD_IP4_HDR_PROTOCOL_UDP
+    };
+    memcpy( ip4_hdr->saddr_c, &src_ip, 4 );
+    memcpy( ip4_hdr->daddr_c, &dst_ip, 4 );
+    ip4_hdr->check = fd_ip4_hdr_check( ip4_hdr );
+    udp_hdr[0] = (fd_udp_hdr_t) {
+      .net_sport = (ushort)fd_ushort_bswap( 0x1234 ),
+      .net_dport = (ushort)fd_ushort_bswap( dst_port ),
+      .net_len   = (ushort)fd_ushort_bswap( 8+sizeof(ulong) ),
+      .check     = 0
+    };
+    memcpy( udp_hdr+1, &j, sizeof(ulong) );
+
+    ulong sz  = 14UL+20UL+8UL+sizeof(ulong);
+    ulong ctl = fd_frag_meta_ctl( 1UL, 1, 1, 0 );
+    fd_mcache_publish( mcache, depth, seq, 0UL, chunk, sz, ctl, 0UL, 0UL );
+
+    chunk = fd_dcache_compact_next( chunk, sz, chunk0, wmark );
+    seq   = fd_seq_inc( seq, 1UL );
+
+    while( rx_cnt<=j && recv_check( recv_fd, rx_cnt, src_ip, MSG_DONTWAIT ) ) rx_cnt++;
+  }
+
+  /* Receive the rest.  A ring stalled on slots left pending by a failed
+     kick times out here. */
+
+  for( ; rx_cnt<pkt_cnt; rx_cnt++ ) recv_check( recv_fd, rx_cnt, src_ip, 0 );
+
+  FD_LOG_INFO(( "Cleaning up" ));
+
+  FD_TEST( !fd_cnc_open( tx_cnc ) );
+  fd_cnc_signal( tx_cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( tx_cnc );
+  FD_TEST( fd_cnc_wait( tx_cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  fd_tile_exec_delete( tx_tile, NULL );
+
+  fdgen_tile_net_packet_tx_diag_t const * tx_diag = fd_cnc_app_laddr_const( tx_cnc );
+  FD_LOG_NOTICE(( "packet_tx: tx_cnt %lu kick_cnt %lu backp_cnt %lu filt_cnt %lu kick_err_cnt %lu",
+                  tx_diag->tx_cnt, tx_diag->kick_cnt, tx_diag->backp_cnt, tx_diag->filt_cnt, tx_diag->kick_err_cnt ));
+  FD_TEST( tx_diag->tx_cnt==pkt_cnt );
+  FD_TEST( !tx_diag->kick_err_cnt );
+
+  close( recv_fd );
+  fdgen_packet_tx_ring_fini( ring );
+  fd_wksp_free_laddr( fd_dcache_delete( fd_dcache_leave( dcache ) ) );
+  fd_wksp_free_laddr( fd_mcache_delete( fd_mcache_leave( mcache ) ) );
+  fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( tx_cnc ) ) );
+  fd_wksp_delete_anonymous( wksp );
+
+  FD_LOG_NOTICE(( "pass" ));
+  fd_halt();
+  return 0;
+}
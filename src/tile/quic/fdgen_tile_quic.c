@@ -0,0 +1,608 @@
+#include "fdgen_tile_quic.h"
+
+#include <assert.h>
+
+#include <firedancer/tango/fd_tango_base.h>
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+#include <firedancer/waltz/aio/fd_aio.h>
+#include <firedancer/ballet/ed25519/fd_ed25519.h>
+#include <firedancer/ballet/sha512/fd_sha512.h>
+
+/* Connection table ****************************************************
+
+   Each connection dialed by the tile occupies a slot, referenced by the
+   fd_quic conn context.  Free slots are kept on a stack.  Established
+   connections are additionally kept in a dense ready list (swap
+   removal), streams are opened round-robin over that list.  All
+   operations are O(1). */
+
+#define SLOT_STATE_FREE    (0)
+#define SLOT_STATE_HS      (1)  /* handshaking */
+#define SLOT_STATE_READY   (2)  /* established, on the ready list */
+#define SLOT_STATE_CLOSING (3)  /* closed by the tile, waiting for conn_final */
+
+struct quic_slot {
+  fd_quic_conn_t * conn;
+  long             ts;          /* tick at which the connection was dialed */
+  ulong            stream_cnt;  /* streams opened on this connection */
+  ulong            ready_idx;   /* index in the ready list if SLOT_STATE_READY */
+  int              state;
+};
+
+typedef struct quic_slot quic_slot_t;
+
+/* quic_ctx_t is the tile state shared with fd_quic callbacks */
+
+struct quic_ctx {
+
+  /* out frag stream state */
+  ulong            orig;
+  ulong            mtu;
+  fd_frag_meta_t * tx_mcache;
+  ulong            tx_depth;
+  ulong            tx_seq;
+  uchar *          tx_base;
+  ulong            tx_chunk0;
+  ulong            tx_wmark;
+  ulong            tx_chunk;
+
+  /* connection table */
+  quic_slot_t *    slot;
+  ulong *          free;        /* stack of free slot indices */
+  ulong            free_cnt;
+  ulong *          ready;       /* slot indices of established connections */
+  ulong            ready_cnt;
+
+  /* diag counters updated by callbacks, flushed during housekeeping */
+  ulong            tx_pub_cnt;
+  ulong            tx_pub_sz;
+  ulong            tx_filt_cnt;
+  ulong            hs_cnt;
+  ulong            hs_fail_cnt;
+  ulong            hs_lat_tick;
+  ulong            conn_close_cnt;
+  ulong            stream_done_cnt;
+  ulong            stream_fail_cnt;
+
+  /* TLS identity */
+  uchar            pub_key [ 32 ];
+  uchar            priv_key[ 32 ];
+  fd_sha512_t *    sha512;
+
+};
+
+typedef struct quic_ctx quic_ctx_t;
+
+FD_FN_CONST ulong
+fdgen_tile_quic_scratch_align( void ) {
+  return 128UL;  /* arbitrarily large */
+}
+
+FD_FN_CONST ulong
+fdgen_tile_quic_scratch_footprint( ulong conn_cnt,
+                                   ulong mtu ) {
+  ulong l = FD_LAYOUT_INIT;
+  l = FD_LAYOUT_APPEND( l, alignof(quic_slot_t),  conn_cnt*sizeof(quic_slot_t) );
+  l = FD_LAYOUT_APPEND( l, alignof(ulong),        conn_cnt*sizeof(ulong)       );
+  l = FD_LAYOUT_APPEND( l, alignof(ulong),        conn_cnt*sizeof(ulong)       );
+  l = FD_LAYOUT_APPEND( l, fd_sha512_align(),     fd_sha512_footprint()        );
+  l = FD_LAYOUT_APPEND( l, FD_CHUNK_ALIGN,        mtu                          );  /* rx frame copy */
+  l = FD_LAYOUT_APPEND( l, FD_CHUNK_ALIGN,        FDGEN_TILE_QUIC_STREAM_SZ_MAX );  /* stream payload */
+  return FD_LAYOUT_FINI( l, fdgen_tile_quic_scratch_align() );
+}
+
+static void
+quic_ready_remove( quic_ctx_t *  ctx,
+                   quic_slot_t * slot ) {
+  ulong idx  = slot->ready_idx;
+  ulong last = ctx->ready[ --ctx->ready_cnt ];
+  ctx->ready[ idx ]             = last;
+  ctx->slot [ last ].ready_idx  = idx;
+}
+
+/* fd_quic callbacks ***************************************************/
+
+static ulong
+quic_now( void * _ctx ) {
+  (void)_ctx;
+  return (ulong)fd_tickcount();
+}
+
+/* quic_tx publishes frames produced by fd_quic to the tx mcache */
+
+static int
+quic_tx( void *                    _ctx,
+         fd_aio_pkt_info_t const * batch,
+         ulong                     batch_cnt,
+         ulong *                   opt_batch_idx,
+         int                       flush ) {
+  (void)flush;
+  quic_ctx_t * ctx = _ctx;
+
+  ulong ts = fd_frag_meta_ts_comp( fd_tickcount() );
+  for( ulong j=0UL; j<batch_cnt; j++ ) {
+    ulong sz = batch[ j ].buf_sz;
+    if( FD_UNLIKELY( sz>ctx->mtu ) ) { ctx->tx_filt_cnt++; continue; }
+
+    fd_memcpy( fd_chunk_to_laddr( ctx->tx_base, ctx->tx_chunk ), batch[ j ].buf, sz );
+    ulong ctl = fd_frag_meta_ctl( ctx->orig, 1 /* som */, 1 /* eom */, 0 /* err */ );
+    fd_mcache_publish( ctx->tx_mcache, ctx->tx_depth, ctx->tx_seq, 0UL, ctx->tx_chunk, sz, ctl, ts, ts );
+
+    ctx->tx_chunk = fd_dcache_compact_next( ctx->tx_chunk, sz, ctx->tx_chunk0, ctx->tx_wmark );
+    ctx->tx_seq   = fd_seq_inc( ctx->tx_seq, 1UL );
+    ctx->tx_pub_cnt++;
+    ctx->tx_pub_sz += sz;
+  }
+
+  if( opt_batch_idx ) *opt_batch_idx = batch_cnt;
+  return FD_AIO_SUCCESS;
+}
+
+/* quic_sign signs TLS CertificateVerify payloads with the identity key */
+
+static void
+quic_sign( void *        _ctx,
+           uchar *       signature,
+           uchar const * payload ) {
+  quic_ctx_t * ctx = _ctx;
+  fd_ed25519_sign( signature, payload, 130UL, ctx->pub_key, ctx->priv_key, ctx->sha512 );
+}
+
+static void
+quic_conn_hs_complete( fd_quic_conn_t * conn,
+                       void *           _ctx ) {
+  quic_ctx_t *  ctx  = _ctx;
+  quic_slot_t * slot = fd_quic_conn_get_context( conn );
+  if( FD_UNLIKELY( !slot || slot->state!=SLOT_STATE_HS ) ) return;
+
+  ulong slot_idx = (ulong)( slot - ctx->slot );
+  slot->state     = SLOT_STATE_READY;
+  slot->ready_idx = ctx->ready_cnt;
+  ctx->ready[ ctx->ready_cnt++ ] = slot_idx;
+
+  ctx->hs_cnt++;
+  ctx->hs_lat_tick += (ulong)fd_long_max( fd_tickcount() - slot->ts, 0L );
+}
+
+static void
+quic_conn_final( fd_quic_conn_t * conn,
+                 void *           _ctx ) {
+  quic_ctx_t *  ctx  = _ctx;
+  quic_slot_t * slot = fd_quic_conn_get_context( conn );
+  if( FD_UNLIKELY( !slot ) ) return;
+
+  switch( slot->state ) {
+  case SLOT_STATE_HS:      ctx->hs_fail_cnt++;                                   break;
+  case SLOT_STATE_READY:   quic_ready_remove( ctx, slot ); ctx->conn_close_cnt++; break;
+  case SLOT_STATE_CLOSING: ctx->conn_close_cnt++;                                break;
+  default:                                                                       return;
+  }
+
+  fd_quic_conn_set_context( conn, NULL );
+  slot->conn  = NULL;
+  slot->state = SLOT_STATE_FREE;
+  ctx->free[ ctx->free_cnt++ ] = (ulong)( slot - ctx->slot );
+}
+
+static void
+quic_stream_notify( fd_quic_stream_t * stream,
+                    void *             _ctx,
+                    int                notify_type ) {
+  (void)stream;
+  quic_ctx_t * ctx = _ctx;
+  if( FD_LIKELY( notify_type==FD_QUIC_STREAM_NOTIFY_END ) ) ctx->stream_done_cnt++;
+  else                                                      ctx->stream_fail_cnt++;
+}
+
+int
+fdgen_tile_quic_run( fdgen_tile_quic_cfg_t * cfg ) {
+
+  if( FD_UNLIKELY( !cfg ) ) { FD_LOG_WARNING(( "NULL cfg" )); return 1; }
+
+  /* load config */
+
+  ulong            orig        = cfg->orig;
+  long             lazy        = cfg->lazy;
+  double           tick_per_ns = cfg->tick_per_ns;
+  ulong            mtu         = cfg->mtu;
+  fd_cnc_t *       cnc         = cfg->cnc;
+  fd_rng_t *       rng         = cfg->rng;
+  uchar *          rx_base     = cfg->rx_base;
+  fd_frag_meta_t * rx_mcache   = cfg->rx_mcache;
+  uchar *          tx_dcache   = cfg->tx_dcache;
+  fd_quic_t *      quic        = cfg->quic;
+  ulong            conn_cnt    = cfg->conn_cnt;
+  ulong            stream_sz   = cfg->stream_sz;
+
+  /* tile state shared with callbacks */
+  quic_ctx_t ctx[1];
+
+  /* cnc state */
+  fdgen_tile_quic_diag_t * cnc_diag;
+  ulong cnc_diag_rx_cnt;
+  ulong cnc_diag_rx_sz;
+  ulong cnc_diag_overnp_cnt;
+  ulong cnc_diag_rx_filt_cnt;
+  ulong cnc_diag_stream_cnt;
+  ulong cnc_diag_stream_fail_cnt;
+  ulong cnc_diag_stream_backp_cnt;
+
+  /* in frag stream state */
+  ulong   rx_depth;
+  ulong   rx_seq;
+  uchar * rx_buf;    /* frames are copied out of the dcache before fd_quic parses them */
+
+  /* out frag stream state */
+  ulong * tx_sync;
+
+  /* housekeeping state */
+  ulong async_min; /* minimum number of ticks between processing a housekeeping event, positive integer power of 2 */
+
+  /* fd_quic state */
+  fd_aio_t         tx_aio[1];
+  fd_aio_t const * rx_aio;
+
+  /* dial and stream pacing.  Buckets hold at most 1 ms worth of tokens,
+     costs are zero for unlimited buckets, so their checks always
+     pass. */
+  double conn_per_tick;
+  double conn_cost;
+  double conn_cap;
+  double conn_tok;
+  double stream_per_tick;
+  double stream_cost;
+  double stream_cap;
+  double stream_tok;
+
+  /* connection state */
+  ulong   conn_active;   /* slots in use */
+  ulong   dial_cnt;      /* connections dialed, selects the source port */
+  ulong   ready_cur;     /* round-robin cursor into the ready list */
+  ushort  src_port_cnt;
+  uchar * payload;
+
+  do {
+
+    FD_LOG_INFO(( "Booting quic" ));
+
+    /* scratch init */
+
+    if( FD_UNLIKELY( !conn_cnt ) ) { FD_LOG_WARNING(( "zero conn_cnt" )); return 1; }
+    if( FD_UNLIKELY( !mtu      ) ) { FD_LOG_WARNING(( "zero mtu"      )); return 1; }
+    if( FD_UNLIKELY( !cfg->scratch ) ) { FD_LOG_WARNING(( "NULL scratch" )); return 1; }
+    if( FD_UNLIKELY( !fd_ulong_is_aligned( (ulong)cfg->scratch, fdgen_tile_quic_scratch_align() ) ) ) {
+      FD_LOG_WARNING(( "misaligned scratch" ));
+      return 1;
+    }
+    if( FD_UNLIKELY( fdgen_tile_quic_scratch_footprint( conn_cnt, mtu )>cfg->scratch_sz ) ) {
+      FD_LOG_WARNING(( "undersz scratch region" ));
+      return 1;
+    }
+
+    FD_SCRATCH_ALLOC_INIT( scratch, cfg->scratch );
+    ctx->slot    = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(quic_slot_t), conn_cnt*sizeof(quic_slot_t) );
+    ctx->free    = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(ulong),       conn_cnt*sizeof(ulong)       );
+    ctx->ready   = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(ulong),       conn_cnt*sizeof(ulong)       );
+    void * sha   = FD_SCRATCH_ALLOC_APPEND( scratch, fd_sha512_align(),    fd_sha512_footprint()        );
+    rx_buf       = FD_SCRATCH_ALLOC_APPEND( scratch, FD_CHUNK_ALIGN,       mtu                          );
+    payload      = FD_SCRATCH_ALLOC_APPEND( scratch, FD_CHUNK_ALIGN,       FDGEN_TILE_QUIC_STREAM_SZ_MAX );
+
+    fd_memset( ctx->slot, 0, conn_cnt*sizeof(quic_slot_t) );
+    for( ulong j=0UL; j<conn_cnt; j++ ) ctx->free[ j ] = conn_cnt-1UL-j;  /* slot 0 on top */
+    ctx->free_cnt  = conn_cnt;
+    ctx->ready_cnt = 0UL;
+
+    /* cnc state init */
+
+    if( FD_UNLIKELY( !cnc ) ) { FD_LOG_WARNING(( "NULL cnc" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<sizeof(fdgen_tile_quic_diag_t) ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_signal_query( cnc )!=FD_CNC_SIGNAL_BOOT ) ) { FD_LOG_WARNING(( "already booted" )); return 1; }
+
+    cnc_diag = fd_cnc_app_laddr( cnc );
+
+    cnc_diag_rx_cnt           = 0UL;
+    cnc_diag_rx_sz            = 0UL;
+    cnc_diag_overnp_cnt       = 0UL;
+    cnc_diag_rx_filt_cnt      = 0UL;
+    cnc_diag_stream_cnt       = 0UL;
+    cnc_diag_stream_fail_cnt  = 0UL;
+    cnc_diag_stream_backp_cnt = 0UL;
+    ctx->tx_pub_cnt      = 0UL;
+    ctx->tx_pub_sz       = 0UL;
+    ctx->tx_filt_cnt     = 0UL;
+    ctx->hs_cnt          = 0UL;
+    ctx->hs_fail_cnt     = 0UL;
+    ctx->hs_lat_tick     = 0UL;
+    ctx->conn_close_cnt  = 0UL;
+    ctx->stream_done_cnt = 0UL;
+    ctx->stream_fail_cnt = 0UL;
+
+    /* in frag stream init */
+
+    if( FD_UNLIKELY( !rx_mcache ) ) { FD_LOG_WARNING(( "NULL rx_mcache" )); return 1; }
+    if( FD_UNLIKELY( !rx_base   ) ) { FD_LOG_WARNING(( "NULL rx_base"   )); return 1; }
+    rx_depth = fd_mcache_depth( rx_mcache );
+    rx_seq   = fd_mcache_seq_query( fd_mcache_seq_laddr( rx_mcache ) );
+
+    /* out frag stream init */
+
+    if( FD_UNLIKELY( !cfg->tx_mcache ) ) { FD_LOG_WARNING(( "NULL tx_mcache" )); return 1; }
+    if( FD_UNLIKELY( !tx_dcache      ) ) { FD_LOG_WARNING(( "NULL tx_dcache" )); return 1; }
+    if( FD_UNLIKELY( !cfg->tx_base   ) ) { FD_LOG_WARNING(( "NULL tx_base"   )); return 1; }
+    ctx->orig      = orig;
+    ctx->mtu       = mtu;
+    ctx->tx_mcache = cfg->tx_mcache;
+    ctx->tx_depth  = fd_mcache_depth( ctx->tx_mcache );
+    tx_sync        = fd_mcache_seq_laddr( ctx->tx_mcache );
+    ctx->tx_seq    = fd_mcache_seq_query( tx_sync );
+    ctx->tx_base   = cfg->tx_base;
+    if( FD_UNLIKELY( !fd_dcache_compact_is_safe( ctx->tx_base, tx_dcache, mtu, ctx->tx_depth ) ) ) {
+      FD_LOG_WARNING(( "tx_dcache not compatible with wksp base and tx_mcache depth" ));
+      return 1;
+    }
+    ctx->tx_chunk0 = fd_dcache_compact_chunk0( ctx->tx_base, tx_dcache );
+    ctx->tx_wmark  = fd_dcache_compact_wmark ( ctx->tx_base, tx_dcache, mtu );
+    ctx->tx_chunk  = ctx->tx_chunk0;
+
+    /* housekeeping init */
+
+    if( lazy<=0L ) lazy = fd_tempo_lazy_default( ctx->tx_depth );
+    FD_LOG_INFO(( "Configuring housekeeping (lazy %li ns)", lazy ));
+
+    async_min = fd_tempo_async_min( lazy, 1UL /*event_cnt*/, (float)tick_per_ns );
+    if( FD_UNLIKELY( !async_min ) ) { FD_LOG_WARNING(( "bad lazy" )); return 1; }
+
+    /* stream payload init */
+
+    if( FD_UNLIKELY( !stream_sz || stream_sz>FDGEN_TILE_QUIC_STREAM_SZ_MAX ) ) {
+      FD_LOG_WARNING(( "stream_sz %lu out of range [1,%lu]", stream_sz, FDGEN_TILE_QUIC_STREAM_SZ_MAX ));
+      return 1;
+    }
+    for( ulong j=0UL; j<FDGEN_TILE_QUIC_STREAM_SZ_MAX; j++ ) payload[ j ] = fd_rng_uchar( rng );
+
+    /* pacing init */
+
+    double tick_per_s = tick_per_ns*1e9;
+    conn_per_tick     = (double)cfg->conn_rate   / tick_per_s;
+    stream_per_tick   = (double)cfg->stream_rate / tick_per_s;
+    conn_cost         = cfg->conn_rate   ? 1.0 : 0.0;
+    stream_cost       = cfg->stream_rate ? 1.0 : 0.0;
+    conn_cap          = fd_ulong_max( cfg->conn_rate  /1000UL, 1UL ) * conn_cost;
+    stream_cap        = fd_ulong_max( cfg->stream_rate/1000UL, 1UL ) * stream_cost;
+    conn_tok          = conn_cap;
+    stream_tok        = stream_cap;
+
+    FD_LOG_INFO(( "Configuring load (conn_cnt %lu, conn_rate %lu, conn_stream_max %lu, stream_rate %lu, stream_sz %lu)",
+                  conn_cnt, cfg->conn_rate, cfg->conn_stream_max, cfg->stream_rate, stream_sz ));
+
+    /* TLS identity init.  Load tests need a distinct identity, not a
+       secure one, so the tile rng is good enough. */
+
+    ctx->sha512 = fd_sha512_join( fd_sha512_new( sha ) );
+    if( FD_UNLIKELY( !ctx->sha512 ) ) { FD_LOG_WARNING(( "fd_sha512_new failed" )); return 1; }
+    for( ulong j=0UL; j<32UL; j++ ) ctx->priv_key[ j ] = fd_rng_uchar( rng );
+    fd_ed25519_public_from_private( ctx->pub_key, ctx->priv_key, ctx->sha512 );
+
+    /* fd_quic init */
+
+    if( FD_UNLIKELY( !quic ) ) { FD_LOG_WARNING(( "NULL quic" )); return 1; }
+
+    fd_quic_config_t * quic_cfg = &quic->config;
+    quic_cfg->role        = FD_QUIC_ROLE_CLIENT;
+    quic_cfg->tick_per_us = tick_per_ns*1e3;
+    quic_cfg->sign        = quic_sign;
+    quic_cfg->sign_ctx    = ctx;
+    fd_memcpy( quic_cfg->identity_public_key, ctx->pub_key, 32UL );
+
+    quic->cb.quic_ctx         = ctx;
+    quic->cb.conn_hs_complete = quic_conn_hs_complete;
+    quic->cb.conn_final       = quic_conn_final;
+    quic->cb.stream_notify    = quic_stream_notify;
+    quic->cb.now              = quic_now;
+    quic->cb.now_ctx          = NULL;
+
+    fd_quic_set_aio_net_tx( quic, fd_aio_join( fd_aio_new( tx_aio, ctx, quic_tx ) ) );
+    if( FD_UNLIKELY( !fd_quic_init( quic ) ) ) { FD_LOG_WARNING(( "fd_quic_init failed" )); return 1; }
+    rx_aio = fd_quic_get_aio_net_rx( quic );
+
+    conn_active  = 0UL;
+    dial_cnt     = 0UL;
+    ready_cur    = 0UL;
+    src_port_cnt = (ushort)fd_ushort_max( cfg->src_port_cnt, 1 );
+
+    /* Sanity check that scratch allocations were within bounds */
+    assert( _scratch <= (ulong)cfg->scratch + cfg->scratch_sz );
+
+  } while(0);
+
+  FD_LOG_INFO(( "Running quic (orig %lu)", orig ));
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+  long  then       = fd_tickcount();
+  long  now        = then;
+  long  run0       = then;   /* tick of RUN, for achieved rates */
+  long  last       = then;   /* tick of last bucket refill */
+  ulong tot_hs     = 0UL;    /* handshakes since RUN */
+  ulong tot_stream = 0UL;    /* acknowledged streams since RUN */
+  for(;;) {
+    now = fd_tickcount();
+
+    /* Do housekeeping at a low rate in the background */
+
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
+      /* Publish flow control info */
+      fd_mcache_seq_update( tx_sync, ctx->tx_seq );
+
+      /* Send diagnostic info */
+      conn_active = conn_cnt - ctx->free_cnt;
+      tot_hs     += ctx->hs_cnt;
+      tot_stream += ctx->stream_done_cnt;
+      double run_ns = (double)fd_ulong_max( (ulong)( (double)( now-run0 ) / tick_per_ns ), 1UL );
+
+      fd_cnc_heartbeat( cnc, now );
+      FD_COMPILER_MFENCE();
+      cnc_diag->rx_cnt           += cnc_diag_rx_cnt;
+      cnc_diag->rx_sz            += cnc_diag_rx_sz;
+      cnc_diag->overnp_cnt       += cnc_diag_overnp_cnt;
+      cnc_diag->rx_filt_cnt      += cnc_diag_rx_filt_cnt;
+      cnc_diag->tx_pub_cnt       += ctx->tx_pub_cnt;
+      cnc_diag->tx_pub_sz        += ctx->tx_pub_sz;
+      cnc_diag->tx_filt_cnt      += ctx->tx_filt_cnt;
+      cnc_diag->conn_active       = conn_active;
+      cnc_diag->hs_cnt           += ctx->hs_cnt;
+      cnc_diag->hs_fail_cnt      += ctx->hs_fail_cnt;
+      cnc_diag->hs_lat_sum_ns    += (ulong)( (double)ctx->hs_lat_tick / tick_per_ns );
+      cnc_diag->conn_close_cnt   += ctx->conn_close_cnt;
+      cnc_diag->stream_cnt       += cnc_diag_stream_cnt;
+      cnc_diag->stream_done_cnt  += ctx->stream_done_cnt;
+      cnc_diag->stream_fail_cnt  += cnc_diag_stream_fail_cnt + ctx->stream_fail_cnt;
+      cnc_diag->stream_backp_cnt += cnc_diag_stream_backp_cnt;
+      cnc_diag->act_hs_ps         = (ulong)( (double)tot_hs     * 1e9 / run_ns );
+      cnc_diag->act_stream_ps     = (ulong)( (double)tot_stream * 1e9 / run_ns );
+      cnc_diag->act_goodput_bps   = (ulong)( (double)( tot_stream*stream_sz ) * 8. * 1e9 / run_ns );
+      FD_COMPILER_MFENCE();
+      cnc_diag_rx_cnt           = 0UL;
+      cnc_diag_rx_sz            = 0UL;
+      cnc_diag_overnp_cnt       = 0UL;
+      cnc_diag_rx_filt_cnt      = 0UL;
+      cnc_diag_stream_cnt       = 0UL;
+      cnc_diag_stream_fail_cnt  = 0UL;
+      cnc_diag_stream_backp_cnt = 0UL;
+      ctx->tx_pub_cnt      = 0UL;
+      ctx->tx_pub_sz       = 0UL;
+      ctx->tx_filt_cnt     = 0UL;
+      ctx->hs_cnt          = 0UL;
+      ctx->hs_fail_cnt     = 0UL;
+      ctx->hs_lat_tick     = 0UL;
+      ctx->conn_close_cnt  = 0UL;
+      ctx->stream_done_cnt = 0UL;
+      ctx->stream_fail_cnt = 0UL;
+
+      /* Receive command-and-control signals */
+      ulong s = fd_cnc_signal_query( cnc );
+      if( FD_UNLIKELY( s!=FD_CNC_SIGNAL_RUN ) ) {
+        if( FD_LIKELY( s==FD_CNC_SIGNAL_HALT ) ) break;
+        fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+      }
+
+      /* Reload housekeeping timer */
+      then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
+
+    /* Feed a received frame into fd_quic */
+
+    fd_frag_meta_t const * rx_mline = rx_mcache + fd_mcache_line_idx( rx_seq, rx_depth );
+
+    FD_COMPILER_MFENCE();
+    __m128i rx_mline_sse0 = _mm_load_si128( &rx_mline->sse0 );
+    FD_COMPILER_MFENCE();
+    __m128i rx_mline_sse1 = _mm_load_si128( &rx_mline->sse1 );
+    FD_COMPILER_MFENCE();
+
+    ulong rx_seq_found = fd_frag_meta_sse0_seq( rx_mline_sse0 );
+    long  rx_diff      = fd_seq_diff( rx_seq_found, rx_seq );
+    if( FD_UNLIKELY( rx_diff>0L ) ) {
+      cnc_diag_overnp_cnt++;
+      rx_seq = rx_seq_found;
+    } else if( rx_diff==0L ) {
+      /* Speculative copy, fd_quic may hold on to the frame across
+         service calls.  Frames larger than mtu are dropped rather than
+         truncated into corrupt datagrams. */
+      ulong sz = fd_frag_meta_sse1_sz( rx_mline_sse1 );
+      fd_memcpy( rx_buf, fd_chunk_to_laddr_const( rx_base, fd_frag_meta_sse1_chunk( rx_mline_sse1 ) ), fd_ulong_min( sz, mtu ) );
+      FD_COMPILER_MFENCE();
+
+      rx_seq_found = fd_frag_meta_seq_query( rx_mline );
+      if( FD_UNLIKELY( rx_seq_found!=rx_seq ) ) {
+        cnc_diag_overnp_cnt++;
+        rx_seq = rx_seq_found;
+      } else if( FD_UNLIKELY( sz>mtu ) ) {
+        cnc_diag_rx_filt_cnt++;
+        rx_seq = fd_seq_inc( rx_seq, 1UL );
+      } else {
+        fd_aio_pkt_info_t pkt = { .buf = rx_buf, .buf_sz = (ushort)sz };
+        fd_aio_send( rx_aio, &pkt, 1UL, NULL, 1 );
+        rx_seq = fd_seq_inc( rx_seq, 1UL );
+        cnc_diag_rx_cnt++;
+        cnc_diag_rx_sz += sz;
+      }
+    }
+
+    /* Run timers, retransmissions and ACKs */
+
+    fd_quic_service( quic );
+
+    /* Refill token buckets */
+
+    double dt = (double)( now-last );
+    last       = now;
+    conn_tok   = conn_tok   + dt*conn_per_tick;    conn_tok   = conn_tok  <conn_cap   ? conn_tok   : conn_cap;
+    stream_tok = stream_tok + dt*stream_per_tick;  stream_tok = stream_tok<stream_cap ? stream_tok : stream_cap;
+
+    /* Dial a new connection */
+
+    if( ctx->free_cnt && conn_tok>=conn_cost ) {
+      conn_tok -= conn_cost;
+
+      ulong            slot_idx = ctx->free[ --ctx->free_cnt ];
+      quic_slot_t *    slot     = ctx->slot + slot_idx;
+      ushort           src_port = (ushort)( cfg->src_port + dial_cnt % src_port_cnt );
+      dial_cnt++;
+      slot->state      = SLOT_STATE_HS;
+      slot->ts         = now;
+      slot->stream_cnt = 0UL;
+      fd_quic_conn_t * conn = fd_quic_connect( quic, cfg->dst_ip, cfg->dst_port, cfg->src_ip, src_port );
+      if( FD_UNLIKELY( !conn ) ) {
+        slot->state = SLOT_STATE_FREE;
+        ctx->free[ ctx->free_cnt++ ] = slot_idx;
+        ctx->hs_fail_cnt++;
+      } else {
+        slot->conn = conn;
+        fd_quic_conn_set_context( conn, slot );
+      }
+    }
+
+    /* Open a stream on the next established connection */
+
+    if( ctx->ready_cnt && stream_tok>=stream_cost ) {
+      if( ready_cur>=ctx->ready_cnt ) ready_cur = 0UL;
+      quic_slot_t *      slot   = ctx->slot + ctx->ready[ ready_cur++ ];
+      fd_quic_stream_t * stream = fd_quic_conn_new_stream( slot->conn );
+      if( FD_UNLIKELY( !stream ) ) {
+        cnc_diag_stream_backp_cnt++;
+        continue;
+      }
+      stream_tok -= stream_cost;
+
+      fd_quic_stream_set_context( stream, ctx );
+      if( FD_UNLIKELY( fd_quic_stream_send( stream, payload, stream_sz, 1 /* fin */ )!=FD_QUIC_SUCCESS ) ) {
+        cnc_diag_stream_fail_cnt++;
+      }
+      cnc_diag_stream_cnt++;
+
+      /* Replace connections that carried enough streams */
+      if( FD_UNLIKELY( ++slot->stream_cnt==cfg->conn_stream_max ) ) {
+        quic_ready_remove( ctx, slot );
+        slot->state = SLOT_STATE_CLOSING;
+        fd_quic_conn_close( slot->conn, 0U );
+      }
+    }
+  }
+
+  do {
+
+    /* Tear down all connections so quic can be initialized again */
+    fd_quic_fini( quic );
+    fd_sha512_delete( fd_sha512_leave( ctx->sha512 ) );
+
+    fd_mcache_seq_update( tx_sync, ctx->tx_seq );
+
+    FD_LOG_INFO(( "Halted quic" ));
+    fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
+
+  } while(0);
+
+  return 0;
+}
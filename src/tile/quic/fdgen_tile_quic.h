@@ -0,0 +1,134 @@
+#pragma once
+
+/* The quic tile is a QUIC client load generator built on fd_quic.  It
+   holds many client connections to one server and opens streams on
+   them at a configured rate.
+
+   fd_quic runs entirely in user space on top of fd_tango: frames
+   produced by fd_quic are published onto the tx_{mcache,dcache} pair
+   for a transmit tile (net_dgram_tx, net_packet_tx, net_dgram_rxtx,
+   ...), frames published by a receive tile (net_xsk_rx, net_dgram_rxtx,
+   net_packet_rx, ...) onto rx_mcache are fed back into fd_quic.  Frames
+   are Ethernet/IPv4/UDP in both directions.  Connections do not own
+   sockets or file descriptors, so thousands of connections cost no
+   per-connection syscalls.  tx_mcache is in unreliable mode.
+
+   # Connections
+
+   The tile keeps up to conn_cnt connections open to dst_ip:dst_port.
+   New connections are dialed at up to conn_rate per second, from
+   src_ip and a source port cycling through
+   [src_port,src_port+src_port_cnt).  After conn_stream_max streams, a
+   connection is closed and replaced, which turns the tile into a
+   steady source of handshakes.  Connections that fail or time out
+   are replaced too.
+
+   # Streams
+
+   Streams are opened round-robin over established connections at up to
+   stream_rate per second.  Each stream carries stream_sz bytes of
+   random payload and is finished immediately (like a TPU transaction).
+   A stream counts towards goodput once the server acknowledged all of
+   its data.
+
+   # Setup
+
+   The caller creates and joins quic with its limits, and sets any
+   config fields it cares about (idle timeout, stream data limits,
+   link and net addresses).  The tile sets the client role, a random
+   TLS identity, the callbacks and the tx aio, then initializes quic.
+   quic is finalized when the tile halts, so it may be run again.
+
+   The cnc diag reports counters and the handshake, stream and goodput
+   rates achieved since RUN. */
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/waltz/quic/fd_quic.h>
+
+/* FDGEN_TILE_QUIC_STREAM_SZ_MAX is the largest supported stream
+   payload (Solana transaction MTU) */
+
+#define FDGEN_TILE_QUIC_STREAM_SZ_MAX (1232UL)
+
+struct fdgen_tile_quic_diag {
+  ulong rx_cnt;
+  ulong rx_sz;
+  ulong overnp_cnt;
+  ulong rx_filt_cnt;       /* received frames larger than mtu, dropped */
+  ulong tx_pub_cnt;
+  ulong tx_pub_sz;
+  ulong tx_filt_cnt;       /* frames from fd_quic larger than mtu */
+  ulong conn_active;       /* connections handshaking or established */
+  ulong hs_cnt;            /* completed handshakes */
+  ulong hs_fail_cnt;       /* connections that failed before completing the handshake */
+  ulong hs_lat_sum_ns;     /* sum of handshake latencies */
+  ulong conn_close_cnt;    /* connections closed after completing the handshake */
+  ulong stream_cnt;        /* streams opened */
+  ulong stream_done_cnt;   /* streams fully acknowledged by the server */
+  ulong stream_fail_cnt;   /* streams rejected or aborted */
+  ulong stream_backp_cnt;  /* stream opens refused by the server's stream limit */
+  ulong act_hs_ps;         /* handshakes per second since RUN */
+  ulong act_stream_ps;     /* acknowledged streams per second since RUN */
+  ulong act_goodput_bps;   /* acknowledged stream payload bits per second since RUN */
+};
+
+typedef struct fdgen_tile_quic_diag fdgen_tile_quic_diag_t;
+
+/* fdgen_tile_quic_cfg_t holds config and local joins required by the
+   quic tile. */
+
+struct fdgen_tile_quic_cfg {
+
+  ulong            orig;
+  long             lazy;
+  double           tick_per_ns;
+  ulong            mtu;
+
+  fd_rng_t *       rng;
+  fd_cnc_t *       cnc;
+  uchar *          rx_base;
+  fd_frag_meta_t * rx_mcache;  /* net -> quic frags */
+  uchar *          tx_base;
+  fd_frag_meta_t * tx_mcache;  /* quic -> net frags */
+  uchar *          tx_dcache;
+
+  fd_quic_t *      quic;       /* joined, not initialized */
+
+  ulong  conn_cnt;         /* connections kept open, at most the quic conn limit */
+  ulong  conn_rate;        /* new connections per second, 0 for unlimited */
+  ulong  conn_stream_max;  /* streams per connection before it is replaced, 0 for unlimited */
+  ulong  stream_rate;      /* streams per second, 0 for unlimited */
+  ulong  stream_sz;        /* payload bytes per stream, in [1,FDGEN_TILE_QUIC_STREAM_SZ_MAX] */
+
+  uint   src_ip;           /* net order */
+  ushort src_port;         /* host order, first source port */
+  ushort src_port_cnt;     /* source ports to cycle through, 0 for 1 */
+  uint   dst_ip;           /* net order */
+  ushort dst_port;         /* host order */
+
+  void * scratch;          /* connection table and buffers, see fdgen_tile_quic_scratch_footprint */
+  ulong  scratch_sz;
+
+};
+
+typedef struct fdgen_tile_quic_cfg fdgen_tile_quic_cfg_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_quic_scratch_{align,footprint} specify parameters of the
+   scratch memory region for up to conn_cnt connections and frames of
+   up to mtu bytes. */
+
+FD_FN_CONST ulong
+fdgen_tile_quic_scratch_align( void );
+
+FD_FN_CONST ulong
+fdgen_tile_quic_scratch_footprint( ulong conn_cnt,
+                                   ulong mtu );
+
+/* fdgen_tile_quic_run enters the tile main loop. */
+
+int
+fdgen_tile_quic_run( fdgen_tile_quic_cfg_t * cfg );
+
+FD_PROTOTYPES_END
@@ -0,0 +1,453 @@
+#include "fdgen_tile_quic_storm.h"
+
+#include <assert.h>
+
+#include <firedancer/tango/fd_tango_base.h>
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+#include <firedancer/waltz/aio/fd_aio.h>
+#include <firedancer/ballet/ed25519/fd_ed25519.h>
+#include <firedancer/ballet/sha512/fd_sha512.h>
+#include <firedancer/util/net/fd_eth.h>
+#include <firedancer/util/net/fd_ip4.h>
+#include <firedancer/util/net/fd_udp.h>
+
+/* STORM_HDR_SZ is the size of the Ethernet, IPv4 (no options) and UDP
+   headers in front of QUIC packets */
+
+#define STORM_HDR_SZ (42UL)
+
+/* STORM_SERVICE_MAX bounds the fd_quic service calls waiting for the
+   Initial of a new connection */
+
+#define STORM_SERVICE_MAX (1000UL)
+
+/* Pool fill ***********************************************************/
+
+struct storm_fill {
+  fdgen_tile_gen_pool_t * pool;
+  int                     want;  /* 1 while waiting for the Initial of the last connection */
+
+  uchar                   pub_key [ 32 ];
+  uchar                   priv_key[ 32 ];
+  fd_sha512_t *           sha512;
+};
+
+typedef struct storm_fill storm_fill_t;
+
+static ulong
+storm_fill_now( void * _ctx ) {
+  (void)_ctx;
+  return (ulong)fd_tickcount();
+}
+
+/* storm_fill_tx captures the first Initial of each new connection */
+
+static int
+storm_fill_tx( void *                    _ctx,
+               fd_aio_pkt_info_t const * batch,
+               ulong                     batch_cnt,
+               ulong *                   opt_batch_idx,
+               int                       flush ) {
+  (void)flush;
+  storm_fill_t * fill = _ctx;
+  for( ulong j=0UL; j<batch_cnt && fill->want; j++ ) {
+    uchar const *        frame   = batch[ j ].buf;
+    ulong                sz      = batch[ j ].buf_sz;
+    fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( frame+14 );
+    if( FD_UNLIKELY( sz<=STORM_HDR_SZ || ip4_hdr->verihl!=FD_IP4_VERIHL( 4, 5 ) ) ) continue;
+
+    ulong dcid, pkt_sz;
+    if( fdgen_quic_pkt_parse( frame+STORM_HDR_SZ, sz-STORM_HDR_SZ, &dcid, &pkt_sz )!=FDGEN_QUIC_PKT_TYPE_INITIAL ) continue;
+
+    uchar * slot = fdgen_tile_gen_pool_append( fill->pool, sz );
+    if( FD_UNLIKELY( !slot ) ) continue;
+    fd_memcpy( slot, frame, sz );
+    fill->want = 0;
+  }
+  if( opt_batch_idx ) *opt_batch_idx = batch_cnt;
+  return FD_AIO_SUCCESS;
+}
+
+static void
+storm_fill_sign( void *        _ctx,
+                 uchar *       signature,
+                 uchar const * payload ) {
+  storm_fill_t * fill = _ctx;
+  fd_ed25519_sign( signature, payload, 130UL, fill->pub_key, fill->priv_key, fill->sha512 );
+}
+
+ulong
+fdgen_tile_quic_storm_pool_fill( fdgen_tile_gen_pool_t * pool,
+                                 fd_quic_t *             quic,
+                                 fd_rng_t *              rng,
+                                 double                  tick_per_ns,
+                                 uint                    src_ip,
+                                 ushort                  src_port,
+                                 uint                    dst_ip,
+                                 ushort                  dst_port ) {
+
+  if( FD_UNLIKELY( !pool ) ) { FD_LOG_WARNING(( "NULL pool" )); return 0UL; }
+  if( FD_UNLIKELY( !quic ) ) { FD_LOG_WARNING(( "NULL quic" )); return 0UL; }
+
+  ulong batch = quic->limits.conn_cnt;
+  if( FD_UNLIKELY( !batch ) ) { FD_LOG_WARNING(( "zero quic conn limit" )); return 0UL; }
+
+  storm_fill_t fill[1];
+  fill->pool = pool;
+  fill->want = 0;
+
+  fd_sha512_t _sha512[1];
+  fill->sha512 = fd_sha512_join( fd_sha512_new( _sha512 ) );
+  for( ulong j=0UL; j<32UL; j++ ) fill->priv_key[ j ] = fd_rng_uchar( rng );
+  fd_ed25519_public_from_private( fill->pub_key, fill->priv_key, fill->sha512 );
+
+  fd_quic_config_t * quic_cfg = &quic->config;
+  quic_cfg->role        = FD_QUIC_ROLE_CLIENT;
+  quic_cfg->tick_per_us = tick_per_ns*1e3;
+  quic_cfg->sign        = storm_fill_sign;
+  quic_cfg->sign_ctx    = fill;
+  fd_memcpy( quic_cfg->identity_public_key, fill->pub_key, 32UL );
+
+  quic->cb.quic_ctx = fill;
+  quic->cb.now      = storm_fill_now;
+  quic->cb.now_ctx  = NULL;
+
+  fd_aio_t _tx_aio[1];
+  fd_quic_set_aio_net_tx( quic, fd_aio_join( fd_aio_new( _tx_aio, fill, storm_fill_tx ) ) );
+
+  /* Dial connections in batches of the conn limit.  Each connection
+     sends its Initial on the next service call, it is captured and the
+     connection is left idle.  Finalizing quic drops the batch without
+     sending anything further. */
+
+  ulong frame_cnt0 = pool->frame_cnt;
+  ulong fail       = 0UL;
+  long  t0         = fd_log_wallclock();
+  while( pool->frame_cnt<pool->frame_max && !fail ) {
+    if( FD_UNLIKELY( !fd_quic_init( quic ) ) ) { FD_LOG_WARNING(( "fd_quic_init failed" )); fail = 1UL; break; }
+
+    for( ulong k=0UL; k<batch && pool->frame_cnt<pool->frame_max; k++ ) {
+      fill->want = 1;
+      if( FD_UNLIKELY( !fd_quic_connect( quic, dst_ip, dst_port, src_ip, src_port ) ) ) {
+        FD_LOG_WARNING(( "fd_quic_connect failed" ));
+        fail = 1UL;
+        break;
+      }
+      for( ulong i=0UL; i<STORM_SERVICE_MAX && fill->want; i++ ) fd_quic_service( quic );
+      if( FD_UNLIKELY( fill->want ) ) {
+        FD_LOG_WARNING(( "no Initial from new connection" ));
+        fail = 1UL;
+        break;
+      }
+    }
+
+    fd_quic_fini( quic );
+  }
+  long dt = fd_log_wallclock() - t0;
+
+  fd_sha512_delete( fd_sha512_leave( fill->sha512 ) );
+  if( FD_UNLIKELY( fail ) ) return 0UL;
+
+  ulong fill_cnt = pool->frame_cnt - frame_cnt0;
+  FD_LOG_NOTICE(( "Built %lu QUIC Initials in %.3f s (%.1f us each), pool %lu bytes",
+                  fill_cnt, (double)dt*1e-9, (double)dt*1e-3/(double)fd_ulong_max( fill_cnt, 1UL ),
+                  fdgen_tile_gen_pool_footprint( pool->frame_max, pool->stride ) ));
+  return fill_cnt;
+}
+
+/* RX side *************************************************************
+
+   Pool frames are mapped by the source connection ID of their Initial
+   in an open addressing hash table with linear probing, sized to a
+   load factor of at most 1/2.  Key 0 marks empty entries (a random
+   connection ID of 0 is not tracked). */
+
+struct storm_map_entry {
+  ulong cid;
+  ulong tmpl_idx;
+};
+
+typedef struct storm_map_entry storm_map_entry_t;
+
+static ulong
+storm_map_cnt( ulong frame_cnt ) {
+  return fd_ulong_pow2_up( fd_ulong_max( 2UL*frame_cnt, 2UL ) );
+}
+
+FD_FN_CONST ulong
+fdgen_tile_quic_storm_rx_scratch_align( void ) {
+  return 128UL;  /* arbitrarily large */
+}
+
+FD_FN_CONST ulong
+fdgen_tile_quic_storm_rx_scratch_footprint( ulong frame_cnt ) {
+  ulong l = FD_LAYOUT_INIT;
+  l = FD_LAYOUT_APPEND( l, alignof(storm_map_entry_t), storm_map_cnt( frame_cnt )*sizeof(storm_map_entry_t) );
+  l = FD_LAYOUT_APPEND( l, alignof(ulong),             ( ( frame_cnt+63UL )>>6 )*sizeof(ulong)             );
+  return FD_LAYOUT_FINI( l, fdgen_tile_quic_storm_rx_scratch_align() );
+}
+
+static inline storm_map_entry_t *
+storm_map_query( storm_map_entry_t * map,
+                 ulong               mask,
+                 ulong               cid ) {
+  ulong idx = fd_ulong_hash( cid ) & mask;
+  for(;;) {
+    storm_map_entry_t * e = map + idx;
+    if( e->cid==cid || !e->cid ) return e;
+    idx = ( idx+1UL ) & mask;
+  }
+}
+
+int
+fdgen_tile_quic_storm_rx_run( fdgen_tile_quic_storm_rx_cfg_t * cfg ) {
+
+  if( FD_UNLIKELY( !cfg ) ) { FD_LOG_WARNING(( "NULL cfg" )); return 1; }
+
+  /* load config */
+
+  long             lazy        = cfg->lazy;
+  double           tick_per_ns = cfg->tick_per_ns;
+  fd_cnc_t *       cnc         = cfg->cnc;
+  fd_rng_t *       rng         = cfg->rng;
+  uchar *          rx_base     = cfg->rx_base;
+  fd_frag_meta_t * rx_mcache   = cfg->rx_mcache;
+
+  fdgen_tile_gen_pool_t const * pool = cfg->pool;
+
+  /* cnc state */
+  fdgen_tile_quic_storm_rx_diag_t * cnc_diag;
+  ulong cnc_diag_rx_cnt;
+  ulong cnc_diag_rx_sz;
+  ulong cnc_diag_overnp_cnt;
+  ulong cnc_diag_filt_cnt;
+  ulong cnc_diag_pkt_cnt[ FDGEN_QUIC_PKT_TYPE_CNT ];
+  ulong cnc_diag_unmatched_cnt;
+  ulong cnc_diag_hs_cnt;
+  ulong cnc_diag_hs_tmpl_cnt;
+
+  /* in frag stream state */
+  ulong rx_depth;
+  ulong rx_seq;
+
+  /* housekeeping state */
+  ulong async_min; /* minimum number of ticks between processing a housekeeping event, positive integer power of 2 */
+
+  /* connection ID map */
+  storm_map_entry_t * map;
+  ulong               map_mask;
+  ulong *             hs_seen;  /* bit per pool frame, set on its first handshake flight */
+
+  do {
+
+    FD_LOG_INFO(( "Booting quic_storm_rx" ));
+
+    /* cnc state init */
+
+    if( FD_UNLIKELY( !cnc ) ) { FD_LOG_WARNING(( "NULL cnc" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_app_sz( cnc )<sizeof(fdgen_tile_quic_storm_rx_diag_t) ) ) { FD_LOG_WARNING(( "undersz cnc diag" )); return 1; }
+    if( FD_UNLIKELY( fd_cnc_signal_query( cnc )!=FD_CNC_SIGNAL_BOOT ) ) { FD_LOG_WARNING(( "already booted" )); return 1; }
+
+    cnc_diag = fd_cnc_app_laddr( cnc );
+
+    cnc_diag_rx_cnt        = 0UL;
+    cnc_diag_rx_sz         = 0UL;
+    cnc_diag_overnp_cnt    = 0UL;
+    cnc_diag_filt_cnt      = 0UL;
+    cnc_diag_unmatched_cnt = 0UL;
+    cnc_diag_hs_cnt        = 0UL;
+    cnc_diag_hs_tmpl_cnt   = 0UL;
+    fd_memset( cnc_diag_pkt_cnt, 0, sizeof(cnc_diag_pkt_cnt) );
+
+    /* in frag stream init */
+
+    if( FD_UNLIKELY( !rx_mcache ) ) { FD_LOG_WARNING(( "NULL rx_mcache" )); return 1; }
+    if( FD_UNLIKELY( !rx_base   ) ) { FD_LOG_WARNING(( "NULL rx_base"   )); return 1; }
+    rx_depth = fd_mcache_depth( rx_mcache );
+    rx_seq   = fd_mcache_seq_query( fd_mcache_seq_laddr( rx_mcache ) );
+
+    /* connection ID map init */
+
+    if( FD_UNLIKELY( !pool ) ) { FD_LOG_WARNING(( "NULL pool" )); return 1; }
+    ulong frame_cnt = pool->frame_cnt;
+    if( FD_UNLIKELY( !cfg->scratch ) ) { FD_LOG_WARNING(( "NULL scratch" )); return 1; }
+    if( FD_UNLIKELY( fdgen_tile_quic_storm_rx_scratch_footprint( frame_cnt )>cfg->scratch_sz ) ) {
+      FD_LOG_WARNING(( "undersz scratch region" ));
+      return 1;
+    }
+
+    FD_SCRATCH_ALLOC_INIT( scratch, cfg->scratch );
+    ulong map_cnt = storm_map_cnt( frame_cnt );
+    map      = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(storm_map_entry_t), map_cnt*sizeof(storm_map_entry_t)     );
+    hs_seen  = FD_SCRATCH_ALLOC_APPEND( scratch, alignof(ulong),             ( ( frame_cnt+63UL )>>6 )*sizeof(ulong) );
+    map_mask = map_cnt-1UL;
+    fd_memset( map,     0, map_cnt*sizeof(storm_map_entry_t)       );
+    fd_memset( hs_seen, 0, ( ( frame_cnt+63UL )>>6 )*sizeof(ulong) );
+
+    ulong map_key_cnt = 0UL;
+    for( ulong j=0UL; j<frame_cnt; j++ ) {
+      ulong         sz    = fdgen_tile_gen_pool_sz( pool, j );
+      uchar const * quic  = fdgen_tile_gen_pool_frame( pool, j ) + STORM_HDR_SZ;
+      if( FD_UNLIKELY( sz<STORM_HDR_SZ+7UL || !( quic[0] & 0x80 ) ) ) continue;
+      ulong dcid_len = quic[5];
+      if( FD_UNLIKELY( sz<STORM_HDR_SZ+7UL+dcid_len+FDGEN_QUIC_CID_SZ || quic[6+dcid_len]!=FDGEN_QUIC_CID_SZ ) ) continue;
+      ulong scid = FD_LOAD( ulong, quic+7UL+dcid_len );
+      if( FD_UNLIKELY( !scid ) ) continue;
+      storm_map_entry_t * e = storm_map_query( map, map_mask, scid );
+      if( FD_UNLIKELY( e->cid ) ) continue;  /* duplicate */
+      e->cid      = scid;
+      e->tmpl_idx = j;
+      map_key_cnt++;
+    }
+    FD_LOG_INFO(( "Tracking %lu of %lu pool connection IDs", map_key_cnt, frame_cnt ));
+
+    /* housekeeping init */
+
+    if( lazy<=0L ) lazy = fd_tempo_lazy_default( rx_depth );
+    FD_LOG_INFO(( "Configuring housekeeping (lazy %li ns)", lazy ));
+
+    async_min = fd_tempo_async_min( lazy, 1UL /*event_cnt*/, (float)tick_per_ns );
+    if( FD_UNLIKELY( !async_min ) ) { FD_LOG_WARNING(( "bad lazy" )); return 1; }
+
+    /* Sanity check that scratch allocations were within bounds */
+    assert( _scratch <= (ulong)cfg->scratch + cfg->scratch_sz );
+
+  } while(0);
+
+  FD_LOG_INFO(( "Running quic_storm_rx" ));
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+  long  then   = fd_tickcount();
+  long  now    = then;
+  long  run0   = then;   /* tick of RUN, for achieved rates */
+  ulong tot_hs = 0UL;    /* handshake flights since RUN */
+  for(;;) {
+    now = fd_tickcount();
+
+    /* Do housekeeping at a low rate in the background */
+
+    if( FD_UNLIKELY( (now-then)>=0L ) ) {
+      /* Send diagnostic info */
+      tot_hs += cnc_diag_hs_cnt;
+      double run_ns = (double)fd_ulong_max( (ulong)( (double)( now-run0 ) / tick_per_ns ), 1UL );
+
+      fd_cnc_heartbeat( cnc, now );
+      FD_COMPILER_MFENCE();
+      cnc_diag->rx_cnt        += cnc_diag_rx_cnt;
+      cnc_diag->rx_sz         += cnc_diag_rx_sz;
+      cnc_diag->overnp_cnt    += cnc_diag_overnp_cnt;
+      cnc_diag->filt_cnt      += cnc_diag_filt_cnt;
+      for( ulong j=0UL; j<FDGEN_QUIC_PKT_TYPE_CNT; j++ ) cnc_diag->pkt_cnt[ j ] += cnc_diag_pkt_cnt[ j ];
+      cnc_diag->unmatched_cnt += cnc_diag_unmatched_cnt;
+      cnc_diag->hs_cnt        += cnc_diag_hs_cnt;
+      cnc_diag->hs_tmpl_cnt   += cnc_diag_hs_tmpl_cnt;
+      cnc_diag->act_hs_ps      = (ulong)( (double)tot_hs * 1e9 / run_ns );
+      FD_COMPILER_MFENCE();
+      cnc_diag_rx_cnt        = 0UL;
+      cnc_diag_rx_sz         = 0UL;
+      cnc_diag_overnp_cnt    = 0UL;
+      cnc_diag_filt_cnt      = 0UL;
+      cnc_diag_unmatched_cnt = 0UL;
+      cnc_diag_hs_cnt        = 0UL;
+      cnc_diag_hs_tmpl_cnt   = 0UL;
+      fd_memset( cnc_diag_pkt_cnt, 0, sizeof(cnc_diag_pkt_cnt) );
+
+      /* Receive command-and-control signals */
+      ulong s = fd_cnc_signal_query( cnc );
+      if( FD_UNLIKELY( s!=FD_CNC_SIGNAL_RUN ) ) {
+        if( FD_LIKELY( s==FD_CNC_SIGNAL_HALT ) ) break;
+        fd_cnc_signal( cnc, FD_CNC_SIGNAL_RUN );
+      }
+
+      /* Reload housekeeping timer */
+      then = now + (long)fd_tempo_async_reload( rng, async_min );
+    }
+
+    /* Check if there is a new incoming frame */
+
+    fd_frag_meta_t const * rx_mline = rx_mcache + fd_mcache_line_idx( rx_seq, rx_depth );
+
+    FD_COMPILER_MFENCE();
+    __m128i rx_mline_sse0 = _mm_load_si128( &rx_mline->sse0 );
+    FD_COMPILER_MFENCE();
+    __m128i rx_mline_sse1 = _mm_load_si128( &rx_mline->sse1 );
+    FD_COMPILER_MFENCE();
+
+    ulong rx_seq_found = fd_frag_meta_sse0_seq( rx_mline_sse0 );
+    long  rx_diff      = fd_seq_diff( rx_seq_found, rx_seq );
+    if( FD_UNLIKELY( rx_diff>0L ) ) {
+      cnc_diag_overnp_cnt++;
+      rx_seq = rx_seq_found;
+      continue;
+    }
+    if( rx_diff<0L ) {
+      FD_SPIN_PAUSE();
+      continue;
+    }
+
+    /* Classify the QUIC packets of the datagram with speculative reads,
+       counted only if the frag was not overrun meanwhile */
+
+    ulong                sz      = fd_frag_meta_sse1_sz( rx_mline_sse1 );
+    uchar const *        frame   = fd_chunk_to_laddr_const( rx_base, fd_frag_meta_sse1_chunk( rx_mline_sse1 ) );
+    fd_eth_hdr_t const * eth_hdr = fd_type_pun_const( frame    );
+    fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( frame+14 );
+
+    ulong pkt_cnt[ FDGEN_QUIC_PKT_TYPE_CNT ] = {0};
+    ulong dcid0 = 0UL;  /* DCID of the first packet */
+    int   valid = ( sz>STORM_HDR_SZ ) &&
+                  ( eth_hdr->net_type==fd_ushort_bswap( FD_ETH_HDR_TYPE_IP ) ) &&
+                  ( ip4_hdr->verihl==FD_IP4_VERIHL( 4, 5 ) ) &&
+                  ( ip4_hdr->protocol==FD_IP4_HDR_PROTOCOL_UDP );
+    if( FD_LIKELY( valid ) ) {
+      uchar const * cur = frame + STORM_HDR_SZ;
+      ulong         rem = sz - STORM_HDR_SZ;
+      for( ulong k=0UL; rem && k<4UL; k++ ) {  /* at most one packet per encryption level */
+        ulong dcid, pkt_sz;
+        int   type = fdgen_quic_pkt_parse( cur, rem, &dcid, &pkt_sz );
+        if( FD_UNLIKELY( type<0 ) ) { valid = k>0UL; break; }
+        if( !k ) dcid0 = dcid;
+        pkt_cnt[ type ]++;
+        cur += pkt_sz;
+        rem -= pkt_sz;
+      }
+    }
+
+    FD_COMPILER_MFENCE();
+    rx_seq_found = fd_frag_meta_seq_query( rx_mline );
+    if( FD_UNLIKELY( rx_seq_found!=rx_seq ) ) {
+      cnc_diag_overnp_cnt++;
+      rx_seq = rx_seq_found;
+      continue;
+    }
+    rx_seq = fd_seq_inc( rx_seq, 1UL );
+    cnc_diag_rx_cnt++;
+    cnc_diag_rx_sz += sz;
+
+    if( FD_UNLIKELY( !valid ) ) { cnc_diag_filt_cnt++; continue; }
+    for( ulong j=0UL; j<FDGEN_QUIC_PKT_TYPE_CNT; j++ ) cnc_diag_pkt_cnt[ j ] += pkt_cnt[ j ];
+
+    /* Map back to the pool frame */
+
+    storm_map_entry_t const * e = dcid0 ? storm_map_query( map, map_mask, dcid0 ) : NULL;
+    if( FD_UNLIKELY( !e || !e->cid ) ) { cnc_diag_unmatched_cnt++; continue; }
+
+    if( pkt_cnt[ FDGEN_QUIC_PKT_TYPE_HANDSHAKE ] ) {
+      ulong idx = e->tmpl_idx;
+      ulong bit = 1UL<<( idx & 63UL );
+      cnc_diag_hs_cnt++;
+      cnc_diag_hs_tmpl_cnt += (ulong)!( hs_seen[ idx>>6 ] & bit );
+      hs_seen[ idx>>6 ] |= bit;
+    }
+  }
+
+  do {
+
+    FD_LOG_INFO(( "Halted quic_storm_rx" ));
+    fd_cnc_signal( cnc, FD_CNC_SIGNAL_BOOT );
+
+  } while(0);
+
+  return 0;
+}
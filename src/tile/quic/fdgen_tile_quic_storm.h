@@ -0,0 +1,193 @@
+#pragma once
+
+/* fdgen_tile_quic_storm.h provides a QUIC handshake storm: a flood of
+   client Initial packets from many distinct connection IDs and source
+   tuples, measuring how many new connections a server can set up.
+
+   # TX side
+
+   QUIC Initial packets are protected with keys derived from their
+   destination connection ID, and the connection IDs and packet number
+   are covered by the AEAD tag and header protection.  Patching them per
+   packet would require encrypting every packet.  Instead,
+   fdgen_tile_quic_storm_pool_fill captures real client Initials (TLS
+   ClientHello, padded to 1200 bytes) from an fd_quic client at boot,
+   each with fresh random connection IDs and key share, into a frame
+   pool (fdgen_tile_gen_pool.h).  The gen tile then replays the pool at
+   the target rate, patching the source address and port of each frame
+   from a flow set, which lives outside the encryption.  A pool of N
+   Initials replayed over a flow set of M source tuples yields up to N
+   distinct connection IDs, and as many distinct 4-tuples as there are
+   flows.  No client state machine runs while the storm is on.
+
+   # RX side (optional)
+
+   The storm_rx tile consumes server responses and classifies the QUIC
+   packets of each datagram (coalesced packets are walked).  Server
+   packets are addressed to the source connection ID of a pool Initial,
+   which maps them back to the pool frame.  The server cannot complete
+   a handshake without the client's Finished, so the tile counts
+   handshake flights instead: datagrams carrying a Handshake packet,
+   i.e. the server accepted the Initial, created connection state and
+   sent its certificate.  The number of distinct pool frames that got a
+   handshake flight is reported too. */
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/waltz/quic/fd_quic.h>
+#include "../gen/fdgen_tile_gen_pool.h"
+
+/* FDGEN_QUIC_PKT_TYPE_* classify QUIC packets */
+
+#define FDGEN_QUIC_PKT_TYPE_INITIAL   (0)
+#define FDGEN_QUIC_PKT_TYPE_0RTT      (1)
+#define FDGEN_QUIC_PKT_TYPE_HANDSHAKE (2)
+#define FDGEN_QUIC_PKT_TYPE_RETRY     (3)
+#define FDGEN_QUIC_PKT_TYPE_SHORT     (4)  /* 1-RTT */
+#define FDGEN_QUIC_PKT_TYPE_VERNEG    (5)  /* version negotiation */
+#define FDGEN_QUIC_PKT_TYPE_CNT       (6)
+
+/* FDGEN_QUIC_CID_SZ is the connection ID size used by fd_quic.  Only
+   connection IDs of this size are tracked. */
+
+#define FDGEN_QUIC_CID_SZ (8UL)
+
+struct fdgen_tile_quic_storm_rx_diag {
+  ulong rx_cnt;
+  ulong rx_sz;
+  ulong overnp_cnt;
+  ulong filt_cnt;                                 /* datagrams that are not QUIC over IPv4/UDP */
+  ulong pkt_cnt[ FDGEN_QUIC_PKT_TYPE_CNT ];       /* QUIC packets by FDGEN_QUIC_PKT_TYPE_* */
+  ulong unmatched_cnt;                            /* datagrams to connection IDs not in the pool */
+  ulong hs_cnt;                                   /* datagrams carrying a handshake flight */
+  ulong hs_tmpl_cnt;                              /* distinct pool frames that got a handshake flight */
+  ulong act_hs_ps;                                /* handshake flights per second since RUN */
+};
+
+typedef struct fdgen_tile_quic_storm_rx_diag fdgen_tile_quic_storm_rx_diag_t;
+
+struct fdgen_tile_quic_storm_rx_cfg {
+
+  long             lazy;
+  double           tick_per_ns;
+
+  fd_rng_t *       rng;
+  fd_cnc_t *       cnc;
+  uchar *          rx_base;
+  fd_frag_meta_t * rx_mcache;  /* net -> storm_rx frags */
+
+  fdgen_tile_gen_pool_t const * pool;  /* Initials being replayed */
+
+  void *           scratch;    /* see fdgen_tile_quic_storm_rx_scratch_footprint */
+  ulong            scratch_sz;
+
+};
+
+typedef struct fdgen_tile_quic_storm_rx_cfg fdgen_tile_quic_storm_rx_cfg_t;
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_tile_quic_storm_pool_fill fills pool with client Initial frames
+   produced by quic for connections from src_ip:src_port to
+   dst_ip:dst_port (net order addresses, host order ports).  quic must
+   be joined and not initialized, its conn limit sets the number of
+   connections dialed per batch.  The caller may set config fields
+   (e.g. link addresses), the client role, identity and callbacks are
+   set here.  quic is finalized on return.  Returns the number of frames
+   appended, 0 on failure (logs details). */
+
+ulong
+fdgen_tile_quic_storm_pool_fill( fdgen_tile_gen_pool_t * pool,
+                                 fd_quic_t *             quic,
+                                 fd_rng_t *              rng,
+                                 double                  tick_per_ns,
+                                 uint                    src_ip,
+                                 ushort                  src_port,
+                                 uint                    dst_ip,
+                                 ushort                  dst_port );
+
+/* fdgen_quic_varint_decode decodes the QUIC variable-length integer at
+   *p (RFC 9000 16), not reading past end.  Advances *p and returns the
+   value, or returns ULONG_MAX on truncation. */
+
+static inline ulong
+fdgen_quic_varint_decode( uchar const ** p,
+                          uchar const *  end ) {
+  uchar const * cur = *p;
+  if( FD_UNLIKELY( cur>=end ) ) return ULONG_MAX;
+  ulong sz = 1UL<<( cur[0]>>6 );
+  if( FD_UNLIKELY( (ulong)( end-cur )<sz ) ) return ULONG_MAX;
+  ulong v = cur[0] & 0x3fUL;
+  for( ulong j=1UL; j<sz; j++ ) v = ( v<<8 ) | cur[ j ];
+  *p = cur+sz;
+  return v;
+}
+
+/* fdgen_quic_pkt_parse parses the QUIC packet at data of up to sz bytes
+   (the rest of the UDP payload).  Stores the first FDGEN_QUIC_CID_SZ
+   bytes of the destination connection ID into *dcid (0 if shorter) and
+   the size of the packet into *pkt_sz (the rest of the datagram for
+   packets without a length field).  Returns the FDGEN_QUIC_PKT_TYPE_*
+   of the packet, -1 if malformed. */
+
+static inline int
+fdgen_quic_pkt_parse( uchar const * data,
+                      ulong         sz,
+                      ulong *       dcid,
+                      ulong *       pkt_sz ) {
+  uchar const * end = data+sz;
+  *dcid   = 0UL;
+  *pkt_sz = sz;
+  if( FD_UNLIKELY( !sz ) ) return -1;
+
+  /* Short header: DCID of implied size */
+  if( !( data[0] & 0x80 ) ) {
+    if( FD_UNLIKELY( !( data[0] & 0x40 ) || sz<1UL+FDGEN_QUIC_CID_SZ ) ) return -1;
+    *dcid = FD_LOAD( ulong, data+1 );
+    return FDGEN_QUIC_PKT_TYPE_SHORT;
+  }
+
+  /* Long header: flags, version, DCID, SCID */
+  if( FD_UNLIKELY( sz<7UL ) ) return -1;
+  uint          version  = FD_LOAD( uint, data+1 );
+  ulong         dcid_len = data[5];
+  uchar const * cur      = data+6;
+  if( FD_UNLIKELY( dcid_len>20UL || (ulong)( end-cur )<dcid_len+1UL ) ) return -1;
+  if( dcid_len==FDGEN_QUIC_CID_SZ ) *dcid = FD_LOAD( ulong, cur );
+  cur += dcid_len;
+  ulong scid_len = *cur++;
+  if( FD_UNLIKELY( scid_len>20UL || (ulong)( end-cur )<scid_len ) ) return -1;
+  cur += scid_len;
+
+  if( !version ) return FDGEN_QUIC_PKT_TYPE_VERNEG;
+  if( FD_UNLIKELY( !( data[0] & 0x40 ) ) ) return -1;  /* fixed bit */
+  int type = ( data[0]>>4 ) & 0x3;
+  if( type==FDGEN_QUIC_PKT_TYPE_RETRY ) return type;
+
+  /* Token (Initial only) and length */
+  if( type==FDGEN_QUIC_PKT_TYPE_INITIAL ) {
+    ulong token_len = fdgen_quic_varint_decode( &cur, end );
+    if( FD_UNLIKELY( token_len>(ulong)( end-cur ) ) ) return -1;
+    cur += token_len;
+  }
+  ulong len = fdgen_quic_varint_decode( &cur, end );
+  if( FD_UNLIKELY( len>(ulong)( end-cur ) ) ) return -1;
+  *pkt_sz = (ulong)( cur-data ) + len;
+  return type;
+}
+
+/* fdgen_tile_quic_storm_rx_scratch_{align,footprint} specify
+   parameters of the scratch memory region for a pool of frame_cnt
+   frames. */
+
+FD_FN_CONST ulong
+fdgen_tile_quic_storm_rx_scratch_align( void );
+
+FD_FN_CONST ulong
+fdgen_tile_quic_storm_rx_scratch_footprint( ulong frame_cnt );
+
+/* fdgen_tile_quic_storm_rx_run enters the tile main loop. */
+
+int
+fdgen_tile_quic_storm_rx_run( fdgen_tile_quic_storm_rx_cfg_t * cfg );
+
+FD_PROTOTYPES_END
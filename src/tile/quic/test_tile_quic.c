@@ -0,0 +1,550 @@
+#include "fdgen_tile_quic.h"
+#include "fdgen_tile_quic_storm.h"
+#include "../gen/fdgen_tile_gen.h"
+
+/* test_tile_quic.c runs the quic tile against an fd_quic server in the
+   main thread.  Frames are exchanged directly over fd_tango, no
+   sockets are involved.
+
+   Topology:
+
+    ┌──────┐  tx  ┌────────┐
+    │ quic ├──────► server │
+    │      ◄──────┤ (main) │
+    └──────┘  rx  └────────┘
+
+   The handshake storm replaces the quic tile with a gen tile replaying
+   a pool of captured Initials, and a storm_rx tile consuming the
+   server responses:
+
+    ┌────────────┐  tx  ┌────────┐  rx  ┌──────────┐
+    │ gen        ├──────► server ├──────► storm_rx │
+    │ (Initials) │      │ (main) │      │          │
+    └────────────┘      └────────┘      └──────────┘
+
+*/
+
+#include <firedancer/tango/cnc/fd_cnc.h>
+#include <firedancer/tango/mcache/fd_mcache.h>
+#include <firedancer/tango/dcache/fd_dcache.h>
+#include <firedancer/tango/tempo/fd_tempo.h>
+#include <firedancer/waltz/aio/fd_aio.h>
+#include <firedancer/ballet/ed25519/fd_ed25519.h>
+#include <firedancer/ballet/sha512/fd_sha512.h>
+#include <firedancer/util/net/fd_ip4.h>
+
+/* Server (main thread) ************************************************/
+
+struct test_server {
+  fd_wksp_t *      wksp;
+  fd_frag_meta_t * mcache;  /* server -> quic tile */
+  ulong            depth;
+  ulong            seq;
+  ulong            chunk0;
+  ulong            wmark;
+  ulong            chunk;
+
+  ulong            rx_stream_cnt;  /* streams received up to fin */
+  ulong            rx_sz;          /* stream bytes received */
+
+  uchar            pub_key [ 32 ];
+  uchar            priv_key[ 32 ];
+  fd_sha512_t *    sha512;
+};
+
+typedef struct test_server test_server_t;
+
+static test_server_t server[1];
+
+static ulong
+server_now( void * ctx ) {
+  (void)ctx;
+  return (ulong)fd_tickcount();
+}
+
+static int
+server_tx( void *                    ctx,
+           fd_aio_pkt_info_t const * batch,
+           ulong                     batch_cnt,
+           ulong *                   opt_batch_idx,
+           int                       flush ) {
+  (void)ctx; (void)flush;
+  for( ulong j=0UL; j<batch_cnt; j++ ) {
+    ulong sz = batch[ j ].buf_sz;
+    ulong ts = fd_frag_meta_ts_comp( fd_tickcount() );
+    fd_memcpy( fd_chunk_to_laddr( server->wksp, server->chunk ), batch[ j ].buf, sz );
+    fd_mcache_publish( server->mcache, server->depth, server->seq, 0UL, server->chunk, sz, 0UL, ts, ts );
+    server->chunk = fd_dcache_compact_next( server->chunk, sz, server->chunk0, server->wmark );
+    server->seq   = fd_seq_inc( server->seq, 1UL );
+  }
+  if( opt_batch_idx ) *opt_batch_idx = batch_cnt;
+  return FD_AIO_SUCCESS;
+}
+
+static void
+server_sign( void *        ctx,
+             uchar *       signature,
+             uchar const * payload ) {
+  (void)ctx;
+  fd_ed25519_sign( signature, payload, 130UL, server->pub_key, server->priv_key, server->sha512 );
+}
+
+static void
+server_stream_receive( fd_quic_stream_t * stream,
+                       void *             ctx,
+                       uchar const *      data,
+                       ulong              data_sz,
+                       ulong              offset,
+                       int                fin ) {
+  (void)stream; (void)ctx; (void)data; (void)offset;
+  server->rx_sz         += data_sz;
+  server->rx_stream_cnt += (ulong)!!fin;
+}
+
+/* Client (tile 1) *****************************************************/
+
+static int
+quic_tile_main( int     argc,
+                char ** argv ) {
+  (void)argc;
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, (uint)fd_tickcount(), 0UL ) );
+
+  fdgen_tile_quic_cfg_t * cfg = fd_type_pun( argv[0] );
+  cfg->rng  = rng;
+  cfg->lazy = 10000L;
+
+  int res = fdgen_tile_quic_run( cfg );
+
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return res;
+}
+
+/* test_load runs the quic tile for duration ns while servicing the
+   server, then checks handshake and stream counters. */
+
+static fdgen_tile_quic_diag_t const *
+test_load( fd_cnc_t *              cnc,
+           fd_quic_t *             server_quic,
+           fdgen_tile_quic_cfg_t * cfg,
+           long                    duration ) {
+
+  FD_LOG_NOTICE(( "Testing conn_cnt %lu conn_stream_max %lu stream_rate %lu stream_sz %lu",
+                  cfg->conn_cnt, cfg->conn_stream_max, cfg->stream_rate, cfg->stream_sz ));
+
+  fdgen_tile_quic_diag_t * diag = fd_cnc_app_laddr( cnc );
+  memset( diag, 0, sizeof(fdgen_tile_quic_diag_t) );
+  server->rx_stream_cnt = 0UL;
+  server->rx_sz         = 0UL;
+
+  char * quic_tile_argv[1] = { fd_type_pun( cfg ) };
+  fd_tile_exec_t * quic_tile = fd_tile_exec_new( 1UL, quic_tile_main, 1, quic_tile_argv );
+  FD_TEST( quic_tile );
+  FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+  /* Forward client frames to the server */
+
+  fd_frag_meta_t const * mcache   = cfg->tx_mcache;
+  ulong                  depth    = fd_mcache_depth( mcache );
+  ulong                  seq      = fd_mcache_seq_query( fd_mcache_seq_laddr_const( mcache ) );
+  fd_aio_t const *       rx_aio   = fd_quic_get_aio_net_rx( server_quic );
+  uchar                  buf[ 2048 ];
+  long                   deadline = fd_log_wallclock() + duration;
+  while( fd_log_wallclock()<deadline ) {
+    fd_quic_service( server_quic );
+
+    fd_frag_meta_t const * mline = mcache + fd_mcache_line_idx( seq, depth );
+    long diff = fd_seq_diff( fd_frag_meta_seq_query( mline ), seq );
+    if( diff<0L ) continue;
+    if( FD_UNLIKELY( diff>0L ) ) FD_LOG_ERR(( "overrun at seq %lu", seq ));
+
+    ulong sz = mline->sz;
+    FD_TEST( sz<=sizeof(buf) );
+    fd_memcpy( buf, fd_chunk_to_laddr_const( server->wksp, mline->chunk ), sz );
+    FD_TEST( fd_seq_eq( fd_frag_meta_seq_query( mline ), seq ) );
+
+    fd_aio_pkt_info_t pkt = { .buf = buf, .buf_sz = (ushort)sz };
+    fd_aio_send( rx_aio, &pkt, 1UL, NULL, 1 );
+    seq = fd_seq_inc( seq, 1UL );
+  }
+
+  FD_TEST( !fd_cnc_open( cnc ) );
+  fd_cnc_signal( cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( cnc );
+  FD_TEST( fd_cnc_wait( cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  fd_tile_exec_delete( quic_tile, NULL );
+
+  double hs_lat_avg = (double)diag->hs_lat_sum_ns / (double)fd_ulong_max( diag->hs_cnt, 1UL );
+  FD_LOG_NOTICE(( "quic: hs_cnt %lu (fail %lu, avg %.1f us) stream_cnt %lu (done %lu fail %lu backp %lu) "
+                  "act_hs_ps %lu act_stream_ps %lu act_goodput_bps %lu",
+                  diag->hs_cnt, diag->hs_fail_cnt, hs_lat_avg*1e-3, diag->stream_cnt, diag->stream_done_cnt,
+                  diag->stream_fail_cnt, diag->stream_backp_cnt, diag->act_hs_ps, diag->act_stream_ps,
+                  diag->act_goodput_bps ));
+  FD_LOG_NOTICE(( "server: rx_stream_cnt %lu rx_sz %lu", server->rx_stream_cnt, server->rx_sz ));
+
+  /* Every acknowledged stream was received in full by the server */
+
+  FD_TEST( diag->hs_cnt>=cfg->conn_cnt );
+  FD_TEST( diag->stream_done_cnt>0UL );
+  FD_TEST( server->rx_stream_cnt>=diag->stream_done_cnt );
+  FD_TEST( server->rx_sz>=diag->stream_done_cnt*cfg->stream_sz );
+  FD_TEST( !diag->rx_filt_cnt && !diag->tx_filt_cnt && !diag->overnp_cnt );
+  return diag;
+}
+
+/* Handshake storm (tiles 1 and 2) *************************************/
+
+static int
+gen_tile_main( int     argc,
+               char ** argv ) {
+  (void)argc;
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, (uint)fd_tickcount(), 0UL ) );
+
+  fdgen_tile_gen_cfg_t * cfg = fd_type_pun( argv[0] );
+  cfg->rng  = rng;
+  cfg->lazy = 10000L;
+
+  int res = fdgen_tile_gen_run( cfg );
+
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return res;
+}
+
+static int
+storm_rx_tile_main( int     argc,
+                    char ** argv ) {
+  (void)argc;
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, (uint)fd_tickcount(), 1UL ) );
+
+  fdgen_tile_quic_storm_rx_cfg_t * cfg = fd_type_pun( argv[0] );
+  cfg->rng  = rng;
+  cfg->lazy = 10000L;
+
+  int res = fdgen_tile_quic_storm_rx_run( cfg );
+
+  fd_rng_delete( fd_rng_leave( rng ) );
+  return res;
+}
+
+/* test_storm replays the Initials of pool from a flow set of source
+   tuples for duration ns while servicing the server, then checks that
+   the server answered with handshake flights to pool connection IDs.
+   The server may fall behind the storm, frames it misses are skipped. */
+
+static void
+test_storm( fd_cnc_t *                       gen_cnc,
+            fd_cnc_t *                       rx_cnc,
+            fd_quic_t *                      server_quic,
+            fdgen_tile_gen_cfg_t *           gen_cfg,
+            fdgen_tile_quic_storm_rx_cfg_t * rx_cfg,
+            long                             duration ) {
+
+  FD_LOG_NOTICE(( "Testing storm of %lu Initials at pps %lu over %lu flows",
+                  gen_cfg->pool->frame_cnt, gen_cfg->pps, gen_cfg->flows->flow_cnt ));
+
+  fdgen_tile_quic_storm_rx_diag_t * diag = fd_cnc_app_laddr( rx_cnc );
+  memset( diag, 0, sizeof(fdgen_tile_quic_storm_rx_diag_t) );
+
+  char * rx_tile_argv [1] = { fd_type_pun( rx_cfg  ) };
+  char * gen_tile_argv[1] = { fd_type_pun( gen_cfg ) };
+  fd_tile_exec_t * rx_tile = fd_tile_exec_new( 2UL, storm_rx_tile_main, 1, rx_tile_argv );
+  FD_TEST( rx_tile );
+  FD_TEST( fd_cnc_wait( rx_cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+  fd_tile_exec_t * gen_tile = fd_tile_exec_new( 1UL, gen_tile_main, 1, gen_tile_argv );
+  FD_TEST( gen_tile );
+  FD_TEST( fd_cnc_wait( gen_cnc, FD_CNC_SIGNAL_BOOT, (long)5e9, NULL )==FD_CNC_SIGNAL_RUN );
+
+  /* Forward storm frames to the server */
+
+  fd_frag_meta_t const * mcache   = gen_cfg->mcache;
+  ulong                  depth    = fd_mcache_depth( mcache );
+  ulong                  seq      = fd_mcache_seq_query( fd_mcache_seq_laddr_const( mcache ) );
+  fd_aio_t const *       rx_aio   = fd_quic_get_aio_net_rx( server_quic );
+  uchar                  buf[ 2048 ];
+  ulong                  fwd_cnt  = 0UL;
+  ulong                  skip_cnt = 0UL;
+  long                   deadline = fd_log_wallclock() + duration;
+  while( fd_log_wallclock()<deadline ) {
+    fd_quic_service( server_quic );
+
+    fd_frag_meta_t const * mline = mcache + fd_mcache_line_idx( seq, depth );
+    ulong seq_found = fd_frag_meta_seq_query( mline );
+    long  diff      = fd_seq_diff( seq_found, seq );
+    if( diff<0L ) continue;
+    if( FD_UNLIKELY( diff>0L ) ) { skip_cnt += (ulong)diff; seq = seq_found; continue; }
+
+    ulong sz = mline->sz;
+    FD_TEST( sz<=sizeof(buf) );
+    fd_memcpy( buf, fd_chunk_to_laddr_const( server->wksp, mline->chunk ), sz );
+    if( FD_UNLIKELY( !fd_seq_eq( fd_frag_meta_seq_query( mline ), seq ) ) ) continue;
+
+    fd_aio_pkt_info_t pkt = { .buf = buf, .buf_sz = (ushort)sz };
+    fd_aio_send( rx_aio, &pkt, 1UL, NULL, 1 );
+    seq = fd_seq_inc( seq, 1UL );
+    fwd_cnt++;
+  }
+
+  FD_TEST( !fd_cnc_open( gen_cnc ) );
+  fd_cnc_signal( gen_cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( gen_cnc );
+  FD_TEST( fd_cnc_wait( gen_cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  fd_tile_exec_delete( gen_tile, NULL );
+
+  /* Let the server drain before stopping storm_rx */
+
+  long drain = fd_log_wallclock() + (long)50e6;
+  while( fd_log_wallclock()<drain ) fd_quic_service( server_quic );
+
+  FD_TEST( !fd_cnc_open( rx_cnc ) );
+  fd_cnc_signal( rx_cnc, FD_CNC_SIGNAL_HALT );
+  fd_cnc_close( rx_cnc );
+  FD_TEST( fd_cnc_wait( rx_cnc, FD_CNC_SIGNAL_HALT, (long)5e9, NULL )==FD_CNC_SIGNAL_BOOT );
+  fd_tile_exec_delete( rx_tile, NULL );
+
+  FD_LOG_NOTICE(( "storm: fwd_cnt %lu skip_cnt %lu", fwd_cnt, skip_cnt ));
+  FD_LOG_NOTICE(( "storm_rx: rx_cnt %lu initial %lu handshake %lu short %lu unmatched %lu "
+                  "hs_cnt %lu hs_tmpl_cnt %lu act_hs_ps %lu",
+                  diag->rx_cnt, diag->pkt_cnt[ FDGEN_QUIC_PKT_TYPE_INITIAL ], diag->pkt_cnt[ FDGEN_QUIC_PKT_TYPE_HANDSHAKE ],
+                  diag->pkt_cnt[ FDGEN_QUIC_PKT_TYPE_SHORT ], diag->unmatched_cnt, diag->hs_cnt, diag->hs_tmpl_cnt,
+                  diag->act_hs_ps ));
+
+  /* Every server response maps back to a pool Initial */
+
+  FD_TEST( fwd_cnt>0UL );
+  FD_TEST( diag->pkt_cnt[ FDGEN_QUIC_PKT_TYPE_INITIAL ]>0UL );
+  FD_TEST( diag->hs_cnt>0UL && diag->hs_tmpl_cnt>0UL );
+  FD_TEST( diag->hs_tmpl_cnt<=gen_cfg->pool->frame_cnt );
+  FD_TEST( !diag->unmatched_cnt && !diag->filt_cnt && !diag->overnp_cnt );
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  fd_boot( &argc, &argv );
+
+  ulong cpu_idx = fd_tile_cpu_id( fd_tile_idx() );
+  if( cpu_idx>=fd_shmem_cpu_cnt() ) cpu_idx = 0UL;
+
+  char const * _page_sz    = fd_env_strip_cmdline_cstr ( &argc, &argv, "--page-sz",     NULL, "gigantic"                 );
+  ulong        page_cnt    = fd_env_strip_cmdline_ulong( &argc, &argv, "--page-cnt",    NULL, 1UL                        );
+  ulong        numa_idx    = fd_env_strip_cmdline_ulong( &argc, &argv, "--numa-idx",    NULL, fd_shmem_numa_idx(cpu_idx) );
+  ulong        depth       = fd_env_strip_cmdline_ulong( &argc, &argv, "--depth",       NULL, 4096UL                     );
+  ulong        conn_cnt    = fd_env_strip_cmdline_ulong( &argc, &argv, "--conn-cnt",    NULL, 256UL                      );
+  ulong        stream_rate = fd_env_strip_cmdline_ulong( &argc, &argv, "--stream-rate", NULL, 100000UL                   );
+  ulong        storm_cnt   = fd_env_strip_cmdline_ulong( &argc, &argv, "--storm-cnt",   NULL, 1024UL                     );
+  ulong        storm_pps   = fd_env_strip_cmdline_ulong( &argc, &argv, "--storm-pps",   NULL, 5000UL                     );
+  long         duration    = fd_env_strip_cmdline_long ( &argc, &argv, "--duration",    NULL, (long)500e6                );
+
+  if( FD_UNLIKELY( fd_tile_cnt()<3UL ) ) FD_LOG_ERR(( "This test requires at least 3 tiles" ));
+
+  ulong page_sz = fd_cstr_to_shmem_page_sz( _page_sz );
+  if( FD_UNLIKELY( !page_sz ) ) FD_LOG_ERR(( "unsupported --page-sz" ));
+
+  ulong mtu = 2048UL;
+
+  FD_LOG_NOTICE(( "Creating workspace with --page-cnt %lu --page-sz %s pages on --numa-idx %lu", page_cnt, _page_sz, numa_idx ));
+  fd_wksp_t * wksp = fd_wksp_new_anonymous( page_sz, page_cnt, fd_shmem_cpu_idx( numa_idx ), "wksp", 0UL );
+  FD_TEST( wksp );
+
+  void *     cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 256UL ), 1UL );
+  fd_cnc_t * cnc     = fd_cnc_join( fd_cnc_new( cnc_mem, 256UL, 1UL, fd_tickcount() ) );
+  FD_TEST( cnc );
+
+  /* Links */
+
+  ulong dcache_data_sz = fd_dcache_req_data_sz( mtu, depth, 1UL, 1 );
+
+  fd_frag_meta_t * tx_mcache = fd_mcache_join( fd_mcache_new( fd_wksp_alloc_laddr( wksp, fd_mcache_align(), fd_mcache_footprint( depth, 0UL ), 1UL ), depth, 0UL, 0UL ) );
+  uchar *          tx_dcache = fd_dcache_join( fd_dcache_new( fd_wksp_alloc_laddr( wksp, fd_dcache_align(), fd_dcache_footprint( dcache_data_sz, 0UL ), 1UL ), dcache_data_sz, 0UL ) );
+  fd_frag_meta_t * rx_mcache = fd_mcache_join( fd_mcache_new( fd_wksp_alloc_laddr( wksp, fd_mcache_align(), fd_mcache_footprint( depth, 0UL ), 1UL ), depth, 0UL, 0UL ) );
+  uchar *          rx_dcache = fd_dcache_join( fd_dcache_new( fd_wksp_alloc_laddr( wksp, fd_dcache_align(), fd_dcache_footprint( dcache_data_sz, 0UL ), 1UL ), dcache_data_sz, 0UL ) );
+  FD_TEST( tx_mcache && tx_dcache && rx_mcache && rx_dcache );
+
+  /* QUIC instances */
+
+  fd_quic_limits_t limits = {
+    .conn_cnt         = conn_cnt,
+    .handshake_cnt    = conn_cnt,
+    .conn_id_cnt      = 4UL,
+    .inflight_pkt_cnt = 64UL,
+    .tx_buf_sz        = 4096UL,
+    .stream_pool_cnt  = 64UL*conn_cnt,
+    .stream_id_cnt    = 64UL
+  };
+  ulong quic_footprint = fd_quic_footprint( &limits );
+  FD_TEST( quic_footprint );
+
+  fd_quic_t * client_quic = fd_quic_join( fd_quic_new( fd_wksp_alloc_laddr( wksp, fd_quic_align(), quic_footprint, 1UL ), &limits ) );
+  fd_quic_t * server_quic = fd_quic_join( fd_quic_new( fd_wksp_alloc_laddr( wksp, fd_quic_align(), quic_footprint, 1UL ), &limits ) );
+  FD_TEST( client_quic && server_quic );
+
+  uint   client_ip   = FD_IP4_ADDR( 127, 0, 0, 2 );
+  uint   server_ip   = FD_IP4_ADDR( 127, 0, 0, 1 );
+  ushort server_port = 8009;
+
+  client_quic->config.idle_timeout = (ulong)1e9;
+
+  /* Server setup */
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, 1U, 0UL ) );
+
+  server->wksp   = wksp;
+  server->mcache = rx_mcache;
+  server->depth  = depth;
+  server->seq    = fd_mcache_seq_query( fd_mcache_seq_laddr( rx_mcache ) );
+  server->chunk0 = fd_dcache_compact_chunk0( wksp, rx_dcache );
+  server->wmark  = fd_dcache_compact_wmark ( wksp, rx_dcache, mtu );
+  server->chunk  = server->chunk0;
+  server->sha512 = fd_sha512_join( fd_sha512_new( fd_wksp_alloc_laddr( wksp, fd_sha512_align(), fd_sha512_footprint(), 1UL ) ) );
+  FD_TEST( server->sha512 );
+  for( ulong j=0UL; j<32UL; j++ ) server->priv_key[ j ] = fd_rng_uchar( rng );
+  fd_ed25519_public_from_private( server->pub_key, server->priv_key, server->sha512 );
+
+  fd_quic_config_t * server_cfg = &server_quic->config;
+  server_cfg->role                       = FD_QUIC_ROLE_SERVER;
+  server_cfg->idle_timeout               = (ulong)1e9;
+  server_cfg->initial_rx_max_stream_data = FDGEN_TILE_QUIC_STREAM_SZ_MAX;
+  server_cfg->tick_per_us                = fd_tempo_tick_per_ns( NULL )*1e3;
+  server_cfg->net.ip_addr                = server_ip;
+  server_cfg->net.listen_udp_port        = server_port;
+  server_cfg->sign                       = server_sign;
+  server_cfg->sign_ctx                   = server;
+  fd_memcpy( server_cfg->identity_public_key, server->pub_key, 32UL );
+
+  server_quic->cb.stream_receive = server_stream_receive;
+  server_quic->cb.now            = server_now;
+
+  fd_aio_t _server_tx[1];
+  fd_quic_set_aio_net_tx( server_quic, fd_aio_join( fd_aio_new( _server_tx, server, server_tx ) ) );
+  FD_TEST( fd_quic_init( server_quic ) );
+
+  /* Client setup */
+
+  ulong  scratch_sz = fdgen_tile_quic_scratch_footprint( conn_cnt, mtu );
+  void * scratch    = fd_wksp_alloc_laddr( wksp, fdgen_tile_quic_scratch_align(), scratch_sz, 1UL );
+  FD_TEST( scratch );
+
+  fdgen_tile_quic_cfg_t cfg[1] = {{
+    .orig        = 1UL,
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+    .mtu         = mtu,
+
+    .cnc       = cnc,
+    .rx_base   = (uchar *)wksp,
+    .rx_mcache = rx_mcache,
+    .tx_base   = (uchar *)wksp,
+    .tx_mcache = tx_mcache,
+    .tx_dcache = tx_dcache,
+    .quic      = client_quic,
+
+    .conn_cnt     = conn_cnt,
+    .stream_rate  = stream_rate,
+    .stream_sz    = FDGEN_TILE_QUIC_STREAM_SZ_MAX,
+    .src_ip       = client_ip,
+    .src_port     = 9000,
+    .src_port_cnt = 16,
+    .dst_ip       = server_ip,
+    .dst_port     = server_port,
+
+    .scratch    = scratch,
+    .scratch_sz = scratch_sz
+  }};
+
+  /* Steady load: every connection stays up */
+
+  fdgen_tile_quic_diag_t const * diag = test_load( cnc, server_quic, cfg, duration );
+  FD_TEST( diag->hs_cnt==conn_cnt && !diag->hs_fail_cnt );
+
+  /* Churn: connections are replaced after 8 streams, so handshakes
+     continue throughout the run */
+
+  cfg->conn_stream_max = 8UL;
+  cfg->conn_rate       = 10000UL;
+  cfg->stream_sz       = 64UL;
+  diag = test_load( cnc, server_quic, cfg, duration );
+  FD_TEST( diag->hs_cnt>conn_cnt && diag->conn_close_cnt>0UL );
+
+  /* Handshake storm: capture Initials with the (now idle) client quic,
+     then replay them from 1000 source ports */
+
+  ulong                   pool_sz  = fdgen_tile_gen_pool_footprint( storm_cnt, mtu );
+  void *                  pool_mem = fd_wksp_alloc_laddr( wksp, fdgen_tile_gen_pool_align(), pool_sz, 1UL );
+  fdgen_tile_gen_pool_t * pool     = fdgen_tile_gen_pool_new( pool_mem, storm_cnt, mtu );
+  FD_TEST( pool );
+  FD_TEST( fdgen_tile_quic_storm_pool_fill( pool, client_quic, rng, fd_tempo_tick_per_ns( NULL ),
+                                            client_ip, 9000, server_ip, server_port )==storm_cnt );
+
+  fdgen_tile_gen_flow_params_t flow_params = {
+    .src_ip   = client_ip,   .src_ip_cnt   = 1UL,
+    .src_port = 10000,       .src_port_cnt = 1000UL,
+    .dst_ip   = server_ip,   .dst_ip_cnt   = 1UL,
+    .dst_port = server_port, .dst_port_cnt = 1UL
+  };
+  fdgen_tile_gen_flow_set_t flows[1];
+  FD_TEST( fdgen_tile_gen_flow_set_init( flows, &flow_params, 1UL ) );
+
+  void *     rx_cnc_mem = fd_wksp_alloc_laddr( wksp, fd_cnc_align(), fd_cnc_footprint( 256UL ), 1UL );
+  fd_cnc_t * rx_cnc     = fd_cnc_join( fd_cnc_new( rx_cnc_mem, 256UL, 2UL, fd_tickcount() ) );
+  FD_TEST( rx_cnc );
+
+  ulong  storm_scratch_sz = fdgen_tile_quic_storm_rx_scratch_footprint( storm_cnt );
+  void * storm_scratch    = fd_wksp_alloc_laddr( wksp, fdgen_tile_quic_storm_rx_scratch_align(), storm_scratch_sz, 1UL );
+  FD_TEST( storm_scratch );
+
+  fdgen_tile_gen_cfg_t gen_cfg[1] = {{
+    .orig        = 2UL,
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+    .mtu         = mtu,
+
+    .cnc    = cnc,
+    .mcache = tx_mcache,
+    .dcache = tx_dcache,
+    .base   = (uchar *)wksp,
+
+    .pps      = storm_pps,
+    .burst    = 1UL,
+    .src_ip   = client_ip,
+    .dst_ip   = server_ip,
+    .src_port = 9000,
+    .dst_port = server_port,
+    .flows    = flows,
+    .pool     = pool
+  }};
+
+  fdgen_tile_quic_storm_rx_cfg_t rx_cfg[1] = {{
+    .tick_per_ns = fd_tempo_tick_per_ns( NULL ),
+    .cnc         = rx_cnc,
+    .rx_base     = (uchar *)wksp,
+    .rx_mcache   = rx_mcache,
+    .pool        = pool,
+    .scratch     = storm_scratch,
+    .scratch_sz  = storm_scratch_sz
+  }};
+
+  test_storm( cnc, rx_cnc, server_quic, gen_cfg, rx_cfg, duration );
+
+  fd_wksp_free_laddr( storm_scratch );
+  fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( rx_cnc ) ) );
+  fd_wksp_free_laddr( pool_mem );
+
+  FD_LOG_INFO(( "Cleaning up" ));
+
+  fd_quic_fini( server_quic );
+  fd_wksp_free_laddr( fd_quic_delete( fd_quic_leave( client_quic ) ) );
+  fd_wksp_free_laddr( fd_quic_delete( fd_quic_leave( server_quic ) ) );
+  fd_wksp_free_laddr( fd_sha512_delete( fd_sha512_leave( server->sha512 ) ) );
+  fd_wksp_free_laddr( scratch );
+  fd_wksp_free_laddr( fd_dcache_delete( fd_dcache_leave( rx_dcache ) ) );
+  fd_wksp_free_laddr( fd_mcache_delete( fd_mcache_leave( rx_mcache ) ) );
+  fd_wksp_free_laddr( fd_dcache_delete( fd_dcache_leave( tx_dcache ) ) );
+  fd_wksp_free_laddr( fd_mcache_delete( fd_mcache_leave( tx_mcache ) ) );
+  fd_wksp_free_laddr( fd_cnc_delete( fd_cnc_leave( cnc ) ) );
+  fd_rng_delete( fd_rng_leave( rng ) );
+  fd_wksp_delete_anonymous( wksp );
+
+  FD_LOG_NOTICE(( "pass" ));
+  fd_halt();
+  return 0;
+}
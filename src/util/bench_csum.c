@@ -0,0 +1,64 @@
+#include "fdgen_csum.h"
+
+/* bench_csum.c reports the single core throughput of each checksum
+   kernel across payload sizes.  Buffers are L1 resident, so this is
+   the compute bound of the kernel, not of memory. */
+
+#define BUF_SZ (16384UL)
+
+static uchar buf[ BUF_SZ ] __attribute__((aligned(64)));
+
+typedef ulong (* csum_fn_t)( void const *, ulong, ulong );
+
+static double
+bench( csum_fn_t fn,
+       ulong     sz,
+       long      duration ) {
+  ulong iter_cnt = 0UL;
+  ulong acc      = 0UL;
+  long  t0       = fd_log_wallclock();
+  long  t1;
+  do {
+    for( ulong j=0UL; j<1024UL; j++ ) {
+      FD_COMPILER_FORGET( acc );
+      acc += fn( buf, sz, 0UL );
+    }
+    iter_cnt += 1024UL;
+    t1 = fd_log_wallclock();
+  } while( (t1-t0)<duration );
+  FD_COMPILER_FORGET( acc );
+  return (double)( iter_cnt*sz ) / (double)( t1-t0 );  /* bytes/ns == GB/s */
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  fd_boot( &argc, &argv );
+
+  long duration = fd_env_strip_cmdline_long( &argc, &argv, "--duration", NULL, (long)100e6 );
+
+  for( ulong j=0UL; j<BUF_SZ; j++ ) buf[j] = (uchar)( j*131UL );
+
+  static ulong const sz_list[] = { 64UL, 128UL, 256UL, 512UL, 1024UL, 1200UL, 1232UL, 1472UL, 4096UL, 9000UL };
+
+  struct { char const * name; csum_fn_t fn; } const kern[] = {
+    { "scalar", fdgen_csum_add_scalar },
+#   if FDGEN_CSUM_HAS_AVX2
+    { "avx2",   fdgen_csum_add_avx2   },
+#   endif
+#   if FDGEN_CSUM_HAS_AVX512
+    { "avx512", fdgen_csum_add_avx512 },
+#   endif
+  };
+
+  for( ulong k=0UL; k<sizeof(kern)/sizeof(kern[0]); k++ ) {
+    for( ulong i=0UL; i<sizeof(sz_list)/sizeof(ulong); i++ ) {
+      ulong  sz   = sz_list[i];
+      double gbps = bench( kern[k].fn, sz, duration );
+      FD_LOG_NOTICE(( "%-6s sz %5lu: %6.2f GB/s/core (%6.2f Mpps)", kern[k].name, sz, gbps, gbps*1e3/(double)sz ));
+    }
+  }
+
+  fd_halt();
+  return 0;
+}
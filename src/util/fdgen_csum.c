@@ -0,0 +1,108 @@
+#include "fdgen_csum.h"
+
+#if FDGEN_CSUM_HAS_AVX2 || FDGEN_CSUM_HAS_AVX512
+#include <immintrin.h>
+#endif
+
+FD_FN_PURE ulong
+fdgen_csum_add_scalar( void const * buf,
+                       ulong        sz,
+                       ulong        sum ) {
+  uchar const * p = buf;
+
+  /* 32 bytes per iteration, each 64-bit load split into 32-bit halves */
+  while( sz>=32UL ) {
+    ulong w0 = FD_LOAD( ulong, p     );
+    ulong w1 = FD_LOAD( ulong, p+ 8UL );
+    ulong w2 = FD_LOAD( ulong, p+16UL );
+    ulong w3 = FD_LOAD( ulong, p+24UL );
+    sum += ( w0 & 0xffffffffUL ) + ( w0>>32 ) + ( w1 & 0xffffffffUL ) + ( w1>>32 )
+         + ( w2 & 0xffffffffUL ) + ( w2>>32 ) + ( w3 & 0xffffffffUL ) + ( w3>>32 );
+    p += 32UL; sz -= 32UL;
+  }
+  while( sz>=4UL ) { sum += (ulong)FD_LOAD( uint,   p ); p += 4UL; sz -= 4UL; }
+  if(    sz>=2UL ) { sum += (ulong)FD_LOAD( ushort, p ); p += 2UL; sz -= 2UL; }
+  if(    sz      ) { sum += (ulong)p[0]; }
+  return sum;
+}
+
+#if FDGEN_CSUM_HAS_AVX2
+
+FD_FN_PURE ulong
+fdgen_csum_add_avx2( void const * buf,
+                     ulong        sz,
+                     ulong        sum ) {
+  uchar const * p    = buf;
+  __m256i const mask = _mm256_set1_epi64x( 0xffffffffL );
+  __m256i       acc0 = _mm256_setzero_si256();
+  __m256i       acc1 = _mm256_setzero_si256();
+
+  /* Two independent accumulator chains, 64 bytes per iteration */
+  while( sz>=64UL ) {
+    __m256i v0 = _mm256_loadu_si256( (__m256i const *)( p     ) );
+    __m256i v1 = _mm256_loadu_si256( (__m256i const *)( p+32UL ) );
+    acc0 = _mm256_add_epi64( acc0, _mm256_and_si256 ( v0, mask ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_srli_epi64( v0, 32   ) );
+    acc0 = _mm256_add_epi64( acc0, _mm256_and_si256 ( v1, mask ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_srli_epi64( v1, 32   ) );
+    p += 64UL; sz -= 64UL;
+  }
+  if( sz>=32UL ) {
+    __m256i v0 = _mm256_loadu_si256( (__m256i const *)p );
+    acc0 = _mm256_add_epi64( acc0, _mm256_and_si256 ( v0, mask ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_srli_epi64( v0, 32   ) );
+    p += 32UL; sz -= 32UL;
+  }
+
+  __m256i acc = _mm256_add_epi64( acc0, acc1 );
+  __m128i s   = _mm_add_epi64( _mm256_castsi256_si128( acc ), _mm256_extracti128_si256( acc, 1 ) );
+  sum += (ulong)_mm_cvtsi128_si64( s ) + (ulong)_mm_extract_epi64( s, 1 );
+
+  return fdgen_csum_add_scalar( p, sz, sum );
+}
+
+#endif /* FDGEN_CSUM_HAS_AVX2 */
+
+#if FDGEN_CSUM_HAS_AVX512
+
+FD_FN_PURE ulong
+fdgen_csum_add_avx512( void const * buf,
+                       ulong        sz,
+                       ulong        sum ) {
+  uchar const * p    = buf;
+  __m512i const mask = _mm512_set1_epi64( 0xffffffffL );
+  __m512i       acc0 = _mm512_setzero_si512();
+  __m512i       acc1 = _mm512_setzero_si512();
+
+  /* Two independent accumulator chains, 128 bytes per iteration */
+  while( sz>=128UL ) {
+    __m512i v0 = _mm512_loadu_si512( p      );
+    __m512i v1 = _mm512_loadu_si512( p+64UL );
+    acc0 = _mm512_add_epi64( acc0, _mm512_and_si512 ( v0, mask ) );
+    acc1 = _mm512_add_epi64( acc1, _mm512_srli_epi64( v0, 32   ) );
+    acc0 = _mm512_add_epi64( acc0, _mm512_and_si512 ( v1, mask ) );
+    acc1 = _mm512_add_epi64( acc1, _mm512_srli_epi64( v1, 32   ) );
+    p += 128UL; sz -= 128UL;
+  }
+
+  /* Tail: whole 32-bit words with a masked load, so no scalar loop */
+  if( sz>=4UL ) {
+    ulong     word_cnt = sz>>2;                      /* at most 31 */
+    __mmask16 k0       = (__mmask16)( ( 1UL<<fd_ulong_min( word_cnt,     16UL ) )-1UL );
+    __mmask16 k1       = (__mmask16)( ( 1UL<<( word_cnt>16UL ? word_cnt-16UL : 0UL ) )-1UL );
+    __m512i   v0       = _mm512_maskz_loadu_epi32( k0, p      );
+    __m512i   v1       = _mm512_maskz_loadu_epi32( k1, p+64UL );
+    acc0 = _mm512_add_epi64( acc0, _mm512_and_si512 ( v0, mask ) );
+    acc1 = _mm512_add_epi64( acc1, _mm512_srli_epi64( v0, 32   ) );
+    acc0 = _mm512_add_epi64( acc0, _mm512_and_si512 ( v1, mask ) );
+    acc1 = _mm512_add_epi64( acc1, _mm512_srli_epi64( v1, 32   ) );
+    p  += word_cnt<<2;
+    sz -= word_cnt<<2;
+  }
+
+  sum += (ulong)_mm512_reduce_add_epi64( _mm512_add_epi64( acc0, acc1 ) );
+
+  return fdgen_csum_add_scalar( p, sz, sum );
+}
+
+#endif /* FDGEN_CSUM_HAS_AVX512 */
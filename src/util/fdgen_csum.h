@@ -0,0 +1,138 @@
+#pragma once
+
+/* fdgen_csum.h provides Internet checksum (RFC 1071) kernels for
+   generating and verifying UDP checksums over frames in the dcache.
+
+   The kernels accumulate the buffer as 32-bit little endian words into
+   a 64-bit sum.  The one's complement sum is byte order independent, so
+   the folded sum can be stored as is into a network order checksum
+   field.  Vector kernels split each 64-bit lane into its 32-bit halves
+   and accumulate both into 64-bit lanes, which cannot overflow for any
+   buffer below 2^34 bytes.
+
+   Kernels are selected at compile time from the target ISA (-march):
+   AVX-512BW, AVX2 or scalar.  All kernels available for the target are
+   exported for testing and benchmarking, fdgen_csum_add picks the
+   widest. */
+
+#include <firedancer/util/fd_util_base.h>
+#include <firedancer/util/net/fd_ip4.h>
+#include <firedancer/util/net/fd_udp.h>
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define FDGEN_CSUM_HAS_AVX512 1
+#else
+#define FDGEN_CSUM_HAS_AVX512 0
+#endif
+
+#if defined(__AVX2__)
+#define FDGEN_CSUM_HAS_AVX2 1
+#else
+#define FDGEN_CSUM_HAS_AVX2 0
+#endif
+
+FD_PROTOTYPES_BEGIN
+
+/* fdgen_csum_add_{scalar,avx2,avx512} add the sz bytes at buf to the
+   unfolded checksum sum and return the new unfolded sum.  A buffer may
+   be checksummed in pieces by chaining calls; all pieces but the last
+   must have an even size.  An odd trailing byte is padded with zero. */
+
+FD_FN_PURE ulong
+fdgen_csum_add_scalar( void const * buf,
+                       ulong        sz,
+                       ulong        sum );
+
+#if FDGEN_CSUM_HAS_AVX2
+FD_FN_PURE ulong
+fdgen_csum_add_avx2( void const * buf,
+                     ulong        sz,
+                     ulong        sum );
+#endif
+
+#if FDGEN_CSUM_HAS_AVX512
+FD_FN_PURE ulong
+fdgen_csum_add_avx512( void const * buf,
+                       ulong        sz,
+                       ulong        sum );
+#endif
+
+FD_FN_PURE static inline ulong
+fdgen_csum_add( void const * buf,
+                ulong        sz,
+                ulong        sum ) {
+# if FDGEN_CSUM_HAS_AVX512
+  return fdgen_csum_add_avx512( buf, sz, sum );
+# elif FDGEN_CSUM_HAS_AVX2
+  return fdgen_csum_add_avx2( buf, sz, sum );
+# else
+  return fdgen_csum_add_scalar( buf, sz, sum );
+# endif
+}
+
+/* fdgen_csum_fold folds an unfolded sum into a 16-bit one's complement
+   sum (not complemented). */
+
+FD_FN_CONST static inline ushort
+fdgen_csum_fold( ulong sum ) {
+  sum = ( sum & 0xffffffffUL ) + ( sum>>32 );
+  sum = ( sum & 0xffffffffUL ) + ( sum>>32 );
+  sum = ( sum & 0xffffUL     ) + ( sum>>16 );
+  sum = ( sum & 0xffffUL     ) + ( sum>>16 );
+  sum = ( sum & 0xffffUL     ) + ( sum>>16 );
+  return (ushort)sum;
+}
+
+/* fdgen_udp4_csum returns the one's complement sum (folded, not
+   complemented) of the IPv4 pseudo-header of ip4_hdr and the udp_sz
+   bytes of the UDP datagram at udp (header and payload). */
+
+FD_FN_PURE static inline ushort
+fdgen_udp4_csum( fd_ip4_hdr_t const * ip4_hdr,
+                 void const *         udp,
+                 ulong                udp_sz ) {
+  uint saddr; memcpy( &saddr, ip4_hdr->saddr_c, 4 );
+  uint daddr; memcpy( &daddr, ip4_hdr->daddr_c, 4 );
+  ulong sum = (ulong)saddr + (ulong)daddr
+            + (ulong)fd_ushort_bswap( FD_IP4_HDR_PROTOCOL_UDP )
+            + (ulong)fd_ushort_bswap( (ushort)udp_sz );
+  return fdgen_csum_fold( fdgen_csum_add( udp, udp_sz, sum ) );
+}
+
+/* fdgen_udp4_check_fill computes the checksum of the UDP datagram of
+   udp_sz bytes at udp, whose check field must be zero, and stores it
+   into the check field. */
+
+static inline void
+fdgen_udp4_check_fill( fd_ip4_hdr_t const * ip4_hdr,
+                       fd_udp_hdr_t *       udp,
+                       ulong                udp_sz ) {
+  ushort check = (ushort)~fdgen_udp4_csum( ip4_hdr, udp, udp_sz );
+  udp->check = check ? check : (ushort)0xffff;  /* zero means no checksum */
+}
+
+/* fdgen_udp4_frame_check validates a published Ethernet/IPv4/UDP frame
+   of sz bytes: IPv4 header checksum, consistent lengths, and the UDP
+   checksum unless it is zero (absent).  Bytes past the IPv4 total
+   length (Ethernet padding) are ignored.  Returns 1 if valid, 0
+   otherwise. */
+
+FD_FN_PURE static inline int
+fdgen_udp4_frame_check( uchar const * frame,
+                        ulong         sz ) {
+  if( FD_UNLIKELY( sz<14UL+20UL+8UL ) ) return 0;
+  fd_ip4_hdr_t const * ip4_hdr = fd_type_pun_const( frame+14 );
+  ulong ihl     = FD_IP4_GET_IHL( *ip4_hdr )<<2;
+  ulong tot_len = (ulong)fd_ushort_bswap( ip4_hdr->net_tot_len );
+  if( FD_UNLIKELY( ( ihl<20UL ) | ( ip4_hdr->protocol!=FD_IP4_HDR_PROTOCOL_UDP ) ) ) return 0;
+  if( FD_UNLIKELY( ( tot_len<ihl+8UL ) | ( tot_len>sz-14UL ) ) ) return 0;
+  if( FD_UNLIKELY( fdgen_csum_fold( fdgen_csum_add( ip4_hdr, ihl, 0UL ) )!=0xffff ) ) return 0;
+
+  ulong udp_sz = tot_len-ihl;
+  fd_udp_hdr_t const * udp_hdr = fd_type_pun_const( frame+14UL+ihl );
+  if( FD_UNLIKELY( (ulong)fd_ushort_bswap( udp_hdr->net_len )!=udp_sz ) ) return 0;
+  if( !udp_hdr->check ) return 1;
+  return fdgen_udp4_csum( ip4_hdr, udp_hdr, udp_sz )==0xffff;
+}
+
+FD_PROTOTYPES_END
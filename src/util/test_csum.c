@@ -0,0 +1,136 @@
+#include "fdgen_csum.h"
+
+/* test_csum.c checks the checksum kernels against a bytewise reference
+   and round-trips UDP checksums through fdgen_udp4_frame_check. */
+
+#define BUF_SZ (70000UL)
+
+static uchar buf[ BUF_SZ ] __attribute__((aligned(64)));
+
+/* ref_csum is the RFC 1071 reference: 16-bit little endian words, odd
+   byte padded, folded */
+
+static ushort
+ref_csum( uchar const * p,
+          ulong         sz ) {
+  ulong sum = 0UL;
+  for( ulong i=0UL; i+1UL<sz; i+=2UL ) sum += (ulong)p[i] | ( (ulong)p[i+1UL]<<8 );
+  if( sz&1UL ) sum += (ulong)p[sz-1UL];
+  while( sum>>16 ) sum = ( sum & 0xffffUL ) + ( sum>>16 );
+  return (ushort)sum;
+}
+
+/* csum_eq compares one's complement sums, 0 and 0xffff both being
+   zero */
+
+static int
+csum_eq( ushort a,
+         ushort b ) {
+  return a==b || ( !(a%0xffff) && !(b%0xffff) );
+}
+
+static void
+test_kernels( fd_rng_t * rng ) {
+  for( ulong j=0UL; j<BUF_SZ; j++ ) buf[j] = fd_rng_uchar( rng );
+
+  for( ulong iter=0UL; iter<100000UL; iter++ ) {
+    ulong off = fd_rng_ulong_roll( rng, 64UL );
+    ulong sz  = fd_rng_ulong_roll( rng, iter<1000UL ? BUF_SZ-64UL : 2100UL );
+    int   sat = !(iter%7UL);  /* all ones, worst case for carries */
+    if( sat ) memset( buf+off, 0xff, sz );
+
+    ushort ref = ref_csum( buf+off, sz );
+    FD_TEST( csum_eq( ref, fdgen_csum_fold( fdgen_csum_add_scalar( buf+off, sz, 0UL ) ) ) );
+#   if FDGEN_CSUM_HAS_AVX2
+    FD_TEST( csum_eq( ref, fdgen_csum_fold( fdgen_csum_add_avx2  ( buf+off, sz, 0UL ) ) ) );
+#   endif
+#   if FDGEN_CSUM_HAS_AVX512
+    FD_TEST( csum_eq( ref, fdgen_csum_fold( fdgen_csum_add_avx512( buf+off, sz, 0UL ) ) ) );
+#   endif
+
+    /* Chained pieces */
+    ulong cut = fd_rng_ulong_roll( rng, sz+1UL ) & ~1UL;
+    FD_TEST( csum_eq( ref, fdgen_csum_fold( fdgen_csum_add( buf+off+cut, sz-cut, fdgen_csum_add( buf+off, cut, 0UL ) ) ) ) );
+
+    if( sat ) for( ulong j=off; j<off+sz; j++ ) buf[j] = fd_rng_uchar( rng );
+  }
+}
+
+static void
+test_udp4( fd_rng_t * rng ) {
+  for( ulong iter=0UL; iter<10000UL; iter++ ) {
+    ulong payload_sz = fd_rng_ulong_roll( rng, 1473UL );
+    ulong sz         = 42UL + payload_sz;
+    uchar * frame    = buf;
+    memset( frame, 0, 42UL );
+
+    fd_ip4_hdr_t * ip4_hdr = fd_type_pun( frame+14 );
+    fd_udp_hdr_t * udp_hdr = fd_type_pun( frame+34 );
+    ip4_hdr->verihl      = FD_IP4_VERIHL( 4, 5 );
+    ip4_hdr->net_tot_len = (ushort)fd_ushort_bswap( (ushort)( sz-14UL ) );
+    ip4_hdr->ttl         = 64;
+    ip4_hdr->protocol    = FD_IP4_HDR_PROTOCOL_UDP;
+    uint saddr = fd_rng_uint( rng ); memcpy( ip4_hdr->saddr_c, &saddr, 4 );
+    uint daddr = fd_rng_uint( rng ); memcpy( ip4_hdr->daddr_c, &daddr, 4 );
+    ip4_hdr->check       = fd_ip4_hdr_check( ip4_hdr );
+    udp_hdr->net_sport   = fd_rng_ushort( rng );
+    udp_hdr->net_dport   = fd_rng_ushort( rng );
+    udp_hdr->net_len     = (ushort)fd_ushort_bswap( (ushort)( sz-34UL ) );
+    for( ulong j=42UL; j<sz; j++ ) frame[j] = fd_rng_uchar( rng );
+
+    FD_TEST( fdgen_udp4_frame_check( frame, sz ) );  /* no checksum */
+    fdgen_udp4_check_fill( ip4_hdr, udp_hdr, sz-34UL );
+    FD_TEST( udp_hdr->check );
+    FD_TEST( fdgen_udp4_frame_check( frame, sz ) );
+
+    /* Ethernet padding past the IPv4 total length is ignored */
+    ulong pad_sz = fd_rng_ulong_roll( rng, 64UL );
+    for( ulong j=sz; j<sz+pad_sz; j++ ) frame[j] = fd_rng_uchar( rng );
+    FD_TEST( fdgen_udp4_frame_check( frame, sz+pad_sz ) );
+
+    /* Truncated frames are rejected */
+    FD_TEST( !fdgen_udp4_frame_check( frame, sz-1UL ) );
+
+    /* Any single bit flip in the datagram is detected */
+    ulong bit = 34UL*8UL + fd_rng_ulong_roll( rng, (sz-34UL)*8UL );
+    frame[ bit>>3 ] ^= (uchar)( 1U<<(bit&7UL) );
+    FD_TEST( !fdgen_udp4_frame_check( frame, sz ) );
+  }
+
+  /* Header lengths inconsistent with the frame are rejected before any
+     bytes past the frame are read */
+  uchar * frame = buf;
+  memset( frame, 0, 64UL );
+  fd_ip4_hdr_t * ip4_hdr = fd_type_pun( frame+14 );
+  ip4_hdr->protocol = FD_IP4_HDR_PROTOCOL_UDP;
+  for( uint ihl=0U; ihl<16U; ihl++ ) {
+    for( ulong tot_len=0UL; tot_len<=64UL; tot_len++ ) {
+      ip4_hdr->verihl      = FD_IP4_VERIHL( 4, ihl );
+      ip4_hdr->net_tot_len = (ushort)fd_ushort_bswap( (ushort)tot_len );
+      ip4_hdr->check       = 0;
+      ip4_hdr->check       = fd_ip4_hdr_check( ip4_hdr );
+      int ok = ihl>=5U && tot_len>=ihl*4UL+8UL && tot_len<=50UL-14UL;
+      if( !ok ) FD_TEST( !fdgen_udp4_frame_check( frame, 50UL ) );
+    }
+  }
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  fd_boot( &argc, &argv );
+
+  fd_rng_t _rng[1]; fd_rng_t * rng = fd_rng_join( fd_rng_new( _rng, 0U, 0UL ) );
+
+  FD_LOG_NOTICE(( "Kernels: scalar%s%s",
+                  FDGEN_CSUM_HAS_AVX2   ? " avx2"   : "",
+                  FDGEN_CSUM_HAS_AVX512 ? " avx512" : "" ));
+
+  test_kernels( rng );
+  test_udp4( rng );
+
+  fd_rng_delete( fd_rng_leave( rng ) );
+  FD_LOG_NOTICE(( "pass" ));
+  fd_halt();
+  return 0;
+}